@@ -0,0 +1,343 @@
+/*
+ * File:   main.cpp
+ * Author: donerkebab
+ *
+ * Created on May 2, 2014, 11:20 AM
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+#include "BinaryChainWriter.h"
+#include "ChainFileFormat.h"
+#include "ChainReadError.h"
+#include "ChainReader.h"
+#include "CompressedChainReader.h"
+#include "Point.h"
+
+
+namespace { // unnamed namespace
+    // A whole chain in memory, as runs of the same point
+    struct Chain {
+        unsigned int dimension;
+        unsigned int num_measurements;
+        std::vector<std::shared_ptr<Mcmc::Point> > points;
+        std::vector<unsigned int> multiplicities;
+    };
+
+    // Forward declarations
+    void ReadChain(std::string const& filename, Chain& chain);
+    void CutBurnIn(double burn_fraction, Chain& chain);
+    void PrintUsage();
+}
+
+/*
+ * Converts chain files into one binary chain file.
+ *
+ * Usage: chainconvert [-b burn_fraction] [-r] output_file input_file...
+ *
+ * The input files may be text, binary or compressed binary chain files, and
+ * all need the same dimension and number of measurements.  The first
+ * burn_fraction of each input chain's steps is left out, and what remains of
+ * the chains is written one after the other to output_file, which must not
+ * exist yet.  With -r, the output is run-length encoded.
+ *
+ */
+int main(int argc, char** argv) {
+
+    double burn_fraction = 0.0;
+    bool run_length_encoded = false;
+    int i_arg = 1;
+    for (; i_arg < argc && argv[i_arg][0] == '-'; ++i_arg) {
+        if (std::strcmp(argv[i_arg], "-b") == 0 && i_arg + 1 < argc) {
+            burn_fraction = std::atof(argv[++i_arg]);
+        } else if (std::strcmp(argv[i_arg], "-r") == 0) {
+            run_length_encoded = true;
+        } else {
+            ::PrintUsage();
+            exit(1);
+        }
+    }
+    if (argc - i_arg < 2 || burn_fraction < 0.0 || burn_fraction >= 1.0) {
+        ::PrintUsage();
+        exit(1);
+    }
+
+    std::string output_filename = argv[i_arg];
+    std::vector<std::string> input_filenames(argv + i_arg + 1, argv + argc);
+    if (std::ifstream(output_filename.c_str())) {
+        printf("%s already exists\n", output_filename.c_str());
+        exit(1);
+    }
+
+    try {
+        std::unique_ptr<Mcmc::BinaryChainWriter> writer;
+        unsigned long num_steps_written = 0;
+        for (std::string const& input_filename : input_filenames) {
+            ::Chain chain = ::Chain();
+            ::ReadChain(input_filename, chain);
+            ::CutBurnIn(burn_fraction, chain);
+            if (chain.points.empty()) {
+                printf("%s: no steps left, skipped\n",
+                        input_filename.c_str());
+                continue;
+            }
+
+            if (!writer) {
+                std::ostringstream metadata;
+                metadata << "converted by chainconvert\nburn_fraction = " <<
+                        burn_fraction << "\n";
+                for (std::string const& filename : input_filenames) {
+                    metadata << "input = " << filename << "\n";
+                }
+                writer.reset(new Mcmc::BinaryChainWriter(output_filename,
+                        chain.dimension, chain.num_measurements,
+                        metadata.str(), run_length_encoded));
+            }
+            if (chain.dimension != writer->dimension() ||
+                    chain.num_measurements != writer->num_measurements()) {
+                throw std::invalid_argument(input_filename + " does not "
+                        "match the dimension and number of measurements of "
+                        "the first input file");
+            }
+
+            writer->Write(chain.points.data(), chain.multiplicities.data(),
+                    chain.points.size());
+            for (unsigned int multiplicity : chain.multiplicities) {
+                num_steps_written += multiplicity;
+            }
+        }
+        if (!writer) {
+            throw std::invalid_argument("no steps to write");
+        }
+        printf("%lu steps written to %s\n", num_steps_written,
+                output_filename.c_str());
+    } catch (std::exception const& e) {
+        printf("%s\n", e.what());
+        std::remove(output_filename.c_str());
+        exit(1);
+    }
+
+    return 0;
+}
+
+
+namespace {
+
+    std::shared_ptr<Mcmc::Point> NewPoint(double const* values,
+            unsigned int dimension,
+            unsigned int num_measurements) {
+        if (dimension == 0 || num_measurements == 0) {
+            throw std::invalid_argument("points need at least one parameter "
+                    "and one measurement");
+        }
+        gsl_vector_const_view parameters = gsl_vector_const_view_array(
+                values, dimension);
+        gsl_vector_const_view measurements = gsl_vector_const_view_array(
+                values + dimension, num_measurements);
+        return std::shared_ptr<Mcmc::Point>(new Mcmc::Point(
+                &parameters.vector, &measurements.vector,
+                values[dimension + num_measurements]));
+    }
+
+    /*
+     * Reads the numbers on one line onto the end of values, and puts how many
+     * there were in num_values.  Returns false at the end of the file.
+     */
+    bool ReadLine(std::istream& input,
+            std::vector<double>& values,
+            unsigned int& num_values) {
+        std::string line;
+        if (!std::getline(input, line)) {
+            return false;
+        }
+
+        num_values = 0;
+        char const* position = line.c_str();
+        while (true) {
+            char* end;
+            double value = std::strtod(position, &end);
+            if (end == position) {
+                break;
+            }
+            values.push_back(value);
+            ++num_values;
+            position = end;
+        }
+        return true;
+    }
+
+    /*
+     * Text files: each point is a line of parameters, a line of measurements,
+     * a line with the likelihood, in run-length encoded files a line with the
+     * multiplicity, and a blank line.  Run-length encoded files start with a
+     * line that says so.
+     */
+    void ReadTextChain(std::string const& filename, Chain& chain) {
+        std::ifstream input(filename.c_str());
+        if (!input) {
+            throw Mcmc::ChainReadError("could not open " + filename);
+        }
+
+        std::vector<double> values;
+        std::string line;
+        bool run_length_encoded = input.peek() == '#';
+        if (run_length_encoded) {
+            std::getline(input, line);
+            if (line != "# run-length encoded") {
+                throw Mcmc::ChainReadError(filename + " is not a text chain "
+                        "file");
+            }
+        }
+        while (input.peek() != std::ifstream::traits_type::eof()) {
+            values.clear();
+            unsigned int dimension;
+            unsigned int num_measurements;
+            unsigned int num_likelihoods;
+            if (!ReadLine(input, values, dimension) ||
+                    !ReadLine(input, values, num_measurements) ||
+                    !ReadLine(input, values, num_likelihoods) ||
+                    !std::getline(input, line)) {
+                printf("%s: last point is cut short, and left out\n",
+                        filename.c_str());
+                break;
+            }
+            if (num_likelihoods != 1) {
+                throw Mcmc::ChainReadError(filename + " is not a text chain "
+                        "file");
+            }
+
+            // The multiplicity and then the blank line, or just the blank
+            // line
+            unsigned int multiplicity = 1;
+            if (run_length_encoded) {
+                char* end;
+                multiplicity = std::strtoul(line.c_str(), &end, 10);
+                if (multiplicity == 0 || *end != '\0') {
+                    throw Mcmc::ChainReadError(filename + " has a point "
+                            "without a multiplicity");
+                }
+                if (!std::getline(input, line)) {
+                    printf("%s: last point is cut short, and left out\n",
+                            filename.c_str());
+                    break;
+                }
+            }
+            if (!line.empty()) {
+                throw Mcmc::ChainReadError(filename + " is not a text chain "
+                        "file");
+            }
+
+            if (chain.points.empty()) {
+                chain.dimension = dimension;
+                chain.num_measurements = num_measurements;
+            } else if (dimension != chain.dimension ||
+                    num_measurements != chain.num_measurements) {
+                throw Mcmc::ChainReadError(filename + " has points with "
+                        "different numbers of parameters or measurements");
+            }
+            chain.points.push_back(NewPoint(values.data(), dimension,
+                    num_measurements));
+            chain.multiplicities.push_back(multiplicity);
+        }
+    }
+
+    void ReadBinaryChain(std::string const& filename, Chain& chain) {
+        Mcmc::ChainReader reader(filename);
+        chain.dimension = reader.dimension();
+        chain.num_measurements = reader.num_measurements();
+        for (std::size_t i_row = 0; i_row < reader.num_rows(); ++i_row) {
+            Mcmc::ChainRow row = reader.row(i_row);
+            chain.points.push_back(NewPoint(row.parameters(),
+                    row.dimension(), row.num_measurements()));
+            chain.multiplicities.push_back(row.multiplicity());
+        }
+        if (reader.truncated()) {
+            printf("%s: last record is cut short, and left out\n",
+                    filename.c_str());
+        }
+    }
+
+    void ReadCompressedChain(std::string const& filename, Chain& chain) {
+        Mcmc::CompressedChainReader reader(filename, 1);
+        chain.dimension = reader.dimension();
+        chain.num_measurements = reader.num_measurements();
+        std::vector<double> records;
+        while (reader.ReadBlock(records)) {
+            for (std::size_t i = 0; i < records.size();
+                    i += reader.record_size()) {
+                chain.points.push_back(NewPoint(&records[i],
+                        reader.dimension(), reader.num_measurements()));
+                chain.multiplicities.push_back(reader.run_length_encoded() ?
+                        records[i + reader.record_size() - 1] : 1);
+            }
+        }
+        if (reader.truncated()) {
+            printf("%s: last block is cut short, and left out\n",
+                    filename.c_str());
+        }
+    }
+
+    void ReadChain(std::string const& filename, Chain& chain) {
+        // Tell the formats apart by the magic at the start of binary files
+        unsigned char header[Mcmc::ChainFileFormat::kFixedHeaderBytes] = {0};
+        {
+            std::ifstream input(filename.c_str(), std::ios::binary);
+            if (!input) {
+                throw Mcmc::ChainReadError("could not open " + filename);
+            }
+            input.read(reinterpret_cast<char*>(header), sizeof(header));
+        }
+
+        if (std::memcmp(header, Mcmc::ChainFileFormat::kMagic,
+                sizeof(Mcmc::ChainFileFormat::kMagic)) != 0) {
+            ReadTextChain(filename, chain);
+        } else if ((Mcmc::ChainFileFormat::DecodeUint32(&header[20]) &
+                Mcmc::ChainFileFormat::kCompressedFlag) != 0) {
+            ReadCompressedChain(filename, chain);
+        } else {
+            ReadBinaryChain(filename, chain);
+        }
+    }
+
+    /*
+     * Leaves out the first burn_fraction of the chain's steps.  A run that
+     * straddles the cut keeps the steps after it.
+     */
+    void CutBurnIn(double burn_fraction, Chain& chain) {
+        unsigned long num_steps = 0;
+        for (unsigned int multiplicity : chain.multiplicities) {
+            num_steps += multiplicity;
+        }
+        unsigned long num_cut = burn_fraction * num_steps;
+
+        std::size_t i_run = 0;
+        while (i_run < chain.multiplicities.size() &&
+                chain.multiplicities[i_run] <= num_cut) {
+            num_cut -= chain.multiplicities[i_run];
+            ++i_run;
+        }
+        if (i_run < chain.multiplicities.size()) {
+            chain.multiplicities[i_run] -= num_cut;
+        }
+        chain.points.erase(chain.points.begin(), chain.points.begin() + i_run);
+        chain.multiplicities.erase(chain.multiplicities.begin(),
+                chain.multiplicities.begin() + i_run);
+    }
+
+    void PrintUsage() {
+        printf("usage: chainconvert [-b burn_fraction] [-r] output_file "
+                "input_file...\n");
+    }
+
+}
@@ -0,0 +1,459 @@
+/*
+ * File:   AdaptiveGaussianProposal.cpp
+ * Author: donerkebab
+ *
+ * Created on May 6, 2014, 4:12 PM
+ */
+
+#include "AdaptiveGaussianProposal.h"
+
+#include <cmath>
+#include <cstddef>
+
+#include <array>
+#include <utility>
+
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_permutation.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_vector.h>
+
+#include "McmcScan.h"
+#include "PositiveDefiniteError.h"
+
+namespace { // unnamed namespace
+    // Number of rank-1 updates of the Cholesky decomposition between full
+    // refactorizations of the covariance matrix
+    unsigned int const kCholeskyRefreshInterval = 1000;
+
+    /*
+     * Replaces the lower triangular matrix L, in the lower triangle of
+     * cholesky, with the Cholesky decomposition of L*L^T + sign*x*x^T, where
+     * sign is +1 (update) or -1 (downdate).  The upper triangle is not touched.
+     * x is used as a workspace and is overwritten.  O(d^2).
+     *
+     * Returns false if the downdated matrix is not positive definite, in which
+     * case L is left partially updated.
+     */
+    bool CholeskyRankOneUpdate(gsl_matrix* cholesky, gsl_vector* x,
+            double sign) {
+        for (std::size_t k = 0; k < cholesky->size1; ++k) {
+            double l_kk = gsl_matrix_get(cholesky, k, k);
+            double x_k = gsl_vector_get(x, k);
+            double r_squared = l_kk * l_kk + sign * x_k * x_k;
+            if (r_squared <= 0.0) {
+                return false;
+            }
+            double r = std::sqrt(r_squared);
+            double c = r / l_kk;
+            double s = x_k / l_kk;
+            gsl_matrix_set(cholesky, k, k, r);
+
+            for (std::size_t i = k + 1; i < cholesky->size1; ++i) {
+                double l_ik = (gsl_matrix_get(cholesky, i, k) +
+                        sign * s * gsl_vector_get(x, i)) / c;
+                gsl_matrix_set(cholesky, i, k, l_ik);
+                gsl_vector_set(x, i, c * gsl_vector_get(x, i) - s * l_ik);
+            }
+        }
+        return true;
+    }
+
+    // log det(L*L^T) = 2 sum_i log L[i][i], for L in the lower triangle of
+    // cholesky.  O(d).
+    double CholeskyLogDeterminant(gsl_matrix const* cholesky) {
+        double logdet = 0.0;
+        for (std::size_t i = 0; i < cholesky->size1; ++i) {
+            logdet += 2.0 * std::log(gsl_matrix_get(cholesky, i, i));
+        }
+        return logdet;
+    }
+}
+
+namespace Mcmc {
+
+    AdaptiveGaussianProposal::AdaptiveGaussianProposal(Mcmc::McmcScan& scan)
+    : scan_(scan),
+    dimension_(scan.dimension()),
+    f_(2.381 / std::sqrt(scan.dimension())),
+    ensemble_size_(scan.num_chains()),
+    initialized_(false),
+    num_cholesky_updates_(0),
+    covariance_logdet_(0.0),
+    trial_covariance_logdet_(0.0) {
+        mean_ = gsl_vector_calloc(dimension_);
+        covariance_ = gsl_matrix_calloc(dimension_, dimension_);
+        covariance_inv_ = gsl_matrix_calloc(dimension_, dimension_);
+        covariance_cholesky_ = gsl_matrix_calloc(dimension_, dimension_);
+
+        trial_mean_ = gsl_vector_calloc(dimension_);
+        trial_covariance_ = gsl_matrix_calloc(dimension_, dimension_);
+        trial_covariance_inv_ = gsl_matrix_calloc(dimension_, dimension_);
+
+        trial_shift_ = gsl_vector_calloc(dimension_);
+        last_deviation_ = gsl_vector_calloc(dimension_);
+        for (int i = 0; i < 2; ++i) {
+            a_[i] = gsl_vector_calloc(dimension_);
+            c_inv_a_[i] = gsl_vector_calloc(dimension_);
+            c_inv_b_[i] = gsl_vector_calloc(dimension_);
+            cholesky_factors_[i] = gsl_vector_calloc(dimension_);
+        }
+        z_ = gsl_vector_calloc(dimension_);
+        temp_ = gsl_vector_calloc(dimension_);
+    }
+
+    AdaptiveGaussianProposal::~AdaptiveGaussianProposal() {
+        gsl_vector_free(mean_);
+        gsl_matrix_free(covariance_);
+        gsl_matrix_free(covariance_inv_);
+        gsl_matrix_free(covariance_cholesky_);
+
+        gsl_vector_free(trial_mean_);
+        gsl_matrix_free(trial_covariance_);
+        gsl_matrix_free(trial_covariance_inv_);
+
+        gsl_vector_free(trial_shift_);
+        gsl_vector_free(last_deviation_);
+        for (int i = 0; i < 2; ++i) {
+            gsl_vector_free(a_[i]);
+            gsl_vector_free(c_inv_a_[i]);
+            gsl_vector_free(c_inv_b_[i]);
+            gsl_vector_free(cholesky_factors_[i]);
+        }
+        gsl_vector_free(z_);
+        gsl_vector_free(temp_);
+    }
+
+    void AdaptiveGaussianProposal::Propose(unsigned int i_chain,
+            gsl_vector const* last_parameters,
+            gsl_rng* rng,
+            gsl_vector* trial_parameters) {
+        if (!initialized_) {
+            Reset();
+        }
+
+        // Keep generating trial points until we get one with valid parameters
+        do {
+            // Construct a vector of random components from a unit Gaussian
+            for (unsigned int i = 0; i < dimension_; ++i) {
+                gsl_vector_set(trial_parameters, i, gsl_ran_ugaussian(rng));
+            }
+
+            // Scale the vector with f*L to get the trial shift, where L is
+            // the Cholesky decomposition of the covariance matrix.
+            // gsl_blas_dtrmv: "matrix-vector product for the triangular
+            // matrix (5') = (4)(5)"
+            gsl_blas_dtrmv(CblasLower, CblasNoTrans, CblasNonUnit,
+                    covariance_cholesky_, trial_parameters);
+            gsl_vector_scale(trial_parameters, f_);
+
+            // Now we have the trial shift from the last point, and we need
+            // to generate the trial point itself
+            gsl_vector_add(trial_parameters, last_parameters);
+        } while (!scan_.IsValidParameters(trial_parameters));
+    }
+
+    double AdaptiveGaussianProposal::LogHastingsRatio(unsigned int i_chain,
+            gsl_vector const* last_parameters,
+            gsl_vector const* trial_parameters) {
+        TrialMeanAndCovariance(last_parameters, trial_parameters);
+
+        // Calculate the linear algebra part of the formula
+        // trial_shift^T (C'^-1 - C^-1) trial_shift, as the difference of two
+        // matrix-vector products so that no d x d temporary is needed
+        // gsl_blas_dsymv: "the matrix-vector product and sum for the symmetric
+        //                  matrix (6') = (2)(3)(4) + (5)(6)"
+        // gsl_blas_ddot: "the scalar product (3) = (1)^T (2)"
+        double linear_algebra_part;
+        gsl_blas_dsymv(CblasLower, 1.0, trial_covariance_inv_, trial_shift_,
+                0.0, temp_);
+        gsl_blas_dsymv(CblasLower, -1.0, covariance_inv_, trial_shift_, 1.0,
+                temp_);
+        gsl_blas_ddot(trial_shift_, temp_, &linear_algebra_part);
+
+        return (covariance_logdet_ - trial_covariance_logdet_) / 2.0 -
+                1.0 / (2.0 * f_ * f_) * linear_algebra_part;
+    }
+
+    void AdaptiveGaussianProposal::UpdateState(unsigned int i_chain,
+            gsl_vector const* last_parameters,
+            gsl_vector const* trial_parameters) {
+        // The Cholesky decomposition is updated from the old mean, so this
+        // has to come before the trial quantities are swapped in
+        UpdateCovarianceCholesky();
+        std::swap(mean_, trial_mean_);
+        std::swap(covariance_, trial_covariance_);
+        std::swap(covariance_inv_, trial_covariance_inv_);
+
+        // The log determinant from TrialMeanAndCovariance() is the last one
+        // plus a correction, and would drift over many steps, so take it from
+        // the Cholesky decomposition instead
+        covariance_logdet_ = CholeskyLogDeterminant(covariance_cholesky_);
+    }
+
+    gsl_vector const* AdaptiveGaussianProposal::mean() const {
+        return mean_;
+    }
+
+    gsl_matrix const* AdaptiveGaussianProposal::covariance() const {
+        return covariance_;
+    }
+
+    gsl_matrix const* AdaptiveGaussianProposal::covariance_cholesky() const {
+        return covariance_cholesky_;
+    }
+
+    void AdaptiveGaussianProposal::Reset() {
+        unsigned int num_chains = scan_.num_chains();
+
+        // Compute the vector mean
+        gsl_vector_set_zero(mean_);
+        for (unsigned int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            gsl_vector_add(mean_, scan_.last_parameters(i_chain));
+        }
+        gsl_vector_scale(mean_, 1.0 / num_chains);
+
+        // Compute the covariance matrix
+        // gsl_blas_dger: "rank-1 update (4') = (1)(2)(3)^T + (4)"
+        gsl_matrix_set_zero(covariance_);
+        for (unsigned int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            gsl_vector_memcpy(temp_, scan_.last_parameters(i_chain));
+            gsl_vector_sub(temp_, mean_);
+            gsl_blas_dger(1.0 / num_chains, temp_, temp_, covariance_);
+        }
+
+        Factor();
+    }
+
+    void AdaptiveGaussianProposal::Factor() {
+        // Compute the Cholesky decomposition and log determinant of the
+        // covariance matrix.  This also checks that the covariance matrix is
+        // positive definite.
+        RefactorCovarianceCholesky(covariance_);
+
+        // Compute the inverse of the covariance matrix
+        gsl_matrix* covariance_lu = gsl_matrix_alloc(dimension_, dimension_);
+        gsl_matrix_memcpy(covariance_lu, covariance_);
+        gsl_permutation* covariance_p = gsl_permutation_alloc(dimension_);
+        int covariance_signum;
+        gsl_linalg_LU_decomp(covariance_lu, covariance_p, &covariance_signum);
+        gsl_linalg_LU_invert(covariance_lu, covariance_p, covariance_inv_);
+
+        // Free memory for intermediates
+        gsl_matrix_free(covariance_lu);
+        gsl_permutation_free(covariance_p);
+
+        initialized_ = true;
+    }
+
+    void AdaptiveGaussianProposal::CopyState(
+            AdaptiveGaussianProposal const& other) {
+        gsl_vector_memcpy(mean_, other.mean_);
+        gsl_matrix_memcpy(covariance_, other.covariance_);
+        covariance_logdet_ = other.covariance_logdet_;
+        gsl_matrix_memcpy(covariance_inv_, other.covariance_inv_);
+        ensemble_size_ = other.ensemble_size_;
+        initialized_ = other.initialized_;
+    }
+
+    void AdaptiveGaussianProposal::TrialMeanAndCovariance(
+            gsl_vector const* last_parameters,
+            gsl_vector const* trial_parameters) {
+        // Calculate the trial shift
+        // trial_shift = trial_parameters - last_parameters
+        gsl_vector_memcpy(trial_shift_, trial_parameters);
+        gsl_vector_sub(trial_shift_, last_parameters);
+
+        // Update the vector mean
+        // mean' = mean + trial_shift/num_chains
+        // gsl_blas_daxpy: "sum (3') = (1)(2) + (3)"
+        gsl_vector_memcpy(trial_mean_, mean_);
+        gsl_blas_daxpy(1.0 / ensemble_size_, trial_shift_, trial_mean_);
+
+        // Get intermediates for the calculation of covariance matrix quantities
+        std::array<gsl_vector*, 2>& a = a_;
+        // b[0] = last_parameters - last_mean
+        // b[1] = trial_shift
+        std::array<gsl_vector*, 2> b = {{last_deviation_, trial_shift_}};
+        gsl_vector_memcpy(b[0], last_parameters);
+        gsl_vector_sub(b[0], mean_);
+        // a[0] = trial_shift/num_chains
+        gsl_vector_memcpy(a[0], trial_shift_);
+        gsl_vector_scale(a[0], 1.0 / ensemble_size_);
+        // a[1] = 1/(num_chains) * (last_parameters - last_mean +
+        //        (num_chains - 1)/num_chains * trial_shift)
+        // gsl_blas_daxpy: "sum (3') = (1)(2) + (3)"
+        gsl_vector_memcpy(a[1], b[0]);
+        gsl_blas_daxpy((ensemble_size_ - 1.0) / ensemble_size_, trial_shift_,
+                a[1]);
+        gsl_vector_scale(a[1], 1.0 / ensemble_size_);
+        // The inverse covariance matrix only ever enters through the products
+        // C^-1 a[i] and b[i]^T C^-1 = (C^-1 b[i])^T, since C^-1 is symmetric.
+        // Computing those four vectors once keeps everything below O(d^2).
+        // c_inv_a[i] = C^-1 a[i]
+        // c_inv_b[i] = C^-1 b[i]
+        // gsl_blas_dsymv: "the matrix-vector product and sum for the symmetric
+        //                  matrix (6') = (2)(3)(4) + (5)(6)"
+        for (int i = 0; i < 2; ++i) {
+            gsl_blas_dsymv(CblasLower, 1.0, covariance_inv_, a[i], 0.0,
+                    c_inv_a_[i]);
+            gsl_blas_dsymv(CblasLower, 1.0, covariance_inv_, b[i], 0.0,
+                    c_inv_b_[i]);
+        }
+        // one_plus_lambda[i,j] = I[i,j] + b[i]^T C^-1 a[j]
+        // The 2x2 matrices are views of arrays on the stack, so that they do
+        // not need to be allocated.
+        // gsl_blas_ddot: "the scalar product (3) = (1)^T (2)"
+        std::array<double, 4> one_plus_lambda_data;
+        gsl_matrix_view one_plus_lambda_view = gsl_matrix_view_array(
+                one_plus_lambda_data.data(), 2, 2);
+        gsl_matrix* one_plus_lambda = &one_plus_lambda_view.matrix;
+        double temp_double;
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                gsl_blas_ddot(b[i], c_inv_a_[j], &temp_double);
+                if (i == j) {
+                    temp_double += 1.0;
+                }
+                gsl_matrix_set(one_plus_lambda, i, j, temp_double);
+            }
+        }
+        // Determinant and inverse of one_plus_lambda
+        // Using the GSL linear algebra library requires computing the LU
+        //   decomposition, and is too heavy-handed for this application.
+        // Note that if the determinant of one_plus_lambda is zero, then the
+        //   resulting trial covariance matrix will also have determinant zero.
+        //   This occurs almost never, but in case it does, we might as well
+        //   check for it here before it is used to compute the inverse.
+        double one_plus_lambda_det = gsl_matrix_get(one_plus_lambda, 0, 0) *
+                gsl_matrix_get(one_plus_lambda, 1, 1) -
+                gsl_matrix_get(one_plus_lambda, 0, 1) *
+                gsl_matrix_get(one_plus_lambda, 1, 0);
+        if (one_plus_lambda_det <= 0.0) {
+            throw Mcmc::PositiveDefiniteError();
+        }
+        std::array<double, 4> one_plus_lambda_inv_data;
+        gsl_matrix_view one_plus_lambda_inv_view = gsl_matrix_view_array(
+                one_plus_lambda_inv_data.data(), 2, 2);
+        gsl_matrix* one_plus_lambda_inv = &one_plus_lambda_inv_view.matrix;
+        gsl_matrix_set(one_plus_lambda_inv, 0, 0,
+                gsl_matrix_get(one_plus_lambda, 1, 1) / one_plus_lambda_det);
+        gsl_matrix_set(one_plus_lambda_inv, 0, 1,
+                -1.0 * gsl_matrix_get(one_plus_lambda, 0, 1) /
+                one_plus_lambda_det);
+        gsl_matrix_set(one_plus_lambda_inv, 1, 0,
+                -1.0 * gsl_matrix_get(one_plus_lambda, 1, 0) /
+                one_plus_lambda_det);
+        gsl_matrix_set(one_plus_lambda_inv, 1, 1,
+                gsl_matrix_get(one_plus_lambda, 0, 0) / one_plus_lambda_det);
+
+        // Update the covariance matrix
+        // C' = C + a[0]*b0^T + a[1]*b[1]^T
+        // gsl_blas_dger: "the rank-1 update (4') = (1)(2)(3)^T + (4)"
+        gsl_matrix_memcpy(trial_covariance_, covariance_);
+        for (int i = 0; i < 2; ++i) {
+            gsl_blas_dger(1.0, a[i], b[i], trial_covariance_);
+        }
+
+        // Update the log determinant of the covariance matrix
+        // det(C') = det(C) * det(one_plus_lambda)
+        trial_covariance_logdet_ = covariance_logdet_ +
+                std::log(one_plus_lambda_det);
+
+        // Update the inverse of the covariance matrix (Sherman-Morrison-
+        // Woodbury formula)
+        // C'^-1 = C^-1 -
+        //         sum_i sum_j (one_plus_lambda^-1)[i][j] C^-1 a[i] b[j]^T C^-1
+        //       = C^-1 - sum_i c_inv_a[i] z[i]^T
+        // where z[i] = sum_j (one_plus_lambda^-1)[i][j] c_inv_b[j].
+        // gsl_blas_dger: "the rank-1 update (4') = (1)(2)(3)^T + (4)"
+        gsl_matrix_memcpy(trial_covariance_inv_, covariance_inv_);
+        for (int i = 0; i < 2; ++i) {
+            gsl_vector_set_zero(z_);
+            for (int j = 0; j < 2; ++j) {
+                gsl_blas_daxpy(gsl_matrix_get(one_plus_lambda_inv, i, j),
+                        c_inv_b_[j], z_);
+            }
+            gsl_blas_dger(-1.0, c_inv_a_[i], z_, trial_covariance_inv_);
+        }
+    }
+
+    void AdaptiveGaussianProposal::RefactorCovarianceCholesky(
+            gsl_matrix const* covariance) {
+        // gsl_linalg_cholesky_decomp: Cholesky decomposition of symmetric,
+        // positive-definite, square argument, only requires lower triangle.
+        // However, this returns L in the lower triangle and L^T overwritten
+        // in the upper triangle.
+        // The GSL error handler is switched off for the call, because it
+        // would otherwise abort the program if the matrix is not positive
+        // definite.
+        gsl_matrix_memcpy(covariance_cholesky_, covariance);
+        gsl_error_handler_t* old_handler = gsl_set_error_handler_off();
+        int status = gsl_linalg_cholesky_decomp(covariance_cholesky_);
+        gsl_set_error_handler(old_handler);
+        if (status != GSL_SUCCESS) {
+            throw Mcmc::PositiveDefiniteError();
+        }
+
+        covariance_logdet_ = CholeskyLogDeterminant(covariance_cholesky_);
+
+        num_cholesky_updates_ = 0;
+    }
+
+    void AdaptiveGaussianProposal::UpdateCovarianceCholesky() {
+        // Every so often, start over from the covariance matrix itself, so
+        // that rounding errors in the updates do not accumulate
+        if (num_cholesky_updates_ >= kCholeskyRefreshInterval) {
+            RefactorCovarianceCholesky(trial_covariance_);
+            return;
+        }
+
+        // The change in the covariance matrix from TrialMeanAndCovariance() is
+        //   C' - C = a[0]*b[0]^T + a[1]*b[1]^T
+        //          = [s p] K [s p]^T,  K = [[(n-1)/n^2, 1/n], [1/n, 0]]
+        // where s = trial_shift, p = last_parameters - last_mean, and
+        // n = ensemble_size_, the number of chains.  K has one positive and
+        // one negative eigenvalue, so diagonalizing it gives
+        //   C' - C = u*u^T - v*v^T
+        // which is one rank-1 update and one rank-1 downdate of L.
+        double k_00 = (ensemble_size_ - 1.0) /
+                (1.0 * ensemble_size_ * ensemble_size_);
+        double k_01 = 1.0 / ensemble_size_;
+        double root = std::sqrt(k_00 * k_00 / 4.0 + k_01 * k_01);
+        std::array<double, 2> eigenvalues = {{k_00 / 2.0 + root,
+            k_00 / 2.0 - root}};
+
+        // Eigenvector of K for eigenvalue e: (n*e, 1), normalized
+        // gsl_blas_daxpy: "sum (3') = (1)(2) + (3)"
+        for (int i = 0; i < 2; ++i) {
+            double norm = std::sqrt(std::pow(ensemble_size_ * eigenvalues[i],
+                    2) + 1.0);
+            double scale = std::sqrt(std::fabs(eigenvalues[i])) / norm;
+            gsl_vector_set_zero(cholesky_factors_[i]);
+            gsl_blas_daxpy(scale * ensemble_size_ * eigenvalues[i],
+                    trial_shift_, cholesky_factors_[i]);
+            gsl_blas_daxpy(scale, last_deviation_, cholesky_factors_[i]);
+        }
+
+        // Do the update before the downdate, so that the intermediate matrix
+        // stays positive definite
+        bool success = CholeskyRankOneUpdate(covariance_cholesky_,
+                cholesky_factors_[0], 1.0) &&
+                CholeskyRankOneUpdate(covariance_cholesky_,
+                cholesky_factors_[1], -1.0);
+
+        // If rounding made the downdate fail, L is left half-updated, so start
+        // over from the covariance matrix
+        if (!success) {
+            RefactorCovarianceCholesky(trial_covariance_);
+            return;
+        }
+
+        ++num_cholesky_updates_;
+    }
+
+}
@@ -0,0 +1,214 @@
+/* 
+ * File:   AdaptiveGaussianProposal.h
+ * Author: donerkebab
+ *
+ * The proposal policy of McmcScan's default mode, see Mcmc::McmcScan.  Trial
+ * points are drawn from a Gaussian around the chain's last point, with the
+ * covariance matrix of all chains' last points scaled by 2.38^2/d.  Since 
+ * that covariance matrix changes whenever a trial point is accepted, the 
+ * proposal is not symmetric, and the Hastings ratio comes from the trial 
+ * mean and covariance.  Accepting a trial point makes those the last 
+ * points' ones.  Trial points are redrawn until they are valid, as in the
+ * scan's other modes, so the policy never proposes an invalid one.
+ * 
+ * The policy keeps the last points' mean, covariance matrix, inverse
+ * covariance matrix, log determinant and Cholesky decomposition itself.
+ * They are computed from the scan's chains at the first Propose(), and then
+ * updated in O(d^2) whenever a trial point is accepted: the mean, covariance
+ * and inverse following Baltz, et al. (arXiv:hep-ph/0602187), and the
+ * Cholesky decomposition with a rank-1 update and a rank-1 downdate, which
+ * is recomputed from scratch every so often to wash out rounding errors.
+ * The scan keeps one of its own for its built-in modes, one for each rung
+ * of the parallel tempering ladder, and a snapshot of its own in sweep mode.
+ * 
+ * Dev notes:
+ * * The mean, covariance matrix, log determinant and inverse covariance
+ *   matrix are double-buffered.  LogHastingsRatio() fills the trial_* slots,
+ *   and UpdateState() swaps them with the last points' ones, so the old
+ *   storage becomes the next trial's, and nothing is copied or freed.
+ * * McmcScan is a friend, so that it can restore the statistics from a
+ *   checkpoint and take them over from the coordinator, and the policy is a
+ *   friend of McmcScan, so that it can call IsValidParameters().
+ * * The methods are not defined in the header: McmcScan::Step() calls them
+ *   without virtual dispatch either way, and each of them does O(d^2) work,
+ *   next to which the call costs nothing.
+ * * Copy constructor is not supported because the policy owns its GSL
+ *   objects.
+ * 
+ * Created on May 6, 2014, 4:12 PM
+ */
+
+#ifndef MCMC_ADAPTIVEGAUSSIANPROPOSAL_H
+#define	MCMC_ADAPTIVEGAUSSIANPROPOSAL_H
+
+#include <array>
+
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_vector.h>
+
+#include "McmcScan.h"
+
+// Unit test fixture, which is allowed to look at the statistics
+class McmcScanTest;
+
+namespace Mcmc {
+
+    class AdaptiveGaussianProposal {
+    public:
+        // The scan has to outlive the policy
+        explicit AdaptiveGaussianProposal(Mcmc::McmcScan& scan);
+        virtual ~AdaptiveGaussianProposal();
+
+        /*
+         * throws Mcmc::PositiveDefiniteError if the covariance matrix is not
+         * positive definite when it is first computed
+         */
+        void Propose(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_rng* rng,
+                gsl_vector* trial_parameters);
+
+        /*
+         * throws Mcmc::PositiveDefiniteError if trial covariance matrix is 
+         * not positive definite
+         */
+        double LogHastingsRatio(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_vector const* trial_parameters);
+
+        /*
+         * Must follow LogHastingsRatio() for the same trial point.  The log
+         * determinant is taken from the updated Cholesky decomposition.
+         * 
+         * throws Mcmc::PositiveDefiniteError if trial covariance matrix is 
+         * not positive definite
+         */
+        void UpdateState(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_vector const* trial_parameters);
+
+        /*
+         * Mean and covariance matrix of the chains' last points, and the
+         * Cholesky decomposition of the covariance matrix in its lower
+         * triangle.  All zero until the first Propose(), and only valid
+         * until the next UpdateState().
+         */
+        gsl_vector const* mean() const;
+        gsl_matrix const* covariance() const;
+        gsl_matrix const* covariance_cholesky() const;
+
+    private:
+        friend class Mcmc::McmcScan;
+        friend class ::McmcScanTest;
+
+        AdaptiveGaussianProposal(AdaptiveGaussianProposal const& orig);
+        void operator=(AdaptiveGaussianProposal const& orig);
+
+        /*
+         * Computes the mean and covariance matrix of the last points of the
+         * scan's chains, and factors the covariance matrix.
+         * 
+         * throws Mcmc::PositiveDefiniteError if covariance matrix is not
+         * positive definite
+         */
+        void Reset();
+
+        /*
+         * Computes the Cholesky decomposition, log determinant and inverse of
+         * the covariance matrix, after it has been set.
+         * 
+         * throws Mcmc::PositiveDefiniteError if covariance matrix is not
+         * positive definite
+         */
+        void Factor();
+
+        /*
+         * Copies the mean, covariance matrix, log determinant, inverse
+         * covariance matrix and ensemble size from other, which must have
+         * the same dimension, for LogHastingsRatio().  The Cholesky
+         * decomposition is left alone.  O(d^2).
+         */
+        void CopyState(AdaptiveGaussianProposal const& other);
+
+        /*
+         * Calculates the mean and covariance if the trial point were to be
+         * accepted.  Stores them in the trial_* slots.
+         * 
+         * Done by updating the last points' quantities with the new trial
+         * point, without having to recalculate them from scratch.
+         * 
+         * Inputs: last_parameters, trial_parameters
+         * Outputs: trial_mean_, trial_covariance_, trial_covariance_logdet_,
+         *          trial_covariance_inv_, trial_shift_, last_deviation_
+         * 
+         * throws Mcmc::PositiveDefiniteError if trial covariance matrix is not
+         * positive definite
+         */
+        void TrialMeanAndCovariance(gsl_vector const* last_parameters,
+                gsl_vector const* trial_parameters);
+
+        /*
+         * Recomputes the Cholesky decomposition and log determinant of the
+         * last points' covariance matrix from scratch, for the given
+         * covariance matrix.  O(d^3).
+         * 
+         * throws Mcmc::PositiveDefiniteError if the covariance matrix is not
+         * positive definite
+         */
+        void RefactorCovarianceCholesky(gsl_matrix const* covariance);
+
+        /*
+         * Brings the Cholesky decomposition up to date after the trial point
+         * is accepted, with a rank-1 update and a rank-1 downdate.  O(d^2).
+         * Uses the trial shift and last deviation left by
+         * TrialMeanAndCovariance(), and must be called before the trial
+         * quantities are swapped in.  Falls back to
+         * RefactorCovarianceCholesky() on the trial covariance matrix if the
+         * downdate fails, and periodically to wash out rounding errors.
+         * 
+         * throws Mcmc::PositiveDefiniteError if trial covariance matrix is not
+         * positive definite
+         */
+        void UpdateCovarianceCholesky();
+
+        Mcmc::McmcScan& scan_;
+        unsigned int const dimension_;
+        // Scale of the trial shifts
+        double const f_;
+        // Number of chains the statistics are over, which is the scan's
+        // number of chains unless the scan is distributed
+        unsigned int ensemble_size_;
+        // Whether the statistics have been computed yet
+        bool initialized_;
+        unsigned int num_cholesky_updates_;
+
+        // Mean, covariance and inverse covariance of the chains' last points
+        gsl_vector* mean_;
+        gsl_matrix* covariance_;
+        double covariance_logdet_;
+        gsl_matrix* covariance_inv_;
+        // Only the lower triangle is kept up to date
+        gsl_matrix* covariance_cholesky_;
+
+        // The same quantities if the trial point were to be accepted
+        gsl_vector* trial_mean_;
+        gsl_matrix* trial_covariance_;
+        double trial_covariance_logdet_;
+        gsl_matrix* trial_covariance_inv_;
+
+        // Scratch space for TrialMeanAndCovariance(), LogHastingsRatio() and
+        // UpdateCovarianceCholesky()
+        gsl_vector* trial_shift_;
+        gsl_vector* last_deviation_;
+        std::array<gsl_vector*, 2> a_;
+        std::array<gsl_vector*, 2> c_inv_a_;
+        std::array<gsl_vector*, 2> c_inv_b_;
+        gsl_vector* z_;
+        gsl_vector* temp_;
+        std::array<gsl_vector*, 2> cholesky_factors_;
+    };
+
+}
+
+#endif	/* MCMC_ADAPTIVEGAUSSIANPROPOSAL_H */
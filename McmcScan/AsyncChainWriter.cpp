@@ -0,0 +1,128 @@
+/*
+ * File:   AsyncChainWriter.cpp
+ * Author: donerkebab
+ *
+ * Created on April 30, 2014, 10:05 PM
+ */
+
+#include "AsyncChainWriter.h"
+
+#include <cstdio>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ChainFlushError.h"
+#include "ChainWriter.h"
+#include "OutputThread.h"
+#include "Point.h"
+
+namespace { // unnamed namespace
+    // Checks the wrapped writer before the base class constructor needs it
+    Mcmc::ChainWriter const& NonNull(
+            std::unique_ptr<Mcmc::ChainWriter> const& writer) {
+        if (writer.get() == nullptr) {
+            throw std::invalid_argument("null writer");
+        }
+        return *writer;
+    }
+}
+
+namespace Mcmc {
+
+    AsyncChainWriter::AsyncChainWriter(
+            std::unique_ptr<Mcmc::ChainWriter> writer,
+            std::shared_ptr<Mcmc::OutputThread> output_thread)
+    : ChainWriter(NonNull(writer).filename(),
+            NonNull(writer).run_length_encoded()),
+    writer_(std::move(writer)),
+    output_thread_(output_thread),
+    write_in_progress_(false),
+    write_failed_(false) {
+        if (output_thread.get() == nullptr) {
+            throw std::invalid_argument("null output thread");
+        }
+    }
+
+    AsyncChainWriter::~AsyncChainWriter() {
+        try {
+            Sync();
+        } catch (Mcmc::ChainFlushError& e) {
+            std::printf("Error writing the last points of %s, %u runs lost\n",
+                    filename().c_str(), 
+                    static_cast<unsigned int>(pending_points_.size()));
+        }
+    }
+
+    void AsyncChainWriter::Write(std::shared_ptr<Mcmc::Point> const* points,
+            unsigned int const* multiplicities,
+            unsigned int num_runs) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (write_in_progress_) {
+            write_done_.wait(lock);
+        }
+
+        if (write_failed_) {
+            write_failed_ = false;
+            Submit();
+            throw Mcmc::ChainFlushError();
+        }
+
+        pending_points_.assign(points, points + num_runs);
+        pending_multiplicities_.assign(multiplicities,
+                multiplicities + num_runs);
+        Submit();
+    }
+
+    void AsyncChainWriter::Sync() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (write_in_progress_) {
+            write_done_.wait(lock);
+        }
+
+        if (write_failed_) {
+            writer_->Write(pending_points_.data(),
+                    pending_multiplicities_.data(), pending_points_.size());
+            write_failed_ = false;
+            pending_points_.clear();
+            pending_multiplicities_.clear();
+        }
+        writer_->Sync();
+    }
+
+    void AsyncChainWriter::Submit() {
+        write_in_progress_ = true;
+        output_thread_->Submit([this]() {
+            WritePending();
+        });
+    }
+
+    void AsyncChainWriter::WritePending() {
+        bool failed = false;
+        try {
+            writer_->Write(pending_points_.data(),
+                    pending_multiplicities_.data(), pending_points_.size());
+        } catch (...) {
+            failed = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!failed) {
+                // Let go of the points right away, rather than at the next
+                // Write()
+                pending_points_.clear();
+                pending_multiplicities_.clear();
+            }
+            write_failed_ = failed;
+            write_in_progress_ = false;
+        }
+        write_done_.notify_all();
+    }
+
+}
@@ -0,0 +1,105 @@
+/*
+ * File:   AsyncChainWriter.h
+ * Author: donerkebab
+ *
+ * Wraps another ChainWriter, and has it write on a Mcmc::OutputThread instead
+ * of in the caller's thread, so that a chain flush in the sampling loop only
+ * costs a copy of the buffered shared_ptr objects.
+ *
+ * The handoff is double-buffered: the chain fills its own buffer while the
+ * points of its last flush are being written in the background.  Write() only
+ * blocks if the last flush of the same chain has not been written yet, which
+ * only happens if the disk cannot keep up.
+ *
+ * If a background write fails, the points stay with the writer, and the next
+ * Write() throws Mcmc::ChainFlushError without taking any new points, and 
+ * queues the failed points again.  As far as the chain can tell, this is just 
+ * a flush that failed, so it keeps its points and tries again later, and no 
+ * points are lost or reordered.
+ *
+ * The destructor waits until everything has been written.  If the last write
+ * fails, it tries once more in the calling thread, and prints a message if 
+ * that fails too.
+ *
+ * Dev notes:
+ * * The shared_ptr objects are copied, not the points, so the memory cost of
+ *   the second buffer is small.
+ * * The wrapped writer is only ever used by one thread at a time.
+ *
+ * Created on April 30, 2014, 10:05 PM
+ */
+
+#ifndef MCMC_ASYNCCHAINWRITER_H
+#define	MCMC_ASYNCCHAINWRITER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ChainWriter.h"
+#include "OutputThread.h"
+#include "Point.h"
+
+namespace Mcmc {
+
+    class AsyncChainWriter : public ChainWriter {
+    public:
+        /*
+         * Takes over writer.  The filename and run-length encoding are those
+         * of writer.
+         * 
+         * throws std::invalid_argument if writer or output_thread is null
+         */
+        AsyncChainWriter(std::unique_ptr<Mcmc::ChainWriter> writer,
+                std::shared_ptr<Mcmc::OutputThread> output_thread);
+        virtual ~AsyncChainWriter();
+
+        /*
+         * Copies the runs, queues them to be written, and returns.
+         * 
+         * throws Mcmc::ChainFlushError if the last background write failed,
+         * in which case the new points are not taken
+         */
+        void Write(std::shared_ptr<Mcmc::Point> const* points,
+                unsigned int const* multiplicities,
+                unsigned int num_runs);
+
+        /*
+         * Waits for the background write, and then syncs the wrapped writer.
+         * If the background write failed, retries it in the calling thread.
+         * 
+         * throws Mcmc::ChainFlushError if output file cannot be written
+         */
+        void Sync();
+
+    private:
+        /*
+         * Queues the pending points on the output thread.  mutex_ must be
+         * held.
+         */
+        void Submit();
+
+        /*
+         * Runs on the output thread.
+         */
+        void WritePending();
+
+        std::unique_ptr<Mcmc::ChainWriter> const writer_;
+        std::shared_ptr<Mcmc::OutputThread> const output_thread_;
+
+        std::mutex mutex_;
+        std::condition_variable write_done_;
+
+        // All guarded by mutex_.  The pending points are only touched by the 
+        // output thread while write_in_progress_ is set.
+        bool write_in_progress_;
+        bool write_failed_;
+        std::vector<std::shared_ptr<Mcmc::Point> > pending_points_;
+        std::vector<unsigned int> pending_multiplicities_;
+    };
+
+}
+
+#endif	/* MCMC_ASYNCCHAINWRITER_H */
+
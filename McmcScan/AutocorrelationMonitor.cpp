@@ -0,0 +1,234 @@
+/*
+ * File:   AutocorrelationMonitor.cpp
+ * Author: donerkebab
+ *
+ * Created on May 5, 2014, 10:20 AM
+ */
+
+#include "AutocorrelationMonitor.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+namespace Mcmc {
+
+    AutocorrelationMonitor::AutocorrelationMonitor(unsigned int num_chains,
+            unsigned int dimension,
+            unsigned int min_batches)
+    : num_chains_(num_chains),
+    dimension_(dimension),
+    min_batches_(min_batches),
+    num_points_(num_chains, 0),
+    batch_sizes_(num_chains, 1),
+    num_batches_(num_chains, 0),
+    means_(num_chains * dimension, 0.0),
+    sum_squares_(num_chains * dimension, 0.0),
+    partial_sums_(num_chains * dimension, 0.0),
+    batch_sums_(num_chains * 2 * min_batches * dimension, 0.0) {
+        if (num_chains == 0) {
+            throw std::invalid_argument("need at least one chain");
+        }
+        if (dimension == 0) {
+            throw std::invalid_argument("cannot have zero dimension");
+        }
+        if (min_batches < 2) {
+            throw std::invalid_argument("need at least two batches");
+        }
+    }
+
+    AutocorrelationMonitor::~AutocorrelationMonitor() {
+    }
+
+    unsigned int AutocorrelationMonitor::num_chains() const {
+        return num_chains_;
+    }
+
+    unsigned int AutocorrelationMonitor::dimension() const {
+        return dimension_;
+    }
+
+    unsigned int AutocorrelationMonitor::min_batches() const {
+        return min_batches_;
+    }
+
+    unsigned long AutocorrelationMonitor::num_points(unsigned int i_chain)
+    const {
+        return num_points_.at(i_chain);
+    }
+
+    unsigned long AutocorrelationMonitor::batch_size(unsigned int i_chain)
+    const {
+        return batch_sizes_.at(i_chain);
+    }
+
+    void AutocorrelationMonitor::Add(unsigned int i_chain,
+            gsl_vector const* parameters) {
+        if (i_chain >= num_chains_) {
+            throw std::invalid_argument("no such chain");
+        }
+        if (parameters->size != dimension_) {
+            throw std::invalid_argument("parameters have the wrong size");
+        }
+
+        // Welford's update of the mean and the sum of squared deviations
+        unsigned long n = ++num_points_[i_chain];
+        double* mean = &means_[i_chain * dimension_];
+        double* sum_squares = &sum_squares_[i_chain * dimension_];
+        double* partial_sum = &partial_sums_[i_chain * dimension_];
+        for (unsigned int i = 0; i < dimension_; ++i) {
+            double x = gsl_vector_get(parameters, i);
+            double delta = x - mean[i];
+            mean[i] += delta / n;
+            sum_squares[i] += delta * (x - mean[i]);
+            partial_sum[i] += x;
+        }
+
+        // Close the batch once it is full
+        unsigned long& batch_size = batch_sizes_[i_chain];
+        unsigned int& num_batches = num_batches_[i_chain];
+        if (n - num_batches * batch_size < batch_size) {
+            return;
+        }
+        double* batch_sums = &batch_sums_[i_chain * 2 * min_batches_ *
+                dimension_];
+        for (unsigned int i = 0; i < dimension_; ++i) {
+            batch_sums[num_batches * dimension_ + i] = partial_sum[i];
+            partial_sum[i] = 0.0;
+        }
+        ++num_batches;
+
+        // Merge the batches in pairs once there is no room for another
+        if (num_batches == 2 * min_batches_) {
+            for (unsigned int i_batch = 0; i_batch < min_batches_;
+                    ++i_batch) {
+                for (unsigned int i = 0; i < dimension_; ++i) {
+                    batch_sums[i_batch * dimension_ + i] =
+                            batch_sums[2 * i_batch * dimension_ + i] +
+                            batch_sums[(2 * i_batch + 1) * dimension_ + i];
+                }
+            }
+            num_batches = min_batches_;
+            batch_size *= 2;
+        }
+    }
+
+    bool AutocorrelationMonitor::ready(unsigned int i_chain) const {
+        return num_batches_.at(i_chain) >= min_batches_;
+    }
+
+    bool AutocorrelationMonitor::ready() const {
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            if (!ready(i_chain)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double AutocorrelationMonitor::AutocorrelationTime(unsigned int i_chain,
+            unsigned int i) const {
+        if (i_chain >= num_chains_ || i >= dimension_) {
+            throw std::out_of_range("no such chain or parameter");
+        }
+        if (!ready(i_chain)) {
+            throw std::logic_error("not enough batches yet");
+        }
+
+        unsigned int num_batches = num_batches_[i_chain];
+        double batch_size = batch_sizes_[i_chain];
+        double const* batch_sums = &batch_sums_[i_chain * 2 * min_batches_ *
+                dimension_];
+
+        // Welford again, over the batch means
+        double batch_mean = 0.0;
+        double batch_sum_squares = 0.0;
+        for (unsigned int i_batch = 0; i_batch < num_batches; ++i_batch) {
+            double x = batch_sums[i_batch * dimension_ + i] / batch_size;
+            double delta = x - batch_mean;
+            batch_mean += delta / (i_batch + 1);
+            batch_sum_squares += delta * (x - batch_mean);
+        }
+
+        double variance = sum_squares_[i_chain * dimension_ + i] /
+                (num_points_[i_chain] - 1);
+        if (!(variance > 0.0)) {
+            return std::numeric_limits<double>::infinity();
+        }
+        return batch_size * batch_sum_squares / (num_batches - 1) / variance;
+    }
+
+    double AutocorrelationMonitor::EffectiveSampleSize(unsigned int i_chain,
+            unsigned int i) const {
+        // An infinite autocorrelation time gives zero
+        return num_points_.at(i_chain) / AutocorrelationTime(i_chain, i);
+    }
+
+    double AutocorrelationMonitor::ComputeEffectiveSampleSizes(
+            std::vector<double>& sample_sizes) const {
+        if (!ready()) {
+            throw std::logic_error("not enough batches yet");
+        }
+
+        sample_sizes.assign(dimension_, 0.0);
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            for (unsigned int i = 0; i < dimension_; ++i) {
+                sample_sizes[i] += EffectiveSampleSize(i_chain, i);
+            }
+        }
+
+        double min_sample_size = std::numeric_limits<double>::infinity();
+        for (unsigned int i = 0; i < dimension_; ++i) {
+            if (sample_sizes[i] < min_sample_size) {
+                min_sample_size = sample_sizes[i];
+            }
+        }
+        return min_sample_size;
+    }
+
+    void AutocorrelationMonitor::GetState(std::vector<unsigned long>& counts,
+            std::vector<double>& sums) const {
+        counts.assign(num_points_.begin(), num_points_.end());
+        counts.insert(counts.end(), batch_sizes_.begin(), batch_sizes_.end());
+        counts.insert(counts.end(), num_batches_.begin(), num_batches_.end());
+        sums.assign(means_.begin(), means_.end());
+        sums.insert(sums.end(), sum_squares_.begin(), sum_squares_.end());
+        sums.insert(sums.end(), partial_sums_.begin(), partial_sums_.end());
+        sums.insert(sums.end(), batch_sums_.begin(), batch_sums_.end());
+    }
+
+    void AutocorrelationMonitor::SetState(
+            std::vector<unsigned long> const& counts,
+            std::vector<double> const& sums) {
+        if (counts.size() != 3 * num_chains_ ||
+                sums.size() != 3 * means_.size() + batch_sums_.size()) {
+            throw std::invalid_argument("state has the wrong size");
+        }
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            if (counts[num_chains_ + i_chain] == 0 ||
+                    counts[2 * num_chains_ + i_chain] > 2 * min_batches_) {
+                throw std::invalid_argument("invalid state");
+            }
+        }
+
+        std::vector<unsigned long>::const_iterator count = counts.begin();
+        std::copy(count, count + num_chains_, num_points_.begin());
+        count += num_chains_;
+        std::copy(count, count + num_chains_, batch_sizes_.begin());
+        count += num_chains_;
+        std::copy(count, count + num_chains_, num_batches_.begin());
+        std::vector<double>::const_iterator sum = sums.begin();
+        std::copy(sum, sum + means_.size(), means_.begin());
+        sum += means_.size();
+        std::copy(sum, sum + sum_squares_.size(), sum_squares_.begin());
+        sum += sum_squares_.size();
+        std::copy(sum, sum + partial_sums_.size(), partial_sums_.begin());
+        sum += partial_sums_.size();
+        std::copy(sum, sums.end(), batch_sums_.begin());
+    }
+
+}
+
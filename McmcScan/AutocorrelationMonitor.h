@@ -0,0 +1,137 @@
+/*
+ * File:   AutocorrelationMonitor.h
+ * Author: donerkebab
+ *
+ * Estimates the integrated autocorrelation time of each parameter in each
+ * chain, and from it the effective sample size, i.e. the number of 
+ * independent points the chain is worth.  McmcScan feeds it every point 
+ * appended to a chain after the burn-in, so that a scan can be sized by how
+ * many independent points it produced instead of by its step count.
+ *
+ * The estimate uses batch means: the trace of a chain is cut into
+ * consecutive batches of b points, and with s_b^2 the variance of the batch
+ * means and s^2 the variance of the points,
+ *   tau = b s_b^2 / s^2
+ *   ESS = n / tau
+ * for n points.  For batches much longer than tau, the batch means are
+ * nearly independent and s_b^2 approaches tau s^2 / b.
+ *
+ * The batches are kept at a fixed memory cost: there are between min_batches
+ * and 2 min_batches of them.  Whenever there would be more, neighbouring 
+ * batches are merged in pairs and b doubles, so b grows in proportion to n.
+ * The estimate is therefore only trustworthy once n is much larger than 
+ * min_batches times tau; before that it comes out too small.
+ *
+ * Dev notes:
+ * * Adding a point is O(d), plus an O(min_batches d) merge every time the 
+ *   number of points doubles, and never allocates.
+ * * The variance of the points is accumulated with Welford's algorithm.  The
+ *   points of the last, unfinished batch count towards it, but not towards
+ *   the batch means.
+ * * Copy constructor is not supported because there is no need for it.
+ *
+ * Created on May 5, 2014, 10:20 AM
+ */
+
+#ifndef MCMC_AUTOCORRELATIONMONITOR_H
+#define	MCMC_AUTOCORRELATIONMONITOR_H
+
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+namespace Mcmc {
+
+    class AutocorrelationMonitor {
+    public:
+        /*
+         * throws std::invalid_argument if num_chains or dimension is zero, or
+         * min_batches is less than two
+         */
+        AutocorrelationMonitor(unsigned int num_chains,
+                unsigned int dimension,
+                unsigned int min_batches = 32);
+        virtual ~AutocorrelationMonitor();
+
+        unsigned int num_chains() const;
+        unsigned int dimension() const;
+        unsigned int min_batches() const;
+        // Number of points added to chain i_chain
+        unsigned long num_points(unsigned int i_chain) const;
+        // Current batch length of chain i_chain
+        unsigned long batch_size(unsigned int i_chain) const;
+
+        /*
+         * Adds a point of chain i_chain.
+         *
+         * throws std::invalid_argument if i_chain is out of range, or
+         * parameters has the wrong size
+         */
+        void Add(unsigned int i_chain, gsl_vector const* parameters);
+
+        /*
+         * Whether chain i_chain, or every chain, has at least min_batches
+         * complete batches, so that the estimates are defined.
+         */
+        bool ready(unsigned int i_chain) const;
+        bool ready() const;
+
+        /*
+         * Integrated autocorrelation time and effective sample size of 
+         * parameter i in chain i_chain.  A parameter that has not moved at
+         * all has an autocorrelation time of infinity, and an effective 
+         * sample size of zero.
+         *
+         * throws std::out_of_range if i_chain or i is out of range
+         *
+         * throws std::logic_error if not ready(i_chain)
+         */
+        double AutocorrelationTime(unsigned int i_chain, unsigned int i) const;
+        double EffectiveSampleSize(unsigned int i_chain, unsigned int i) const;
+
+        /*
+         * Puts the effective sample size of each parameter, summed over the
+         * chains, in sample_sizes, and returns the smallest.
+         *
+         * throws std::logic_error if not ready()
+         */
+        double ComputeEffectiveSampleSizes(std::vector<double>& sample_sizes)
+        const;
+
+        /*
+         * The accumulated counts and sums of every chain, e.g. for a 
+         * checkpoint.  SetState() carries on from the state that GetState()
+         * gave for a monitor of the same sizes.
+         * 
+         * SetState() throws std::invalid_argument if counts or sums do not 
+         * fit this monitor, and leaves it as it was
+         */
+        void GetState(std::vector<unsigned long>& counts,
+                std::vector<double>& sums) const;
+        void SetState(std::vector<unsigned long> const& counts,
+                std::vector<double> const& sums);
+
+    private:
+        AutocorrelationMonitor(AutocorrelationMonitor const& orig);
+        void operator=(AutocorrelationMonitor const& orig);
+
+        unsigned int const num_chains_;
+        unsigned int const dimension_;
+        unsigned int const min_batches_;
+
+        // Per chain; means_, sum_squares_ and partial_sums_ hold dimension_
+        // values per chain, and batch_sums_ holds 2 min_batches_ batches of 
+        // dimension_ values per chain
+        std::vector<unsigned long> num_points_;
+        std::vector<unsigned long> batch_sizes_;
+        std::vector<unsigned int> num_batches_;
+        std::vector<double> means_;
+        std::vector<double> sum_squares_;
+        std::vector<double> partial_sums_;
+        std::vector<double> batch_sums_;
+    };
+
+}
+
+#endif	/* MCMC_AUTOCORRELATIONMONITOR_H */
+
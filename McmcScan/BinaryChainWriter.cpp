@@ -0,0 +1,218 @@
+/*
+ * File:   BinaryChainWriter.cpp
+ * Author: donerkebab
+ *
+ * Created on April 29, 2014, 6:25 PM
+ */
+
+#include "BinaryChainWriter.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+#include "ChainFileFormat.h"
+#include "ChainFlushError.h"
+#include "ChainWriter.h"
+#include "Point.h"
+
+namespace { // unnamed namespace
+    // throws Mcmc::ChainFlushError if the file cannot be opened
+    std::FILE* OpenForAppending(std::string const& filename) {
+        std::FILE* file = std::fopen(filename.c_str(), "ab");
+        if (file == nullptr) {
+            throw Mcmc::ChainFlushError();
+        }
+        return file;
+    }
+}
+
+namespace Mcmc {
+
+    BinaryChainWriter::BinaryChainWriter(std::string filename,
+            unsigned int dimension,
+            unsigned int num_measurements,
+            std::string metadata)
+    : BinaryChainWriter(filename, dimension, num_measurements, metadata,
+            false) {
+    }
+
+    BinaryChainWriter::BinaryChainWriter(std::string filename,
+            unsigned int dimension,
+            unsigned int num_measurements,
+            std::string metadata,
+            bool run_length_encoded)
+    : BinaryChainWriter(filename, dimension, num_measurements, metadata,
+            run_length_encoded, 0) {
+    }
+
+    BinaryChainWriter::BinaryChainWriter(std::string filename,
+            unsigned int dimension,
+            unsigned int num_measurements,
+            std::string metadata,
+            bool run_length_encoded,
+            std::uint32_t extra_flags)
+    : ChainWriter(filename, run_length_encoded),
+    dimension_(dimension),
+    num_measurements_(num_measurements),
+    flags_(extra_flags | (run_length_encoded ?
+            ChainFileFormat::kRunLengthEncodedFlag : 0)),
+    output_file_(OpenForAppending(filename)) {
+        try {
+            if (dimension == 0) {
+                throw std::invalid_argument("cannot have zero dimension");
+            }
+
+            std::fseek(output_file_, 0, SEEK_END);
+            if (std::ftell(output_file_) == 0) {
+                WriteHeader(metadata);
+            } else {
+                CheckHeader();
+            }
+        } catch (...) {
+            std::fclose(output_file_);
+            throw;
+        }
+    }
+
+    BinaryChainWriter::~BinaryChainWriter() {
+        std::fclose(output_file_);
+    }
+
+    unsigned int BinaryChainWriter::dimension() const {
+        return dimension_;
+    }
+
+    unsigned int BinaryChainWriter::num_measurements() const {
+        return num_measurements_;
+    }
+
+    std::size_t BinaryChainWriter::record_bytes() const {
+        unsigned int num_columns = dimension_ + num_measurements_ + 1;
+        if (run_length_encoded()) {
+            ++num_columns;
+        }
+        return num_columns * sizeof(double);
+    }
+
+    void BinaryChainWriter::Write(std::shared_ptr<Mcmc::Point> const* points,
+            unsigned int const* multiplicities,
+            unsigned int num_runs) {
+        unsigned int num_records = 0;
+        for (unsigned int i_run = 0; i_run < num_runs; ++i_run) {
+            num_records += run_length_encoded() ? 1 : multiplicities[i_run];
+        }
+
+        // Pack everything first, so that a bad point leaves the file alone
+        records_.resize(num_records * record_bytes());
+        unsigned char* record = records_.data();
+        for (unsigned int i_run = 0; i_run < num_runs; ++i_run) {
+            Mcmc::Point const* point = points[i_run].get();
+            unsigned char* first_record = record;
+            gsl_vector const* parameters = point->parameters();
+            gsl_vector const* measurements = point->measurements();
+            if (parameters->size != dimension_ ||
+                    measurements->size != num_measurements_) {
+                throw std::invalid_argument("point does not match the chain "
+                        "file's dimension and number of measurements");
+            }
+
+            for (unsigned int i = 0; i < dimension_; ++i) {
+                ChainFileFormat::EncodeDouble(gsl_vector_get(parameters, i),
+                        record);
+                record += sizeof(double);
+            }
+            for (unsigned int i = 0; i < num_measurements_; ++i) {
+                ChainFileFormat::EncodeDouble(gsl_vector_get(measurements, i),
+                        record);
+                record += sizeof(double);
+            }
+            ChainFileFormat::EncodeDouble(point->likelihood(), record);
+            record += sizeof(double);
+
+            if (run_length_encoded()) {
+                ChainFileFormat::EncodeDouble(multiplicities[i_run], record);
+                record += sizeof(double);
+            } else {
+                // Further copies of the same record
+                for (unsigned int i_copy = 1; i_copy < multiplicities[i_run];
+                        ++i_copy) {
+                    std::memcpy(record, first_record, record_bytes());
+                    record += record_bytes();
+                }
+            }
+        }
+
+        WriteRecords(records_.data(), records_.size(), num_records);
+    }
+
+    std::FILE* BinaryChainWriter::output_file() const {
+        return output_file_;
+    }
+
+    void BinaryChainWriter::WriteRecords(unsigned char const* records,
+            std::size_t num_bytes,
+            unsigned int num_records) {
+        if (std::fwrite(records, 1, num_bytes, output_file_) != num_bytes ||
+                std::fflush(output_file_) != 0) {
+            std::clearerr(output_file_);
+            throw Mcmc::ChainFlushError();
+        }
+    }
+
+    void BinaryChainWriter::WriteHeader(std::string const& metadata) {
+        std::size_t header_bytes = ChainFileFormat::kFixedHeaderBytes +
+                metadata.size();
+        header_bytes = (header_bytes + 7) / 8 * 8;
+
+        std::vector<unsigned char> header(header_bytes, 0);
+        std::memcpy(&header[0], ChainFileFormat::kMagic,
+                sizeof(ChainFileFormat::kMagic));
+        ChainFileFormat::EncodeUint32(header_bytes, &header[8]);
+        ChainFileFormat::EncodeUint32(dimension_, &header[12]);
+        ChainFileFormat::EncodeUint32(num_measurements_, &header[16]);
+        ChainFileFormat::EncodeUint32(flags_, &header[20]);
+        ChainFileFormat::EncodeUint32(metadata.size(), &header[24]);
+        std::memcpy(&header[ChainFileFormat::kFixedHeaderBytes],
+                metadata.data(), metadata.size());
+
+        if (std::fwrite(header.data(), 1, header.size(), output_file_) !=
+                header.size() || std::fflush(output_file_) != 0) {
+            throw Mcmc::ChainFlushError();
+        }
+    }
+
+    void BinaryChainWriter::CheckHeader() {
+        std::FILE* input_file = std::fopen(filename().c_str(), "rb");
+        if (input_file == nullptr) {
+            throw Mcmc::ChainFlushError();
+        }
+        unsigned char header[ChainFileFormat::kFixedHeaderBytes];
+        std::size_t num_read = std::fread(header, 1, sizeof(header),
+                input_file);
+        std::fclose(input_file);
+
+        if (num_read != sizeof(header) ||
+                std::memcmp(header, ChainFileFormat::kMagic,
+                sizeof(ChainFileFormat::kMagic)) != 0) {
+            throw std::invalid_argument("existing output file is not a "
+                    "binary chain file");
+        }
+        if (ChainFileFormat::DecodeUint32(&header[12]) != dimension_ ||
+                ChainFileFormat::DecodeUint32(&header[16]) !=
+                num_measurements_ ||
+                ChainFileFormat::DecodeUint32(&header[20]) != flags_) {
+            throw std::invalid_argument("existing output file has a "
+                    "different record layout");
+        }
+    }
+
+}
@@ -0,0 +1,148 @@
+/*
+ * File:   BinaryChainWriter.h
+ * Author: donerkebab
+ *
+ * Writes chain points in a compact binary format, which is much faster to
+ * read back than text, and exact.  The file is a header followed by one
+ * fixed-width record per point, so it can be appended to, and memory-mapped
+ * by Mcmc::ChainReader.
+ *
+ * All numbers are little-endian, whatever the machine.  Header layout, with
+ * byte offsets:
+ *   0  char[8]  magic "MCMCCHN1", where the last character is the version
+ *   8  uint32   header size in bytes, including the metadata and padding
+ *  12  uint32   dimension d, i.e. number of parameters per point
+ *  16  uint32   number of measurements m per point
+ *  20  uint32   flags: bit 0 set if run-length encoded, bit 1 set if the
+ *               records are in compressed blocks, others reserved
+ *  24  uint32   metadata size in bytes
+ *  28  char[]   metadata, free-form text supplied by the user
+ * The header is padded with zeros to a multiple of 8 bytes, so that the
+ * records that follow are aligned for memory mapping.
+ *
+ * Each record holds d + m + 1 IEEE 754 doubles: the parameters, then the
+ * measurements, then the likelihood.  When run-length encoded, each record 
+ * stands for a run of the same point, and has one more double at the end, the
+ * multiplicity.  (A double rather than an integer, so that all of the columns
+ * have the same type.)
+ *
+ * When the writer is constructed on an empty file, it writes the header.  On
+ * a file that already holds a header, e.g. when a scan resumes from a
+ * checkpoint, it checks the header against the dimension and measurement
+ * count and run-length encoding instead, and leaves the existing metadata 
+ * alone.
+ *
+ * The constants of the format live in ChainFileFormat.h.  Subclasses may 
+ * change how the packed records are stored by overriding WriteRecords(), as
+ * Mcmc::CompressedChainWriter does.
+ * 
+ * Dev notes:
+ * * All points of a chain must have the same number of measurements, unlike
+ *   with the text format.
+ * * Each Write() packs all of the records into one memory buffer and writes it
+ *   in one go, to the output file that the writer keeps open.
+ *
+ * Created on April 29, 2014, 6:25 PM
+ */
+
+#ifndef MCMC_BINARYCHAINWRITER_H
+#define	MCMC_BINARYCHAINWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ChainWriter.h"
+#include "Point.h"
+
+namespace Mcmc {
+
+    class BinaryChainWriter : public ChainWriter {
+    public:
+        /*
+         * throws std::invalid_argument if filename is empty, dimension is
+         * zero, or the file already holds something other than a header for
+         * the same dimension, number of measurements and run-length encoding
+         *
+         * throws Mcmc::ChainFlushError if output file cannot be opened
+         */
+        BinaryChainWriter(std::string filename,
+                unsigned int dimension,
+                unsigned int num_measurements,
+                std::string metadata);
+        // As above, optionally run-length encoded
+        BinaryChainWriter(std::string filename,
+                unsigned int dimension,
+                unsigned int num_measurements,
+                std::string metadata,
+                bool run_length_encoded);
+        virtual ~BinaryChainWriter();
+
+        unsigned int dimension() const;
+        unsigned int num_measurements() const;
+        std::size_t record_bytes() const;
+
+        /*
+         * throws std::invalid_argument if a point does not have the right
+         * number of parameters and measurements, in which case nothing is
+         * written
+         *
+         * throws Mcmc::ChainFlushError if output file cannot be written
+         */
+        void Write(std::shared_ptr<Mcmc::Point> const* points,
+                unsigned int const* multiplicities,
+                unsigned int num_runs);
+
+    protected:
+        /*
+         * For subclasses, which set extra header flags for their own format.
+         * Throws as above.
+         */
+        BinaryChainWriter(std::string filename,
+                unsigned int dimension,
+                unsigned int num_measurements,
+                std::string metadata,
+                bool run_length_encoded,
+                std::uint32_t extra_flags);
+
+        std::FILE* output_file() const;
+
+        /*
+         * Stores num_records packed records, num_bytes in all, at the end of
+         * the output file, and flushes the stdio buffer.  By default, writes
+         * them as they are.
+         * 
+         * throws Mcmc::ChainFlushError if output file cannot be written
+         */
+        virtual void WriteRecords(unsigned char const* records,
+                std::size_t num_bytes,
+                unsigned int num_records);
+
+    private:
+        /*
+         * Writes the header to the (empty) output file.
+         */
+        void WriteHeader(std::string const& metadata);
+
+        /*
+         * Checks the header already in the output file.
+         */
+        void CheckHeader();
+
+        unsigned int const dimension_;
+        unsigned int const num_measurements_;
+        std::uint32_t const flags_;
+        std::FILE* const output_file_;
+
+        // Reused between calls to Write()
+        std::vector<unsigned char> records_;
+    };
+
+}
+
+#endif	/* MCMC_BINARYCHAINWRITER_H */
+
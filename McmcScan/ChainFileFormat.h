@@ -0,0 +1,77 @@
+/*
+ * File:   ChainFileFormat.h
+ * Author: donerkebab
+ *
+ * Constants of the binary chain file format, shared by the writers and 
+ * readers, and the encoding and decoding of its little-endian numbers.  See
+ * BinaryChainWriter.h for the layout of the header and the records, and 
+ * CompressedChainWriter.h for the layout of compressed blocks.
+ *
+ * The encoding does not depend on the machine's byte order.  On a 
+ * little-endian machine the compiler turns it into plain copies.
+ *
+ * Created on May 1, 2014, 3:12 PM
+ */
+
+#ifndef MCMC_CHAINFILEFORMAT_H
+#define	MCMC_CHAINFILEFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Mcmc {
+
+    namespace ChainFileFormat {
+
+        // First bytes of every binary chain file, including a format version
+        char const kMagic[8] = {'M', 'C', 'M', 'C', 'C', 'H', 'N', '1'};
+
+        // Size of the header up to the metadata
+        std::size_t const kFixedHeaderBytes = 28;
+
+        // Header flag bits
+        std::uint32_t const kRunLengthEncodedFlag = 1;
+        std::uint32_t const kCompressedFlag = 2;
+
+        // Size of the header of each compressed block
+        std::size_t const kBlockHeaderBytes = 12;
+
+        inline void EncodeUint32(std::uint32_t value, unsigned char* bytes) {
+            for (int i = 0; i < 4; ++i) {
+                bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+
+        inline std::uint32_t DecodeUint32(unsigned char const* bytes) {
+            std::uint32_t value = 0;
+            for (int i = 0; i < 4; ++i) {
+                value |= static_cast<std::uint32_t>(bytes[i]) << (8 * i);
+            }
+            return value;
+        }
+
+        inline void EncodeDouble(double value, unsigned char* bytes) {
+            std::uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            for (int i = 0; i < 8; ++i) {
+                bytes[i] = static_cast<unsigned char>(bits >> (8 * i));
+            }
+        }
+
+        inline double DecodeDouble(unsigned char const* bytes) {
+            std::uint64_t bits = 0;
+            for (int i = 0; i < 8; ++i) {
+                bits |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+            }
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+    }
+
+}
+
+#endif	/* MCMC_CHAINFILEFORMAT_H */
+
@@ -0,0 +1,30 @@
+/* 
+ * File:   ChainReadError.h
+ * Author: donerkebab
+ *
+ * Exception for errors when reading a chain file back, e.g. if it cannot be
+ * opened, is not a chain file of the expected kind, or is corrupt.
+ * Extends std::runtime_error.
+ *
+ * Created on May 1, 2014, 4:02 PM
+ */
+
+#ifndef MCMC_CHAINREADERROR_H
+#define	MCMC_CHAINREADERROR_H
+
+#include <stdexcept>
+#include <string>
+
+namespace Mcmc {
+    
+    class ChainReadError : public std::runtime_error {
+    public:
+        explicit ChainReadError(std::string const& what) 
+        : std::runtime_error("chain read error: " + what)
+        {}       
+    };
+    
+}
+
+#endif	/* MCMC_CHAINREADERROR_H */
+
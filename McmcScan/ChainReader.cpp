@@ -0,0 +1,176 @@
+/*
+ * File:   ChainReader.cpp
+ * Author: donerkebab
+ *
+ * Created on May 2, 2014, 10:05 AM
+ */
+
+#include "ChainReader.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ChainFileFormat.h"
+#include "ChainReadError.h"
+
+namespace { // unnamed namespace
+    bool IsLittleEndian() {
+        std::uint32_t one = 1;
+        unsigned char first_byte;
+        std::memcpy(&first_byte, &one, 1);
+        return first_byte == 1;
+    }
+}
+
+namespace Mcmc {
+
+    ChainReader::ChainReader(std::string filename)
+    : filename_(filename),
+    mapping_(MAP_FAILED),
+    mapping_bytes_(0),
+    dimension_(0),
+    num_measurements_(0),
+    run_length_encoded_(false),
+    records_(nullptr),
+    num_rows_(0),
+    truncated_(false) {
+        if (!IsLittleEndian()) {
+            throw Mcmc::ChainReadError("chain files can only be mapped on a "
+                    "little-endian machine");
+        }
+
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw Mcmc::ChainReadError("could not open " + filename);
+        }
+        struct stat file_status;
+        if (::fstat(fd, &file_status) != 0) {
+            ::close(fd);
+            throw Mcmc::ChainReadError("could not open " + filename);
+        }
+        mapping_bytes_ = file_status.st_size;
+        if (mapping_bytes_ < ChainFileFormat::kFixedHeaderBytes) {
+            ::close(fd);
+            throw Mcmc::ChainReadError(filename + " is not a binary chain "
+                    "file");
+        }
+        mapping_ = ::mmap(nullptr, mapping_bytes_, PROT_READ, MAP_SHARED, fd,
+                0);
+        ::close(fd);
+        if (mapping_ == MAP_FAILED) {
+            throw Mcmc::ChainReadError("could not map " + filename);
+        }
+
+        try {
+            unsigned char const* bytes =
+                    static_cast<unsigned char const*>(mapping_);
+            if (std::memcmp(bytes, ChainFileFormat::kMagic,
+                    sizeof(ChainFileFormat::kMagic)) != 0) {
+                throw Mcmc::ChainReadError(filename + " is not a binary "
+                        "chain file");
+            }
+
+            std::uint32_t header_bytes = ChainFileFormat::DecodeUint32(
+                    &bytes[8]);
+            dimension_ = ChainFileFormat::DecodeUint32(&bytes[12]);
+            num_measurements_ = ChainFileFormat::DecodeUint32(&bytes[16]);
+            std::uint32_t flags = ChainFileFormat::DecodeUint32(&bytes[20]);
+            std::uint32_t metadata_bytes = ChainFileFormat::DecodeUint32(
+                    &bytes[24]);
+
+            if ((flags & ChainFileFormat::kCompressedFlag) != 0) {
+                throw Mcmc::ChainReadError(filename + " is compressed");
+            }
+            if ((flags & ~ChainFileFormat::kRunLengthEncodedFlag) != 0 ||
+                    header_bytes % 8 != 0 ||
+                    ChainFileFormat::kFixedHeaderBytes + metadata_bytes >
+                    header_bytes || header_bytes > mapping_bytes_) {
+                throw Mcmc::ChainReadError(filename + " has an unknown "
+                        "header");
+            }
+            run_length_encoded_ = (flags &
+                    ChainFileFormat::kRunLengthEncodedFlag) != 0;
+            metadata_.assign(reinterpret_cast<char const*>(
+                    &bytes[ChainFileFormat::kFixedHeaderBytes]),
+                    metadata_bytes);
+
+            // The header is padded to 8 bytes and the mapping is page-aligned,
+            // so the records are aligned for double
+            records_ = reinterpret_cast<double const*>(&bytes[header_bytes]);
+            std::size_t record_bytes = record_size() * sizeof(double);
+            std::size_t records_bytes = mapping_bytes_ - header_bytes;
+            num_rows_ = records_bytes / record_bytes;
+            truncated_ = records_bytes % record_bytes != 0;
+        } catch (...) {
+            ::munmap(mapping_, mapping_bytes_);
+            throw;
+        }
+    }
+
+    ChainReader::~ChainReader() {
+        ::munmap(mapping_, mapping_bytes_);
+    }
+
+    std::string ChainReader::filename() const {
+        return filename_;
+    }
+
+    unsigned int ChainReader::dimension() const {
+        return dimension_;
+    }
+
+    unsigned int ChainReader::num_measurements() const {
+        return num_measurements_;
+    }
+
+    bool ChainReader::run_length_encoded() const {
+        return run_length_encoded_;
+    }
+
+    std::string ChainReader::metadata() const {
+        return metadata_;
+    }
+
+    unsigned int ChainReader::record_size() const {
+        return dimension_ + num_measurements_ + (run_length_encoded_ ? 2 : 1);
+    }
+
+    bool ChainReader::truncated() const {
+        return truncated_;
+    }
+
+    std::size_t ChainReader::num_rows() const {
+        return num_rows_;
+    }
+
+    std::size_t ChainReader::num_steps() const {
+        if (!run_length_encoded_) {
+            return num_rows_;
+        }
+
+        // Goes through the whole file
+        std::size_t num_steps = 0;
+        for (std::size_t i_row = 0; i_row < num_rows_; ++i_row) {
+            num_steps += row(i_row).multiplicity();
+        }
+        return num_steps;
+    }
+
+    ChainRow ChainReader::row(std::size_t i_row) const {
+        return ChainRow(records_ + i_row * record_size(), dimension_,
+                num_measurements_, run_length_encoded_);
+    }
+
+    double const* ChainReader::records() const {
+        return records_;
+    }
+
+}
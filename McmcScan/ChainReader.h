@@ -0,0 +1,147 @@
+/*
+ * File:   ChainReader.h
+ * Author: donerkebab
+ *
+ * Reads back a binary chain file written by Mcmc::BinaryChainWriter, by
+ * mapping the whole file into memory.  Nothing is copied or decoded: each row
+ * is a Mcmc::ChainRow, a view of a record's doubles right where they lie in
+ * the mapped file.  The operating system pages the file in as the rows are
+ * used, so files much bigger than memory can be read.
+ *
+ * Compressed files cannot be mapped, and are read with
+ * Mcmc::CompressedChainReader instead.  Text files are not read at all; the
+ * chainconvert tool converts them to the binary format.
+ *
+ * A last record that has been cut short, e.g. because the scan died while it
+ * was being written, is left out, and truncated() tells whether that happened.
+ *
+ * Dev notes:
+ * * The records are only usable in place on a little-endian machine, since the
+ *   file format is little-endian.  Elsewhere the constructor throws.
+ * * The rows are only valid as long as the reader that they came from.
+ * * Copy constructor is not supported because the reader owns its mapping.
+ *
+ * Created on May 2, 2014, 10:05 AM
+ */
+
+#ifndef MCMC_CHAINREADER_H
+#define	MCMC_CHAINREADER_H
+
+#include <cstddef>
+
+#include <string>
+
+namespace Mcmc {
+
+    /*
+     * One record of a chain file.  Just a pointer and the record's layout, so
+     * it is cheap to pass around by value.
+     */
+    class ChainRow {
+    public:
+        ChainRow(double const* record,
+                unsigned int dimension,
+                unsigned int num_measurements,
+                bool run_length_encoded)
+        : record_(record),
+        dimension_(dimension),
+        num_measurements_(num_measurements),
+        run_length_encoded_(run_length_encoded) {
+        }
+
+        unsigned int dimension() const {
+            return dimension_;
+        }
+
+        unsigned int num_measurements() const {
+            return num_measurements_;
+        }
+
+        // dimension() doubles
+        double const* parameters() const {
+            return record_;
+        }
+
+        // num_measurements() doubles
+        double const* measurements() const {
+            return record_ + dimension_;
+        }
+
+        double likelihood() const {
+            return record_[dimension_ + num_measurements_];
+        }
+
+        // Number of steps the chain stayed at this point; 1 unless the file is
+        // run-length encoded
+        unsigned int multiplicity() const {
+            return run_length_encoded_ ?
+                    static_cast<unsigned int>(
+                    record_[dimension_ + num_measurements_ + 1]) : 1;
+        }
+
+    private:
+        double const* record_;
+        unsigned int dimension_;
+        unsigned int num_measurements_;
+        bool run_length_encoded_;
+    };
+
+    class ChainReader {
+    public:
+        /*
+         * Opens and maps the file, and reads the header.
+         *
+         * throws Mcmc::ChainReadError if the file cannot be opened or mapped,
+         * is not an uncompressed binary chain file, or this machine is not
+         * little-endian
+         */
+        explicit ChainReader(std::string filename);
+        virtual ~ChainReader();
+
+        std::string filename() const;
+        unsigned int dimension() const;
+        unsigned int num_measurements() const;
+        bool run_length_encoded() const;
+        std::string metadata() const;
+        // Number of doubles per record
+        unsigned int record_size() const;
+        // Whether the last record was found cut short
+        bool truncated() const;
+
+        // Number of complete records in the file
+        std::size_t num_rows() const;
+        // Number of chain steps, i.e. the sum of the rows' multiplicities
+        std::size_t num_steps() const;
+
+        /*
+         * Row i_row, for i_row < num_rows().  Not bounds-checked.
+         */
+        ChainRow row(std::size_t i_row) const;
+
+        /*
+         * All of the records, one after the other, record_size() doubles each.
+         */
+        double const* records() const;
+
+    private:
+        ChainReader(ChainReader const& orig);
+        void operator=(ChainReader const& orig);
+
+        std::string const filename_;
+        void* mapping_;
+        std::size_t mapping_bytes_;
+
+        unsigned int dimension_;
+        unsigned int num_measurements_;
+        bool run_length_encoded_;
+        std::string metadata_;
+
+        double const* records_;
+        std::size_t num_rows_;
+        bool truncated_;
+    };
+
+}
+
+#endif	/* MCMC_CHAINREADER_H */
+
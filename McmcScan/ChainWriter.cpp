@@ -0,0 +1,37 @@
+/*
+ * File:   ChainWriter.cpp
+ * Author: donerkebab
+ *
+ * Created on April 29, 2014, 6:02 PM
+ */
+
+#include "ChainWriter.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace Mcmc {
+
+    ChainWriter::ChainWriter(std::string filename, bool run_length_encoded)
+    : filename_(filename),
+    run_length_encoded_(run_length_encoded) {
+        if (filename == "") {
+            throw std::invalid_argument("invalid filename");
+        }
+    }
+
+    ChainWriter::~ChainWriter() {
+    }
+
+    std::string ChainWriter::filename() const {
+        return filename_;
+    }
+
+    bool ChainWriter::run_length_encoded() const {
+        return run_length_encoded_;
+    }
+
+    void ChainWriter::Sync() {
+    }
+
+}
@@ -0,0 +1,92 @@
+/*
+ * File:   ChainWriter.h
+ * Author: donerkebab
+ *
+ * Abstract output sink for a MarkovChain.  Whenever the chain flushes its
+ * buffer, it hands the points to be written, in order, to its ChainWriter,
+ * which appends them to the output file in its own format.  The writer is
+ * tied to one output file for its whole lifetime.  The concrete writers keep
+ * the file open for as long as they exist, and flush the stdio buffer at the
+ * end of every Write(), so that the file is always complete up to the last
+ * Write().
+ *
+ * A chain buffer usually holds runs of the same point, one for each rejected
+ * step.  The chain hands each run over once, together with its multiplicity.
+ * A run-length encoded writer writes each run once with its multiplicity; 
+ * otherwise the point is written out multiplicity times, as if the run had
+ * never been coalesced.  A run may be split across two flushes, since the
+ * chain always keeps its last point back, so readers of run-length encoded
+ * files should not assume that consecutive records differ.
+ * 
+ * Concrete writers:
+ * * Mcmc::TextChainWriter, the original text format, one line each for
+ *   parameters, measurements and likelihood.
+ * * Mcmc::BinaryChainWriter, a compact little-endian binary format with
+ *   fixed-width records.
+ * * Mcmc::AsyncChainWriter, which hands the points to another writer on a
+ *   background thread.
+ *
+ * If there are problems opening or writing the output file, the writer
+ * throws a McmcScan::ChainFlushError.  Write() should then leave the points 
+ * to the chain, which can simply try again with the same points later.
+ *
+ * Dev notes:
+ * * Write() takes a plain array of shared_ptr rather than a container, so that
+ *   the chain is free to store its buffer however it likes.
+ * * Copy constructor is not supported because a copy of the writer would
+ *   write to the same output file.
+ *
+ * Created on April 29, 2014, 6:02 PM
+ */
+
+#ifndef MCMC_CHAINWRITER_H
+#define	MCMC_CHAINWRITER_H
+
+#include <memory>
+#include <string>
+
+#include "Point.h"
+
+namespace Mcmc {
+
+    class ChainWriter {
+    public:
+        virtual ~ChainWriter();
+
+        std::string filename() const;
+        bool run_length_encoded() const;
+
+        /*
+         * Appends num_runs runs of points to the output file, in order.  Run 
+         * i is point points[i] repeated multiplicities[i] times.
+         *
+         * throws Mcmc::ChainFlushError if output file cannot be written
+         */
+        virtual void Write(std::shared_ptr<Mcmc::Point> const* points,
+                unsigned int const* multiplicities,
+                unsigned int num_runs) = 0;
+
+        /*
+         * Blocks until everything passed to Write() so far is in the output
+         * file.  Writers that write synchronously have nothing to do.
+         *
+         * throws Mcmc::ChainFlushError if output file cannot be written
+         */
+        virtual void Sync();
+
+    protected:
+        // throws std::invalid_argument if filename is empty
+        ChainWriter(std::string filename, bool run_length_encoded);
+
+    private:
+        ChainWriter(ChainWriter const& orig);
+        void operator=(ChainWriter const& orig);
+
+        std::string const filename_;
+        bool const run_length_encoded_;
+    };
+
+}
+
+#endif	/* MCMC_CHAINWRITER_H */
+
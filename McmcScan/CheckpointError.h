@@ -0,0 +1,30 @@
+/* 
+ * File:   CheckpointError.h
+ * Author: donerkebab
+ *
+ * Exception for errors when McmcScan writes or reads a checkpoint file, or
+ * when a checkpoint does not match the scan or its chain files.
+ * Extends std::runtime_error.
+ *
+ * Created on April 28, 2014, 7:36 PM
+ */
+
+#ifndef MCMC_CHECKPOINTERROR_H
+#define	MCMC_CHECKPOINTERROR_H
+
+#include <stdexcept>
+#include <string>
+
+namespace Mcmc {
+    
+    class CheckpointError : public std::runtime_error {
+    public:
+        explicit CheckpointError(std::string const& what) 
+        : std::runtime_error("checkpoint error: " + what)
+        {}       
+    };
+    
+}
+
+#endif	/* MCMC_CHECKPOINTERROR_H */
+
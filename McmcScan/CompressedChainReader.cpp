@@ -0,0 +1,199 @@
+/*
+ * File:   CompressedChainReader.cpp
+ * Author: donerkebab
+ *
+ * Created on May 1, 2014, 4:10 PM
+ */
+
+#include "CompressedChainReader.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "ChainFileFormat.h"
+#include "ChainReadError.h"
+#include "ThreadPool.h"
+
+namespace { // unnamed namespace
+    // How many blocks ReadAhead() reads for each thread
+    unsigned int const kBlocksPerThread = 4;
+}
+
+namespace Mcmc {
+
+    CompressedChainReader::CompressedChainReader(std::string filename,
+            unsigned int num_threads)
+    : input_file_(nullptr),
+    thread_pool_(num_threads),
+    dimension_(0),
+    num_measurements_(0),
+    run_length_encoded_(false),
+    end_of_file_(false),
+    truncated_(false) {
+        input_file_ = std::fopen(filename.c_str(), "rb");
+        if (input_file_ == nullptr) {
+            throw Mcmc::ChainReadError("could not open " + filename);
+        }
+
+        try {
+            unsigned char header[ChainFileFormat::kFixedHeaderBytes];
+            if (std::fread(header, 1, sizeof(header), input_file_) !=
+                    sizeof(header) || std::memcmp(header,
+                    ChainFileFormat::kMagic,
+                    sizeof(ChainFileFormat::kMagic)) != 0) {
+                throw Mcmc::ChainReadError(filename + " is not a binary "
+                        "chain file");
+            }
+
+            std::uint32_t header_bytes = ChainFileFormat::DecodeUint32(
+                    &header[8]);
+            dimension_ = ChainFileFormat::DecodeUint32(&header[12]);
+            num_measurements_ = ChainFileFormat::DecodeUint32(&header[16]);
+            std::uint32_t flags = ChainFileFormat::DecodeUint32(&header[20]);
+            std::uint32_t metadata_bytes = ChainFileFormat::DecodeUint32(
+                    &header[24]);
+
+            if ((flags & ChainFileFormat::kCompressedFlag) == 0) {
+                throw Mcmc::ChainReadError(filename + " is not compressed");
+            }
+            if ((flags & ~(ChainFileFormat::kCompressedFlag |
+                    ChainFileFormat::kRunLengthEncodedFlag)) != 0 ||
+                    ChainFileFormat::kFixedHeaderBytes + metadata_bytes >
+                    header_bytes) {
+                throw Mcmc::ChainReadError(filename + " has an unknown "
+                        "header");
+            }
+            run_length_encoded_ = (flags &
+                    ChainFileFormat::kRunLengthEncodedFlag) != 0;
+
+            metadata_.resize(metadata_bytes);
+            if (metadata_bytes > 0 && std::fread(&metadata_[0], 1,
+                    metadata_bytes, input_file_) != metadata_bytes) {
+                throw Mcmc::ChainReadError(filename + " is truncated");
+            }
+            std::fseek(input_file_, header_bytes, SEEK_SET);
+        } catch (...) {
+            std::fclose(input_file_);
+            throw;
+        }
+    }
+
+    CompressedChainReader::~CompressedChainReader() {
+        std::fclose(input_file_);
+    }
+
+    unsigned int CompressedChainReader::dimension() const {
+        return dimension_;
+    }
+
+    unsigned int CompressedChainReader::num_measurements() const {
+        return num_measurements_;
+    }
+
+    bool CompressedChainReader::run_length_encoded() const {
+        return run_length_encoded_;
+    }
+
+    std::string CompressedChainReader::metadata() const {
+        return metadata_;
+    }
+
+    unsigned int CompressedChainReader::record_size() const {
+        return dimension_ + num_measurements_ + (run_length_encoded_ ? 2 : 1);
+    }
+
+    bool CompressedChainReader::truncated() const {
+        return truncated_;
+    }
+
+    bool CompressedChainReader::ReadBlock(std::vector<double>& records) {
+        if (decoded_blocks_.empty() && !end_of_file_) {
+            ReadAhead();
+        }
+        if (decoded_blocks_.empty()) {
+            return false;
+        }
+
+        records.swap(decoded_blocks_.front());
+        decoded_blocks_.pop_front();
+        return true;
+    }
+
+    void CompressedChainReader::ReadAhead() {
+        // Read the compressed blocks one after the other
+        unsigned int max_blocks = kBlocksPerThread *
+                thread_pool_.num_threads();
+        std::vector<std::vector<unsigned char> > compressed_blocks;
+        std::vector<std::size_t> block_bytes;
+        while (compressed_blocks.size() < max_blocks) {
+            unsigned char header[ChainFileFormat::kBlockHeaderBytes];
+            std::size_t num_read = std::fread(header, 1, sizeof(header),
+                    input_file_);
+            if (num_read == 0) {
+                end_of_file_ = true;
+                break;
+            }
+            if (num_read < sizeof(header)) {
+                end_of_file_ = true;
+                truncated_ = true;
+                break;
+            }
+
+            std::uint32_t num_records = ChainFileFormat::DecodeUint32(
+                    &header[0]);
+            std::uint32_t num_bytes = ChainFileFormat::DecodeUint32(
+                    &header[4]);
+            std::uint32_t compressed_bytes = ChainFileFormat::DecodeUint32(
+                    &header[8]);
+            if (num_bytes != num_records * record_size() * sizeof(double)) {
+                throw Mcmc::ChainReadError("block has the wrong size");
+            }
+
+            std::vector<unsigned char> compressed_block(compressed_bytes);
+            if (std::fread(compressed_block.data(), 1, compressed_bytes,
+                    input_file_) != compressed_bytes) {
+                end_of_file_ = true;
+                truncated_ = true;
+                break;
+            }
+            compressed_blocks.push_back(std::vector<unsigned char>());
+            compressed_blocks.back().swap(compressed_block);
+            block_bytes.push_back(num_bytes);
+        }
+
+        // Decompress and decode them in parallel, each into its own slot
+        std::vector<std::vector<double> > blocks(compressed_blocks.size());
+        thread_pool_.ParallelFor(compressed_blocks.size(),
+                [&](unsigned int i_block) {
+                    std::vector<unsigned char> bytes(block_bytes[i_block]);
+                    uLongf num_bytes = bytes.size();
+                    if (uncompress(bytes.data(), &num_bytes,
+                            compressed_blocks[i_block].data(),
+                            compressed_blocks[i_block].size()) != Z_OK ||
+                            num_bytes != bytes.size()) {
+                        throw Mcmc::ChainReadError("block is corrupt");
+                    }
+
+                    std::vector<double>& block = blocks[i_block];
+                    block.resize(num_bytes / sizeof(double));
+                    for (std::size_t i = 0; i < block.size(); ++i) {
+                        block[i] = ChainFileFormat::DecodeDouble(
+                                &bytes[i * sizeof(double)]);
+                    }
+                });
+
+        for (std::size_t i_block = 0; i_block < blocks.size(); ++i_block) {
+            decoded_blocks_.push_back(std::vector<double>());
+            decoded_blocks_.back().swap(blocks[i_block]);
+        }
+    }
+
+}
@@ -0,0 +1,96 @@
+/*
+ * File:   CompressedChainReader.h
+ * Author: donerkebab
+ *
+ * Reads back a chain file written by Mcmc::CompressedChainWriter, one block at
+ * a time, without holding the whole file in memory.
+ *
+ * The reader keeps a few blocks per thread ahead of the caller.  It reads 
+ * them from the file one after the other, and then decompresses and decodes
+ * all of them at once on a Mcmc::ThreadPool, so that decompression, which is
+ * what takes the time, runs in parallel.  The blocks are still handed out in
+ * file order.
+ *
+ * A last block that has been cut short, e.g. because the scan died while it
+ * was being written, is treated as the end of the file, and truncated() tells
+ * whether that happened.  A block that is complete but does not decompress
+ * properly is an error.
+ *
+ * Dev notes:
+ * * Copy constructor is not supported because the reader owns its file and
+ *   its threads.
+ *
+ * Created on May 1, 2014, 4:10 PM
+ */
+
+#ifndef MCMC_COMPRESSEDCHAINREADER_H
+#define	MCMC_COMPRESSEDCHAINREADER_H
+
+#include <cstdio>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace Mcmc {
+
+    class CompressedChainReader {
+    public:
+        /*
+         * Opens the file and reads the header.
+         * 
+         * throws std::invalid_argument if num_threads is zero
+         * 
+         * throws Mcmc::ChainReadError if the file cannot be opened, or is not
+         * a compressed binary chain file
+         */
+        CompressedChainReader(std::string filename, unsigned int num_threads);
+        virtual ~CompressedChainReader();
+
+        unsigned int dimension() const;
+        unsigned int num_measurements() const;
+        bool run_length_encoded() const;
+        std::string metadata() const;
+        // Number of doubles per record
+        unsigned int record_size() const;
+        // Whether the last block was found cut short
+        bool truncated() const;
+
+        /*
+         * Puts the records of the next block in records, one after the 
+         * other, record_size() doubles each, and returns true.  Returns false
+         * if there are no more blocks.
+         * 
+         * throws Mcmc::ChainReadError if a block is corrupt
+         */
+        bool ReadBlock(std::vector<double>& records);
+
+    private:
+        CompressedChainReader(CompressedChainReader const& orig);
+        void operator=(CompressedChainReader const& orig);
+
+        /*
+         * Reads the next few blocks from the file, and decompresses and 
+         * decodes them in parallel into decoded_blocks_.
+         */
+        void ReadAhead();
+
+        std::FILE* input_file_;
+        Mcmc::ThreadPool thread_pool_;
+
+        unsigned int dimension_;
+        unsigned int num_measurements_;
+        bool run_length_encoded_;
+        std::string metadata_;
+
+        std::deque<std::vector<double> > decoded_blocks_;
+        bool end_of_file_;
+        bool truncated_;
+    };
+
+}
+
+#endif	/* MCMC_COMPRESSEDCHAINREADER_H */
+
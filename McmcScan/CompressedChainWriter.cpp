@@ -0,0 +1,62 @@
+/*
+ * File:   CompressedChainWriter.cpp
+ * Author: donerkebab
+ *
+ * Created on May 1, 2014, 3:40 PM
+ */
+
+#include "CompressedChainWriter.h"
+
+#include <cstddef>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "BinaryChainWriter.h"
+#include "ChainFileFormat.h"
+#include "ChainFlushError.h"
+
+namespace Mcmc {
+
+    CompressedChainWriter::CompressedChainWriter(std::string filename,
+            unsigned int dimension,
+            unsigned int num_measurements,
+            std::string metadata,
+            bool run_length_encoded)
+    : BinaryChainWriter(filename, dimension, num_measurements, metadata,
+            run_length_encoded, ChainFileFormat::kCompressedFlag) {
+    }
+
+    CompressedChainWriter::~CompressedChainWriter() {
+    }
+
+    void CompressedChainWriter::WriteRecords(unsigned char const* records,
+            std::size_t num_bytes,
+            unsigned int num_records) {
+        uLongf compressed_bytes = compressBound(num_bytes);
+        block_.resize(ChainFileFormat::kBlockHeaderBytes + compressed_bytes);
+        if (compress2(&block_[ChainFileFormat::kBlockHeaderBytes],
+                &compressed_bytes, records, num_bytes,
+                Z_DEFAULT_COMPRESSION) != Z_OK) {
+            throw Mcmc::ChainFlushError();
+        }
+
+        ChainFileFormat::EncodeUint32(num_records, &block_[0]);
+        ChainFileFormat::EncodeUint32(num_bytes, &block_[4]);
+        ChainFileFormat::EncodeUint32(compressed_bytes, &block_[8]);
+        std::size_t block_bytes = ChainFileFormat::kBlockHeaderBytes +
+                compressed_bytes;
+
+        // One fwrite() for the whole block, so that a block is either there
+        // or, after a crash, cut short
+        if (std::fwrite(block_.data(), 1, block_bytes, output_file()) !=
+                block_bytes || std::fflush(output_file()) != 0) {
+            std::clearerr(output_file());
+            throw Mcmc::ChainFlushError();
+        }
+    }
+
+}
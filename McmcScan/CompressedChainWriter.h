@@ -0,0 +1,81 @@
+/*
+ * File:   CompressedChainWriter.h
+ * Author: donerkebab
+ *
+ * Writes chain points in the binary format of Mcmc::BinaryChainWriter, but 
+ * with the records compressed with zlib, for when disk bandwidth is the 
+ * bottleneck.  The header is the same, uncompressed, with flag bit 1 set.
+ *
+ * Each Write() produces one block, which is compressed on its own, so that it
+ * can be decompressed without any of the other blocks.  If the scan dies in
+ * the middle of writing a block, only that block is lost, and the blocks can
+ * be decompressed in parallel.  Block layout, little-endian, with byte 
+ * offsets from the start of the block:
+ *   0  uint32  number of records in the block
+ *   4  uint32  size in bytes of the records, uncompressed
+ *   8  uint32  size in bytes of the compressed data that follows
+ *  12  char[]  the records, as one zlib stream
+ *
+ * Use Mcmc::CompressedChainReader to read the file back.
+ *
+ * Dev notes:
+ * * Doubles do not compress very well, but the repeated points of a chain
+ *   without run-length encoding compress very well, and the measurements of
+ *   nearby points have many leading bytes in common.
+ * * Uses zlib's default compression level, which is a good compromise between
+ *   speed and size.
+ * * Smaller buffer sizes mean smaller blocks, which lose less in a crash but
+ *   compress less well.
+ *
+ * Created on May 1, 2014, 3:40 PM
+ */
+
+#ifndef MCMC_COMPRESSEDCHAINWRITER_H
+#define	MCMC_COMPRESSEDCHAINWRITER_H
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+#include "BinaryChainWriter.h"
+
+namespace Mcmc {
+
+    class CompressedChainWriter : public BinaryChainWriter {
+    public:
+        /*
+         * throws std::invalid_argument if filename is empty, dimension is
+         * zero, or the file already holds something other than a header for
+         * the same dimension, number of measurements, run-length encoding and
+         * compression
+         *
+         * throws Mcmc::ChainFlushError if output file cannot be opened
+         */
+        CompressedChainWriter(std::string filename,
+                unsigned int dimension,
+                unsigned int num_measurements,
+                std::string metadata,
+                bool run_length_encoded);
+        virtual ~CompressedChainWriter();
+
+    protected:
+        /*
+         * Compresses the records into one block, and writes it.
+         * 
+         * throws Mcmc::ChainFlushError if output file cannot be written, or
+         * the records cannot be compressed
+         */
+        void WriteRecords(unsigned char const* records,
+                std::size_t num_bytes,
+                unsigned int num_records);
+
+    private:
+        // Reused between calls to WriteRecords()
+        std::vector<unsigned char> block_;
+    };
+
+}
+
+#endif	/* MCMC_COMPRESSEDCHAINWRITER_H */
+
@@ -0,0 +1,146 @@
+/*
+ * File:   ConvergenceMonitor.cpp
+ * Author: donerkebab
+ *
+ * Created on May 3, 2014, 2:40 PM
+ */
+
+#include "ConvergenceMonitor.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+namespace Mcmc {
+
+    ConvergenceMonitor::ConvergenceMonitor(unsigned int num_chains,
+            unsigned int dimension)
+    : num_chains_(num_chains),
+    dimension_(dimension),
+    num_points_(num_chains, 0),
+    means_(num_chains * dimension, 0.0),
+    sum_squares_(num_chains * dimension, 0.0) {
+        if (num_chains < 2) {
+            throw std::invalid_argument("R-hat needs at least two chains");
+        }
+        if (dimension == 0) {
+            throw std::invalid_argument("cannot have zero dimension");
+        }
+    }
+
+    ConvergenceMonitor::~ConvergenceMonitor() {
+    }
+
+    unsigned int ConvergenceMonitor::num_chains() const {
+        return num_chains_;
+    }
+
+    unsigned int ConvergenceMonitor::dimension() const {
+        return dimension_;
+    }
+
+    unsigned long ConvergenceMonitor::num_points(unsigned int i_chain) const {
+        return num_points_.at(i_chain);
+    }
+
+    void ConvergenceMonitor::Add(unsigned int i_chain,
+            gsl_vector const* parameters) {
+        if (i_chain >= num_chains_) {
+            throw std::invalid_argument("no such chain");
+        }
+        if (parameters->size != dimension_) {
+            throw std::invalid_argument("parameters have the wrong size");
+        }
+
+        // Welford's update of the mean and the sum of squared deviations
+        unsigned long n = ++num_points_[i_chain];
+        double* mean = &means_[i_chain * dimension_];
+        double* sum_squares = &sum_squares_[i_chain * dimension_];
+        for (unsigned int i = 0; i < dimension_; ++i) {
+            double x = gsl_vector_get(parameters, i);
+            double delta = x - mean[i];
+            mean[i] += delta / n;
+            sum_squares[i] += delta * (x - mean[i]);
+        }
+    }
+
+    bool ConvergenceMonitor::ready() const {
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            if (num_points_[i_chain] < 2) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double ConvergenceMonitor::ComputeRHats(std::vector<double>& r_hats)
+    const {
+        if (!ready()) {
+            throw std::logic_error("every chain needs at least two points");
+        }
+
+        double n = 0.0;
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            n += num_points_[i_chain];
+        }
+        n /= num_chains_;
+
+        r_hats.resize(dimension_);
+        double max_r_hat = 0.0;
+        for (unsigned int i = 0; i < dimension_; ++i) {
+            double grand_mean = 0.0;
+            double within = 0.0;
+            for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+                grand_mean += means_[i_chain * dimension_ + i];
+                within += sum_squares_[i_chain * dimension_ + i] /
+                        (num_points_[i_chain] - 1);
+            }
+            grand_mean /= num_chains_;
+            within /= num_chains_;
+
+            double between_over_n = 0.0;
+            for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+                double deviation = means_[i_chain * dimension_ + i] -
+                        grand_mean;
+                between_over_n += deviation * deviation;
+            }
+            between_over_n /= num_chains_ - 1;
+
+            if (within > 0.0) {
+                r_hats[i] = std::sqrt(((n - 1.0) / n * within +
+                        between_over_n) / within);
+            } else {
+                r_hats[i] = std::numeric_limits<double>::infinity();
+            }
+            if (r_hats[i] > max_r_hat) {
+                max_r_hat = r_hats[i];
+            }
+        }
+        return max_r_hat;
+    }
+
+    void ConvergenceMonitor::GetState(std::vector<unsigned long>& counts,
+            std::vector<double>& sums) const {
+        counts = num_points_;
+        sums.assign(means_.begin(), means_.end());
+        sums.insert(sums.end(), sum_squares_.begin(), sum_squares_.end());
+    }
+
+    void ConvergenceMonitor::SetState(std::vector<unsigned long> const& counts,
+            std::vector<double> const& sums) {
+        if (counts.size() != num_chains_ || sums.size() != 2 * means_.size()) {
+            throw std::invalid_argument("state has the wrong size");
+        }
+
+        num_points_ = counts;
+        std::copy(sums.begin(), sums.begin() + means_.size(), means_.begin());
+        std::copy(sums.begin() + means_.size(), sums.end(),
+                sum_squares_.begin());
+    }
+
+}
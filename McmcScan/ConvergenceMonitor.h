@@ -0,0 +1,104 @@
+/*
+ * File:   ConvergenceMonitor.h
+ * Author: donerkebab
+ *
+ * Keeps running means and variances of each parameter in each chain, and
+ * computes the Gelman-Rubin potential scale reduction factor R-hat from them
+ * (Gelman & Rubin, Stat. Sci. 7, 457 (1992)).  McmcScan feeds it every point
+ * appended to a chain after the burn-in, so that convergence can be checked
+ * while the scan is running, without reading the chains back.
+ *
+ * For each parameter, with J chains of n_j points each, chain means m_j and
+ * chain variances s_j^2,
+ *   W = mean of s_j^2                          (within-chain variance)
+ *   B/n = variance of the m_j                  (between-chain variance)
+ *   V = (n - 1)/n W + B/n
+ *   R-hat = sqrt(V / W)
+ * where n is the mean of the n_j, since the chains need not have the same
+ * number of points.  R-hat approaches 1 from above as the chains converge to
+ * the same distribution.
+ *
+ * Dev notes:
+ * * The means and variances are accumulated with Welford's algorithm, which
+ *   is O(d) per point and numerically stable.
+ * * Copy constructor is not supported because there is no need for it.
+ *
+ * Created on May 3, 2014, 2:40 PM
+ */
+
+#ifndef MCMC_CONVERGENCEMONITOR_H
+#define	MCMC_CONVERGENCEMONITOR_H
+
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+namespace Mcmc {
+
+    class ConvergenceMonitor {
+    public:
+        /*
+         * throws std::invalid_argument if there are fewer than two chains, or
+         * dimension is zero
+         */
+        ConvergenceMonitor(unsigned int num_chains, unsigned int dimension);
+        virtual ~ConvergenceMonitor();
+
+        unsigned int num_chains() const;
+        unsigned int dimension() const;
+        // Number of points added to chain i_chain
+        unsigned long num_points(unsigned int i_chain) const;
+
+        /*
+         * Adds a point of chain i_chain.
+         *
+         * throws std::invalid_argument if i_chain is out of range, or
+         * parameters has the wrong size
+         */
+        void Add(unsigned int i_chain, gsl_vector const* parameters);
+
+        /*
+         * Whether every chain has at least two points, so that R-hat is
+         * defined.
+         */
+        bool ready() const;
+
+        /*
+         * Puts the R-hat of each parameter in r_hats, and returns the largest.
+         * A parameter whose chains have no spread at all within them has an
+         * R-hat of infinity.
+         *
+         * throws std::logic_error if not ready()
+         */
+        double ComputeRHats(std::vector<double>& r_hats) const;
+
+        /*
+         * The accumulated counts and sums of every chain, e.g. for a 
+         * checkpoint.  SetState() carries on from the state that GetState()
+         * gave for a monitor of the same sizes.
+         * 
+         * SetState() throws std::invalid_argument if counts or sums do not 
+         * fit this monitor, and leaves it as it was
+         */
+        void GetState(std::vector<unsigned long>& counts,
+                std::vector<double>& sums) const;
+        void SetState(std::vector<unsigned long> const& counts,
+                std::vector<double> const& sums);
+
+    private:
+        ConvergenceMonitor(ConvergenceMonitor const& orig);
+        void operator=(ConvergenceMonitor const& orig);
+
+        unsigned int const num_chains_;
+        unsigned int const dimension_;
+
+        // Per chain; means_ and sum_squares_ hold dimension_ values per chain
+        std::vector<unsigned long> num_points_;
+        std::vector<double> means_;
+        std::vector<double> sum_squares_;
+    };
+
+}
+
+#endif	/* MCMC_CONVERGENCEMONITOR_H */
+
@@ -0,0 +1,30 @@
+/* 
+ * File:   CoordinatorError.h
+ * Author: donerkebab
+ *
+ * Exception for errors in a distributed scan, e.g. if the coordinator's 
+ * socket cannot be set up or reached, a connection breaks, or a message does
+ * not fit the protocol.  Extends std::runtime_error.
+ *
+ * Created on May 6, 2014, 9:05 AM
+ */
+
+#ifndef MCMC_COORDINATORERROR_H
+#define	MCMC_COORDINATORERROR_H
+
+#include <stdexcept>
+#include <string>
+
+namespace Mcmc {
+    
+    class CoordinatorError : public std::runtime_error {
+    public:
+        explicit CoordinatorError(std::string const& what) 
+        : std::runtime_error("coordinator error: " + what)
+        {}       
+    };
+    
+}
+
+#endif	/* MCMC_COORDINATORERROR_H */
+
@@ -0,0 +1,89 @@
+/*
+ * File:   CoordinatorProtocol.cpp
+ * Author: donerkebab
+ *
+ * Created on May 6, 2014, 9:20 AM
+ */
+
+#include "CoordinatorProtocol.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include "CoordinatorError.h"
+
+namespace { // unnamed namespace
+    void SendAll(int socket, void const* data, std::size_t num_bytes) {
+        char const* bytes = static_cast<char const*>(data);
+        while (num_bytes > 0) {
+            // MSG_NOSIGNAL, so that a closed connection is an error and not
+            // a SIGPIPE
+            ssize_t num_sent = ::send(socket, bytes, num_bytes, MSG_NOSIGNAL);
+            if (num_sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw Mcmc::CoordinatorError(std::string("could not send: ") +
+                        std::strerror(errno));
+            }
+            bytes += num_sent;
+            num_bytes -= num_sent;
+        }
+    }
+
+    void ReceiveAll(int socket, void* data, std::size_t num_bytes) {
+        char* bytes = static_cast<char*>(data);
+        while (num_bytes > 0) {
+            ssize_t num_received = ::recv(socket, bytes, num_bytes, 0);
+            if (num_received < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw Mcmc::CoordinatorError(std::string("could not "
+                        "receive: ") + std::strerror(errno));
+            }
+            if (num_received == 0) {
+                throw Mcmc::CoordinatorError("connection closed");
+            }
+            bytes += num_received;
+            num_bytes -= num_received;
+        }
+    }
+}
+
+namespace Mcmc {
+
+    namespace CoordinatorProtocol {
+
+        void SendMessage(int socket,
+                std::uint32_t type,
+                std::vector<double> const& values) {
+            std::uint32_t header[2] = {type,
+                static_cast<std::uint32_t>(values.size())};
+            SendAll(socket, header, sizeof(header));
+            SendAll(socket, values.data(), values.size() * sizeof(double));
+        }
+
+        std::uint32_t ReceiveMessage(int socket, std::vector<double>& values) {
+            std::uint32_t header[2];
+            ReceiveAll(socket, header, sizeof(header));
+            if (header[1] > kMaxValues) {
+                throw Mcmc::CoordinatorError("message is too long");
+            }
+            values.resize(header[1]);
+            ReceiveAll(socket, values.data(), values.size() * sizeof(double));
+            return header[0];
+        }
+
+    }
+
+}
+
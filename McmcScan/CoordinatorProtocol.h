@@ -0,0 +1,66 @@
+/*
+ * File:   CoordinatorProtocol.h
+ * Author: donerkebab
+ *
+ * Messages between a Mcmc::ScanCoordinator and the McmcScan workers of a 
+ * distributed scan, over a Unix domain stream socket.  Every message is a
+ * 4-byte type and a 4-byte count, followed by that many doubles, all in the
+ * machine's own byte order, since both ends run on the same machine.
+ *
+ *   kHello  worker -> coordinator  the last parameters of each of the 
+ *                                  worker's chains, d values per chain
+ *   kState  coordinator -> worker  the number of chains in the whole scan,
+ *                                  the index of the worker's first chain in
+ *                                  it, then the d-vector mean and the d x d 
+ *                                  covariance matrix (row-major) of the last
+ *                                  parameters of all chains
+ *   kSync   worker -> coordinator  as kHello, asking for a new kState
+ *   kDone   worker -> coordinator  as kHello, and no reply; the worker then
+ *                                  closes the connection
+ *
+ * Created on May 6, 2014, 9:20 AM
+ */
+
+#ifndef MCMC_COORDINATORPROTOCOL_H
+#define	MCMC_COORDINATORPROTOCOL_H
+
+#include <cstdint>
+
+#include <vector>
+
+namespace Mcmc {
+
+    namespace CoordinatorProtocol {
+
+        std::uint32_t const kHello = 1;
+        std::uint32_t const kState = 2;
+        std::uint32_t const kSync = 3;
+        std::uint32_t const kDone = 4;
+
+        // Largest number of values in a message, to catch garbage counts
+        std::uint32_t const kMaxValues = 1 << 26;
+
+        /*
+         * Sends a message over the connected socket.
+         *
+         * throws Mcmc::CoordinatorError if the connection breaks
+         */
+        void SendMessage(int socket,
+                std::uint32_t type,
+                std::vector<double> const& values);
+
+        /*
+         * Receives a message from the connected socket into values, and 
+         * returns its type.
+         *
+         * throws Mcmc::CoordinatorError if the connection breaks or is closed,
+         * or the count is too large
+         */
+        std::uint32_t ReceiveMessage(int socket, std::vector<double>& values);
+
+    }
+
+}
+
+#endif	/* MCMC_COORDINATORPROTOCOL_H */
+
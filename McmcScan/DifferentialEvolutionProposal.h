@@ -0,0 +1,102 @@
+/* 
+ * File:   DifferentialEvolutionProposal.h
+ * Author: donerkebab
+ *
+ * The proposal policy of McmcScan with differential evolution, see 
+ * Mcmc::McmcScan::EnableDifferentialEvolution().  The jump from a chain's 
+ * last point is gamma times the difference of the last points of two other
+ * chains, plus a little noise.  The proposal is symmetric, so the log 
+ * Hastings ratio is 0, and there is no state to update on acceptance.
+ * 
+ * Dev notes:
+ * * The noise is scaled by the spread of the seeds, which is what the scan's
+ *   last_points_covariance() holds with differential evolution, since 
+ *   nothing updates it.
+ * * The methods are defined here, so that McmcScan::Step() can inline them.
+ * 
+ * Created on May 6, 2014, 4:31 PM
+ */
+
+#ifndef MCMC_DIFFERENTIALEVOLUTIONPROPOSAL_H
+#define	MCMC_DIFFERENTIALEVOLUTIONPROPOSAL_H
+
+#include <algorithm>
+#include <cmath>
+
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_vector.h>
+
+#include "McmcScan.h"
+
+namespace Mcmc {
+
+    class DifferentialEvolutionProposal {
+    public:
+        explicit DifferentialEvolutionProposal(Mcmc::McmcScan& scan)
+        : scan_(scan)
+        {}
+
+        void Propose(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_rng* rng,
+                gsl_vector* trial_parameters) {
+            // Noise relative to the spread of the seeds, and how often a 
+            // jump uses gamma = 1
+            double const noise_scale = 1E-4;
+            double const full_jump_probability = 0.1;
+
+            // Two other chains, different from each other
+            unsigned int num_chains = scan_.num_chains();
+            unsigned int i_chain_a = gsl_rng_uniform_int(rng, num_chains - 1);
+            if (i_chain_a >= i_chain) {
+                ++i_chain_a;
+            }
+            unsigned int i_chain_b = gsl_rng_uniform_int(rng, num_chains - 2);
+            if (i_chain_b >= std::min(i_chain, i_chain_a)) {
+                ++i_chain_b;
+            }
+            if (i_chain_b >= std::max(i_chain, i_chain_a)) {
+                ++i_chain_b;
+            }
+            gsl_vector const* parameters_a = scan_.last_parameters(i_chain_a);
+            gsl_vector const* parameters_b = scan_.last_parameters(i_chain_b);
+            gsl_matrix const* seed_covariance = scan_.last_points_covariance();
+
+            unsigned int dimension = scan_.dimension();
+            double gamma = 2.381 / std::sqrt(2.0 * dimension);
+            if (gsl_rng_uniform(rng) < full_jump_probability) {
+                gamma = 1.0;
+            }
+
+            // trial = last + gamma (a - b) + noise
+            for (unsigned int i = 0; i < dimension; ++i) {
+                double noise = noise_scale * std::sqrt(gsl_matrix_get(
+                        seed_covariance, i, i)) * gsl_ran_ugaussian(rng);
+                gsl_vector_set(trial_parameters, i,
+                        gsl_vector_get(last_parameters, i) + gamma *
+                        (gsl_vector_get(parameters_a, i) -
+                        gsl_vector_get(parameters_b, i)) + noise);
+            }
+        }
+
+        double LogHastingsRatio(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_vector const* trial_parameters) {
+            return 0.0;
+        }
+
+        void UpdateState(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_vector const* trial_parameters) {
+        }
+
+    private:
+        Mcmc::McmcScan& scan_;
+    };
+
+}
+
+#endif	/* MCMC_DIFFERENTIALEVOLUTIONPROPOSAL_H */
+
@@ -0,0 +1,308 @@
+/*
+ * File:   FixedDimensionGaussianProposal.h
+ * Author: donerkebab
+ *
+ * The adaptive Gaussian proposal of Mcmc::AdaptiveGaussianProposal, for
+ * scans whose dimension D is known at compile time, to be passed to
+ * McmcScan::Run(proposal).  Meant for small problems, say D up to 8, where
+ * the GSL vectors and matrices of Mcmc::AdaptiveGaussianProposal and the
+ * generic BLAS calls on them cost more than the algebra itself.
+ *
+ * The policy keeps its own copy of the last points' mean, covariance matrix,
+ * Cholesky decomposition and log determinant, in std::array objects, and
+ * updates them in O(D^2) when a trial point is accepted.  The Cholesky
+ * decomposition of the trial covariance matrix is recomputed from scratch
+ * for each trial point instead of being updated, which for small D is
+ * cheaper than the rank-1 update and downdate, and never has to fall back.
+ * The quadratic forms of the proposal densities go through triangular solves
+ * with the Cholesky decompositions, so no inverse is kept.
+ *
+ * The mean and covariance are computed from the chains' last points at the
+ * first Propose(), and again every kRefreshInterval accepted trial points,
+ * to wash out rounding errors.  In between, they are only updated with the
+ * policy's own accepted points, which is an approximation in two ways:
+ * their rounding errors build up over as many as kRefreshInterval updates,
+ * so the Hastings ratios only agree with the default proposal's to about
+ * 1E-6, not bit for bit; and a chain that moves without the policy, say
+ * in a Run() between two Run(proposal) calls with the same policy, only
+ * shows up at the next recomputation.  They only cover the scan's own
+ * chains, so the policy does not take part in distributed mode.  Unlike the
+ * default proposal, it does not redraw trial points that are not valid, so
+ * the scan rejects them.
+ *
+ * Dev notes:
+ * * Every loop bound is a compile-time constant, so that the compiler can
+ *   unroll the kernels completely for small D.
+ * * Only the lower triangles of the matrices are used.
+ * * The methods are defined here, since this is a class template.
+ *
+ * Created on May 6, 2014, 7:48 PM
+ */
+
+#ifndef MCMC_FIXEDDIMENSIONGAUSSIANPROPOSAL_H
+#define	MCMC_FIXEDDIMENSIONGAUSSIANPROPOSAL_H
+
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_vector.h>
+
+#include "McmcScan.h"
+#include "PositiveDefiniteError.h"
+
+namespace Mcmc {
+
+    template <unsigned int D>
+    class FixedDimensionGaussianProposal {
+    public:
+        /*
+         * throws std::invalid_argument if the scan's dimension is not D
+         */
+        explicit FixedDimensionGaussianProposal(Mcmc::McmcScan const& scan);
+
+        /*
+         * throws Mcmc::PositiveDefiniteError if the last points' covariance
+         * matrix is not positive definite when it is recomputed
+         */
+        void Propose(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_rng* rng,
+                gsl_vector* trial_parameters);
+
+        /*
+         * throws Mcmc::PositiveDefiniteError if trial covariance matrix is
+         * not positive definite
+         */
+        double LogHastingsRatio(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_vector const* trial_parameters);
+
+        // Must follow LogHastingsRatio() for the same trial point
+        void UpdateState(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_vector const* trial_parameters);
+
+        // Number of accepted trial points between recomputations
+        static unsigned int const kRefreshInterval = 1000;
+
+    private:
+        static_assert(D > 0, "dimension must be positive");
+
+        typedef std::array<double, D> Vector;
+        // Row-major
+        typedef std::array<double, D * D> Matrix;
+
+        /*
+         * Recomputes the mean, covariance matrix, Cholesky decomposition and
+         * log determinant from the chains' last points.
+         *
+         * throws Mcmc::PositiveDefiniteError if covariance matrix is not
+         * positive definite
+         */
+        void Refresh();
+
+        /*
+         * Computes the Cholesky decomposition and log determinant of the
+         * given covariance matrix.
+         *
+         * throws Mcmc::PositiveDefiniteError if covariance matrix is not
+         * positive definite
+         */
+        static void Factor(Matrix const& covariance,
+                Matrix& cholesky,
+                double& logdet);
+
+        /*
+         * Calculates v^T C^-1 v, for the Cholesky decomposition L of C, as
+         * |L^-1 v|^2.
+         */
+        static double InverseQuadraticForm(Matrix const& cholesky,
+                Vector const& v);
+
+        Mcmc::McmcScan const& scan_;
+        double const f_;
+        // Starts at kRefreshInterval, so that the first Propose() computes
+        // everything
+        unsigned int num_updates_;
+
+        Vector mean_;
+        Matrix covariance_;
+        Matrix cholesky_;
+        double logdet_;
+
+        // Set by LogHastingsRatio()
+        Vector trial_mean_;
+        Matrix trial_covariance_;
+        Matrix trial_cholesky_;
+        double trial_logdet_;
+    };
+
+    template <unsigned int D>
+    FixedDimensionGaussianProposal<D>::FixedDimensionGaussianProposal(
+            Mcmc::McmcScan const& scan)
+    : scan_(scan),
+    f_(2.381 / std::sqrt(D)),
+    num_updates_(kRefreshInterval),
+    logdet_(0.0),
+    trial_logdet_(0.0) {
+        if (scan.dimension() != D) {
+            throw std::invalid_argument("scan dimension does not match the "
+                    "proposal's");
+        }
+    }
+
+    template <unsigned int D>
+    void FixedDimensionGaussianProposal<D>::Propose(unsigned int i_chain,
+            gsl_vector const* last_parameters,
+            gsl_rng* rng,
+            gsl_vector* trial_parameters) {
+        if (num_updates_ >= kRefreshInterval) {
+            Refresh();
+        }
+
+        // trial = last + f L z, for a vector z of unit Gaussians
+        Vector z;
+        for (unsigned int i = 0; i < D; ++i) {
+            z[i] = gsl_ran_ugaussian(rng);
+        }
+        for (unsigned int i = 0; i < D; ++i) {
+            double shift = 0.0;
+            for (unsigned int j = 0; j <= i; ++j) {
+                shift += cholesky_[i * D + j] * z[j];
+            }
+            gsl_vector_set(trial_parameters, i,
+                    gsl_vector_get(last_parameters, i) + f_ * shift);
+        }
+    }
+
+    template <unsigned int D>
+    double FixedDimensionGaussianProposal<D>::LogHastingsRatio(
+            unsigned int i_chain,
+            gsl_vector const* last_parameters,
+            gsl_vector const* trial_parameters) {
+        double n = scan_.num_chains();
+
+        // shift = trial_parameters - last_parameters
+        // deviation = last_parameters - mean
+        Vector shift;
+        Vector deviation;
+        for (unsigned int i = 0; i < D; ++i) {
+            shift[i] = gsl_vector_get(trial_parameters, i) -
+                    gsl_vector_get(last_parameters, i);
+            deviation[i] = gsl_vector_get(last_parameters, i) - mean_[i];
+            trial_mean_[i] = mean_[i] + shift[i] / n;
+        }
+
+        // C' = C + (deviation shift^T + shift deviation^T +
+        //           (1 - 1/n) shift shift^T) / n
+        for (unsigned int i = 0; i < D; ++i) {
+            for (unsigned int j = 0; j <= i; ++j) {
+                trial_covariance_[i * D + j] = covariance_[i * D + j] +
+                        (deviation[i] * shift[j] + shift[i] * deviation[j] +
+                        (1.0 - 1.0 / n) * shift[i] * shift[j]) / n;
+            }
+        }
+        Factor(trial_covariance_, trial_cholesky_, trial_logdet_);
+
+        // log of sqrt(|C| / |C'|) exp(-shift^T (C'^-1 - C^-1) shift / 2 f^2)
+        double linear_algebra_part =
+                InverseQuadraticForm(trial_cholesky_, shift) -
+                InverseQuadraticForm(cholesky_, shift);
+        return (logdet_ - trial_logdet_) / 2.0 -
+                linear_algebra_part / (2.0 * f_ * f_);
+    }
+
+    template <unsigned int D>
+    void FixedDimensionGaussianProposal<D>::UpdateState(unsigned int i_chain,
+            gsl_vector const* last_parameters,
+            gsl_vector const* trial_parameters) {
+        mean_ = trial_mean_;
+        covariance_ = trial_covariance_;
+        cholesky_ = trial_cholesky_;
+        logdet_ = trial_logdet_;
+        ++num_updates_;
+    }
+
+    template <unsigned int D>
+    void FixedDimensionGaussianProposal<D>::Refresh() {
+        unsigned int num_chains = scan_.num_chains();
+
+        mean_.fill(0.0);
+        for (unsigned int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            gsl_vector const* parameters = scan_.last_parameters(i_chain);
+            for (unsigned int i = 0; i < D; ++i) {
+                mean_[i] += gsl_vector_get(parameters, i) / num_chains;
+            }
+        }
+
+        covariance_.fill(0.0);
+        for (unsigned int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            gsl_vector const* parameters = scan_.last_parameters(i_chain);
+            Vector deviation;
+            for (unsigned int i = 0; i < D; ++i) {
+                deviation[i] = gsl_vector_get(parameters, i) - mean_[i];
+            }
+            for (unsigned int i = 0; i < D; ++i) {
+                for (unsigned int j = 0; j <= i; ++j) {
+                    covariance_[i * D + j] += deviation[i] * deviation[j] /
+                            num_chains;
+                }
+            }
+        }
+
+        Factor(covariance_, cholesky_, logdet_);
+        num_updates_ = 0;
+    }
+
+    template <unsigned int D>
+    void FixedDimensionGaussianProposal<D>::Factor(Matrix const& covariance,
+            Matrix& cholesky,
+            double& logdet) {
+        logdet = 0.0;
+        for (unsigned int j = 0; j < D; ++j) {
+            double diagonal = covariance[j * D + j];
+            for (unsigned int k = 0; k < j; ++k) {
+                diagonal -= cholesky[j * D + k] * cholesky[j * D + k];
+            }
+            if (!(diagonal > 0.0)) {
+                throw Mcmc::PositiveDefiniteError();
+            }
+            double l_jj = std::sqrt(diagonal);
+            cholesky[j * D + j] = l_jj;
+            logdet += 2.0 * std::log(l_jj);
+
+            for (unsigned int i = j + 1; i < D; ++i) {
+                double element = covariance[i * D + j];
+                for (unsigned int k = 0; k < j; ++k) {
+                    element -= cholesky[i * D + k] * cholesky[j * D + k];
+                }
+                cholesky[i * D + j] = element / l_jj;
+            }
+        }
+    }
+
+    template <unsigned int D>
+    double FixedDimensionGaussianProposal<D>::InverseQuadraticForm(
+            Matrix const& cholesky,
+            Vector const& v) {
+        // Forward substitution for y = L^-1 v
+        Vector y;
+        double result = 0.0;
+        for (unsigned int i = 0; i < D; ++i) {
+            double element = v[i];
+            for (unsigned int k = 0; k < i; ++k) {
+                element -= cholesky[i * D + k] * y[k];
+            }
+            y[i] = element / cholesky[i * D + i];
+            result += y[i] * y[i];
+        }
+        return result;
+    }
+
+}
+
+#endif	/* MCMC_FIXEDDIMENSIONGAUSSIANPROPOSAL_H */
+
@@ -7,58 +7,108 @@
 
 #include "MarkovChain.h"
 
-#include <cstdio>
-
+#include <algorithm>
 #include <memory>
-#include <queue>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "ChainFlushError.h"
+#include "ChainWriter.h"
 #include "Point.h"
+#include "PosteriorAccumulator.h"
+#include "TextChainWriter.h"
+
+namespace { // unnamed namespace
+    /*
+     * Number of the positions begin, ..., end - 1 that the output policy 
+     * of first_written and thinning keeps.
+     */
+    unsigned int NumPositionsKept(unsigned int begin,
+            unsigned int end,
+            unsigned int first_written,
+            unsigned int thinning) {
+        unsigned long long first = std::max(begin, first_written);
+        if ( first >= end ) {
+            return 0;
+        }
+        // Kept positions are first_written + k thinning, for k in
+        // [k_first, k_last]
+        unsigned long long k_first = (first - first_written + thinning - 1) / 
+                thinning;
+        unsigned long long k_last = (end - 1ULL - first_written) / thinning;
+        return k_last >= k_first ? k_last - k_first + 1 : 0;
+    }
+}
 
 namespace Mcmc {
     
+    unsigned int const MarkovChain::kNeverWritten;
+    
     MarkovChain::MarkovChain(std::shared_ptr<Mcmc::Point> point,
             std::string filename,
             unsigned int buffer_size)
-    : filename_(filename),
+    : MarkovChain(point, filename, buffer_size, 0)
+    {
+    }
+
+    MarkovChain::MarkovChain(std::shared_ptr<Mcmc::Point> point,
+            std::string filename,
+            unsigned int buffer_size,
+            unsigned int num_points_flushed)
+    : MarkovChain(point, std::unique_ptr<Mcmc::ChainWriter>(
+            new Mcmc::TextChainWriter(filename)), 
+            buffer_size, num_points_flushed)
+    {
+    }
+
+    MarkovChain::MarkovChain(std::shared_ptr<Mcmc::Point> point,
+            std::unique_ptr<Mcmc::ChainWriter> writer,
+            unsigned int buffer_size,
+            unsigned int num_points_flushed)
+    : writer_(std::move(writer)),
             buffer_size_(buffer_size),
-            num_points_flushed_(0)
+            num_points_flushed_(num_points_flushed),
+            first_written_(0),
+            thinning_(1),
+            num_points_written_(0),
+            num_points_buffered_(1),
+            accumulated_weight_(0)
     {
         if ( point.get() == nullptr ) {
             throw std::invalid_argument("null point used to initialize chain");
         }
-        if ( filename == "" ) {
-            throw std::invalid_argument("invalid filename");
+        if ( writer_.get() == nullptr ) {
+            throw std::invalid_argument("null writer used to initialize chain");
         }
         if ( buffer_size == 0 ) {
             throw std::invalid_argument("cannot have zero buffer size");
         }
-        
-        // Also check to see if there are any issues opening the output file
-        std::FILE* output_file = std::fopen(filename_.c_str(), "a");
-        if ( output_file == nullptr ) {
-            throw Mcmc::ChainFlushError();
-        } else {
-            std::fclose(output_file);
-        }
-
-        buffer_.push(point);        
 
+        run_points_.reserve(buffer_size_);
+        run_lengths_.reserve(buffer_size_);
+        run_points_.push_back(point);
+        run_lengths_.push_back(1);
     }
 
     MarkovChain::~MarkovChain() {
+        // The last run goes into the accumulator.  A destructor must not 
+        // throw, so a point that does not fit the accumulator is dropped.
+        if ( accumulated_weight_ > 0 ) {
+            try {
+                accumulator_->Add(*accumulated_point_, accumulated_weight_);
+            } catch (std::invalid_argument& e) {
+            }
+        }
+
         // Need to flush all of the Point objects from the chain, including the
-        // last one.  Save on coding complexity by adding a new dummy Point to 
-        // the buffer, and then simply calling Flush().
-        
-        buffer_.push(std::shared_ptr<Mcmc::Point>(
-                new Mcmc::Point(gsl_vector_alloc(1), gsl_vector_alloc(1), 0.)));
-        Flush();
+        // last one
+        Flush(false);
     }
 
     std::string MarkovChain::filename() const {
-        return filename_;
+        return writer_->filename();
     }
     
     unsigned int MarkovChain::buffer_size() const {
@@ -66,7 +116,7 @@ namespace Mcmc {
     }
     
     unsigned int MarkovChain::num_points_buffered() const {
-        return buffer_.size();
+        return num_points_buffered_;
     }
     
     unsigned int MarkovChain::num_points_flushed() const {
@@ -74,60 +124,168 @@ namespace Mcmc {
     }
     
     unsigned int MarkovChain::length() const {
-        return buffer_.size() + num_points_flushed_;
+        return num_points_buffered_ + num_points_flushed_;
     }
     
     std::shared_ptr<Mcmc::Point> MarkovChain::last_point() const {
-        return buffer_.back();
+        return run_points_.back();
     }
     
-    void MarkovChain::Append(std::shared_ptr<Mcmc::Point> point) {
+    unsigned int MarkovChain::first_written() const {
+        return first_written_;
+    }
+    
+    unsigned int MarkovChain::thinning() const {
+        return thinning_;
+    }
+    
+    unsigned int MarkovChain::num_points_written() const {
+        return num_points_written_;
+    }
+    
+    void MarkovChain::Append(std::shared_ptr<Mcmc::Point> const& point) {
         if ( point.get() == nullptr ) {
             throw std::invalid_argument("null point appended");
         }
+
+        if ( accumulator_.get() != nullptr ) {
+            if ( point == accumulated_point_ ) {
+                ++accumulated_weight_;
+            } else {
+                if ( accumulated_weight_ > 0 ) {
+                    accumulator_->Add(*accumulated_point_, 
+                            accumulated_weight_);
+                }
+                accumulated_point_ = point;
+                accumulated_weight_ = 1;
+            }
+        }
         
-        buffer_.push(point);
+        // Another copy of the last point only lengthens its run
+        if ( point == run_points_.back() ) {
+            ++run_lengths_.back();
+        } else {
+            run_points_.push_back(point);
+            run_lengths_.push_back(1);
+        }
+        ++num_points_buffered_;
         
-        if ( buffer_.size() >= buffer_size_ ) {
+        if ( num_points_buffered_ >= buffer_size_ ) {
             Flush();
         }
     }
     
     void MarkovChain::Flush() {
-        if ( buffer_.size() == 1 ) {
+        Flush(true);
+    }
+    
+    void MarkovChain::Flush(bool keep_last_point) {
+        unsigned int num_kept = keep_last_point ? 1 : 0;
+        if ( num_points_buffered_ == num_kept ) {
             return;
         }
         
-        std::FILE* output_file = std::fopen(filename_.c_str(), "a");
-        if ( output_file == nullptr ) {
-            throw Mcmc::ChainFlushError();
+        // Hand the writer everything except the points kept back, leaving 
+        // the buffer as it is until the points have been written 
+        // successfully.  The last run is written without the kept copy, if
+        // there are any others.
+        unsigned int num_runs = run_points_.size();
+        run_lengths_.back() -= num_kept;
+        if ( run_lengths_.back() == 0 ) {
+            --num_runs;
+        }
+        unsigned int num_written;
+        try {
+            num_written = WriteRuns(num_runs);
+        } catch (...) {
+            run_lengths_.back() += num_kept;
+            throw;
+        }
+        num_points_flushed_ += num_points_buffered_ - num_kept;
+        num_points_written_ += num_written;
+        num_points_buffered_ = num_kept;
+        
+        // Start the buffer over with the kept copy at the front
+        if ( keep_last_point ) {
+            if ( run_points_.size() > 1 ) {
+                run_points_.front() = std::move(run_points_.back());
+            }
+            run_points_.resize(1);
+            run_lengths_.resize(1);
+            run_lengths_.front() = 1;
         } else {
-            while ( buffer_.size() > 1 ) {
-                std::shared_ptr<Mcmc::Point> point = buffer_.front();
-                
-                gsl_vector const* parameters = point->parameters();
-                for ( int i = 0; i < parameters->size; ++i ) {
-                    std::fprintf(output_file, "%- 9.8E  ", 
-                            gsl_vector_get(parameters, i));
-                }
-                std::fprintf(output_file, "\n");
-                
-                gsl_vector const* measurements = point->measurements();
-                for ( int i = 0; i < measurements->size; ++i) {
-                    std::fprintf(output_file, "%- 9.8E  ", 
-                            gsl_vector_get(measurements, i));
-                }
-                std::fprintf(output_file, "\n");
-                
-                std::fprintf(output_file, "%- 9.8E\n", point->likelihood());
-                std::fprintf(output_file, "\n");
-                
-                buffer_.pop();
-                ++num_points_flushed_;
+            run_points_.clear();
+            run_lengths_.clear();
+        }
+    }
+    
+    unsigned int MarkovChain::WriteRuns(unsigned int num_runs) {
+        if ( num_runs == 0 ) {
+            return 0;
+        }
+        
+        if ( first_written_ <= num_points_flushed_ && thinning_ == 1 ) {
+            writer_->Write(run_points_.data(), run_lengths_.data(), num_runs);
+            unsigned int num_written = 0;
+            for ( unsigned int i = 0; i < num_runs; ++i ) {
+                num_written += run_lengths_[i];
+            }
+            return num_written;
+        }
+        
+        // Consecutive runs are of different points, so the runs that are 
+        // thinned rather than dropped stay runs
+        written_points_.clear();
+        written_multiplicities_.clear();
+        unsigned int num_written = 0;
+        unsigned int position = num_points_flushed_;
+        for ( unsigned int i = 0; i < num_runs; ++i ) {
+            unsigned int multiplicity = NumPositionsKept(position, 
+                    position + run_lengths_[i], first_written_, thinning_);
+            if ( multiplicity > 0 ) {
+                written_points_.push_back(run_points_[i]);
+                written_multiplicities_.push_back(multiplicity);
+                num_written += multiplicity;
             }
-            
-            std::fclose(output_file);
+            position += run_lengths_[i];
         }
-    }   
+        // Let go of the copies either way, so that the points can be freed
+        try {
+            if ( !written_points_.empty() ) {
+                writer_->Write(written_points_.data(), 
+                        written_multiplicities_.data(), 
+                        written_points_.size());
+            }
+        } catch (...) {
+            written_points_.clear();
+            throw;
+        }
+        written_points_.clear();
+        return num_written;
+    }
         
+    void MarkovChain::Sync() {
+        Flush();
+        writer_->Sync();
+    }
+
+    void MarkovChain::SetAccumulator(
+            std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator) {
+        if ( accumulated_weight_ > 0 ) {
+            accumulator_->Add(*accumulated_point_, accumulated_weight_);
+        }
+        accumulator_ = accumulator;
+        accumulated_point_.reset();
+        accumulated_weight_ = 0;
+    }
+
+    void MarkovChain::SetOutputPolicy(unsigned int first_written,
+            unsigned int thinning) {
+        if ( thinning == 0 ) {
+            throw std::invalid_argument("cannot have zero thinning");
+        }
+        first_written_ = first_written;
+        thinning_ = thinning;
+    }
+
 }
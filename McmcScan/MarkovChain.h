@@ -3,10 +3,16 @@
  * Author: donerkebab
  *
  * Represents a Markov chain of Point objects in the parameter space.  The chain
- * has a fixed buffer size and is tied to a text output file.  When the number
- * of buffered points reaches the buffer size, the chain flushes all except the
+ * has a fixed buffer size and is tied to an output file.  When the number of
+ * buffered points reaches the buffer size, the chain flushes all except the
  * last point into the output file.  The user may also flush the chain manually.
  * 
+ * The output format is up to a Mcmc::ChainWriter, which the chain owns.  When
+ * the chain is given only a filename, it writes text with a 
+ * Mcmc::TextChainWriter.  On flushing, consecutive copies of the same Point 
+ * object are coalesced into runs, so that a run-length encoded writer can 
+ * write each of them once.  num_points_flushed() still counts every copy.
+ * 
  * If there are problems opening the output file, either when the MarkovChain is
  * constructed or during flushing, it throws a McmcScan::ChainFlushError.  If
  * this happens during construction, the MarkovChain will fail to initialize.  
@@ -18,16 +24,32 @@
  * use, the chain will contain many consecutive duplicate Point objects.
  * Storing them as pointers allows us to save considerable memory, and using
  * shared_ptr only frees the Point objects' memory when the last pointer is
- * flushed.
+ * flushed.  The buffer holds one pointer per run of copies of the same Point
+ * object, together with the run's length, so appending another copy of the
+ * last point only counts it.
+ * 
+ * A chain may be given a Mcmc::PosteriorAccumulator, which then gets every
+ * point appended from then on, with consecutive copies of the same Point 
+ * object added once, weighted by their number.  A run is added when a 
+ * different point is appended, or when the accumulator is replaced or the 
+ * chain is destroyed, so a run still going on is not in the accumulator yet.
+ * 
+ * The chain's output policy decides which points reach the output file: only
+ * the points from position first_written on, and of those only every 
+ * thinning-th.  The others are dropped when the buffer is flushed, but still 
+ * count as flushed.  A run of copies of the same point is written with the
+ * number of its copies that were kept, so the output stays a valid, thinned
+ * chain.  By default, every point is written.
  * 
  * Terminology: chain "length" is considered to be the sum of the number of 
  * currently buffered points and the number of points already flushed.
  * 
  * Dev notes:
- * * I use a queue for the buffer, in order to internally mostly-enforce the
- *   rule that the system can only depend on the last point of the chain.  It
- *   also has the advantage of being based on deque, which can store elements in
- *   discontinuous memory blocks to avoid resizing/reallocation issues.
+ * * The buffer's arrays are reserved for buffer_size runs up front, and a 
+ *   flush always leaves only the last point, so appending and flushing do not
+ *   allocate.  Only a buffer that could not be flushed grows past that.
+ * * The runs are written straight from the buffer's arrays when the output
+ *   policy keeps every point, so a flush normally copies no pointers at all.
  * * Copy constructor is not supported because a copy of the chain would flush
  *   to the same output file.
  * 
@@ -37,12 +59,15 @@
 #ifndef MCMC_MARKOVCHAIN_H
 #define	MCMC_MARKOVCHAIN_H
 
+#include <limits>
 #include <memory>
-#include <queue>
 #include <string>
+#include <vector>
 
 #include "Point.h"
 #include "ChainFlushError.h"
+#include "ChainWriter.h"
+#include "PosteriorAccumulator.h"
 
 namespace Mcmc {
     
@@ -52,6 +77,28 @@ namespace Mcmc {
         MarkovChain(std::shared_ptr<Mcmc::Point> point,
                 std::string filename,
                 unsigned int buffer_size);
+        /*
+         * Reattaches a chain to an output file that already holds 
+         * num_points_flushed points, e.g. when resuming a scan from a 
+         * checkpoint.  point is the chain's last point, which has not been
+         * flushed yet.
+         * 
+         * throws Mcmc::ChainFlushError if output file cannot be opened
+         */
+        MarkovChain(std::shared_ptr<Mcmc::Point> point,
+                std::string filename,
+                unsigned int buffer_size,
+                unsigned int num_points_flushed);
+        /*
+         * Writes to the output file through the given writer, which the chain
+         * takes over.  num_points_flushed is as above.
+         * 
+         * throws std::invalid_argument if writer is null
+         */
+        MarkovChain(std::shared_ptr<Mcmc::Point> point,
+                std::unique_ptr<Mcmc::ChainWriter> writer,
+                unsigned int buffer_size,
+                unsigned int num_points_flushed);
         virtual ~MarkovChain();
         
         std::string filename() const;
@@ -60,20 +107,86 @@ namespace Mcmc {
         unsigned int num_points_flushed() const;
         unsigned int length() const;
         std::shared_ptr<Mcmc::Point> last_point() const;
+        unsigned int first_written() const;
+        unsigned int thinning() const;
+        // Number of points that reached the writer since construction
+        unsigned int num_points_written() const;
         
         // throws Mcmc::ChainFlushError if output file cannot be opened
-        void Append(std::shared_ptr<Mcmc::Point> point);
+        void Append(std::shared_ptr<Mcmc::Point> const& point);
         // throws Mcmc::ChainFlushError if output file cannot be opened
         void Flush();
+        /*
+         * Flushes, and then blocks until everything flushed so far is in the
+         * output file, even if the writer writes in the background.
+         * 
+         * throws Mcmc::ChainFlushError if output file cannot be written
+         */
+        void Sync();
+        /*
+         * Adds every point appended from now on to the given accumulator, or
+         * to none if it is null.  The run of the last point is added to the
+         * old accumulator first, if there is one.
+         * 
+         * throws std::invalid_argument if the old accumulator rejects the 
+         * run, see Mcmc::PosteriorAccumulator::Add()
+         */
+        void SetAccumulator(std::shared_ptr<Mcmc::PosteriorAccumulator>
+                accumulator);
+        /*
+         * Writes only the points at positions first_written, first_written +
+         * thinning, first_written + 2 thinning, ... from the next flush on,
+         * with the positions counted from the start of the chain.  Pass 
+         * kNeverWritten as first_written to write nothing for now.
+         * 
+         * throws std::invalid_argument if thinning is zero
+         */
+        void SetOutputPolicy(unsigned int first_written,
+                unsigned int thinning);
+        
+        static unsigned int const kNeverWritten =
+                std::numeric_limits<unsigned int>::max();
         
     private:
         MarkovChain(MarkovChain const& orig);
         void operator=(MarkovChain const& orig);
 
-        std::queue<std::shared_ptr<Mcmc::Point> > buffer_;
-        std::string const filename_;
+        /*
+         * Flushes the whole buffer, or all except the last point if 
+         * keep_last_point is set.
+         * 
+         * throws Mcmc::ChainFlushError if output file cannot be opened
+         */
+        void Flush(bool keep_last_point);
+        /*
+         * Hands the writer the points of the first num_runs runs of the 
+         * buffer that the output policy keeps, and returns their number.
+         */
+        unsigned int WriteRuns(unsigned int num_runs);
+
+        std::unique_ptr<Mcmc::ChainWriter> const writer_;
         unsigned int const buffer_size_;
         unsigned int num_points_flushed_;
+        unsigned int first_written_;
+        unsigned int thinning_;
+        unsigned int num_points_written_;
+
+        // The buffer, as runs of copies of the same Point object, oldest 
+        // first, in parallel arrays that the writer can take as they are.  
+        // A flush moves the last run to the front, so that the buffer always
+        // starts at the front.
+        std::vector<std::shared_ptr<Mcmc::Point> > run_points_;
+        std::vector<unsigned int> run_lengths_;
+        unsigned int num_points_buffered_;
+        // Kept between flushes, for the runs that the output policy thins
+        std::vector<std::shared_ptr<Mcmc::Point> > written_points_;
+        std::vector<unsigned int> written_multiplicities_;
+
+        // Only set while accumulating.  The run of accumulated_point_, 
+        // accumulated_weight_ copies so far, is not in the accumulator yet.
+        std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator_;
+        std::shared_ptr<Mcmc::Point> accumulated_point_;
+        unsigned int accumulated_weight_;
     };
     
 }
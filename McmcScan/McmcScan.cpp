@@ -8,27 +8,239 @@
 #include "McmcScan.h"
 
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
 
-#include <array>
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include <gsl/gsl_blas.h>
-#include <gsl/gsl_linalg.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <gsl/gsl_errno.h>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_matrix.h>
-#include <gsl/gsl_randist.h>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_vector.h>
 
+#include "AsyncChainWriter.h"
+#include "AdaptiveGaussianProposal.h"
+#include "AutocorrelationMonitor.h"
+#include "BinaryChainWriter.h"
 #include "ChainFlushError.h"
+#include "ChainWriter.h"
+#include "CheckpointError.h"
+#include "CompressedChainWriter.h"
+#include "ConvergenceMonitor.h"
+#include "CoordinatorError.h"
+#include "CoordinatorProtocol.h"
+#include "DifferentialEvolutionProposal.h"
 #include "MarkovChain.h"
+#include "MeasurementCache.h"
+#include "OutputThread.h"
+#include "Point.h"
+#include "PointPool.h"
 #include "PositiveDefiniteError.h"
+#include "PosteriorAccumulator.h"
+#include "ScanWorkspace.h"
+#include "StretchMoveProposal.h"
+#include "TextChainWriter.h"
+#include "ThreadPool.h"
+
+namespace { // unnamed namespace
+    // First bytes of every checkpoint file, including a format version
+    char const kCheckpointMagic[8] = {'M', 'C', 'M', 'C', 'C', 'K', 'P', '3'};
+
+    /*
+     * Helpers for the binary checkpoint format.  Everything is written in the
+     * machine's native representation, so a checkpoint can only be read on 
+     * the same kind of machine that wrote it.  All of them throw 
+     * Mcmc::CheckpointError if the file cannot be written or read.
+     */
+    template <typename T>
+    void WriteValue(std::FILE* file, T const& value) {
+        if (std::fwrite(&value, sizeof(T), 1, file) != 1) {
+            throw Mcmc::CheckpointError("could not write checkpoint");
+        }
+    }
+
+    template <typename T>
+    T ReadValue(std::FILE* file) {
+        T value;
+        if (std::fread(&value, sizeof(T), 1, file) != 1) {
+            throw Mcmc::CheckpointError("checkpoint file is truncated");
+        }
+        return value;
+    }
+
+    void WriteString(std::FILE* file, std::string const& value) {
+        WriteValue<std::uint32_t>(file, value.size());
+        if (std::fwrite(value.data(), 1, value.size(), file) != 
+                value.size()) {
+            throw Mcmc::CheckpointError("could not write checkpoint");
+        }
+    }
+
+    std::string ReadString(std::FILE* file) {
+        std::string value(ReadValue<std::uint32_t>(file), '\0');
+        if (std::fread(&value[0], 1, value.size(), file) != value.size()) {
+            throw Mcmc::CheckpointError("checkpoint file is truncated");
+        }
+        return value;
+    }
+
+    // Vectors are written with their size, since the number of measurements
+    // is not known in advance
+    void WriteVector(std::FILE* file, gsl_vector const* vector) {
+        WriteValue<std::uint32_t>(file, vector->size);
+        if (gsl_vector_fwrite(file, vector) != GSL_SUCCESS) {
+            throw Mcmc::CheckpointError("could not write checkpoint");
+        }
+    }
+
+    // The result is newly allocated within the function
+    gsl_vector* ReadVector(std::FILE* file) {
+        std::uint32_t size = ReadValue<std::uint32_t>(file);
+        if (size == 0) {
+            throw Mcmc::CheckpointError("checkpoint file is corrupt");
+        }
+        gsl_vector* vector = gsl_vector_alloc(size);
+        if (gsl_vector_fread(file, vector) != GSL_SUCCESS) {
+            gsl_vector_free(vector);
+            throw Mcmc::CheckpointError("checkpoint file is truncated");
+        }
+        return vector;
+    }
+
+    template <typename T>
+    void WriteValues(std::FILE* file, std::vector<T> const& values) {
+        WriteValue<std::uint32_t>(file, values.size());
+        if (std::fwrite(values.data(), sizeof(T), values.size(), file) !=
+                values.size()) {
+            throw Mcmc::CheckpointError("could not write checkpoint");
+        }
+    }
+
+    template <typename T>
+    std::vector<T> ReadValues(std::FILE* file) {
+        std::vector<T> values(ReadValue<std::uint32_t>(file));
+        if (std::fread(values.data(), sizeof(T), values.size(), file) !=
+                values.size()) {
+            throw Mcmc::CheckpointError("checkpoint file is truncated");
+        }
+        return values;
+    }
+
+    /*
+     * Writes whether there is a monitor, and if so its state.  Monitor is 
+     * any class with GetState() and SetState().
+     */
+    template <typename Monitor>
+    void WriteMonitor(std::FILE* file, Monitor const* monitor) {
+        WriteValue<std::uint8_t>(file, monitor != nullptr);
+        if (monitor != nullptr) {
+            std::vector<unsigned long> counts;
+            std::vector<double> sums;
+            monitor->GetState(counts, sums);
+            WriteValues(file, counts);
+            WriteValues(file, sums);
+        }
+    }
+
+    /*
+     * Reads what WriteMonitor() wrote, into monitor unless it is null, and
+     * returns whether monitor now holds the state from the checkpoint.
+     */
+    template <typename Monitor>
+    bool ReadMonitor(std::FILE* file, Monitor* monitor) {
+        if (ReadValue<std::uint8_t>(file) == 0) {
+            return false;
+        }
+        std::vector<unsigned long> counts = ReadValues<unsigned long>(file);
+        std::vector<double> sums = ReadValues<double>(file);
+        if (monitor == nullptr) {
+            return false;
+        }
+        try {
+            monitor->SetState(counts, sums);
+        } catch (std::invalid_argument& e) {
+            throw Mcmc::CheckpointError("checkpoint file is corrupt");
+        }
+        return true;
+    }
+
+    // Matrices are always d x d, so only the elements are written
+    void WriteMatrix(std::FILE* file, gsl_matrix const* matrix) {
+        if (gsl_matrix_fwrite(file, matrix) != GSL_SUCCESS) {
+            throw Mcmc::CheckpointError("could not write checkpoint");
+        }
+    }
+
+    void ReadMatrix(std::FILE* file, gsl_matrix* matrix) {
+        if (gsl_matrix_fread(file, matrix) != GSL_SUCCESS) {
+            throw Mcmc::CheckpointError("checkpoint file is truncated");
+        }
+    }
+
+    /*
+     * Returns the size of the file in bytes, or -1 if it cannot be opened.
+     */
+    long FileSize(std::string const& filename) {
+        std::FILE* file = std::fopen(filename.c_str(), "rb");
+        if (file == nullptr) {
+            return -1;
+        }
+        std::fseek(file, 0, SEEK_END);
+        long size = std::ftell(file);
+        std::fclose(file);
+        return size;
+    }
+
+    // How long a worker keeps trying to reach the coordinator, which may
+    // still be starting up
+    unsigned int const kConnectAttempts = 1000;
+    unsigned int const kConnectRetryMicroseconds = 10000;
+
+    /*
+     * Connects to the coordinator listening on socket_path, and returns the
+     * socket.
+     * 
+     * throws Mcmc::CoordinatorError if it cannot be reached
+     */
+    int ConnectToCoordinator(std::string const& socket_path) {
+        sockaddr_un address;
+        if (socket_path.size() >= sizeof(address.sun_path)) {
+            throw Mcmc::CoordinatorError("socket path is too long");
+        }
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, socket_path.c_str());
+
+        for (unsigned int i = 0; i < kConnectAttempts; ++i) {
+            int coordinator_socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (coordinator_socket < 0) {
+                throw Mcmc::CoordinatorError("could not create socket");
+            }
+            if (::connect(coordinator_socket,
+                    reinterpret_cast<sockaddr*>(&address),
+                    sizeof(address)) == 0) {
+                return coordinator_socket;
+            }
+            ::close(coordinator_socket);
+            ::usleep(kConnectRetryMicroseconds);
+        }
+        throw Mcmc::CoordinatorError("could not connect to " + socket_path);
+    }
+}
 
 namespace Mcmc {
 
@@ -40,7 +252,45 @@ namespace Mcmc {
     num_chains_(num_chains),
     max_steps_(max_steps),
     burn_fraction_(burn_fraction),
-    num_steps_(0) {
+    num_steps_(0),
+    workspace_(nullptr),
+    gaussian_proposal_(nullptr),
+    running_policy_(false),
+    thread_pool_(nullptr),
+    sweep_snapshot_(nullptr),
+    delayed_acceptance_(false),
+    num_surrogate_rejections_(0),
+    differential_evolution_(false),
+    stretch_move_(false),
+    swap_interval_(0),
+    replica_lambda_(1.0),
+    checkpoint_interval_(0),
+    last_checkpoint_step_(0),
+    binary_output_(false),
+    compressed_output_(false),
+    run_length_encoding_(false),
+    output_policy_set_(false),
+    discard_burn_in_(false),
+    output_thinning_(1),
+    output_started_(false),
+    convergence_log_(nullptr),
+    convergence_interval_(0),
+    last_convergence_step_(0),
+    early_stop_threshold_(0.0),
+    last_max_r_hat_(std::numeric_limits<double>::infinity()),
+    accumulating_(false),
+    coordinator_socket_(-1),
+    sync_interval_(0),
+    last_sync_step_(0),
+    ensemble_size_(num_chains),
+    first_ensemble_chain_(0),
+    num_syncs_(0),
+    sync_wait_time_(0.0),
+    autocorrelation_monitor_(new Mcmc::AutocorrelationMonitor(num_chains,
+            dimension)),
+    effective_sample_sizes_(dimension),
+    measuring_time_(0.0),
+    output_wait_time_(0.0) {
         if (dimension == 0 || num_chains == 0 || max_steps == 0 ||
                 burn_fraction < 0.0 || burn_fraction > 1.0) {
             throw std::invalid_argument("invalid input to McmcScan");
@@ -62,11 +312,28 @@ namespace Mcmc {
         for (int i = 0; i < chains_.size(); ++i) {
             delete chains_[i];
         }
+        delete thread_pool_;
         
+        delete workspace_;
+        delete gaussian_proposal_;
+        delete sweep_snapshot_;
+        // Rung 0 shares gaussian_proposal_
+        for (unsigned int i_rung = 0; i_rung < replicas_.size(); ++i_rung) {
+            if (i_rung > 0) {
+                delete replicas_[i_rung].proposal;
+            }
+            gsl_vector_free(replicas_[i_rung].trial_parameters);
+            gsl_vector_free(replicas_[i_rung].trial_measurements);
+        }
+
+        if (convergence_log_ != nullptr) {
+            std::fclose(convergence_log_);
+        }
+        if (coordinator_socket_ >= 0) {
+            ::close(coordinator_socket_);
+        }
+
         gsl_rng_free(rng_);
-        gsl_vector_free(last_points_mean_);
-        gsl_matrix_free(last_points_covariance_);
-        gsl_matrix_free(last_points_covariance_inv_);
     }
 
     void McmcScan::Initialize(unsigned int buffer_size,
@@ -98,355 +365,1640 @@ namespace Mcmc {
         // Initialize the chains
         InitializeChains(buffer_size, chains_info);
 
+        // Allocate everything the step loop needs up front
+        workspace_ = new Mcmc::ScanWorkspace(dimension_, num_chains_);
+        gaussian_proposal_ = new Mcmc::AdaptiveGaussianProposal(*this);
+
         // Initialize the last points' mean, covariance
-        InitializeLastPointsMeanAndCovariance();
+        gaussian_proposal_->Reset();
+    }
+
+    void McmcScan::EnableSweepMode(unsigned int num_threads) {
+        if (num_threads == 0) {
+            throw std::invalid_argument("need at least one thread");
+        }
+        if (StepMode() == "sweep mode") {
+            throw std::logic_error("sweep mode has already been enabled");
+        }
+        CheckStepMode("sweep mode", true);
+
+        thread_pool_ = new Mcmc::ThreadPool(num_threads);
+        sweep_snapshot_ = new Mcmc::AdaptiveGaussianProposal(*this);
+    }
+
+    void McmcScan::EnableDelayedAcceptance() {
+        if (delayed_acceptance_) {
+            throw std::logic_error("delayed-acceptance mode has already been "
+                    "enabled");
+        }
+        CheckStepMode("delayed-acceptance mode", true);
+
+        delayed_acceptance_ = true;
+    }
+
+    void McmcScan::EnableDifferentialEvolution() {
+        if (differential_evolution_) {
+            throw std::logic_error("differential evolution has already been "
+                    "enabled");
+        }
+        if (num_chains_ < 3) {
+            throw std::logic_error("differential evolution needs at least "
+                    "three chains");
+        }
+        CheckStepMode("differential evolution", false);
+
+        differential_evolution_ = true;
+    }
+
+    void McmcScan::EnableStretchMove(unsigned int num_threads) {
+        if (num_threads == 0) {
+            throw std::invalid_argument("need at least one thread");
+        }
+        if (stretch_move_) {
+            throw std::logic_error("stretch moves have already been enabled");
+        }
+        CheckStepMode("stretch moves", false);
+
+        stretch_move_ = true;
+        thread_pool_ = new Mcmc::ThreadPool(num_threads);
+    }
+
+    void McmcScan::EnableParallelTempering(std::vector<double> ladder,
+            unsigned int swap_interval) {
+        if (ladder.empty() || ladder[0] != 1.0 || swap_interval == 0) {
+            throw std::invalid_argument("invalid input to "
+                    "EnableParallelTempering");
+        }
+        for (unsigned int i_rung = 1; i_rung < ladder.size(); ++i_rung) {
+            if (!(ladder[i_rung] > 0.0 &&
+                    ladder[i_rung] < ladder[i_rung - 1])) {
+                throw std::invalid_argument("lambdas must decrease strictly "
+                        "and stay above zero");
+            }
+        }
+        if (!tempering_ladder_.empty()) {
+            throw std::logic_error("parallel tempering has already been "
+                    "enabled");
+        }
+        CheckStepMode("parallel tempering", false);
+
+        tempering_ladder_ = ladder;
+        swap_interval_ = swap_interval;
+        thread_pool_ = new Mcmc::ThreadPool(ladder.size());
+    }
+
+    double McmcScan::swap_acceptance_rate(unsigned int i_rung) const {
+        if (i_rung + 1 >= tempering_ladder_.size()) {
+            throw std::out_of_range("no such pair of rungs");
+        }
+        if (i_rung + 1 >= replicas_.size() ||
+                replicas_[i_rung + 1].num_swaps_proposed == 0) {
+            return 0.0;
+        }
+        return 1.0 * replicas_[i_rung + 1].num_swaps_accepted /
+                replicas_[i_rung + 1].num_swaps_proposed;
+    }
+
+    void McmcScan::UseMeasurementCache(
+            std::shared_ptr<Mcmc::MeasurementCache> cache) {
+        if (cache.get() == nullptr) {
+            throw std::invalid_argument("null measurement cache");
+        }
+        if (measurement_cache_.get() != nullptr) {
+            throw std::logic_error("a measurement cache is already in use");
+        }
+
+        measurement_cache_ = cache;
+    }
+
+    void McmcScan::EnableCheckpoints(std::string filename,
+            unsigned int interval) {
+        if (filename == "") {
+            throw std::invalid_argument("invalid checkpoint filename");
+        }
+        if (interval == 0) {
+            throw std::invalid_argument("cannot have zero checkpoint interval");
+        }
+
+        checkpoint_filename_ = filename;
+        checkpoint_interval_ = interval;
+    }
+
+    void McmcScan::EnableBinaryOutput() {
+        if (binary_output_) {
+            throw std::logic_error("binary output is already enabled");
+        }
+        if (chains_.size() != 0) {
+            throw std::logic_error("chains have already been initialized");
+        }
+
+        binary_output_ = true;
+    }
+
+    void McmcScan::EnableCompressedOutput() {
+        if (compressed_output_) {
+            throw std::logic_error("compressed output is already enabled");
+        }
+        if (!binary_output_) {
+            throw std::logic_error("compression needs binary output");
+        }
+        if (chains_.size() != 0) {
+            throw std::logic_error("chains have already been initialized");
+        }
+
+        compressed_output_ = true;
+    }
+
+    void McmcScan::EnableRunLengthEncoding() {
+        if (run_length_encoding_) {
+            throw std::logic_error("run-length encoding is already enabled");
+        }
+        if (chains_.size() != 0) {
+            throw std::logic_error("chains have already been initialized");
+        }
+
+        run_length_encoding_ = true;
+    }
+
+    void McmcScan::SetOutputPolicy(bool discard_burn_in,
+            unsigned int thinning) {
+        if (thinning == 0) {
+            throw std::invalid_argument("cannot have zero thinning");
+        }
+        if (output_policy_set_) {
+            throw std::logic_error("output policy is already set");
+        }
+        if (chains_.size() != 0) {
+            throw std::logic_error("chains have already been initialized");
+        }
+
+        output_policy_set_ = true;
+        discard_burn_in_ = discard_burn_in;
+        output_thinning_ = thinning;
+    }
+
+    void McmcScan::EnableAutomaticThinning() {
+        if (output_policy_set_) {
+            throw std::logic_error("output policy is already set");
+        }
+        if (chains_.size() != 0) {
+            throw std::logic_error("chains have already been initialized");
+        }
+
+        output_policy_set_ = true;
+        discard_burn_in_ = true;
+        output_thinning_ = 0;
+        // The second half of the burn-in is short, so make do with fewer,
+        // longer batches
+        burn_in_monitor_.reset(new Mcmc::AutocorrelationMonitor(num_chains_,
+                dimension_, 8));
+    }
+
+    void McmcScan::EnableBackgroundOutput() {
+        if (output_thread_.get() != nullptr) {
+            throw std::logic_error("background output is already enabled");
+        }
+        if (chains_.size() != 0) {
+            throw std::logic_error("chains have already been initialized");
+        }
+
+        output_thread_ = std::make_shared<Mcmc::OutputThread>();
+    }
+
+    void McmcScan::EnableConvergenceMonitor(std::string log_filename,
+            unsigned int interval) {
+        if (log_filename == "") {
+            throw std::invalid_argument("invalid convergence log filename");
+        }
+        if (interval == 0) {
+            throw std::invalid_argument("cannot have zero convergence "
+                    "interval");
+        }
+        if (convergence_monitor_.get() != nullptr) {
+            throw std::logic_error("convergence monitor is already enabled");
+        }
+
+        convergence_monitor_.reset(new Mcmc::ConvergenceMonitor(num_chains_,
+                dimension_));
+        convergence_log_ = std::fopen(log_filename.c_str(), "a");
+        if (convergence_log_ == nullptr) {
+            convergence_monitor_.reset();
+            throw std::runtime_error("could not open " + log_filename);
+        }
+        convergence_interval_ = interval;
+    }
+
+    void McmcScan::EnableEarlyStop(double r_hat_threshold) {
+        if (r_hat_threshold <= 1.0) {
+            throw std::invalid_argument("R-hat threshold must be above 1");
+        }
+        if (early_stop_threshold_ != 0.0) {
+            throw std::logic_error("early stop is already enabled");
+        }
+        if (convergence_monitor_.get() == nullptr) {
+            throw std::logic_error("early stop needs the convergence monitor");
+        }
+
+        early_stop_threshold_ = r_hat_threshold;
+    }
+
+    void McmcScan::UsePosteriorAccumulator(
+            std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator,
+            std::string summary_filename) {
+        if (accumulator.get() == nullptr) {
+            throw std::invalid_argument("null posterior accumulator");
+        }
+        if (accumulator->dimension() != dimension_) {
+            throw std::invalid_argument("posterior accumulator has the wrong "
+                    "dimension");
+        }
+        if (summary_filename == "") {
+            throw std::invalid_argument("invalid summary filename");
+        }
+        if (posterior_accumulator_.get() != nullptr) {
+            throw std::logic_error("a posterior accumulator is already in "
+                    "use");
+        }
+
+        posterior_accumulator_ = accumulator;
+        summary_filename_ = summary_filename;
+    }
+
+    Mcmc::AutocorrelationMonitor const& McmcScan::autocorrelation_monitor()
+    const {
+        return *autocorrelation_monitor_;
+    }
+
+    unsigned int McmcScan::dimension() const {
+        return dimension_;
+    }
+
+    unsigned int McmcScan::num_chains() const {
+        return num_chains_;
+    }
+
+    gsl_vector const* McmcScan::last_parameters(unsigned int i_chain) const {
+        if (i_chain >= chains_.size()) {
+            throw std::out_of_range("no such chain");
+        }
+        return chains_[i_chain]->last_point()->parameters();
+    }
+
+    gsl_vector const* McmcScan::last_points_mean() const {
+        return gaussian_proposal_->mean();
+    }
+
+    gsl_matrix const* McmcScan::last_points_covariance() const {
+        return gaussian_proposal_->covariance();
+    }
+
+    gsl_matrix const* McmcScan::last_points_covariance_cholesky() const {
+        return gaussian_proposal_->covariance_cholesky();
+    }
+
+    void McmcScan::EnableDistributedMode(std::string socket_path,
+            unsigned int sync_interval) {
+        if (socket_path.empty() || sync_interval == 0) {
+            throw std::invalid_argument("invalid input to "
+                    "EnableDistributedMode");
+        }
+        if (!coordinator_path_.empty()) {
+            throw std::logic_error("distributed mode has already been "
+                    "enabled");
+        }
+        if (!tempering_ladder_.empty() || differential_evolution_ ||
+                stretch_move_) {
+            throw std::logic_error("distributed mode cannot be combined with "
+                    + StepMode());
+        }
+
+        coordinator_path_ = socket_path;
+        sync_interval_ = sync_interval;
+    }
+
+    void McmcScan::ResumeFromCheckpoint(std::string filename) {
+        // Sanity check: make sure chains haven't already been initialized
+        if (chains_.size() != 0) {
+            throw std::logic_error("chains have already been initialized");
+        }
+
+        std::FILE* checkpoint_file = std::fopen(filename.c_str(), "rb");
+        if (checkpoint_file == nullptr) {
+            throw Mcmc::CheckpointError("could not open " + filename);
+        }
+
+        // Read everything into temporaries first, so that nothing about the
+        // scan or its chain files changes unless the whole checkpoint is good
+        Mcmc::AdaptiveGaussianProposal* proposal = nullptr;
+        std::vector<std::shared_ptr<Mcmc::Point> > last_points;
+        std::vector<std::string> filenames;
+        std::vector<std::uint32_t> buffer_sizes;
+        std::vector<std::uint32_t> nums_points_flushed;
+        std::vector<std::uint32_t> firsts_written;
+        std::vector<std::uint32_t> thinnings;
+        std::vector<std::uint64_t> file_sizes;
+        std::uint32_t num_steps;
+        std::uint32_t num_cholesky_updates;
+        std::uint32_t num_surrogate_rejections;
+        double measuring_time;
+        std::unique_ptr<Mcmc::AutocorrelationMonitor> autocorrelation_monitor(
+                new Mcmc::AutocorrelationMonitor(num_chains_, dimension_));
+        // The optional monitors that are enabled now, to be restored if they
+        // were when the checkpoint was written
+        std::unique_ptr<Mcmc::AutocorrelationMonitor> burn_in_monitor;
+        if (burn_in_monitor_.get() != nullptr) {
+            burn_in_monitor.reset(new Mcmc::AutocorrelationMonitor(
+                    num_chains_, dimension_, burn_in_monitor_->min_batches()));
+        }
+        std::unique_ptr<Mcmc::ConvergenceMonitor> convergence_monitor;
+        if (convergence_monitor_.get() != nullptr) {
+            convergence_monitor.reset(new Mcmc::ConvergenceMonitor(
+                    num_chains_, dimension_));
+        }
+        bool burn_in_restored;
+        bool convergence_restored;
+        std::uint32_t last_convergence_step;
+        double last_max_r_hat;
+        try {
+            char magic[sizeof(kCheckpointMagic)];
+            if (std::fread(magic, 1, sizeof(magic), checkpoint_file) !=
+                    sizeof(magic) || std::string(magic, sizeof(magic)) !=
+                    std::string(kCheckpointMagic, sizeof(kCheckpointMagic))) {
+                throw Mcmc::CheckpointError(filename + " is not a checkpoint");
+            }
+
+            if (ReadValue<std::uint32_t>(checkpoint_file) != dimension_ ||
+                    ReadValue<std::uint32_t>(checkpoint_file) != num_chains_ ||
+                    ReadValue<std::uint32_t>(checkpoint_file) != max_steps_ ||
+                    ReadValue<double>(checkpoint_file) != burn_fraction_) {
+                throw Mcmc::CheckpointError(filename + " does not match the "
+                        "scan");
+            }
+
+            num_steps = ReadValue<std::uint32_t>(checkpoint_file);
+            num_cholesky_updates = ReadValue<std::uint32_t>(checkpoint_file);
+            num_surrogate_rejections = ReadValue<std::uint32_t>(
+                    checkpoint_file);
+            measuring_time = ReadValue<double>(checkpoint_file);
+
+            // The random number generator state is only meaningful for the
+            // same type of generator
+            if (ReadString(checkpoint_file) != gsl_rng_name(rng_)) {
+                throw Mcmc::CheckpointError(filename + " was written with a "
+                        "different random number generator");
+            }
+            if (gsl_rng_fread(checkpoint_file, rng_) != GSL_SUCCESS) {
+                throw Mcmc::CheckpointError("checkpoint file is truncated");
+            }
+
+            proposal = new Mcmc::AdaptiveGaussianProposal(*this);
+            ReadMatrix(checkpoint_file, proposal->covariance_);
+            ReadMatrix(checkpoint_file, proposal->covariance_inv_);
+            ReadMatrix(checkpoint_file, proposal->covariance_cholesky_);
+            proposal->covariance_logdet_ = ReadValue<double>(
+                    checkpoint_file);
+            gsl_vector* mean = ReadVector(checkpoint_file);
+            bool mean_ok = mean->size == dimension_;
+            if (mean_ok) {
+                gsl_vector_memcpy(proposal->mean_, mean);
+            }
+            gsl_vector_free(mean);
+            if (!mean_ok) {
+                throw Mcmc::CheckpointError("checkpoint file is corrupt");
+            }
+
+            for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+                filenames.push_back(ReadString(checkpoint_file));
+                buffer_sizes.push_back(ReadValue<std::uint32_t>(
+                        checkpoint_file));
+                nums_points_flushed.push_back(ReadValue<std::uint32_t>(
+                        checkpoint_file));
+                firsts_written.push_back(ReadValue<std::uint32_t>(
+                        checkpoint_file));
+                thinnings.push_back(ReadValue<std::uint32_t>(
+                        checkpoint_file));
+                if (thinnings.back() == 0) {
+                    throw Mcmc::CheckpointError("checkpoint file is corrupt");
+                }
+                file_sizes.push_back(ReadValue<std::uint64_t>(
+                        checkpoint_file));
+
+                gsl_vector* parameters = ReadVector(checkpoint_file);
+                gsl_vector* measurements = nullptr;
+                try {
+                    measurements = ReadVector(checkpoint_file);
+                    double likelihood = ReadValue<double>(checkpoint_file);
+                    if (parameters->size != dimension_) {
+                        throw Mcmc::CheckpointError("checkpoint file is "
+                                "corrupt");
+                    }
+                    last_points.push_back(NewPoint(parameters, measurements,
+                            likelihood));
+                } catch (...) {
+                    gsl_vector_free(parameters);
+                    gsl_vector_free(measurements);
+                    throw;
+                }
+                gsl_vector_free(parameters);
+                gsl_vector_free(measurements);
+
+                long file_size = FileSize(filenames[i_chain]);
+                if (file_size < 0 ||
+                        static_cast<std::uint64_t>(file_size) <
+                        file_sizes[i_chain]) {
+                    throw Mcmc::CheckpointError(filenames[i_chain] +
+                            " is missing or shorter than recorded");
+                }
+            }
+
+            if (!ReadMonitor(checkpoint_file, autocorrelation_monitor.get())) {
+                throw Mcmc::CheckpointError("checkpoint file is corrupt");
+            }
+            burn_in_restored = ReadMonitor(checkpoint_file,
+                    burn_in_monitor.get());
+            convergence_restored = ReadMonitor(checkpoint_file,
+                    convergence_monitor.get());
+            last_convergence_step = ReadValue<std::uint32_t>(checkpoint_file);
+            last_max_r_hat = ReadValue<double>(checkpoint_file);
+        } catch (...) {
+            std::fclose(checkpoint_file);
+            delete proposal;
+            throw;
+        }
+        std::fclose(checkpoint_file);
+
+        // Cut off anything the earlier run wrote after the checkpoint
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            if (::truncate(filenames[i_chain].c_str(), file_sizes[i_chain])
+                    != 0) {
+                delete proposal;
+                throw Mcmc::CheckpointError("could not truncate " +
+                        filenames[i_chain]);
+            }
+        }
+
+        workspace_ = new Mcmc::ScanWorkspace(dimension_, num_chains_);
+        gaussian_proposal_ = proposal;
+        gaussian_proposal_->num_cholesky_updates_ = num_cholesky_updates;
+        gaussian_proposal_->initialized_ = true;
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            chains_.push_back(new Mcmc::MarkovChain(last_points[i_chain],
+                    NewChainWriter(filenames[i_chain], i_chain,
+                    *last_points[i_chain]), buffer_sizes[i_chain],
+                    nums_points_flushed[i_chain]));
+            chains_.back()->SetOutputPolicy(firsts_written[i_chain],
+                    thinnings[i_chain]);
+        }
+        num_steps_ = num_steps;
+        num_surrogate_rejections_ = num_surrogate_rejections;
+        measuring_time_ = std::chrono::duration<double>(measuring_time);
+        last_checkpoint_step_ = num_steps_;
+
+        // The chains carry on with the output policy they had
+        output_started_ = num_steps_ > burn_fraction_ * max_steps_;
+        if (output_started_) {
+            output_thinning_ = chains_[0]->thinning();
+        }
+
+        // So do the monitors, the optional ones only if they were enabled
+        // then and are now.  The others start over.
+        autocorrelation_monitor_ = std::move(autocorrelation_monitor);
+        if (burn_in_restored) {
+            burn_in_monitor_ = std::move(burn_in_monitor);
+        }
+        if (convergence_restored) {
+            convergence_monitor_ = std::move(convergence_monitor);
+            last_convergence_step_ = last_convergence_step;
+            last_max_r_hat_ = last_max_r_hat;
+        }
     }
 
     void McmcScan::Run() {
+        // The adaptive Gaussian proposal lives as long as the scan, since 
+        // it keeps the last points' statistics.  The others cost next to 
+        // nothing to set up.
+        Mcmc::DifferentialEvolutionProposal evolution_proposal(*this);
+        Mcmc::StretchMoveProposal stretch_proposal(*this);
+
+        // In case a Run(proposal) was cut short by an exception
+        running_policy_ = false;
+        std::chrono::steady_clock::time_point start = StartRun();
+
+        while (num_steps_ < max_steps_) {
+            if (!tempering_ladder_.empty()) {
+                TemperedStep();
+            } else if (stretch_move_) {
+                StretchSweep(stretch_proposal);
+            } else if (thread_pool_ != nullptr) {
+                Sweep();
+            } else if (delayed_acceptance_) {
+                DelayedAcceptanceStep(*gaussian_proposal_);
+            } else if (differential_evolution_) {
+                Step(evolution_proposal);
+            } else {
+                Step(*gaussian_proposal_);
+            }
+
+            if (FinishStep()) {
+                break;
+            }
+        }
+
+        FinishRun(start);
+    }
+
+    std::string McmcScan::StepMode() const {
+        // Stretch moves and parallel tempering have a thread pool as well
+        if (delayed_acceptance_) {
+            return "delayed-acceptance mode";
+        } else if (differential_evolution_) {
+            return "differential evolution";
+        } else if (stretch_move_) {
+            return "stretch moves";
+        } else if (!tempering_ladder_.empty()) {
+            return "parallel tempering";
+        } else if (thread_pool_ != nullptr) {
+            return "sweep mode";
+        }
+        return "";
+    }
+
+    void McmcScan::CheckStepMode(std::string mode,
+            bool distributed_ok) const {
+        std::string step_mode = StepMode();
+        if (!step_mode.empty()) {
+            throw std::logic_error(mode + " cannot be combined with " +
+                    step_mode);
+        }
+        if (!distributed_ok && !coordinator_path_.empty()) {
+            throw std::logic_error(mode + " cannot be combined with "
+                    "distributed mode");
+        }
+    }
+
+    std::chrono::steady_clock::time_point McmcScan::StartRun() {
         // Sanity check: make sure chains have been initialized
         if (chains_.size() == 0) {
             throw std::logic_error("chains have not been initialized yet");
         }
 
         std::printf("\n");
-        std::printf("Beginning scan for %u steps...\n", max_steps_);
+        if (!tempering_ladder_.empty()) {
+            std::printf("Beginning scan for %u steps with parallel tempering "
+                    "over %u rungs...\n", max_steps_,
+                    (unsigned int) tempering_ladder_.size());
+        } else if (stretch_move_) {
+            std::printf("Beginning scan for %u steps with stretch moves on %u "
+                    "threads...\n", max_steps_, thread_pool_->num_threads());
+        } else if (thread_pool_ != nullptr) {
+            std::printf("Beginning scan for %u steps in sweep mode with %u "
+                    "threads...\n", max_steps_, thread_pool_->num_threads());
+        } else if (delayed_acceptance_) {
+            std::printf("Beginning scan for %u steps in delayed-acceptance "
+                    "mode...\n", max_steps_);
+        } else if (differential_evolution_) {
+            std::printf("Beginning scan for %u steps with differential "
+                    "evolution...\n", max_steps_);
+        } else {
+            std::printf("Beginning scan for %u steps...\n", max_steps_);
+        }
         std::printf("\n");
+
+        // Join the other workers, and start from the mean and covariance of
+        // all of their chains.  The workers all seed their generators from
+        // the clock, so they are set apart by where their chains are.
+        if (!coordinator_path_.empty()) {
+            coordinator_socket_ = ConnectToCoordinator(coordinator_path_);
+            SyncWithCoordinator(Mcmc::CoordinatorProtocol::kHello);
+            gsl_rng_set(rng_, gsl_rng_get(rng_) + first_ensemble_chain_);
+            last_sync_step_ = num_steps_;
+            std::printf("  Running chains %u to %u of %u, synchronizing with "
+                    "%s every %u steps.\n", first_ensemble_chain_,
+                    first_ensemble_chain_ + num_chains_ - 1, ensemble_size_,
+                    coordinator_path_.c_str(), sync_interval_);
+            std::printf("\n");
+        }
+
+        // The first stage of delayed acceptance compares against the last
+        // points' surrogate likelihoods, which are kept up to date from here
+        if (delayed_acceptance_) {
+            last_surrogate_likelihoods_.resize(num_chains_);
+            for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+                last_surrogate_likelihoods_[i_chain] = SurrogateLikelihood(
+                        chains_[i_chain]->last_point()->parameters());
+            }
+        }
+
+        std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
         
-        while (num_steps_ < max_steps_) {
-            // Increment num_steps_ here to get the right value for Lambda()
-            ++num_steps_;
-            
-            if (num_steps_ % 10000 == 0) {
-                std::printf("  Step %u of %u done.\n", num_steps_, max_steps_);
+        // The other rungs start over from the chains' last points
+        if (!tempering_ladder_.empty()) {
+            InitializeReplicas();
+        }
+
+        return start;
+    }
+
+    bool McmcScan::FinishStep() {
+        if (coordinator_socket_ >= 0 &&
+                num_steps_ - last_sync_step_ >= sync_interval_) {
+            last_sync_step_ = num_steps_;
+            SyncWithCoordinator(Mcmc::CoordinatorProtocol::kSync);
+        }
+
+        if (convergence_monitor_.get() != nullptr &&
+                num_steps_ - last_convergence_step_ >= convergence_interval_) {
+            last_convergence_step_ = num_steps_;
+            if (CheckConvergence()) {
+                std::printf("  All R-hat below %g at step %u of %u, stopping "
+                        "early.\n", early_stop_threshold_, num_steps_,
+                        max_steps_);
                 std::printf("\n");
+                return true;
             }
-            
-            // Randomly choose a chain to update
-            unsigned int chain_to_update = gsl_rng_uniform_int(rng_,
+        }
+
+        // Last, so that a resumed run carries on after this step's checks
+        if (checkpoint_interval_ != 0 &&
+                num_steps_ - last_checkpoint_step_ >= checkpoint_interval_) {
+            last_checkpoint_step_ = num_steps_;
+            try {
+                WriteCheckpoint();
+            } catch (std::runtime_error& e) {
+                std::printf("Error writing checkpoint at step %u, will try "
+                        "again later: %s\n", num_steps_, e.what());
+            }
+        }
+
+        return false;
+    }
+
+    void McmcScan::FinishRun(std::chrono::steady_clock::time_point start) {
+        std::chrono::duration<double> total_time =
+                std::chrono::steady_clock::now() - start;
+
+        // Bring the scan's own statistics up to date after Run(proposal), as
+        // WriteCheckpoint() does
+        if (running_policy_) {
+            running_policy_ = false;
+            if (coordinator_socket_ < 0) {
+                gaussian_proposal_->Reset();
+            }
+        }
+
+        // Leave the final last points with the coordinator
+        if (coordinator_socket_ >= 0) {
+            SyncWithCoordinator(Mcmc::CoordinatorProtocol::kDone);
+        }
+
+        // Hand the runs still going on to the accumulator, and write out what
+        // it has
+        if (accumulating_) {
+            for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+                chains_[i_chain]->SetAccumulator(nullptr);
+            }
+            accumulating_ = false;
+            try {
+                posterior_accumulator_->WriteSummary(summary_filename_);
+            } catch (std::runtime_error& e) {
+                std::printf("Error writing the posterior summary: %s\n",
+                        e.what());
+            }
+        }
+        
+        std::printf("Scan completed.\n");
+        std::printf("  Time spent measuring points: %.3f s of %.3f s total\n",
+                measuring_time_.count(), total_time.count());
+        std::printf("  Time spent waiting on chain output: %.3f s\n",
+                output_wait_time_.count());
+        if (delayed_acceptance_) {
+            std::printf("  Trial points rejected by the surrogate likelihood "
+                    "without being measured: %u of %u\n",
+                    num_surrogate_rejections_, num_steps_);
+        }
+        if (convergence_monitor_.get() != nullptr) {
+            std::printf("  Largest R-hat at the last check: %.4f\n",
+                    last_max_r_hat_);
+        }
+        for (unsigned int i_rung = 1; i_rung < replicas_.size(); ++i_rung) {
+            std::printf("  Swaps between lambda %.4g and %.4g: %lu of %lu "
+                    "accepted (%.1f%%)\n", replicas_[i_rung - 1].lambda,
+                    replicas_[i_rung].lambda,
+                    replicas_[i_rung].num_swaps_accepted,
+                    replicas_[i_rung].num_swaps_proposed,
+                    100.0 * swap_acceptance_rate(i_rung - 1));
+        }
+        if (output_policy_set_ && output_started_) {
+            std::printf("  Chain output thinned by %u%s\n", output_thinning_,
+                    discard_burn_in_ ? ", without the burn-in" : "");
+        }
+        PrintAutocorrelation();
+        if (posterior_accumulator_.get() != nullptr) {
+            std::printf("  Posterior summary of %.0f steps written to %s\n",
+                    posterior_accumulator_->total_weight(),
+                    summary_filename_.c_str());
+        }
+        if (!coordinator_path_.empty()) {
+            std::printf("  Synchronized with the coordinator %u times, "
+                    "waiting %.3f s\n", num_syncs_, sync_wait_time_.count());
+        }
+        if (measurement_cache_.get() != nullptr) {
+            std::printf("  Measurement cache: %lu hits, %lu misses, %u "
+                    "entries\n", measurement_cache_->num_hits(),
+                    measurement_cache_->num_misses(),
+                    measurement_cache_->num_entries());
+        }
+        std::printf("\n");
+    }
+
+    void McmcScan::Sweep() {
+        // The last sweep may be cut short by max_steps_.  It then starts at
+        // a random chain, so that the chains it leaves out are not always
+        // the last ones.
+        unsigned int num_updates = num_chains_;
+        unsigned int first_chain = 0;
+        if (max_steps_ - num_steps_ < num_updates) {
+            num_updates = max_steps_ - num_steps_;
+            first_chain = gsl_rng_uniform_int(rng_, num_chains_);
+        }
+
+        // Draw every chain's trial parameters up front, so that they all see
+        // the same snapshot of the last points' mean and covariance.  This is
+        // done serially because it uses rng_.  Row i_update is chain
+        // (first_chain + i_update) mod num_chains_.
+        for (unsigned int i_update = 0; i_update < num_updates; ++i_update) {
+            unsigned int i_chain = (first_chain + i_update) % num_chains_;
+            gsl_vector_view parameters_row = gsl_matrix_row(
+                    workspace_->sweep_trial_parameters, i_update);
+            gaussian_proposal_->Propose(i_chain,
+                    chains_[i_chain]->last_point()->parameters(), rng_,
+                    &parameters_row.vector);
+        }
+        sweep_snapshot_->CopyState(*gaussian_proposal_);
+
+        unsigned int num_batches = MeasureSweepBatches(num_updates);
+
+        // Accept or reject in row order, so that the result does not depend
+        // on how the measurements were scheduled
+        bool snapshot_current = true;
+        for (unsigned int i_batch = 0; i_batch < num_batches; ++i_batch) {
+            unsigned int first = i_batch * num_updates / num_batches;
+            unsigned int last = (i_batch + 1) * num_updates / num_batches;
+            for (unsigned int i_update = first; i_update < last; ++i_update) {
+                gsl_vector_const_view parameters_row = gsl_matrix_const_row(
+                        workspace_->sweep_trial_parameters, i_update);
+                gsl_vector_const_view measurements_row = gsl_matrix_const_row(
+                        workspace_->batch_measurements[i_batch],
+                        i_update - first);
+
+                if (UpdateChain((first_chain + i_update) % num_chains_,
+                        &parameters_row.vector, &measurements_row.vector,
+                        gsl_vector_get(workspace_->batch_likelihoods[i_batch],
+                        i_update - first), snapshot_current)) {
+                    snapshot_current = false;
+                }
+            }
+        }
+        FreeSweepBatches(num_batches);
+    }
+
+    void McmcScan::TemperedStep() {
+        unsigned int num_rungs = replicas_.size();
+        for (unsigned int i_rung = 0; i_rung < num_rungs; ++i_rung) {
+            replicas_[i_rung].chain_to_update = gsl_rng_uniform_int(rng_,
                     num_chains_);
-            std::shared_ptr<Mcmc::Point> last_point =
-                    chains_[chain_to_update]->last_point();
-
-            // Construct a trial point and compute the trial mean and covariance
-            std::shared_ptr<Mcmc::Point> trial_point = TrialPoint(last_point);
-            gsl_vector* trial_mean = nullptr;
-            gsl_matrix* trial_covariance = nullptr;
-            double trial_covariance_det;
-            gsl_matrix* trial_covariance_inv = nullptr;
-            TrialMeanAndCovariance(last_point, trial_point, trial_mean,
-                    trial_covariance, trial_covariance_det,
-                    trial_covariance_inv);
-
-            // Compute the acceptance ratio and decide
-            double acceptance_ratio = AcceptanceRatio(last_point, trial_point,
-                    trial_covariance_det, trial_covariance_inv);
-
-            if (gsl_rng_uniform(rng_) <= acceptance_ratio) {
-                gsl_vector_free(last_points_mean_);
-                gsl_matrix_free(last_points_covariance_);
-                gsl_matrix_free(last_points_covariance_inv_);
+        }
 
-                try {
-                    chains_[chain_to_update]->Append(trial_point);
-                } catch (Mcmc::ChainFlushError& e) {
-                    std::printf("Error flushing chain %u, will try again next time",
-                            chain_to_update);
+        // Swaps come first, so that a point rung 0 gets in one is recorded by
+        // this step, as the chain's last point or the one it moves from
+        if ((num_steps_ + 1) % swap_interval_ == 0) {
+            ProposeSwaps();
+        }
+
+        // Draw every rung's trial point serially, since this uses rng_
+        for (unsigned int i_rung = 0; i_rung < num_rungs; ++i_rung) {
+            Replica& replica = replicas_[i_rung];
+            replica.proposal->Propose(replica.chain_to_update,
+                    ReplicaPoint(i_rung, replica.chain_to_update)->
+                    parameters(), rng_, replica.trial_parameters);
+        }
+
+        // Measure one rung per thread.  Each task writes only to its own 
+        // rung.
+        std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+        try {
+            thread_pool_->ParallelFor(num_rungs, [this](unsigned int i_rung) {
+                Replica& replica = replicas_[i_rung];
+                MeasurePointCached(replica.trial_parameters,
+                        replica.trial_measurements, replica.trial_likelihood);
+            });
+        } catch (...) {
+            for (unsigned int i_rung = 0; i_rung < num_rungs; ++i_rung) {
+                gsl_vector_free(replicas_[i_rung].trial_measurements);
+                replicas_[i_rung].trial_measurements = nullptr;
+            }
+            throw;
+        }
+        measuring_time_ += std::chrono::steady_clock::now() - start;
+
+        // Decide in rung order, so that the result does not depend on how the
+        // measurements were scheduled.  Only rung 0 counts as a step.
+        CountStep();
+        for (unsigned int i_rung = 0; i_rung < num_rungs; ++i_rung) {
+            Replica& replica = replicas_[i_rung];
+            std::shared_ptr<Mcmc::Point> next_point = ReplicaPoint(i_rung,
+                    replica.chain_to_update);
+
+            // The Metropolis-Hastings test takes the rung's lambda from 
+            // Lambda()
+            double log_hastings_ratio = replica.proposal->LogHastingsRatio(
+                    replica.chain_to_update, next_point->parameters(),
+                    replica.trial_parameters);
+            replica_lambda_ = replica.lambda;
+            bool accepted = MetropolisHastingsTest(next_point->likelihood(),
+                    replica.trial_likelihood, log_hastings_ratio);
+            replica_lambda_ = 1.0;
+            if (accepted) {
+                replica.proposal->UpdateState(replica.chain_to_update,
+                        next_point->parameters(), replica.trial_parameters);
+                next_point = NewPoint(replica.trial_parameters,
+                        replica.trial_measurements, replica.trial_likelihood);
+            }
+            gsl_vector_free(replica.trial_measurements);
+            replica.trial_measurements = nullptr;
+
+            replica.last_points[replica.chain_to_update] = next_point;
+            if (i_rung == 0) {
+                AppendToChain(replica.chain_to_update, next_point);
+            }
+        }
+    }
+
+    void McmcScan::InitializeReplicas() {
+        for (unsigned int i_rung = 0; i_rung < replicas_.size(); ++i_rung) {
+            if (i_rung > 0) {
+                delete replicas_[i_rung].proposal;
+            }
+            gsl_vector_free(replicas_[i_rung].trial_parameters);
+            gsl_vector_free(replicas_[i_rung].trial_measurements);
+        }
+        replicas_.clear();
+
+        for (unsigned int i_rung = 0; i_rung < tempering_ladder_.size();
+                ++i_rung) {
+            Replica replica;
+            replica.lambda = tempering_ladder_[i_rung];
+            replica.proposal = gaussian_proposal_;
+            replica.chain_to_update = 0;
+            replica.trial_parameters = gsl_vector_alloc(dimension_);
+            replica.trial_measurements = nullptr;
+            replica.trial_likelihood = 0.0;
+            replica.num_swaps_proposed = 0;
+            replica.num_swaps_accepted = 0;
+            for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+                replica.last_points.push_back(chains_[i_chain]->last_point());
+            }
+            replicas_.push_back(replica);
+            if (i_rung == 0) {
+                continue;
+            }
+
+            // Same points as rung 0, but the mean and covariance go into the
+            // rung's own proposal
+            replicas_[i_rung].proposal = new Mcmc::AdaptiveGaussianProposal(
+                    *this);
+            replicas_[i_rung].proposal->Reset();
+        }
+    }
+
+    std::shared_ptr<Mcmc::Point> McmcScan::ReplicaPoint(unsigned int i_rung,
+            unsigned int i_chain) const {
+        return replicas_[i_rung].last_points[i_chain];
+    }
+
+    void McmcScan::ReplaceReplicaPoint(unsigned int i_rung,
+            unsigned int i_chain,
+            std::shared_ptr<Mcmc::Point> point) {
+        Mcmc::AdaptiveGaussianProposal* proposal = replicas_[i_rung].proposal;
+        gsl_vector const* last_parameters = ReplicaPoint(i_rung, i_chain)->
+                parameters();
+        // LogHastingsRatio() fills in the trial statistics, which 
+        // UpdateState() then takes over
+        proposal->LogHastingsRatio(i_chain, last_parameters,
+                point->parameters());
+        proposal->UpdateState(i_chain, last_parameters, point->parameters());
+
+        replicas_[i_rung].last_points[i_chain] = point;
+    }
+
+    void McmcScan::ProposeSwaps() {
+        for (unsigned int i_rung = 1; i_rung < replicas_.size(); ++i_rung) {
+            Replica& replica = replicas_[i_rung];
+            unsigned int i_chain = i_rung == 1 ?
+                    replicas_[0].chain_to_update :
+                    gsl_rng_uniform_int(rng_, num_chains_);
+            std::shared_ptr<Mcmc::Point> colder_point = ReplicaPoint(
+                    i_rung - 1, i_chain);
+            std::shared_ptr<Mcmc::Point> hotter_point = ReplicaPoint(i_rung,
+                    i_chain);
+
+            // Accepted with probability
+            //   min(1, (L_hotter/L_colder)^(lambda_colder - lambda_hotter))
+            // done in logs, so that zero likelihoods come out right.  Two 
+            // zero likelihoods give NaN, which is rejected.
+            ++replica.num_swaps_proposed;
+            double log_ratio = (replicas_[i_rung - 1].lambda - replica.lambda)
+                    * (std::log(hotter_point->likelihood()) -
+                    std::log(colder_point->likelihood()));
+            if (!(std::log(gsl_rng_uniform(rng_)) < log_ratio)) {
+                continue;
+            }
+            ++replica.num_swaps_accepted;
+
+            ReplaceReplicaPoint(i_rung - 1, i_chain, hotter_point);
+            ReplaceReplicaPoint(i_rung, i_chain, colder_point);
+        }
+    }
+
+    void McmcScan::StretchSweep(Mcmc::StretchMoveProposal& proposal) {
+        unsigned int half = num_chains_ / 2;
+        for (unsigned int i_half = 0; i_half < 2; ++i_half) {
+            unsigned int first_chain = i_half == 0 ? 0 : half;
+            unsigned int num_updates = i_half == 0 ? half : num_chains_ - half;
+            // The last sweep may be cut short by max_steps_
+            if (max_steps_ - num_steps_ < num_updates) {
+                num_updates = max_steps_ - num_steps_;
+            }
+
+            // Draw the half's trial points serially, since this uses rng_.
+            // The other half stays put until this half is done, since the
+            // trial points are stretched from its last points.  Only the 
+            // valid trial points get rows of sweep_trial_parameters, to be
+            // measured.
+            unsigned int num_valid = 0;
+            for (unsigned int i_update = 0; i_update < num_updates;
+                    ++i_update) {
+                unsigned int i_chain = first_chain + i_update;
+                gsl_vector_view parameters_row = gsl_matrix_row(
+                        workspace_->sweep_trial_parameters, num_valid);
+                proposal.Propose(i_chain,
+                        chains_[i_chain]->last_point()->parameters(), rng_,
+                        &parameters_row.vector);
+                if (IsValidParameters(&parameters_row.vector)) {
+                    workspace_->stretch_rows[i_update] = num_valid++;
+                } else {
+                    workspace_->stretch_rows[i_update] = -1;
                 }
-                last_points_mean_ = trial_mean;
-                last_points_covariance_ = trial_covariance;
-                last_points_covariance_det_ = trial_covariance_det;
-                last_points_covariance_inv_ = trial_covariance_inv;
-            } else {
-                gsl_vector_free(trial_mean);
-                gsl_matrix_free(trial_covariance);
-                gsl_matrix_free(trial_covariance_inv);
+            }
 
-                try {
-                    chains_[chain_to_update]->Append(last_point);
-                } catch (Mcmc::ChainFlushError& e) {
-                    std::printf("Error flushing chain %u, will try again next time",
-                            chain_to_update);
+            unsigned int num_batches = MeasureSweepBatches(num_valid);
+
+            // Decide in chain order.  Invalid trial points are rejected 
+            // outright, since redrawing them would bias the proposal.
+            unsigned int i_batch = 0;
+            for (unsigned int i_update = 0; i_update < num_updates;
+                    ++i_update) {
+                unsigned int i_chain = first_chain + i_update;
+                CountStep();
+                std::shared_ptr<Mcmc::Point> next_point =
+                        chains_[i_chain]->last_point();
+
+                int row = workspace_->stretch_rows[i_update];
+                if (row >= 0) {
+                    while (static_cast<unsigned int>(row) >=
+                            (i_batch + 1) * num_valid / num_batches) {
+                        ++i_batch;
+                    }
+                    unsigned int first = i_batch * num_valid / num_batches;
+                    gsl_vector_const_view parameters_row = 
+                            gsl_matrix_const_row(
+                            workspace_->sweep_trial_parameters, row);
+                    gsl_vector_const_view measurements_row =
+                            gsl_matrix_const_row(
+                            workspace_->batch_measurements[i_batch],
+                            row - first);
+                    double trial_likelihood = gsl_vector_get(
+                            workspace_->batch_likelihoods[i_batch],
+                            row - first);
+
+                    // Acceptance ratio z^(d-1) (L_Y/L_X)^lambda
+                    gsl_vector const* last_parameters =
+                            next_point->parameters();
+                    double log_hastings_ratio = proposal.LogHastingsRatio(
+                            i_chain, last_parameters, &parameters_row.vector);
+                    if (MetropolisHastingsTest(next_point->likelihood(),
+                            trial_likelihood, log_hastings_ratio)) {
+                        proposal.UpdateState(i_chain, last_parameters,
+                                &parameters_row.vector);
+                        next_point = NewPoint(&parameters_row.vector,
+                                &measurements_row.vector, trial_likelihood);
+                    }
                 }
+
+                AppendToChain(i_chain, next_point);
             }
+            FreeSweepBatches(num_batches);
+        }
+    }
+
+    unsigned int McmcScan::MeasureSweepBatches(unsigned int num_points) {
+        if (num_points == 0) {
+            return 0;
+        }
+
+        // Split the trial points into one contiguous batch per thread, and
+        // measure the batches concurrently.  Each task writes only to its own
+        // slots.  The task only captures this and two integers, so that it 
+        // fits in std::function without a heap allocation.
+        unsigned int num_batches = thread_pool_->num_threads();
+        if (num_points < num_batches) {
+            num_batches = num_points;
+        }
+        std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+        try {
+            thread_pool_->ParallelFor(num_batches,
+                    [this, num_points, num_batches](unsigned int i_batch) {
+                        unsigned int first = i_batch * num_points / num_batches;
+                        unsigned int last =
+                                (i_batch + 1) * num_points / num_batches;
+                        gsl_matrix_const_view batch_parameters =
+                                gsl_matrix_const_submatrix(
+                                workspace_->sweep_trial_parameters,
+                                first, 0, last - first, dimension_);
+                        MeasureBatchCached(&batch_parameters.matrix,
+                                workspace_->batch_measurements[i_batch],
+                                workspace_->batch_likelihoods[i_batch]);
+                    });
+        } catch (...) {
+            FreeSweepBatches(num_batches);
+            throw;
+        }
+        measuring_time_ += std::chrono::steady_clock::now() - start;
+        return num_batches;
+    }
+
+    void McmcScan::FreeSweepBatches(unsigned int num_batches) {
+        for (unsigned int i_batch = 0; i_batch < num_batches; ++i_batch) {
+            gsl_matrix_free(workspace_->batch_measurements[i_batch]);
+            gsl_vector_free(workspace_->batch_likelihoods[i_batch]);
+            workspace_->batch_measurements[i_batch] = nullptr;
+            workspace_->batch_likelihoods[i_batch] = nullptr;
+        }
+    }
+
+    bool McmcScan::UpdateChain(unsigned int chain_to_update,
+            gsl_vector const* trial_parameters,
+            gsl_vector const* trial_measurements,
+            double trial_likelihood,
+            bool snapshot_current) {
+        CountStep();
+
+        std::shared_ptr<Mcmc::Point> next_point =
+                chains_[chain_to_update]->last_point();
+        gsl_vector const* last_parameters = next_point->parameters();
+
+        // Once earlier chains of the sweep have moved, the Hastings ratio 
+        // has to come from the snapshot the trial point was drawn from, and 
+        // only an accepted move is applied to the current statistics
+        Mcmc::AdaptiveGaussianProposal* drawn_from = snapshot_current ?
+                gaussian_proposal_ : sweep_snapshot_;
+        double log_hastings_ratio = drawn_from->LogHastingsRatio(
+                chain_to_update, last_parameters, trial_parameters);
+        bool accepted = MetropolisHastingsTest(next_point->likelihood(),
+                trial_likelihood, log_hastings_ratio);
+
+        if (accepted) {
+            if (!snapshot_current) {
+                gaussian_proposal_->LogHastingsRatio(chain_to_update,
+                        last_parameters, trial_parameters);
+            }
+            gaussian_proposal_->UpdateState(chain_to_update, last_parameters,
+                    trial_parameters);
+            next_point = NewPoint(trial_parameters, trial_measurements,
+                    trial_likelihood);
+        }
+        AppendToChain(chain_to_update, next_point);
+        return accepted;
+    }
+
+    std::shared_ptr<Mcmc::Point> McmcScan::NewPoint(
+            gsl_vector const* parameters,
+            gsl_vector const* measurements,
+            double likelihood) {
+        // The pool takes its sizes from the first point.  A point that does
+        // not fit them, if MeasurePoint() ever makes one, does without.
+        if (point_pool_.get() == nullptr && parameters != nullptr &&
+                measurements != nullptr) {
+            point_pool_.reset(new Mcmc::PointPool(parameters->size,
+                    measurements->size));
+        }
+        if (point_pool_.get() == nullptr ||
+                parameters == nullptr || measurements == nullptr ||
+                parameters->size != point_pool_->num_parameters() ||
+                measurements->size != point_pool_->num_measurements()) {
+            return std::shared_ptr<Mcmc::Point>(new Mcmc::Point(parameters,
+                    measurements, likelihood));
+        }
+        return point_pool_->NewPoint(parameters, measurements, likelihood);
+    }
+
+    void McmcScan::CountStep() {
+        // Increment num_steps_ before deciding, to get the right value for 
+        // Lambda()
+        ++num_steps_;
+
+        if (num_steps_ % 10000 == 0) {
+            std::printf("  Step %u of %u done.\n", num_steps_, max_steps_);
+            if (autocorrelation_monitor_->ready()) {
+                std::printf("  Smallest effective sample size: %.0f\n",
+                        autocorrelation_monitor_->ComputeEffectiveSampleSizes(
+                        effective_sample_sizes_));
+            }
+            std::printf("\n");
+        }
+    }
+
+    bool McmcScan::CheckConvergence() {
+        if (!convergence_monitor_->ready()) {
+            return false;
+        }
+
+        std::vector<double> r_hats;
+        last_max_r_hat_ = convergence_monitor_->ComputeRHats(r_hats);
+
+        std::fprintf(convergence_log_, "%u", num_steps_);
+        for (unsigned int i = 0; i < dimension_; ++i) {
+            std::fprintf(convergence_log_, "  %- 9.8E", r_hats[i]);
+        }
+        std::fprintf(convergence_log_, "\n");
+        if (std::fflush(convergence_log_) != 0) {
+            std::clearerr(convergence_log_);
+            std::printf("Error writing the convergence log at step %u\n",
+                    num_steps_);
+        }
+
+        return early_stop_threshold_ != 0.0 &&
+                last_max_r_hat_ < early_stop_threshold_;
+    }
+
+    void McmcScan::PrintAutocorrelation() const {
+        if (!autocorrelation_monitor_->ready()) {
+            std::printf("  Too few steps after the burn-in to estimate the "
+                    "autocorrelation.\n");
+            return;
+        }
+
+        std::printf("  Autocorrelation times, by chain and parameter:\n");
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            std::printf("    %3u:", i_chain);
+            for (unsigned int i = 0; i < dimension_; ++i) {
+                std::printf(" %9.1f",
+                        autocorrelation_monitor_->AutocorrelationTime(i_chain,
+                        i));
+            }
+            std::printf("\n");
+        }
+
+        std::vector<double> sample_sizes;
+        autocorrelation_monitor_->ComputeEffectiveSampleSizes(sample_sizes);
+        std::printf("  Effective sample sizes, by parameter:\n");
+        std::printf("        ");
+        for (unsigned int i = 0; i < dimension_; ++i) {
+            std::printf(" %9.0f", sample_sizes[i]);
         }
-        
-        std::printf("Scan completed.\n");
         std::printf("\n");
     }
 
+    void McmcScan::AppendToChain(unsigned int chain_to_update,
+            std::shared_ptr<Mcmc::Point> const& point) {
+        // Automatic thinning goes by the second half of the burn-in, where
+        // lambda is 1 already
+        if (burn_in_monitor_.get() != nullptr &&
+                num_steps_ > burn_fraction_ * max_steps_ / 2.0 &&
+                num_steps_ <= burn_fraction_ * max_steps_) {
+            burn_in_monitor_->Add(chain_to_update, point->parameters());
+        }
+
+        // Only points after the burn-in count towards convergence, the
+        // autocorrelation and the posterior summary
+        if (num_steps_ > burn_fraction_ * max_steps_) {
+            if (!output_started_) {
+                StartOutput();
+            }
+            autocorrelation_monitor_->Add(chain_to_update, point->parameters());
+            if (convergence_monitor_.get() != nullptr) {
+                convergence_monitor_->Add(chain_to_update,
+                        point->parameters());
+            }
+            if (posterior_accumulator_.get() != nullptr && !accumulating_) {
+                for (unsigned int i_chain = 0; i_chain < num_chains_;
+                        ++i_chain) {
+                    chains_[i_chain]->SetAccumulator(posterior_accumulator_);
+                }
+                accumulating_ = true;
+            }
+        }
+
+        try {
+            // Only time the appends that flush, to keep the clock out of 
+            // the step loop otherwise
+            Mcmc::MarkovChain* chain = chains_[chain_to_update];
+            if (chain->num_points_buffered() + 1 >= chain->buffer_size()) {
+                std::chrono::steady_clock::time_point start =
+                        std::chrono::steady_clock::now();
+                chain->Append(point);
+                output_wait_time_ += std::chrono::steady_clock::now() - start;
+            } else {
+                chain->Append(point);
+            }
+        } catch (Mcmc::ChainFlushError& e) {
+            std::printf("Error flushing chain %u, will try again next time",
+                    chain_to_update);
+        }
+    }
+
+    bool McmcScan::MetropolisHastingsTest(double last_likelihood,
+            double trial_likelihood,
+            double log_hastings_ratio) {
+        double acceptance_ratio = 1.0;
+        if (last_likelihood != 0.0) {
+            acceptance_ratio = std::exp(log_hastings_ratio) *
+                    LikelihoodRatio(last_likelihood, trial_likelihood);
+        }
+        return gsl_rng_uniform(rng_) <= acceptance_ratio;
+    }
+
+    void McmcScan::WriteCheckpoint() {
+        // The steps of Run(proposal) leave the scan's own statistics behind.
+        // In distributed mode, the coordinator's are taken over at each 
+        // synchronization instead.
+        if (running_policy_ && coordinator_socket_ < 0) {
+            gaussian_proposal_->Reset();
+        }
+
+        // Flush the chains, so that everything except the last points is in
+        // the chain files, and note how long the files are
+        std::vector<long> file_sizes;
+        std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            chains_[i_chain]->Sync();
+            file_sizes.push_back(FileSize(chains_[i_chain]->filename()));
+            if (file_sizes[i_chain] < 0) {
+                throw Mcmc::ChainFlushError();
+            }
+        }
+        output_wait_time_ += std::chrono::steady_clock::now() - start;
+
+        // Write to a temporary file, and only replace the old checkpoint once
+        // the new one is complete
+        std::string temp_filename = checkpoint_filename_ + ".tmp";
+        std::FILE* checkpoint_file = std::fopen(temp_filename.c_str(), "wb");
+        if (checkpoint_file == nullptr) {
+            throw Mcmc::CheckpointError("could not open " + temp_filename);
+        }
+
+        try {
+            if (std::fwrite(kCheckpointMagic, 1, sizeof(kCheckpointMagic),
+                    checkpoint_file) != sizeof(kCheckpointMagic)) {
+                throw Mcmc::CheckpointError("could not write checkpoint");
+            }
+            WriteValue<std::uint32_t>(checkpoint_file, dimension_);
+            WriteValue<std::uint32_t>(checkpoint_file, num_chains_);
+            WriteValue<std::uint32_t>(checkpoint_file, max_steps_);
+            WriteValue<double>(checkpoint_file, burn_fraction_);
+
+            WriteValue<std::uint32_t>(checkpoint_file, num_steps_);
+            WriteValue<std::uint32_t>(checkpoint_file,
+                    gaussian_proposal_->num_cholesky_updates_);
+            WriteValue<std::uint32_t>(checkpoint_file,
+                    num_surrogate_rejections_);
+            WriteValue<double>(checkpoint_file, measuring_time_.count());
+
+            WriteString(checkpoint_file, gsl_rng_name(rng_));
+            if (gsl_rng_fwrite(checkpoint_file, rng_) != GSL_SUCCESS) {
+                throw Mcmc::CheckpointError("could not write checkpoint");
+            }
+
+            WriteMatrix(checkpoint_file, gaussian_proposal_->covariance_);
+            WriteMatrix(checkpoint_file, gaussian_proposal_->covariance_inv_);
+            WriteMatrix(checkpoint_file,
+                    gaussian_proposal_->covariance_cholesky_);
+            WriteValue<double>(checkpoint_file,
+                    gaussian_proposal_->covariance_logdet_);
+            WriteVector(checkpoint_file, gaussian_proposal_->mean_);
+
+            for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+                Mcmc::MarkovChain const* chain = chains_[i_chain];
+                WriteString(checkpoint_file, chain->filename());
+                WriteValue<std::uint32_t>(checkpoint_file,
+                        chain->buffer_size());
+                WriteValue<std::uint32_t>(checkpoint_file,
+                        chain->num_points_flushed());
+                WriteValue<std::uint32_t>(checkpoint_file,
+                        chain->first_written());
+                WriteValue<std::uint32_t>(checkpoint_file,
+                        chain->thinning());
+                WriteValue<std::uint64_t>(checkpoint_file,
+                        file_sizes[i_chain]);
+
+                std::shared_ptr<Mcmc::Point> last_point = chain->last_point();
+                WriteVector(checkpoint_file, last_point->parameters());
+                WriteVector(checkpoint_file, last_point->measurements());
+                WriteValue<double>(checkpoint_file, last_point->likelihood());
+            }
+
+            WriteMonitor(checkpoint_file, autocorrelation_monitor_.get());
+            WriteMonitor(checkpoint_file, burn_in_monitor_.get());
+            WriteMonitor(checkpoint_file, convergence_monitor_.get());
+            WriteValue<std::uint32_t>(checkpoint_file, last_convergence_step_);
+            WriteValue<double>(checkpoint_file, last_max_r_hat_);
+        } catch (...) {
+            std::fclose(checkpoint_file);
+            std::remove(temp_filename.c_str());
+            throw;
+        }
+
+        if (std::fclose(checkpoint_file) != 0 ||
+                std::rename(temp_filename.c_str(),
+                checkpoint_filename_.c_str()) != 0) {
+            std::remove(temp_filename.c_str());
+            throw Mcmc::CheckpointError("could not write " +
+                    checkpoint_filename_);
+        }
+    }
+
+    std::unique_ptr<Mcmc::ChainWriter> McmcScan::NewChainWriter(
+            std::string filename,
+            unsigned int i_chain,
+            Mcmc::Point const& point) const {
+        std::unique_ptr<Mcmc::ChainWriter> writer;
+        if (binary_output_) {
+            char metadata[256];
+            std::snprintf(metadata, sizeof(metadata), "chain = %u\n"
+                    "num_chains = %u\nmax_steps = %u\nburn_fraction = %g\n",
+                    i_chain, num_chains_, max_steps_, burn_fraction_);
+            if (compressed_output_) {
+                writer.reset(new Mcmc::CompressedChainWriter(filename,
+                        dimension_, point.measurements()->size, metadata,
+                        run_length_encoding_));
+            } else {
+                writer.reset(new Mcmc::BinaryChainWriter(filename, dimension_,
+                        point.measurements()->size, metadata,
+                        run_length_encoding_));
+            }
+        } else {
+            writer.reset(new Mcmc::TextChainWriter(filename,
+                    run_length_encoding_));
+        }
+
+        if (output_thread_.get() == nullptr) {
+            return writer;
+        }
+        return std::unique_ptr<Mcmc::ChainWriter>(new Mcmc::AsyncChainWriter(
+                std::move(writer), output_thread_));
+    }
+
     void McmcScan::InitializeChains(unsigned int buffer_size,
             std::vector<std::pair<gsl_vector*, std::string> > chains_info)
     {
-        for (std::vector<std::pair<gsl_vector*, 
-                std::string> >::const_iterator i_chain = chains_info.begin(); 
-                i_chain < chains_info.end(); ++i_chain) {
-            gsl_vector* parameters = gsl_vector_alloc(dimension_);
-            gsl_vector_memcpy(parameters, i_chain->first);
-            
-            gsl_vector* measurements = nullptr;
-            double likelihood = 0.0;
-            MeasurePoint(parameters, measurements, likelihood);
+        // Measure all the seeds in one batch
+        gsl_matrix* parameters = gsl_matrix_alloc(num_chains_, dimension_);
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            gsl_matrix_set_row(parameters, i_chain, chains_info[i_chain].first);
+        }
+
+        gsl_matrix* measurements = nullptr;
+        gsl_vector* likelihoods = nullptr;
+        MeasureBatchCached(parameters, measurements, likelihoods);
+
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            gsl_vector_const_view parameters_row =
+                    gsl_matrix_const_row(parameters, i_chain);
+            gsl_vector_const_view measurements_row =
+                    gsl_matrix_const_row(measurements, i_chain);
             
-            std::shared_ptr<Mcmc::Point> point(
-                    new Mcmc::Point(parameters, measurements, likelihood));
-
-            chains_.push_back(
-                    new Mcmc::MarkovChain(point, i_chain->second, buffer_size));
-        }
-    }
-
-    void McmcScan::InitializeLastPointsMeanAndCovariance() {
-        // Compute the vector mean
-        last_points_mean_ = gsl_vector_calloc(dimension_);
-        for (std::vector<Mcmc::MarkovChain*>::const_iterator i_chain =
-                chains_.begin();
-                i_chain < chains_.end(); ++i_chain) {
-            gsl_vector_add(last_points_mean_,
-                    (*i_chain)->last_point()->parameters());
-        }
-        gsl_vector_scale(last_points_mean_, 1.0 / num_chains_);
-
-        // Compute the covariance matrix
-        // gsl_blas_dger: "rank-1 update (4') = (1)(2)(3)^T + (4)"
-        last_points_covariance_ = gsl_matrix_calloc(dimension_, dimension_);
-        gsl_vector* temp = gsl_vector_alloc(dimension_);
-        for (std::vector<Mcmc::MarkovChain*>::const_iterator i_chain =
-                chains_.begin();
-                i_chain < chains_.end(); ++i_chain) {
-            gsl_vector_memcpy(temp, (*i_chain)->last_point()->parameters());
-            gsl_vector_sub(temp, last_points_mean_);
-            gsl_blas_dger(1.0 / num_chains_, temp, temp,
-                    last_points_covariance_);
-        }
-        gsl_vector_free(temp);
-
-        // Compute the intermediates for the determinant and inverse of the 
-        // covariance matrix
-        gsl_matrix* covariance_lu = gsl_matrix_alloc(dimension_, dimension_);
-        gsl_matrix_memcpy(covariance_lu, last_points_covariance_);
-        gsl_permutation* covariance_p = gsl_permutation_alloc(dimension_);
-        int covariance_signum;
-        gsl_linalg_LU_decomp(covariance_lu, covariance_p, &covariance_signum);
-
-        // Compute the determinant of the covariance matrix
-        last_points_covariance_det_ = gsl_linalg_LU_det(covariance_lu,
-                covariance_signum);
-
-        // Sanity check: covariance matrix is nonsingular and positive definite
-        if (last_points_covariance_det_ <= 0.0) {
-            throw new Mcmc::PositiveDefiniteError();
-        }
-
-        // Compute the inverse of the covariance matrix
-        last_points_covariance_inv_ = gsl_matrix_alloc(dimension_, dimension_);
-        gsl_linalg_LU_invert(covariance_lu, covariance_p,
-                last_points_covariance_inv_);
-
-        // Free memory for intermediates
-        gsl_matrix_free(covariance_lu);
-        gsl_permutation_free(covariance_p);
-    }
-
-    std::shared_ptr<Mcmc::Point> McmcScan::TrialPoint(
-            std::shared_ptr<Mcmc::Point> last_point) {
-        double f = 2.381 / std::sqrt(dimension_);
-
-        // Compute the Cholesky decomposition of the covariance matrix
-        // gsl_linalg_cholesky_decomp: Cholesky decomposition of symmetric,
-        // positive-definite, square argument, only requires lower triangle.
-        // However, this returns L in the lower triangle and L^T overwritten
-        // in the upper triangle.
-        gsl_matrix* last_covariance_cholesky = gsl_matrix_alloc(dimension_,
-                dimension_);
-        gsl_matrix_memcpy(last_covariance_cholesky, last_points_covariance_);
-        gsl_linalg_cholesky_decomp(last_covariance_cholesky);
-
-        // Keep generating trial points until we get one with valid parameters
-        gsl_vector* trial_parameters = gsl_vector_alloc(dimension_);
-        while (true) {
-            // Construct a vector of random components from a unit Gaussian
-            for (int i = 0; i < dimension_; ++i) {
-                gsl_vector_set(trial_parameters, i, gsl_ran_ugaussian(rng_));
-            }
-
-            // Scale the vector with f*L to get the trial shift, where L is
-            // the Cholesky decomposition of the covariance matrix.
-            // gsl_blas_dtrmv: "matrix-vector product for the triangular matrix
-            // (5') = (4)(5)"
-            gsl_blas_dtrmv(CblasLower, CblasNoTrans, CblasNonUnit,
-                    last_covariance_cholesky, trial_parameters);
-            gsl_vector_scale(trial_parameters, f);
-
-            // Now we have the trial shift from the last point, and we need to
-            // generate the trial point itself
-            gsl_vector_add(trial_parameters, last_point->parameters());
-
-            // Test to see if the new parameters are valid
-            if (IsValidParameters(trial_parameters)) {
-                gsl_vector* trial_measurements = nullptr;
-                double trial_likelihood = 0.0;
-                MeasurePoint(trial_parameters, trial_measurements,
-                        trial_likelihood);
-
-                std::shared_ptr<Mcmc::Point> trial_point(
-                        new Mcmc::Point(trial_parameters, trial_measurements,
-                        trial_likelihood));
-
-                gsl_matrix_free(last_covariance_cholesky);
-
-                return trial_point;
-            }
-        }
-    }
-
-    void McmcScan::TrialMeanAndCovariance(
-            std::shared_ptr<Mcmc::Point> last_point,
-            std::shared_ptr<Mcmc::Point> trial_point,
-            gsl_vector*& trial_mean,
-            gsl_matrix*& trial_covariance,
-            double& trial_covariance_det,
-            gsl_matrix*& trial_covariance_inv) {
-        // Calculate the trial shift
-        // trial_shift = trial_parameters - last_parameters
-        gsl_vector* trial_shift = gsl_vector_alloc(dimension_);
-        gsl_vector_memcpy(trial_shift, trial_point->parameters());
-        gsl_vector_sub(trial_shift, last_point->parameters());
-
-        // Update the vector mean
-        // mean' = mean + trial_shift/num_chains
-        // gsl_blas_daxpy: "sum (3') = (1)(2) + (3)"
-        trial_mean = gsl_vector_alloc(dimension_);
-        gsl_vector_memcpy(trial_mean, last_points_mean_);
-        gsl_blas_daxpy(1.0 / num_chains_, trial_shift, trial_mean);
-
-        // Get intermediates for the calculation of covariance matrix quantities
-        std::array<gsl_vector*, 2> a;
-        std::array<gsl_vector*, 2> b;
-        for (int i = 0; i < 2; ++i) {
-            a[i] = gsl_vector_alloc(dimension_);
-            b[i] = gsl_vector_alloc(dimension_);
-        }
-        // a[0] = trial_shift/num_chains
-        gsl_vector_memcpy(a[0], trial_shift);
-        gsl_vector_scale(a[0], 1.0 / num_chains_);
-        // b[0] = last_parameters - last_mean
-        gsl_vector_memcpy(b[0], last_point->parameters());
-        gsl_vector_sub(b[0], last_points_mean_);
-        // a[1] = 1/(num_chains) * (last_parameters - last_mean + 
-        //        (num_chains - 1)/num_chains * trial_shift)
-        // gsl_blas_daxpy: "sum (3') = (1)(2) + (3)"
-        gsl_vector_memcpy(a[1], last_point->parameters());
-        gsl_vector_sub(a[1], last_points_mean_);
-        gsl_blas_daxpy((num_chains_ - 1.0) / num_chains_, trial_shift, a[1]);
-        gsl_vector_scale(a[1], 1.0 / num_chains_);
-        // b[1] = trial_shift
-        gsl_vector_memcpy(b[1], trial_shift);
-        // one_plus_lambda[i,j] = I[i,j] + b[i]^T C^-1 a[j]
-        // gsl_blas_dgemv: "the matrix-vector product and sum
-        //                  (6') = (2)(3)(4) + (5)(6)"
-        // gsl_blas_ddot: "the scalar product (3) = (1)^T (2)"
-        gsl_matrix* one_plus_lambda = gsl_matrix_calloc(2, 2);
-        double temp_double;
-        gsl_vector* temp_vector = gsl_vector_alloc(dimension_);
-        for (int i = 0; i < 2; ++i) {
-            for (int j = 0; j < 2; ++j) {
-                gsl_vector_set_zero(temp_vector);
-                gsl_blas_dgemv(CblasNoTrans, 1.0, last_points_covariance_inv_,
-                        a[j], 0.0, temp_vector);
-                gsl_blas_ddot(b[i], temp_vector, &temp_double);
-                if (i == j) {
-                    temp_double += 1.0;
+            std::shared_ptr<Mcmc::Point> point = NewPoint(
+                    &parameters_row.vector, &measurements_row.vector,
+                    gsl_vector_get(likelihoods, i_chain));
+
+            chains_.push_back(new Mcmc::MarkovChain(point,
+                    NewChainWriter(chains_info[i_chain].second, i_chain,
+                    *point), buffer_size, 0));
+            if (discard_burn_in_) {
+                chains_.back()->SetOutputPolicy(
+                        Mcmc::MarkovChain::kNeverWritten, 1);
+            } else {
+                chains_.back()->SetOutputPolicy(0, output_thinning_);
+            }
+        }
+
+        gsl_matrix_free(parameters);
+        gsl_matrix_free(measurements);
+        gsl_vector_free(likelihoods);
+    }
+
+    void McmcScan::SyncWithCoordinator(std::uint32_t type) {
+        sync_values_.resize(num_chains_ * dimension_);
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            gsl_vector const* parameters =
+                    chains_[i_chain]->last_point()->parameters();
+            for (unsigned int i = 0; i < dimension_; ++i) {
+                sync_values_[i_chain * dimension_ + i] =
+                        gsl_vector_get(parameters, i);
+            }
+        }
+
+        std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+        Mcmc::CoordinatorProtocol::SendMessage(coordinator_socket_, type,
+                sync_values_);
+        if (type == Mcmc::CoordinatorProtocol::kDone) {
+            ::close(coordinator_socket_);
+            coordinator_socket_ = -1;
+            return;
+        }
+        if (Mcmc::CoordinatorProtocol::ReceiveMessage(coordinator_socket_,
+                sync_values_) != Mcmc::CoordinatorProtocol::kState ||
+                sync_values_.size() != 2 + dimension_ + dimension_ * 
+                dimension_) {
+            throw Mcmc::CoordinatorError("expected the state of the scan");
+        }
+        sync_wait_time_ += std::chrono::steady_clock::now() - start;
+        if (type == Mcmc::CoordinatorProtocol::kSync) {
+            ++num_syncs_;
+        }
+
+        // Sanity check: the other workers' chains are counted from here on,
+        // so the numbers must add up
+        unsigned int ensemble_size = sync_values_[0];
+        unsigned int first_ensemble_chain = sync_values_[1];
+        if (ensemble_size <= dimension_ ||
+                first_ensemble_chain + num_chains_ > ensemble_size) {
+            throw Mcmc::CoordinatorError("inconsistent number of chains");
+        }
+        ensemble_size_ = ensemble_size;
+        first_ensemble_chain_ = first_ensemble_chain;
+
+        double const* mean = &sync_values_[2];
+        double const* covariance = &sync_values_[2 + dimension_];
+        for (unsigned int i = 0; i < dimension_; ++i) {
+            gsl_vector_set(gaussian_proposal_->mean_, i, mean[i]);
+            for (unsigned int j = 0; j < dimension_; ++j) {
+                gsl_matrix_set(gaussian_proposal_->covariance_, i, j,
+                        covariance[i * dimension_ + j]);
+            }
+        }
+        gaussian_proposal_->ensemble_size_ = ensemble_size_;
+        gaussian_proposal_->Factor();
+    }
+
+    void McmcScan::MeasureBatch(gsl_matrix const* parameters,
+            gsl_matrix*& measurements,
+            gsl_vector*& likelihoods) {
+        likelihoods = gsl_vector_alloc(parameters->size1);
+
+        for (size_t i_point = 0; i_point < parameters->size1; ++i_point) {
+            gsl_vector_const_view point_parameters =
+                    gsl_matrix_const_row(parameters, i_point);
+            gsl_vector* point_measurements = nullptr;
+            double point_likelihood = 0.0;
+            MeasurePoint(&point_parameters.vector, point_measurements,
+                    point_likelihood);
+
+            // The number of measurements is only known once the first point
+            // has been measured
+            if (i_point == 0) {
+                measurements = gsl_matrix_alloc(parameters->size1,
+                        point_measurements->size);
+            }
+            gsl_matrix_set_row(measurements, i_point, point_measurements);
+            gsl_vector_set(likelihoods, i_point, point_likelihood);
+
+            gsl_vector_free(point_measurements);
+        }
+    }
+
+    double McmcScan::SurrogateLikelihood(gsl_vector const* parameters) {
+        return 1.0;
+    }
+
+    void McmcScan::MeasurePointCached(gsl_vector const* parameters,
+            gsl_vector*& measurements,
+            double& likelihood) {
+        if (measurement_cache_.get() != nullptr &&
+                measurement_cache_->Lookup(parameters, measurements,
+                likelihood)) {
+            return;
+        }
+
+        MeasurePoint(parameters, measurements, likelihood);
+
+        if (measurement_cache_.get() != nullptr) {
+            measurement_cache_->Insert(parameters, measurements, likelihood);
+        }
+    }
+
+    void McmcScan::MeasureBatchCached(gsl_matrix const* parameters,
+            gsl_matrix*& measurements,
+            gsl_vector*& likelihoods) {
+        if (measurement_cache_.get() == nullptr) {
+            MeasureBatch(parameters, measurements, likelihoods);
+            return;
+        }
+
+        size_t num_points = parameters->size1;
+        likelihoods = gsl_vector_alloc(num_points);
+
+        // Look up every row, and collect the ones that miss
+        std::vector<gsl_vector*> cached_measurements(num_points, nullptr);
+        std::vector<size_t> misses;
+        for (size_t i_point = 0; i_point < num_points; ++i_point) {
+            gsl_vector_const_view point_parameters =
+                    gsl_matrix_const_row(parameters, i_point);
+            double point_likelihood = 0.0;
+            if (measurement_cache_->Lookup(&point_parameters.vector,
+                    cached_measurements[i_point], point_likelihood)) {
+                gsl_vector_set(likelihoods, i_point, point_likelihood);
+            } else {
+                misses.push_back(i_point);
+            }
+        }
+
+        // Measure the misses as one batch, and remember the results
+        gsl_matrix* miss_measurements = nullptr;
+        gsl_vector* miss_likelihoods = nullptr;
+        if (!misses.empty()) {
+            gsl_matrix* miss_parameters = gsl_matrix_alloc(misses.size(),
+                    parameters->size2);
+            for (size_t i_miss = 0; i_miss < misses.size(); ++i_miss) {
+                gsl_vector_const_view point_parameters =
+                        gsl_matrix_const_row(parameters, misses[i_miss]);
+                gsl_matrix_set_row(miss_parameters, i_miss,
+                        &point_parameters.vector);
+            }
+
+            try {
+                MeasureBatch(miss_parameters, miss_measurements,
+                        miss_likelihoods);
+            } catch (...) {
+                gsl_matrix_free(miss_parameters);
+                gsl_vector_free(likelihoods);
+                for (size_t i_point = 0; i_point < num_points; ++i_point) {
+                    gsl_vector_free(cached_measurements[i_point]);
                 }
-                gsl_matrix_set(one_plus_lambda, i, j, temp_double);
-            }
-        }
-        gsl_vector_free(temp_vector);
-        // Determinant and inverse of one_plus_lambda
-        // Using the GSL linear algebra library requires computing the LU
-        //   decomposition, and is too heavy-handed for this application.
-        // Note that if the determinant of one_plus_lambda is zero, then the
-        //   resulting trial covariance matrix will also have determinant zero.
-        //   This occurs almost never, but in case it does, we might as well 
-        //   check for it here before it is used to compute the inverse.
-        double one_plus_lambda_det = gsl_matrix_get(one_plus_lambda, 0, 0) *
-                gsl_matrix_get(one_plus_lambda, 1, 1) -
-                gsl_matrix_get(one_plus_lambda, 0, 1) *
-                gsl_matrix_get(one_plus_lambda, 1, 0);
-        if (one_plus_lambda_det <= 0.0) {
-            // Free memory of intermediates
-            gsl_vector_free(trial_shift);
-            for (int i = 0; i < 2; ++i) {
-                gsl_vector_free(a[i]);
-                gsl_vector_free(b[i]);
-            }
-            gsl_matrix_free(one_plus_lambda);
-
-            throw new Mcmc::PositiveDefiniteError();
-        }
-        gsl_matrix* one_plus_lambda_inv = gsl_matrix_alloc(2, 2);
-        gsl_matrix_set(one_plus_lambda_inv, 0, 0,
-                gsl_matrix_get(one_plus_lambda, 1, 1) / one_plus_lambda_det);
-        gsl_matrix_set(one_plus_lambda_inv, 0, 1,
-                -1.0 * gsl_matrix_get(one_plus_lambda, 0, 1) /
-                one_plus_lambda_det);
-        gsl_matrix_set(one_plus_lambda_inv, 1, 0,
-                -1.0 * gsl_matrix_get(one_plus_lambda, 1, 0) /
-                one_plus_lambda_det);
-        gsl_matrix_set(one_plus_lambda_inv, 1, 1,
-                gsl_matrix_get(one_plus_lambda, 0, 0) / one_plus_lambda_det);
-        
-        // Update the covariance matrix
-        // C' = C + a[0]*b0^T + a[1]*b[1]^T
-        // gsl_blas_dger: "the rank-1 update (4') = (1)(2)(3)^T + (4)"
-        trial_covariance = gsl_matrix_alloc(dimension_, dimension_);
-        gsl_matrix_memcpy(trial_covariance, last_points_covariance_);
-        for (int i = 0; i < 2; ++i) {
-            gsl_blas_dger(1.0, a[i], b[i], trial_covariance);
-        }
-
-        // Update the determinant of the covariance matrix
-        // det(C') = det(C) * det(one_plus_lambda)
-        trial_covariance_det = last_points_covariance_det_ *
-                one_plus_lambda_det;
-
-        // Update the inverse of the covariance matrix
-        // C'^-1 = C^-1 - 
-        //         sum_i sum_j (one_plus_lambda^-1)[i][j] C^-1 a[i] b[j]^T C^-1
-        // gsl_blas_dger: "the rank-1 update (4') = (1)(2)(3)^T + (4)"
-        // gsl_blas_dgemm: "the matrix-matrix product and sum
-        //                  (7') = (3)(4)(5) + (6)(7)"
-        trial_covariance_inv = gsl_matrix_alloc(dimension_, dimension_);
-        gsl_matrix* temp_matrix1 = gsl_matrix_alloc(dimension_, dimension_);
-        gsl_matrix* temp_matrix2 = gsl_matrix_alloc(dimension_, dimension_);
-        gsl_matrix_memcpy(trial_covariance_inv, last_points_covariance_inv_);
-        for (int i = 0; i < 2; ++i) {
-            for (int j = 0; j < 2; ++j) {
-                gsl_matrix_set_zero(temp_matrix1);
-                gsl_matrix_set_zero(temp_matrix2);
-                gsl_blas_dger(1.0, a[i], b[j], temp_matrix1);
-                gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, temp_matrix1,
-                        last_points_covariance_inv_, 0.0, temp_matrix2);
-                gsl_blas_dgemm(CblasNoTrans, CblasNoTrans,
-                        gsl_matrix_get(one_plus_lambda_inv, i, j),
-                        last_points_covariance_inv_, temp_matrix2, 0.0,
-                        temp_matrix1);
-                gsl_matrix_sub(trial_covariance_inv, temp_matrix1);
-            }
-        }
-        gsl_matrix_free(temp_matrix1);
-        gsl_matrix_free(temp_matrix2);
-
-        // Free memory of intermediates
-        gsl_vector_free(trial_shift);
-        for (int i = 0; i < 2; ++i) {
-            gsl_vector_free(a[i]);
-            gsl_vector_free(b[i]);
-        }
-        gsl_matrix_free(one_plus_lambda);
-        gsl_matrix_free(one_plus_lambda_inv);
+                throw;
+            }
+
+            for (size_t i_miss = 0; i_miss < misses.size(); ++i_miss) {
+                gsl_vector_const_view point_parameters =
+                        gsl_matrix_const_row(miss_parameters, i_miss);
+                gsl_vector_const_view point_measurements =
+                        gsl_matrix_const_row(miss_measurements, i_miss);
+                measurement_cache_->Insert(&point_parameters.vector,
+                        &point_measurements.vector,
+                        gsl_vector_get(miss_likelihoods, i_miss));
+            }
+            gsl_matrix_free(miss_parameters);
+        }
+
+        // Put the cached and freshly measured rows back together, in order
+        size_t num_measurements;
+        if (misses.empty()) {
+            num_measurements = cached_measurements[0]->size;
+        } else {
+            num_measurements = miss_measurements->size2;
+        }
+        measurements = gsl_matrix_alloc(num_points, num_measurements);
+        size_t i_miss = 0;
+        for (size_t i_point = 0; i_point < num_points; ++i_point) {
+            if (i_miss < misses.size() && misses[i_miss] == i_point) {
+                gsl_vector_const_view point_measurements =
+                        gsl_matrix_const_row(miss_measurements, i_miss);
+                gsl_matrix_set_row(measurements, i_point,
+                        &point_measurements.vector);
+                gsl_vector_set(likelihoods, i_point,
+                        gsl_vector_get(miss_likelihoods, i_miss));
+                ++i_miss;
+            } else {
+                gsl_matrix_set_row(measurements, i_point,
+                        cached_measurements[i_point]);
+                gsl_vector_free(cached_measurements[i_point]);
+            }
+        }
+
+        gsl_matrix_free(miss_measurements);
+        gsl_vector_free(miss_likelihoods);
     }
 
     double McmcScan::Lambda() {
+        if (!tempering_ladder_.empty()) {
+            return replica_lambda_;
+        }
+
         double lambda = 1.0;
 
         if (num_steps_ <= burn_fraction_ * max_steps_ / 2.0) {
@@ -457,48 +2009,50 @@ namespace Mcmc {
         return lambda;
     }
 
-    double McmcScan::AcceptanceRatio(std::shared_ptr<Mcmc::Point> last_point,
-            std::shared_ptr<Mcmc::Point> trial_point,
-            double trial_covariance_det,
-            gsl_matrix const* trial_covariance_inv) {
-        double f = 2.381 / std::sqrt(dimension_);
-
-        // Calculate the trial shift
-        // trial_shift = trial_parameters - last_parameters
-        gsl_vector* trial_shift = gsl_vector_alloc(dimension_);
-        gsl_vector_memcpy(trial_shift, trial_point->parameters());
-        gsl_vector_sub(trial_shift, last_point->parameters());
-
-        // Calculate the linear algebra part of the formula
-        // gsl_blas_dgemv: "the matrix-vector product and sum
-        //                  (6') = (2)(3)(4) + (5)(6)"
-        // gsl_blas_ddot: "the scalar product (3) = (1)^T (2)"
-        double linear_algebra_part;
-        gsl_matrix* temp_matrix = gsl_matrix_alloc(dimension_, dimension_);
-        gsl_vector* temp_vector = gsl_vector_alloc(dimension_);
-        gsl_matrix_memcpy(temp_matrix, trial_covariance_inv);
-        gsl_matrix_sub(temp_matrix, last_points_covariance_inv_);
-        gsl_blas_dgemv(CblasNoTrans, 1.0, temp_matrix, trial_shift, 0.0,
-                temp_vector);
-        gsl_blas_ddot(trial_shift, temp_vector, &linear_algebra_part);
-        gsl_matrix_free(temp_matrix);
-        gsl_vector_free(temp_vector);
-        gsl_vector_free(trial_shift);
-
-        // Calculate the acceptance ratio
-        // If either matrix determinant were zero, it would have thrown an 
-        // exception already.
-        double acceptance_ratio;
-        if (last_point->likelihood() == 0.0) {
-            acceptance_ratio = 1.0;
-        } else {
-            acceptance_ratio =
-                    std::sqrt(last_points_covariance_det_ / trial_covariance_det) *
-                    std::exp(-1.0 / (2.0 * f * f) * linear_algebra_part) *
-                    std::pow(trial_point->likelihood() / last_point->likelihood(),
-                    Lambda());
+    void McmcScan::StartOutput() {
+        output_started_ = true;
+        if (!output_policy_set_) {
+            return;
         }
-        return acceptance_ratio;
+
+        if (burn_in_monitor_.get() != nullptr) {
+            // Largest autocorrelation time of each chain, averaged over the
+            // chains that have a finite estimate
+            double sum_times = 0.0;
+            unsigned int num_times = 0;
+            for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+                if (!burn_in_monitor_->ready(i_chain)) {
+                    continue;
+                }
+                double max_time = 0.0;
+                for (unsigned int i = 0; i < dimension_; ++i) {
+                    max_time = std::max(max_time,
+                            burn_in_monitor_->AutocorrelationTime(i_chain,
+                            i));
+                }
+                if (max_time < std::numeric_limits<double>::infinity()) {
+                    sum_times += max_time;
+                    ++num_times;
+                }
+            }
+            output_thinning_ = num_times == 0 ? 1 : std::max(1.0,
+                    std::ceil(sum_times / num_times));
+            std::printf("  Burn-in done, thinning the chain output by %u.\n",
+                    output_thinning_);
+            std::printf("\n");
+        }
+
+        if (discard_burn_in_) {
+            for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+                chains_[i_chain]->SetOutputPolicy(chains_[i_chain]->length(),
+                        output_thinning_);
+            }
+        }
+    }
+
+    double McmcScan::LikelihoodRatio(double last_likelihood,
+            double trial_likelihood) {
+        return std::pow(trial_likelihood / last_likelihood, Lambda());
     }
 
 
@@ -5,22 +5,59 @@
  * Markov chain Monte Carlo (MCMC) scan of a parameter space.  Abstract class.
  * Users must subclass McmcScan, supplying implementations for the pure virtual 
  * methods IsValidParameters(), MeasurePoint(), and InitializeChains().
+ * Subclasses may also override MeasureBatch() to measure many points at once.
  * 
  * McmcScan uses an adaptive Metropolis-Hastings algorithm with simulated
  * annealing.  A Gaussian proposal is used to choose the trial shift.  The
  * algorithm is adaptive in that the size of the shift in any direction is based
  * on the covariance matrix of the chains' last points, which is a measure of
  * how large the posterior probability distribution seems to be at that time.
- * These quantities are continuously updated at each step.
+ * These quantities are continuously updated at each step.  The Cholesky 
+ * decomposition of the covariance matrix, which is used to draw the trial 
+ * shifts, is kept as well, and updated with a rank-1 update and a rank-1 
+ * downdate whenever a trial point is accepted.
  * 
  * Users must first extend this class to supply
  * * IsValidParameters(), which returns true if the parameters are within the
  *   bounds of the parameter space.
  * * MeasurePoint(), which supplies the measurements and likelihood for a given
  *   point in the parameter space.
+ * Users may optionally override
+ * * SurrogateLikelihood(), a cheap approximation to the likelihood, which is
+ *   used in delayed-acceptance mode.
+ * * MeasureBatch(), which does the same for a whole block of points at once.
+ *   The default implementation just calls MeasurePoint() on each point.  An
+ *   override can vectorize across points, or set up an expensive external
+ *   calculation once per batch instead of once per point.  It is used to 
+ *   measure the chain seeds in Initialize(), and the trial points in sweep
+ *   mode, where each worker thread measures one contiguous batch.
  * Users should then initialize an instance of the subclass, and then call
  * Initialize() with the chain initialization info, and then Run().  
  * 
+ * By default, Run() updates one randomly chosen chain per step, drawing the
+ * trial point from an Mcmc::AdaptiveGaussianProposal.  The Enable*(), Use*()
+ * and SetOutputPolicy() methods change how the steps are taken, measured,
+ * checkpointed, written out and monitored, and each describes its mode.  
+ * Run(proposal) takes the trial points from a proposal policy of the user's
+ * own instead.  Every point appended to a chain after the burn-in also goes
+ * into an Mcmc::AutocorrelationMonitor, whose effective sample sizes the 
+ * progress output reports.  At the end of Run(), the scan reports where the
+ * time went and what each enabled mode did.
+ * 
+ * Compatibility of the modes:
+ * * The step modes, i.e. sweep mode, delayed acceptance, differential 
+ *   evolution, stretch moves and parallel tempering, cannot be combined with
+ *   each other.
+ * * Run(proposal) only works in the default step mode and in 
+ *   delayed-acceptance mode.
+ * * Distributed mode works with the default step mode, sweep mode and 
+ *   delayed acceptance.
+ * * Compressed output needs binary output, and early stop the convergence
+ *   monitor.  SetOutputPolicy() and EnableAutomaticThinning() exclude each
+ *   other.
+ * * Everything else combines freely.  Breaking a rule throws 
+ *   std::logic_error from the Enable*() method or Run(proposal).
+ * 
  * The random number generator rng_ is protected so that users may use it in
  * their subclass, say, to initialize chains.
  * 
@@ -37,8 +74,16 @@
  *   results in printing a message to stdout.  Flushing will be tried again the
  *   next time MarkovChain::Append(), MarkovChain::Flush(), or the destructor
  *   is called.
- * * For all the private methods, all output pointers are allocated within the
- *   method.  So the output pointers passed in should not be allocated already.
+ * * All of the vectors and matrices used in the step loop live in a 
+ *   Mcmc::ScanWorkspace and the Mcmc::AdaptiveGaussianProposal of the 
+ *   built-in modes, which are allocated once in Initialize(), so that 
+ *   Run() does no allocations of its own per step.  The Point objects of 
+ *   accepted trial points come from a Mcmc::PointPool, which only allocates
+ *   until it has as many slots as the scan ever holds Points at once, and 
+ *   the chains' output buffers only grow when a flush fails.  In the steady
+ *   state, the only allocations left are the trial measurements that 
+ *   MeasurePoint() or MeasureBatch() allocate, and that the step frees 
+ *   again, plus whatever a measurement cache or a background writer does.
  * 
  * Created on March 19, 2014, 11:19 PM
  */
@@ -46,7 +91,13 @@
 #ifndef MCMC_MCMCSCAN_H
 #define	MCMC_MCMCSCAN_H
 
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include <chrono>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
@@ -55,10 +106,27 @@
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_vector.h>
 
+#include "AutocorrelationMonitor.h"
+#include "ChainWriter.h"
+#include "ConvergenceMonitor.h"
 #include "MarkovChain.h"
+#include "MeasurementCache.h"
+#include "OutputThread.h"
+#include "Point.h"
+#include "PointPool.h"
+#include "PosteriorAccumulator.h"
+#include "ScanWorkspace.h"
+#include "ThreadPool.h"
+
+// Unit test fixture, which is allowed to drive the private step methods
+class McmcScanTest;
 
 namespace Mcmc {
 
+    // Proposal policies of the built-in modes, which include this header
+    class AdaptiveGaussianProposal;
+    class StretchMoveProposal;
+
     class McmcScan {
     public:
         McmcScan(unsigned int dimension,
@@ -86,7 +154,15 @@ namespace Mcmc {
                 std::pair<gsl_vector*, std::string> > chains_info);
 
         /*
-         * Runs the scan to completion unless an exception is thrown.
+         * Runs the scan to completion unless an exception is thrown, or the
+         * chains have converged with early stop enabled.  At the end, it 
+         * reports how much of the time was spent measuring points and 
+         * waiting on the chain output, and what the enabled modes did: the
+         * trial points delayed acceptance rejected without measuring them,
+         * the cache's hits and misses, the largest R-hat at the last check,
+         * the swap acceptance rates, the time spent waiting on the 
+         * coordinator, and the autocorrelation times and effective sample 
+         * sizes.
          * 
          * throws std::logic error if called before chains are initialized
          * 
@@ -97,13 +173,476 @@ namespace Mcmc {
          */
         void Run();
 
+        /*
+         * Same as Run(), but with trial points drawn from the given proposal
+         * policy instead of the built-in ones, to try another algorithm 
+         * without touching McmcScan.  The policy has to outlive the call.
+         * Run() is a template over it, so that the step loop makes no 
+         * virtual calls to it.  A policy is any class with the methods
+         *   void Propose(unsigned int i_chain, 
+         *           gsl_vector const* last_parameters,
+         *           gsl_rng* rng, gsl_vector* trial_parameters);
+         *   double LogHastingsRatio(unsigned int i_chain, 
+         *           gsl_vector const* last_parameters,
+         *           gsl_vector const* trial_parameters);
+         *   void UpdateState(unsigned int i_chain, 
+         *           gsl_vector const* last_parameters,
+         *           gsl_vector const* trial_parameters);
+         * Each step, Propose() draws trial parameters for the randomly 
+         * chosen chain i_chain, once.  If IsValidParameters() does not 
+         * accept them, the step is a rejection, and the chain repeats its 
+         * last point.  Otherwise, once the trial point is measured, 
+         * LogHastingsRatio() returns 
+         *   log(q(last | trial) / q(trial | last))
+         * for the policy's proposal density q, i.e. 0 for a symmetric 
+         * proposal, and the trial point is accepted with probability
+         *   min(1, exp(LogHastingsRatio()) (L'/L)^lambda)
+         * If it is, UpdateState() is called before the chain moves, so that
+         * the policy can bring any ensemble statistics it keeps up to date.
+         * In delayed-acceptance mode, each step makes the two-stage decision
+         * of EnableDelayedAcceptance() instead, with the policy's Hastings 
+         * ratio.  The public accessors below give a policy the chains' state
+         * to build on, though the last points' statistics lag behind the 
+         * steps, as described there.  A policy can hold an 
+         * Mcmc::AdaptiveGaussianProposal of its own to fall back on the 
+         * default proposal.  For small scans whose dimension is known at 
+         * compile time, Mcmc::FixedDimensionGaussianProposal does the same 
+         * as the default proposal on fixed-size arrays instead of GSL 
+         * vectors and matrices.
+         * 
+         * throws std::logic_error if called before chains are initialized,
+         * or if a step mode other than delayed acceptance is enabled
+         * 
+         * may throw whatever the policy throws, and the same as Run()
+         */
+        template <typename Proposal>
+        void Run(Proposal& proposal);
+
+        /*
+         * Switches Run() to sweep mode, with MeasureBatch() calls spread over
+         * the given number of worker threads.  Must be called before Run().
+         * 
+         * Each sweep, every chain draws a trial point from the same snapshot
+         * of the last points' mean and covariance, all of the trial points
+         * are measured concurrently, each worker thread measuring one 
+         * contiguous batch, and the accept/reject decisions are then made 
+         * one chain at a time, in chain order, each with the Hastings ratio
+         * of the snapshot its trial point was drawn from.  Each chain update
+         * still counts as one step.  A last sweep cut short by max_steps 
+         * starts at a random chain.  MeasureBatch() must be safe to call 
+         * from several threads at once, and must not use rng_.
+         * 
+         * throws std::invalid_argument if num_threads is zero
+         * 
+         * throws std::logic_error if sweep mode is already enabled, or if
+         * another step mode is
+         */
+        void EnableSweepMode(unsigned int num_threads);
+
+        /*
+         * Switches Run() to delayed-acceptance mode, where trial points are
+         * first screened with SurrogateLikelihood(), and only the survivors
+         * are measured.  Must be called before Run().
+         * 
+         * Each step is decided in two stages (Christen & Fox, J. Comput. 
+         * Graph. Stat. 14, 795 (2005)).  The first stage accepts or rejects
+         * the trial point as usual, but with SurrogateLikelihood() in place
+         * of the likelihood.  The trial points that survive it are measured,
+         * and the second stage accepts them with probability
+         *   min(1, (L'/L)^lambda / (S'/S)^lambda)
+         * where L and S are the likelihood and the surrogate likelihood, and
+         * primes denote the trial point.  The product of the two stages 
+         * satisfies detailed balance with respect to the true posterior, so
+         * the surrogate only changes how many points are measured, not the 
+         * distribution of the chains.  For this to hold, the surrogate must
+         * be positive wherever the likelihood is.  The better the surrogate,
+         * the fewer of the measured points are rejected in the second stage.
+         * 
+         * throws std::logic_error if delayed-acceptance mode is already 
+         * enabled, or if another step mode is
+         */
+        void EnableDelayedAcceptance();
+
+        /*
+         * Makes Run() draw trial points by differential evolution (ter 
+         * Braak, Stat. Comput. 16, 239 (2006)) instead of from the 
+         * covariance matrix, with an Mcmc::DifferentialEvolutionProposal.
+         * Must be called before Run().
+         * 
+         * The jump from a chain's last point is gamma (x_a - x_b), for the 
+         * last points x_a and x_b of two other randomly chosen chains, plus
+         * a little Gaussian noise, scaled by the spread of the seeds in each
+         * parameter.  gamma is 2.38/sqrt(2 d), and 1 for one jump in ten, so
+         * that chains can jump between modes.  The proposal is symmetric, so
+         * the step needs no mean, covariance or matrix factorization at all,
+         * and the acceptance ratio is the likelihood ratio alone.  For it to
+         * stay symmetric near the boundary, a trial point outside the valid
+         * region is rejected rather than redrawn.
+         * 
+         * throws std::logic_error if differential evolution is already 
+         * enabled, if there are fewer than three chains, or if another step
+         * mode or distributed mode is enabled
+         */
+        void EnableDifferentialEvolution();
+
+        /*
+         * Makes Run() update the chains with the affine-invariant stretch 
+         * move of Goodman and Weare (Commun. Appl. Math. Comput. Sci. 5, 65
+         * (2010)), one half of the chains at a time, with the MeasurePoint()
+         * calls of each half spread over the given number of worker threads.
+         * Must be called before Run().
+         * 
+         * The stretch move does not care how badly scaled or correlated the
+         * parameters are.  While one half of the chains is updated, the 
+         * other stays put: chain k moves to X_j + z (X_k - X_j), for a 
+         * random chain j of the other half and a random stretch factor z 
+         * between 1/2 and 2, and is accepted with probability z^(d - 1) 
+         * times the likelihood ratio.  Like differential evolution, it needs
+         * no mean, covariance or matrix factorization.
+         * 
+         * throws std::invalid_argument if num_threads is zero
+         * 
+         * throws std::logic_error if stretch moves are already enabled, or if
+         * another step mode or distributed mode is enabled
+         */
+        void EnableStretchMove(unsigned int num_threads);
+
+        /*
+         * Enables parallel tempering over the given ladder of lambdas, which
+         * must start at 1 and decrease strictly, staying above 0.  Neighbouring
+         * rungs propose a swap every swap_interval steps.  Must be called 
+         * before Run().
+         * 
+         * This replaces the annealing in the burn-in.  Every rung of the 
+         * ladder runs num_chains chains of its own, started from copies of 
+         * the seeds, with its own last points' mean and covariance, and 
+         * samples the likelihood raised to the rung's lambda.  Each step 
+         * updates one randomly chosen chain in every rung, with the trial 
+         * points of all rungs measured concurrently, one rung per thread.
+         * A swap exchanges the points of one randomly chosen chain of a pair
+         * of neighbouring rungs with the same chain of the other rung, if 
+         * the Metropolis test on the swap passes, so that chains stuck in one
+         * mode of the lambda = 1 rung can be handed points the hotter rungs
+         * found elsewhere.  Only the lambda = 1 rung has chain files.  Its 
+         * swaps are proposed at the start of a step, with the chain the step
+         * updates, so a point it gets in a swap replaces the chain's current
+         * state and is recorded by that step, rather than being appended as 
+         * an extra sample.  All the rungs step in lockstep, so the hotter 
+         * rungs adapt their proposals at the same rate as the lambda = 1 
+         * rung.  Checkpoints only hold the lambda = 1 rung, so after a 
+         * resume the other rungs start over from copies of its last points.
+         * 
+         * throws std::invalid_argument if the ladder is not as above, or 
+         * swap_interval is zero
+         * 
+         * throws std::logic_error if parallel tempering is already enabled, 
+         * or if another step mode or distributed mode is enabled
+         */
+        void EnableParallelTempering(std::vector<double> ladder,
+                unsigned int swap_interval);
+
+        /*
+         * Fraction of the proposed swaps between rungs i_rung and i_rung + 1
+         * of the ladder that were accepted, or 0 if none were proposed.
+         * 
+         * throws std::out_of_range if there is no such pair of rungs
+         */
+        double swap_acceptance_rate(unsigned int i_rung) const;
+
+        /*
+         * Looks up every point in the given cache before measuring it, and 
+         * stores the results of every measurement there.  The cache can be
+         * shared with later scans.  Must be called before Initialize() for 
+         * the chain seeds to go through the cache as well.
+         * 
+         * throws std::invalid_argument if cache is null
+         * 
+         * throws std::logic_error if a cache is already in use
+         */
+        void UseMeasurementCache(std::shared_ptr<Mcmc::MeasurementCache>
+                cache);
+
+        /*
+         * Makes Run() write a checkpoint to the given file every interval 
+         * steps.  (In sweep mode, at the end of the first sweep after that.)
+         * The file is written to a temporary file first and then renamed, so
+         * an existing checkpoint is never left half-written.
+         * 
+         * The binary checkpoint holds everything needed to carry on: the 
+         * state of rng_, the step count, the last points' mean, covariance,
+         * inverse and Cholesky decomposition, each chain's filename, buffer
+         * size, output file length, and last point, and the counts and sums
+         * of the autocorrelation, automatic-thinning and convergence 
+         * monitors.  The chains are flushed right before a checkpoint is 
+         * written, so the points before each chain's last point are already
+         * in the chain files.  The modes themselves are not part of the 
+         * checkpoint, and must be enabled again before resuming.
+         * 
+         * If a checkpoint cannot be written, Run() only prints a message, and
+         * tries again after another interval.
+         * 
+         * throws std::invalid_argument if filename is empty or interval is 
+         * zero
+         */
+        void EnableCheckpoints(std::string filename, unsigned int interval);
+
+        /*
+         * Initializes the scan from a checkpoint file written by an earlier
+         * run of the same scan, instead of Initialize(), e.g. after the run 
+         * died.  The chain files named in the checkpoint are truncated back
+         * to where they were when the checkpoint was written, and Run() then
+         * carries on exactly where the checkpoint left off, so the chain 
+         * files end up bit-identical to those of an uninterrupted run.  The
+         * monitors that are enabled now and were then carry on from the 
+         * checkpoint, so automatic thinning picks the same thinning and the 
+         * R-hat checks come out the same; the others, and the posterior 
+         * accumulator, start over.
+         * 
+         * throws std::logic_error if the chains have already been initialized
+         * 
+         * throws Mcmc::CheckpointError if the file cannot be read, does not
+         * match the dimension, number of chains, maximum steps or burn 
+         * fraction of this scan, or if a chain file is shorter than recorded
+         * 
+         * may throw Mcmc::ChainFlushError if output files cannot be opened
+         */
+        void ResumeFromCheckpoint(std::string filename);
+
+        /*
+         * Makes the chains write their output files in the binary format of
+         * Mcmc::BinaryChainWriter rather than text, with the scan's settings
+         * and the chain's number in each file's header.  Must be called 
+         * before Initialize() or ResumeFromCheckpoint().
+         * 
+         * throws std::logic_error if binary output is already enabled, or if
+         * the chains have already been initialized
+         */
+        void EnableBinaryOutput();
+
+        /*
+         * Makes the chains compress their binary output files with zlib, in
+         * one independent block per flush, through an 
+         * Mcmc::CompressedChainWriter.  Must be called before Initialize() or
+         * ResumeFromCheckpoint(), and after EnableBinaryOutput().
+         * 
+         * throws std::logic_error if compressed output is already enabled,
+         * if binary output is not enabled, or if the chains have already been
+         * initialized
+         */
+        void EnableCompressedOutput();
+
+        /*
+         * Makes the chains write each run of repeated points, i.e. a point 
+         * and its rejected trial steps, once, with its multiplicity, in 
+         * either format.  At typical acceptance rates this makes the chain
+         * files several times smaller.  Must be called before Initialize() 
+         * or ResumeFromCheckpoint().
+         * 
+         * throws std::logic_error if run-length encoding is already enabled,
+         * or if the chains have already been initialized
+         */
+        void EnableRunLengthEncoding();
+
+        /*
+         * Makes the chains write nothing before the end of the burn-in if 
+         * discard_burn_in, and only every thinning-th point of each chain.
+         * Without discard_burn_in, the thinning starts with the seeds.  A 
+         * thinned run of repeated points is written with the number of its
+         * copies that were kept.  Must be called before Initialize() or 
+         * ResumeFromCheckpoint().
+         * 
+         * throws std::invalid_argument if thinning is zero
+         * 
+         * throws std::logic_error if the output policy is already set, or if
+         * the chains have already been initialized
+         */
+        void SetOutputPolicy(bool discard_burn_in, unsigned int thinning);
+
+        /*
+         * Makes the chains write nothing before the end of the burn-in, and 
+         * then only every k-th point, with k the largest autocorrelation time
+         * of any parameter over the second half of the burn-in, where lambda
+         * is already 1, averaged over the chains and rounded up.  If the 
+         * second half of the burn-in is too short to estimate it, k is 1.  
+         * Must be called before Initialize() or ResumeFromCheckpoint().
+         * 
+         * throws std::logic_error if the output policy is already set, or if
+         * the chains have already been initialized
+         */
+        void EnableAutomaticThinning();
+
+        /*
+         * Makes the chains write their output files on a background 
+         * Mcmc::OutputThread, shared by all chains, through an 
+         * Mcmc::AsyncChainWriter for each chain.  A flush in the step loop 
+         * then only hands the buffered points over, and only waits if the 
+         * chain's previous flush has not been written yet.  Must be called 
+         * before Initialize() or ResumeFromCheckpoint().
+         * 
+         * throws std::logic_error if background output is already enabled,
+         * or if the chains have already been initialized
+         */
+        void EnableBackgroundOutput();
+
+        /*
+         * Makes Run() compute the R-hat of each parameter every interval 
+         * steps, after the burn-in, and append them to the given log file.
+         * (In sweep mode, at the end of the first sweep after that.)  Each
+         * line of the log holds the step count and then the R-hats, so that
+         * max_steps can be tuned from how quickly the scans converge.  The 
+         * Gelman-Rubin R-hats come from an Mcmc::ConvergenceMonitor, which 
+         * keeps running means and variances of the parameters of each chain
+         * over the points after the burn-in.  Must be called before Run().
+         * 
+         * throws std::invalid_argument if log_filename is empty or interval
+         * is zero
+         * 
+         * throws std::logic_error if the convergence monitor is already 
+         * enabled
+         * 
+         * throws std::runtime_error if the log file cannot be opened
+         */
+        void EnableConvergenceMonitor(std::string log_filename,
+                unsigned int interval);
+
+        /*
+         * Makes Run() stop as soon as every R-hat is below r_hat_threshold, 
+         * e.g. 1.01.  Must be called after EnableConvergenceMonitor().
+         * 
+         * throws std::invalid_argument if r_hat_threshold is not above 1
+         * 
+         * throws std::logic_error if early stop is already enabled, or if the
+         * convergence monitor is not enabled
+         */
+        void EnableEarlyStop(double r_hat_threshold);
+
+        /*
+         * Makes the chains add every point after the burn-in to the given
+         * accumulator, which keeps the mean and covariance of the parameters
+         * and measurements, and any histograms set up in it, and Run() write
+         * its summary to summary_filename at the end, so that quick-look 
+         * plots need not read the chains back.  If the summary cannot be 
+         * written, Run() only prints a message.  Must be called before Run().
+         * 
+         * throws std::invalid_argument if accumulator is null or has a 
+         * different dimension, or if summary_filename is empty
+         * 
+         * throws std::logic_error if an accumulator is already in use
+         */
+        void UsePosteriorAccumulator(
+                std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator,
+                std::string summary_filename);
+
+        /*
+         * Makes Run() work as one of the workers of the Mcmc::ScanCoordinator
+         * listening on socket_path, and synchronize with it every 
+         * sync_interval steps.  Run() throws Mcmc::CoordinatorError if the
+         * coordinator cannot be reached within a few seconds, or the 
+         * connection breaks.  Must be called before Run().
+         * 
+         * Each worker has chains of its own, and draws its trial points from
+         * the mean and covariance of the last points of the chains of all 
+         * workers, which it gets from the coordinator first.  Between 
+         * synchronizations, the worker updates them with its own moves as in
+         * a single scan, while the other workers' last points stay where 
+         * they were at the last synchronization.  At each synchronization, 
+         * it sends its last points to the coordinator, and gets the mean and
+         * covariance with every worker's moves back.  Each worker writes its
+         * own chain files, so their filenames must differ between workers.
+         * 
+         * throws std::invalid_argument if socket_path is empty or 
+         * sync_interval is zero
+         * 
+         * throws std::logic_error if distributed mode is already enabled, or
+         * if differential evolution, stretch moves or parallel tempering are
+         * enabled
+         */
+        void EnableDistributedMode(std::string socket_path,
+                unsigned int sync_interval);
+
+        /*
+         * Autocorrelation times and effective sample sizes of the points
+         * after the burn-in, e.g. to decide after Run() whether the scan
+         * needs more steps.
+         */
+        Mcmc::AutocorrelationMonitor const& autocorrelation_monitor() const;
+
+        unsigned int dimension() const;
+        unsigned int num_chains() const;
+        /*
+         * Parameters of the last point of chain i_chain, for proposal 
+         * policies.  Only valid until the chain moves on.
+         * 
+         * throws std::out_of_range if there is no such chain
+         */
+        gsl_vector const* last_parameters(unsigned int i_chain) const;
+        /*
+         * Mean and covariance matrix of the chains' last points, and the
+         * Cholesky decomposition of the covariance matrix in its lower 
+         * triangle, for proposal policies.  They are those of the scan's own
+         * Mcmc::AdaptiveGaussianProposal, which the default mode, sweep mode,
+         * delayed acceptance and parallel tempering keep up to date.  
+         * Run(proposal) only recomputes them from the chains at each 
+         * checkpoint and at the end, or takes them over from the 
+         * coordinator at each synchronization in distributed mode, so a 
+         * policy must not rely on them between those.  With differential 
+         * evolution and stretch moves, they stay those of the seeds.  Only
+         * valid once the chains are initialized, and until they move on.
+         */
+        gsl_vector const* last_points_mean() const;
+        gsl_matrix const* last_points_covariance() const;
+        gsl_matrix const* last_points_covariance_cholesky() const;
+
     protected:
         gsl_rng* rng_;
 
     private:
+        friend class ::McmcScanTest;
+        // The adaptive Gaussian proposal redraws its trial points until 
+        // IsValidParameters() accepts them
+        friend class Mcmc::AdaptiveGaussianProposal;
+
         McmcScan(McmcScan const& orig);
         void operator=(McmcScan const& orig);
 
+        /*
+         * Flushes the chains and writes a checkpoint to checkpoint_filename_.
+         * During Run(proposal), the scan's own statistics are recomputed 
+         * from the chains first.
+         * 
+         * throws Mcmc::CheckpointError if the checkpoint cannot be written
+         * 
+         * throws Mcmc::ChainFlushError if output files cannot be opened
+         */
+        void WriteCheckpoint();
+
+        /*
+         * Computes the R-hats and appends them to the convergence log, if 
+         * every chain has enough points after the burn-in yet.  Returns true
+         * if early stop is enabled and every R-hat is below the threshold.
+         */
+        bool CheckConvergence();
+
+        /*
+         * Prints the autocorrelation time of each parameter in each chain,
+         * and the effective sample sizes summed over the chains, if every
+         * chain has enough points after the burn-in yet.
+         */
+        void PrintAutocorrelation() const;
+
+        /*
+         * Creates the writer for the output file of chain i_chain, in text, 
+         * binary or compressed binary, with or without run-length encoding,
+         * and in the background or not, as selected.  point is the chain's
+         * first point, which fixes the number of measurements of a binary
+         * file.
+         * 
+         * throws Mcmc::ChainFlushError if output file cannot be opened
+         */
+        std::unique_ptr<Mcmc::ChainWriter> NewChainWriter(std::string filename,
+                unsigned int i_chain,
+                Mcmc::Point const& point) const;
+
         /*
          * Initializes the chains with the seed parameters and filenames.
          * The resulting chains are stored in member variable chains_.
@@ -114,58 +653,200 @@ namespace Mcmc {
                 std::pair<gsl_vector*, std::string> > chains_info);
 
         /*
-         * Initializes the vector mean of the parameters of each chain's last 
-         * point, the covariance matrix, inverse covariance matrix, and
-         * determinant of the covariance matrix.  Results are stored in the
-         * class's member variables.
+         * Sends the last parameters of every chain to the coordinator in a 
+         * message of the given type, and unless it is kDone, takes over the
+         * mean and covariance of the whole scan from the reply.  Closes the
+         * connection after kDone.
          * 
-         * throws Mcmc::PositiveDefiniteError if covariance matrix is not
+         * throws Mcmc::CoordinatorError if the connection breaks or the reply
+         * does not fit
+         * 
+         * throws Mcmc::PositiveDefiniteError if the covariance matrix is not
          * positive definite
          */
-        void InitializeLastPointsMeanAndCovariance();
+        void SyncWithCoordinator(std::uint32_t type);
 
         /*
-         * Constructs a trial point from the last point in the chain to update.
+         * StepMode() names the step mode that is enabled, e.g. "sweep mode",
+         * or is empty in the default mode.  CheckStepMode() throws 
+         * std::logic_error if mode would be combined with another step 
+         * mode, or with distributed mode unless distributed_ok, which are
+         * the compatibility rules in the class comment.
          */
-        std::shared_ptr<Mcmc::Point> TrialPoint(std::shared_ptr<Mcmc::Point>
-                last_point);
+        std::string StepMode() const;
+        void CheckStepMode(std::string mode, bool distributed_ok) const;
 
         /*
-         * Calculates the mean and covariance if the trial point were to be
-         * accepted.  Stores them in output arguments, which are also newly
-         * allocated within the method.
+         * The parts of Run() before, between and after the steps.  
+         * StartRun() returns the time at which the steps start, and 
+         * FinishStep() does the synchronizations, convergence checks and 
+         * checkpoints that are due, in that order, and returns true to stop
+         * early.
          * 
-         * Done by updating the last_* quantities with the new trial point,
-         * without having to recalculate them from scratch.  Follows the 
-         * procedure in Baltz, et al. (arXiv:hep-ph/0602187)
+         * StartRun() throws std::logic_error if called before chains are 
+         * initialized
+         */
+        std::chrono::steady_clock::time_point StartRun();
+        bool FinishStep();
+        void FinishRun(std::chrono::steady_clock::time_point start);
+
+        /*
+         * Updates one randomly chosen chain, with a trial point drawn from 
+         * the given proposal policy.  A trial point that is not valid counts
+         * as a rejected step.  Used by Run() in the default mode.
+         */
+        template <typename Proposal>
+        void Step(Proposal& proposal);
+
+        /*
+         * Draws a random number and decides whether to accept a trial point,
+         * given the log Hastings ratio of the proposal.  A point following a
+         * zero-likelihood point is always accepted.
+         */
+        bool MetropolisHastingsTest(double last_likelihood,
+                double trial_likelihood,
+                double log_hastings_ratio);
+
+        /*
+         * Updates one randomly chosen chain in every rung of the ladder, 
+         * measuring the trial points concurrently, after proposing swaps 
+         * between the rungs every swap_interval_ steps.  Used by Run() with
+         * parallel tempering.
+         */
+        void TemperedStep();
+
+        /*
+         * Sets up the rungs of the ladder other than lambda = 1, with copies
+         * of the chains' last points, and an adaptive Gaussian proposal of 
+         * their own.  Used by Run() with parallel tempering.
          * 
-         * Inputs: last_point, trial_point
-         * Outputs: trial_mean, trial_covariance, trial_covariance_det,
-         *            trial_covariance_inv
+         * throws Mcmc::PositiveDefiniteError if covariance matrix is not
+         * positive definite
+         */
+        void InitializeReplicas();
+
+        /*
+         * Last point of chain i_chain in rung i_rung, and replacing it, which
+         * updates the statistics of the rung's proposal.  Replacing a point
+         * of rung 0 does not append it to the chain; the chain's next step 
+         * does.
+         * 
+         * throws Mcmc::PositiveDefiniteError if covariance matrix is not
+         * positive definite
+         */
+        std::shared_ptr<Mcmc::Point> ReplicaPoint(unsigned int i_rung,
+                unsigned int i_chain) const;
+        void ReplaceReplicaPoint(unsigned int i_rung,
+                unsigned int i_chain,
+                std::shared_ptr<Mcmc::Point> point);
+
+        /*
+         * Proposes a swap between one chain of each pair of neighbouring 
+         * rungs and the same chain of the other rung.  Between rungs 0 and 1
+         * that is the chain rung 0 is about to update, otherwise a randomly
+         * chosen one.
+         */
+        void ProposeSwaps();
+
+        /*
+         * Updates one randomly chosen chain, with the two-stage decision and
+         * a trial point drawn from the given proposal policy.  A trial point
+         * that is not valid counts as a rejected step.  Used by Run() in 
+         * delayed-acceptance mode.
+         */
+        template <typename Proposal>
+        void DelayedAcceptanceStep(Proposal& proposal);
+
+        /*
+         * Updates every chain once, measuring the trial points concurrently.
+         * Used by Run() in sweep mode.  The last sweep is cut short if it would
+         * take the scan past max_steps_.
+         */
+        void Sweep();
+
+        /*
+         * Updates every chain once with a stretch move, one half of the 
+         * chains after the other, measuring the trial points of each half
+         * concurrently, with trial points drawn from the given policy.  Used
+         * by Run() with stretch moves.  The last sweep is cut short if it 
+         * would take the scan past max_steps_.
+         */
+        void StretchSweep(Mcmc::StretchMoveProposal& proposal);
+
+        /*
+         * Measures the first num_points rows of the workspace's 
+         * sweep_trial_parameters on the thread pool, in one contiguous batch
+         * per thread, and returns the number of batches.  Batch i_batch has
+         * rows i_batch num_points / num_batches up to (i_batch + 1) 
+         * num_points / num_batches, and its results are in the workspace's 
+         * batch_measurements and batch_likelihoods, to be freed with 
+         * FreeSweepBatches().
+         */
+        unsigned int MeasureSweepBatches(unsigned int num_points);
+        void FreeSweepBatches(unsigned int num_batches);
+
+        /*
+         * Takes one step of a sweep for the given chain: decides whether to
+         * accept the measured trial point, and appends the resulting point 
+         * to the chain.  The Hastings ratio is that of the last points' 
+         * statistics in sweep_snapshot_, which the trial point was drawn 
+         * from, and the ones in gaussian_proposal_ are updated if it is 
+         * accepted.  snapshot_current tells whether the two are still the 
+         * same, i.e. no trial point of the sweep has been accepted yet, so 
+         * that gaussian_proposal_ will do for both.  A new Point is only 
+         * constructed if the trial point is accepted.  Returns whether it 
+         * was.
          * 
          * throws Mcmc::PositiveDefiniteError if trial covariance matrix is not
          * positive definite
          */
-        void TrialMeanAndCovariance(std::shared_ptr<Mcmc::Point> last_point,
-                std::shared_ptr<Mcmc::Point> trial_point,
-                gsl_vector*& trial_mean,
-                gsl_matrix*& trial_covariance,
-                double& trial_covariance_det,
-                gsl_matrix*& trial_covariance_inv);
+        bool UpdateChain(unsigned int chain_to_update,
+                gsl_vector const* trial_parameters,
+                gsl_vector const* trial_measurements,
+                double trial_likelihood,
+                bool snapshot_current);
+
+        /*
+         * Makes a Point in point_pool_, which is set up for the sizes of 
+         * the first one, or on its own if it does not fit the pool.
+         * 
+         * throws std::invalid_argument for the same inputs as the Point
+         * constructor
+         */
+        std::shared_ptr<Mcmc::Point> NewPoint(gsl_vector const* parameters,
+                gsl_vector const* measurements,
+                double likelihood);
+
+        /*
+         * Counts one step, and prints the progress every so often.
+         */
+        void CountStep();
+
+        /*
+         * Appends a point to the given chain.  Mcmc::ChainFlushError only 
+         * results in a message.
+         */
+        void AppendToChain(unsigned int chain_to_update,
+                std::shared_ptr<Mcmc::Point> const& point);
 
         /*
          * Calculates lambda, the annealing exponent.  It takes values other
-         * than 1 for the first half of the burn-in period.
+         * than 1 for the first half of the burn-in period.  With parallel 
+         * tempering, it is the lambda of the current rung instead.
          */
         double Lambda();
 
         /*
-         * Calculates the acceptance ratio for the trial point.
+         * Applies the output policy for after the burn-in to every chain,
+         * choosing the thinning first if it is automatic.
+         */
+        void StartOutput();
+
+        /*
+         * Calculates (trial_likelihood/last_likelihood)^lambda.
          */
-        double AcceptanceRatio(std::shared_ptr<Mcmc::Point> last_point,
-                std::shared_ptr<Mcmc::Point> trial_point,
-                double trial_covariance_det,
-                gsl_matrix const* trial_covariance_inv);
+        double LikelihoodRatio(double last_likelihood,
+                double trial_likelihood);
 
         /*
          * Determines if the parameters are valid in the parameter space.
@@ -186,6 +867,49 @@ namespace Mcmc {
                 gsl_vector*& measurements,
                 double& likelihood) = 0;
 
+        /*
+         * Calculates the measurements and likelihoods for a batch of points.
+         * Each row of parameters holds one point's parameters, and the same
+         * row of measurements and element of likelihoods hold its results.
+         * Stores them in output arguments.  GSL matrix measurements and GSL
+         * vector likelihoods get newly allocated within the method.
+         * 
+         * The default implementation calls MeasurePoint() on each row.
+         * 
+         * Input: parameters
+         * Outputs: measurements, likelihoods
+         */
+        virtual void MeasureBatch(gsl_matrix const* parameters,
+                gsl_matrix*& measurements,
+                gsl_vector*& likelihoods);
+
+        /*
+         * Calculates a cheap approximation to the likelihood of a given set 
+         * of parameters, for the first stage of delayed-acceptance mode.  It 
+         * must be positive wherever the likelihood is.
+         * 
+         * The default implementation returns 1, so that the first stage only 
+         * screens on the proposal densities.
+         */
+        virtual double SurrogateLikelihood(gsl_vector const* parameters);
+
+        /*
+         * Same as MeasurePoint(), but goes through the measurement cache if
+         * there is one.
+         */
+        void MeasurePointCached(gsl_vector const* parameters,
+                gsl_vector*& measurements,
+                double& likelihood);
+
+        /*
+         * Same as MeasureBatch(), but goes through the measurement cache if 
+         * there is one.  Only the rows that miss are passed on to 
+         * MeasureBatch(), as one smaller batch.
+         */
+        void MeasureBatchCached(gsl_matrix const* parameters,
+                gsl_matrix*& measurements,
+                gsl_vector*& likelihoods);
+
 
         std::vector<Mcmc::MarkovChain*> chains_;
 
@@ -195,12 +919,287 @@ namespace Mcmc {
         double const burn_fraction_;
 
         unsigned int num_steps_;
-        gsl_vector* last_points_mean_;
-        gsl_matrix* last_points_covariance_;
-        double last_points_covariance_det_;
-        gsl_matrix* last_points_covariance_inv_;
+        // Allocated in Initialize()
+        Mcmc::ScanWorkspace* workspace_;
+        // The proposal of the built-in modes, whose statistics are also the
+        // last points' mean and covariance of the other modes.  Allocated in
+        // Initialize()
+        Mcmc::AdaptiveGaussianProposal* gaussian_proposal_;
+        // Whether Run(proposal) is running, whose steps leave 
+        // gaussian_proposal_ behind the chains
+        bool running_policy_;
+
+        // Only allocated in sweep mode
+        Mcmc::ThreadPool* thread_pool_;
+        // The last points' statistics that a sweep's trial points were drawn
+        // from, only allocated in sweep mode
+        Mcmc::AdaptiveGaussianProposal* sweep_snapshot_;
+
+        bool delayed_acceptance_;
+        // Surrogate likelihood of each chain's last point, only used in
+        // delayed-acceptance mode
+        std::vector<double> last_surrogate_likelihoods_;
+        unsigned int num_surrogate_rejections_;
+
+        // With differential evolution, the last points' mean and covariance 
+        // are left as they were at the start
+        bool differential_evolution_;
+        // Stretch moves use thread_pool_ as well
+        bool stretch_move_;
+
+        // One rung of the parallel tempering ladder.  Rung 0, lambda = 1, is 
+        // the scan's own chains and gaussian_proposal_, and keeps its 
+        // chains' current states in last_points, which only differ from the
+        // chains' last points between a swap and the step that records it.
+        // The swap counts are those with the next colder rung.
+        struct Replica {
+            double lambda;
+            Mcmc::AdaptiveGaussianProposal* proposal;
+            std::vector<std::shared_ptr<Mcmc::Point> > last_points;
+            unsigned int chain_to_update;
+            gsl_vector* trial_parameters;
+            gsl_vector* trial_measurements;
+            double trial_likelihood;
+            unsigned long num_swaps_proposed;
+            unsigned long num_swaps_accepted;
+        };
+
+        // Parallel tempering is off while tempering_ladder_ is empty.  The 
+        // replicas are set up at the start of Run(), and measured on 
+        // thread_pool_.
+        std::vector<double> tempering_ladder_;
+        unsigned int swap_interval_;
+        std::vector<Replica> replicas_;
+        double replica_lambda_;
+
+        // Only set if UseMeasurementCache() is called
+        std::shared_ptr<Mcmc::MeasurementCache> measurement_cache_;
+
+        // Checkpoints are off while checkpoint_interval_ is zero
+        std::string checkpoint_filename_;
+        unsigned int checkpoint_interval_;
+        unsigned int last_checkpoint_step_;
+
+        bool binary_output_;
+        bool compressed_output_;
+        bool run_length_encoding_;
+        // The chains write every point until SetOutputPolicy() or 
+        // EnableAutomaticThinning() is called.  output_thinning_ is zero 
+        // until automatic thinning has been chosen, and output_started_
+        // tells whether the policy for after the burn-in has been applied.
+        bool output_policy_set_;
+        bool discard_burn_in_;
+        unsigned int output_thinning_;
+        bool output_started_;
+        // Only set if EnableAutomaticThinning() is called
+        std::unique_ptr<Mcmc::AutocorrelationMonitor> burn_in_monitor_;
+        // Only set if EnableBackgroundOutput() is called
+        std::shared_ptr<Mcmc::OutputThread> output_thread_;
+
+        // Only set if EnableConvergenceMonitor() is called.  Early stop is
+        // off while early_stop_threshold_ is zero.
+        std::unique_ptr<Mcmc::ConvergenceMonitor> convergence_monitor_;
+        std::FILE* convergence_log_;
+        unsigned int convergence_interval_;
+        unsigned int last_convergence_step_;
+        double early_stop_threshold_;
+        double last_max_r_hat_;
+
+        // Only set if UsePosteriorAccumulator() is called.  The chains only
+        // feed it while accumulating_, i.e. after the burn-in.
+        std::shared_ptr<Mcmc::PosteriorAccumulator> posterior_accumulator_;
+        std::string summary_filename_;
+        bool accumulating_;
+
+        // Distributed mode is off while coordinator_path_ is empty.  
+        // ensemble_size_ is the number of chains that the last points' mean
+        // and covariance are over, which is num_chains_ unless distributed.
+        std::string coordinator_path_;
+        int coordinator_socket_;
+        unsigned int sync_interval_;
+        unsigned int last_sync_step_;
+        unsigned int ensemble_size_;
+        unsigned int first_ensemble_chain_;
+        unsigned int num_syncs_;
+        std::chrono::duration<double> sync_wait_time_;
+        // Reused by SyncWithCoordinator()
+        std::vector<double> sync_values_;
+
+        // Set up by the first NewPoint()
+        std::unique_ptr<Mcmc::PointPool> point_pool_;
+
+        std::unique_ptr<Mcmc::AutocorrelationMonitor> autocorrelation_monitor_;
+        // Reused by the progress output
+        std::vector<double> effective_sample_sizes_;
+
+        std::chrono::duration<double> measuring_time_;
+        // Time the sampling thread spent flushing chains, or waiting for the
+        // background output to catch up
+        std::chrono::duration<double> output_wait_time_;
     };
 
+    template <typename Proposal>
+    void McmcScan::Run(Proposal& proposal) {
+        if (!delayed_acceptance_) {
+            CheckStepMode("a proposal policy", true);
+        }
+
+        running_policy_ = true;
+        std::chrono::steady_clock::time_point start = StartRun();
+
+        while (num_steps_ < max_steps_) {
+            if (delayed_acceptance_) {
+                DelayedAcceptanceStep(proposal);
+            } else {
+                Step(proposal);
+            }
+
+            if (FinishStep()) {
+                break;
+            }
+        }
+
+        FinishRun(start);
+    }
+
+    template <typename Proposal>
+    void McmcScan::Step(Proposal& proposal) {
+        // Randomly choose a chain to update
+        unsigned int chain_to_update = gsl_rng_uniform_int(rng_, num_chains_);
+        std::shared_ptr<Mcmc::Point> next_point =
+                chains_[chain_to_update]->last_point();
+        gsl_vector const* last_parameters = next_point->parameters();
+
+        // An invalid trial point is rejected rather than redrawn, since
+        // redrawing would cut the proposal off at the boundary, and bias the
+        // chains there unless the policy's Hastings ratio accounts for it
+        gsl_vector* trial_parameters = workspace_->trial_parameters;
+        proposal.Propose(chain_to_update, last_parameters, rng_,
+                trial_parameters);
+        if (!IsValidParameters(trial_parameters)) {
+            CountStep();
+            AppendToChain(chain_to_update, next_point);
+            return;
+        }
+
+        // The trial measurements are freed whether or not a step throws,
+        // since the point keeps its own copy of them
+        gsl_vector* trial_measurements = nullptr;
+        try {
+            double trial_likelihood = 0.0;
+            std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now();
+            MeasurePointCached(trial_parameters, trial_measurements,
+                    trial_likelihood);
+            measuring_time_ += std::chrono::steady_clock::now() - start;
+
+            CountStep();
+
+            // Accept or reject the trial point
+            double log_hastings_ratio = proposal.LogHastingsRatio(
+                    chain_to_update, last_parameters, trial_parameters);
+            if (MetropolisHastingsTest(next_point->likelihood(),
+                    trial_likelihood, log_hastings_ratio)) {
+                proposal.UpdateState(chain_to_update, last_parameters,
+                        trial_parameters);
+                next_point = NewPoint(trial_parameters, trial_measurements,
+                        trial_likelihood);
+            }
+        } catch (...) {
+            gsl_vector_free(trial_measurements);
+            throw;
+        }
+        gsl_vector_free(trial_measurements);
+
+        AppendToChain(chain_to_update, next_point);
+    }
+
+    template <typename Proposal>
+    void McmcScan::DelayedAcceptanceStep(Proposal& proposal) {
+        // Randomly choose a chain to update
+        unsigned int chain_to_update = gsl_rng_uniform_int(rng_, num_chains_);
+        std::shared_ptr<Mcmc::Point> next_point =
+                chains_[chain_to_update]->last_point();
+        gsl_vector const* last_parameters = next_point->parameters();
+        double last_likelihood = next_point->likelihood();
+        double last_surrogate_likelihood =
+                last_surrogate_likelihoods_[chain_to_update];
+
+        gsl_vector* trial_parameters = workspace_->trial_parameters;
+        proposal.Propose(chain_to_update, last_parameters, rng_,
+                trial_parameters);
+
+        CountStep();
+
+        // As in Step(), an invalid trial point is rejected rather than 
+        // redrawn
+        if (!IsValidParameters(trial_parameters)) {
+            AppendToChain(chain_to_update, next_point);
+            return;
+        }
+
+        double proposal_ratio = std::exp(proposal.LogHastingsRatio(
+                chain_to_update, last_parameters, trial_parameters));
+
+        // First stage: the usual Metropolis-Hastings decision, but with the
+        // surrogate likelihood.  A trial point with zero surrogate likelihood
+        // is always rejected here.
+        double trial_surrogate_likelihood = SurrogateLikelihood(
+                trial_parameters);
+        double first_stage_ratio = 1.0;
+        if (last_surrogate_likelihood != 0.0) {
+            first_stage_ratio = proposal_ratio * LikelihoodRatio(
+                    last_surrogate_likelihood, trial_surrogate_likelihood);
+        }
+        if (gsl_rng_uniform(rng_) >= first_stage_ratio) {
+            ++num_surrogate_rejections_;
+            AppendToChain(chain_to_update, next_point);
+            return;
+        }
+
+        // Only now measure the trial point.  The trial measurements are 
+        // freed whether or not the second stage throws, since the point 
+        // keeps its own copy of them.
+        gsl_vector* trial_measurements = nullptr;
+        try {
+            double trial_likelihood = 0.0;
+            std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now();
+            MeasurePointCached(trial_parameters, trial_measurements,
+                    trial_likelihood);
+            measuring_time_ += std::chrono::steady_clock::now() - start;
+
+            // Second stage: correct for the difference between the surrogate
+            // and the true likelihood.  The proposal ratio cancels out, 
+            // except when the first stage could not use it.
+            double second_stage_ratio;
+            if (last_likelihood == 0.0) {
+                second_stage_ratio = 1.0;
+            } else if (last_surrogate_likelihood == 0.0) {
+                second_stage_ratio = proposal_ratio * LikelihoodRatio(
+                        last_likelihood, trial_likelihood);
+            } else {
+                second_stage_ratio = LikelihoodRatio(last_likelihood,
+                        trial_likelihood) / LikelihoodRatio(
+                        last_surrogate_likelihood, trial_surrogate_likelihood);
+            }
+            if (gsl_rng_uniform(rng_) <= second_stage_ratio) {
+                proposal.UpdateState(chain_to_update, last_parameters,
+                        trial_parameters);
+                last_surrogate_likelihoods_[chain_to_update] =
+                        trial_surrogate_likelihood;
+                next_point = NewPoint(trial_parameters, trial_measurements,
+                        trial_likelihood);
+            }
+        } catch (...) {
+            gsl_vector_free(trial_measurements);
+            throw;
+        }
+        gsl_vector_free(trial_measurements);
+
+        AppendToChain(chain_to_update, next_point);
+    }
+
 }
 
 #endif	/* MCMC_MCMCSCAN_H */
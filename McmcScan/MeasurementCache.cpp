@@ -0,0 +1,152 @@
+/*
+ * File:   MeasurementCache.cpp
+ * Author: donerkebab
+ *
+ * Created on April 26, 2014, 4:18 PM
+ */
+
+#include "MeasurementCache.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+namespace { // unnamed namespace
+    // Rough allowance for the list node, the hash map node and bucket, and
+    // the string and vector headers of one entry
+    std::size_t const kEntryOverheadBytes = 128;
+}
+
+namespace Mcmc {
+
+    MeasurementCache::MeasurementCache(std::size_t max_bytes)
+    : max_bytes_(max_bytes),
+    num_bytes_(0),
+    num_hits_(0),
+    num_misses_(0) {
+        if (max_bytes == 0) {
+            throw std::invalid_argument("cannot have zero cache size");
+        }
+    }
+
+    MeasurementCache::~MeasurementCache() {
+    }
+
+    std::size_t MeasurementCache::max_bytes() const {
+        return max_bytes_;
+    }
+
+    std::size_t MeasurementCache::num_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return num_bytes_;
+    }
+
+    unsigned int MeasurementCache::num_entries() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    unsigned long MeasurementCache::num_hits() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return num_hits_;
+    }
+
+    unsigned long MeasurementCache::num_misses() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return num_misses_;
+    }
+
+    bool MeasurementCache::Lookup(gsl_vector const* parameters,
+            gsl_vector*& measurements,
+            double& likelihood) {
+        std::string key = Key(parameters);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::unordered_map<std::string, std::list<Entry>::iterator>::iterator
+                i_index = index_.find(key);
+        if (i_index == index_.end()) {
+            ++num_misses_;
+            return false;
+        }
+        ++num_hits_;
+
+        // Move the entry to the front of the list, as the most recently used
+        entries_.splice(entries_.begin(), entries_, i_index->second);
+
+        Entry const& entry = *i_index->second;
+        measurements = gsl_vector_alloc(entry.measurements.size());
+        for (std::size_t i = 0; i < entry.measurements.size(); ++i) {
+            gsl_vector_set(measurements, i, entry.measurements[i]);
+        }
+        likelihood = entry.likelihood;
+        return true;
+    }
+
+    void MeasurementCache::Insert(gsl_vector const* parameters,
+            gsl_vector const* measurements,
+            double likelihood) {
+        Entry entry;
+        entry.key = Key(parameters);
+        entry.measurements.resize(measurements->size);
+        for (std::size_t i = 0; i < measurements->size; ++i) {
+            entry.measurements[i] = gsl_vector_get(measurements, i);
+        }
+        entry.likelihood = likelihood;
+
+        std::size_t entry_bytes = EntryBytes(entry);
+        if (entry_bytes > max_bytes_) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Replace any existing entry for the same parameters
+        std::unordered_map<std::string, std::list<Entry>::iterator>::iterator
+                i_index = index_.find(entry.key);
+        if (i_index != index_.end()) {
+            num_bytes_ -= EntryBytes(*i_index->second);
+            entries_.erase(i_index->second);
+            index_.erase(i_index);
+        }
+
+        while (num_bytes_ + entry_bytes > max_bytes_) {
+            EvictOldest();
+        }
+
+        entries_.push_front(entry);
+        index_[entries_.front().key] = entries_.begin();
+        num_bytes_ += entry_bytes;
+    }
+
+    std::string MeasurementCache::Key(gsl_vector const* parameters) {
+        // Copy element by element, since the vector may have a stride
+        std::string key(parameters->size * sizeof(double), '\0');
+        for (std::size_t i = 0; i < parameters->size; ++i) {
+            double value = gsl_vector_get(parameters, i);
+            std::memcpy(&key[i * sizeof(double)], &value, sizeof(double));
+        }
+        return key;
+    }
+
+    std::size_t MeasurementCache::EntryBytes(Entry const& entry) {
+        // The key is stored twice, once in the entry and once in the index
+        return kEntryOverheadBytes + 2 * entry.key.size() +
+                entry.measurements.size() * sizeof(double);
+    }
+
+    void MeasurementCache::EvictOldest() {
+        Entry const& oldest = entries_.back();
+        num_bytes_ -= EntryBytes(oldest);
+        index_.erase(oldest.key);
+        entries_.pop_back();
+    }
+
+}
@@ -0,0 +1,128 @@
+/*
+ * File:   MeasurementCache.h
+ * Author: donerkebab
+ *
+ * A bounded least-recently-used (LRU) cache of measurement results, keyed on
+ * the exact parameter values of a point.  McmcScan consults it before calling
+ * MeasurePoint() or MeasureBatch(), so that a parameter vector that has been
+ * measured before is not measured again.  This pays off when the same points
+ * come up over and over, e.g. chain seeds on re-seeding or restarted runs,
+ * and each measurement is expensive.
+ *
+ * The key is the bit pattern of the parameters, so only exactly identical
+ * parameter vectors match.  (In particular, 0.0 and -0.0 are different keys.)
+ * Each entry stores the measurements and the likelihood.
+ *
+ * The cache holds at most max_bytes worth of entries.  The size of an entry
+ * is estimated from its key, its measurements, and a fixed allowance for the
+ * bookkeeping structures, so the cap is approximate.  When an insertion would
+ * go over the cap, the least recently used entries are evicted first.  An
+ * entry that is larger than the whole cap is not stored at all.
+ *
+ * The cache counts lookup hits and misses.
+ *
+ * All of the methods are safe to call from several threads at once, so the
+ * cache can be used from MeasureBatch() calls in sweep mode.  A cache may be
+ * shared between several scans, one after the other, by way of shared_ptr.
+ *
+ * Dev notes:
+ * * The entries are held in a std::list in order of use, most recent first,
+ *   with a hash map from key to list position.  Both lookups and insertions
+ *   are O(d + m), for d parameters and m measurements.
+ * * Copy constructor is not supported because there is no need for it.
+ *
+ * Created on April 26, 2014, 4:18 PM
+ */
+
+#ifndef MCMC_MEASUREMENTCACHE_H
+#define	MCMC_MEASUREMENTCACHE_H
+
+#include <cstddef>
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+namespace Mcmc {
+
+    class MeasurementCache {
+    public:
+        // throws std::invalid_argument if max_bytes is zero
+        explicit MeasurementCache(std::size_t max_bytes);
+        virtual ~MeasurementCache();
+
+        std::size_t max_bytes() const;
+        std::size_t num_bytes() const;
+        unsigned int num_entries() const;
+        unsigned long num_hits() const;
+        unsigned long num_misses() const;
+
+        /*
+         * Looks up the measurement results for the given parameters.  On a
+         * hit, stores them in the output arguments and returns true; GSL
+         * vector measurements gets newly allocated within the method.  On a
+         * miss, returns false and leaves the output arguments alone.
+         *
+         * Input: parameters
+         * Outputs: measurements, likelihood
+         */
+        bool Lookup(gsl_vector const* parameters,
+                gsl_vector*& measurements,
+                double& likelihood);
+
+        /*
+         * Stores the measurement results for the given parameters, replacing
+         * any that are already stored, and evicts the least recently used
+         * entries if needed to stay under the memory cap.  The GSL vectors
+         * are copied, and must be freed by the user.
+         */
+        void Insert(gsl_vector const* parameters,
+                gsl_vector const* measurements,
+                double likelihood);
+
+    private:
+        MeasurementCache(MeasurementCache const& orig);
+        void operator=(MeasurementCache const& orig);
+
+        struct Entry {
+            std::string key;
+            std::vector<double> measurements;
+            double likelihood;
+        };
+
+        /*
+         * Packs the bit pattern of the parameters into a string.
+         */
+        static std::string Key(gsl_vector const* parameters);
+
+        /*
+         * Estimates the memory taken up by an entry, including its share of
+         * the list and hash map.
+         */
+        static std::size_t EntryBytes(Entry const& entry);
+
+        /*
+         * Removes the least recently used entry.  mutex_ must be held.
+         */
+        void EvictOldest();
+
+        std::size_t const max_bytes_;
+
+        mutable std::mutex mutex_;
+
+        // All guarded by mutex_
+        std::list<Entry> entries_;
+        std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+        std::size_t num_bytes_;
+        unsigned long num_hits_;
+        unsigned long num_misses_;
+    };
+
+}
+
+#endif	/* MCMC_MEASUREMENTCACHE_H */
+
@@ -0,0 +1,61 @@
+/*
+ * File:   OutputThread.cpp
+ * Author: donerkebab
+ *
+ * Created on April 30, 2014, 9:41 PM
+ */
+
+#include "OutputThread.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Mcmc {
+
+    OutputThread::OutputThread()
+    : shutting_down_(false),
+    thread_(&OutputThread::ThreadLoop, this) {
+    }
+
+    OutputThread::~OutputThread() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shutting_down_ = true;
+        }
+        job_available_.notify_all();
+        thread_.join();
+    }
+
+    void OutputThread::Submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(job);
+        }
+        job_available_.notify_one();
+    }
+
+    void OutputThread::ThreadLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            while (jobs_.empty() && !shutting_down_) {
+                job_available_.wait(lock);
+            }
+            if (jobs_.empty()) {
+                return;
+            }
+
+            std::function<void()> job = jobs_.front();
+            jobs_.pop_front();
+
+            // Run the job without holding the lock, so that more jobs can be
+            // submitted in the meantime
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+}
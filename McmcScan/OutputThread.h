@@ -0,0 +1,68 @@
+/*
+ * File:   OutputThread.h
+ * Author: donerkebab
+ *
+ * A single background thread that runs output jobs one after the other, in
+ * the order in which they were submitted.  McmcScan shares one among all of
+ * its chains' Mcmc::AsyncChainWriter objects, so that formatting and writing
+ * the chain files happens off the sampling thread.
+ *
+ * Jobs must not throw; a job that needs to report an error has to record it
+ * itself.  The destructor runs all of the jobs still queued before it joins
+ * the thread, so no output is lost.
+ *
+ * Dev notes:
+ * * One thread, not a pool, because the chains share the same disk, and
+ *   writing them one at a time keeps the writes sequential.
+ * * Copy constructor is not supported because the object owns its thread.
+ *
+ * Created on April 30, 2014, 9:41 PM
+ */
+
+#ifndef MCMC_OUTPUTTHREAD_H
+#define	MCMC_OUTPUTTHREAD_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Mcmc {
+
+    class OutputThread {
+    public:
+        OutputThread();
+        virtual ~OutputThread();
+
+        /*
+         * Queues the job to be run on the output thread, and returns right 
+         * away.
+         */
+        void Submit(std::function<void()> job);
+
+    private:
+        OutputThread(OutputThread const& orig);
+        void operator=(OutputThread const& orig);
+
+        /*
+         * Main loop of the thread.  Runs jobs until shutting down and out of
+         * jobs.
+         */
+        void ThreadLoop();
+
+        std::mutex mutex_;
+        std::condition_variable job_available_;
+
+        // All guarded by mutex_
+        bool shutting_down_;
+        std::deque<std::function<void()> > jobs_;
+
+        // Started last, once everything it uses has been constructed
+        std::thread thread_;
+    };
+
+}
+
+#endif	/* MCMC_OUTPUTTHREAD_H */
+
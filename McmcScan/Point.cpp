@@ -7,47 +7,85 @@
 
 #include "Point.h"
 
+#include <cstddef>
+
 #include <stdexcept>
 
 #include <gsl/gsl_vector.h>
 
+namespace { // unnamed namespace
+    // Makes vector a view of size doubles at data
+    void ViewStorage(double* data, std::size_t size, gsl_vector& vector) {
+        vector.size = size;
+        vector.stride = 1;
+        vector.data = data;
+        vector.block = nullptr;
+        vector.owner = 0;
+    }
+}
+
 namespace Mcmc {
 
     Point::Point(gsl_vector const* parameters,
             gsl_vector const* measurements,
-            double likelihood) {
-        if (parameters == nullptr) {
-            throw std::invalid_argument("input parameters is null");
-        }
-        if (measurements == nullptr) {
-            throw std::invalid_argument("input measurements is null");
-        }
-        if (likelihood < 0.0) {
-            throw std::invalid_argument("input likelihood is negative");
-        }
+            double likelihood)
+    : owned_storage_(nullptr) {
+        CheckInputs(parameters, measurements, likelihood);
 
-        parameters_ = gsl_vector_alloc(parameters->size);
-        gsl_vector_memcpy(parameters_, parameters);
-        measurements_ = gsl_vector_alloc(measurements->size);
-        gsl_vector_memcpy(measurements_, measurements);
+        owned_storage_ = new double[parameters->size + measurements->size];
+        CopyInputs(parameters, measurements, owned_storage_);
+        likelihood_ = likelihood;
+    }
+
+    Point::Point(gsl_vector const* parameters,
+            gsl_vector const* measurements,
+            double likelihood,
+            double* storage)
+    : owned_storage_(nullptr) {
+        CheckInputs(parameters, measurements, likelihood);
+
+        CopyInputs(parameters, measurements, storage);
         likelihood_ = likelihood;
     }
 
     Point::~Point() {
-        gsl_vector_free(parameters_);
-        gsl_vector_free(measurements_);
+        delete[] owned_storage_;
     }
 
     gsl_vector const* Point::parameters() const {
-        return parameters_;
+        return &parameters_;
     }
 
     gsl_vector const* Point::measurements() const {
-        return measurements_;
+        return &measurements_;
     }
 
     double Point::likelihood() const {
         return likelihood_;
     }
 
-}
\ No newline at end of file
+    void Point::CheckInputs(gsl_vector const* parameters,
+            gsl_vector const* measurements,
+            double likelihood) {
+        if (parameters == nullptr) {
+            throw std::invalid_argument("input parameters is null");
+        }
+        if (measurements == nullptr) {
+            throw std::invalid_argument("input measurements is null");
+        }
+        if (likelihood < 0.0) {
+            throw std::invalid_argument("input likelihood is negative");
+        }
+    }
+
+    void Point::CopyInputs(gsl_vector const* parameters,
+            gsl_vector const* measurements,
+            double* storage) {
+        ViewStorage(storage, parameters->size, parameters_);
+        gsl_vector_memcpy(&parameters_, parameters);
+        ViewStorage(storage + parameters->size, measurements->size,
+                measurements_);
+        gsl_vector_memcpy(&measurements_, measurements);
+    }
+
+}
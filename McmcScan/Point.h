@@ -4,10 +4,10 @@
  * 
  * Represents a point in the parameter space.  Stores the parameters and 
  * measurement values at that point, as well as the likelihood of the point.  
- * Parameters and measurements are stored as pointers to GSL vectors, which the
- * Point owns.  Parameters are meant to be stored here as their real-world 
- * values, and will have to be converted into the right form for the MCMC 
- * algorithm.
+ * Parameters and measurements are handed out as pointers to GSL vectors that
+ * view the Point's own storage.  Parameters are meant to be stored here as
+ * their real-world values, and will have to be converted into the right form
+ * for the MCMC algorithm.
  * 
  * Immutable.  The constructor makes a defensive copy of the GSL vectors, and
  * accessor methods return pointers to const GSL vectors.  
@@ -16,7 +16,14 @@
  * will not be storing their data in multiple places.  As such, there is no copy
  * constructor or assignment operator.
  *  
- * When a Point object is deleted, it also deletes its GSL vectors.
+ * The parameters and measurements are kept one after the other, in one 
+ * contiguous block of doubles that the Point allocates itself, and the GSL 
+ * vectors handed out are views of it.  A Mcmc::PointPool makes Points with 
+ * the block right behind the Point object, in one recycled slot.
+ * 
+ * When a Point object is deleted, it frees the block it allocated itself.  
+ * The block of a Point from a pool goes back to the pool with its slot, so
+ * the vectors handed out are only valid while the Point is alive.
  * 
  * Dev notes:
  * * Even though we do not accept NULL inputs, parameters and measurements are 
@@ -26,6 +33,9 @@
  *   use of gsl_vector_memcpy() for defensive copies in the constructor. 
  *   Instead, const-ness is ensured by keeping all accessor methods const and
  *   having no mutator methods.
+ * * The views are filled in by hand rather than with gsl_vector_view_array(),
+ *   which does not allow vectors of size zero, e.g. a point without 
+ *   measurements.
  *  
  * Created on March 9, 2014, 4:51 AM
  */
@@ -37,6 +47,8 @@
 
 namespace Mcmc {
 
+    class PointPool;
+
     class Point {
     public:
         Point(gsl_vector const* parameters,
@@ -49,12 +61,35 @@ namespace Mcmc {
         double likelihood() const;
 
     private:
+        friend class Mcmc::PointPool;
+
         Point(Point const& orig);
         void operator=(Point const& orig);
 
-        gsl_vector* parameters_;
-        gsl_vector* measurements_;
+        /*
+         * Same as the public constructor, but copies the parameters and 
+         * measurements into the given storage, which must hold both, and
+         * which the Point does not own.
+         */
+        Point(gsl_vector const* parameters,
+                gsl_vector const* measurements,
+                double likelihood,
+                double* storage);
+
+        // Throws std::invalid_argument if the inputs are not as in the 
+        // public constructor
+        static void CheckInputs(gsl_vector const* parameters,
+                gsl_vector const* measurements,
+                double likelihood);
+        void CopyInputs(gsl_vector const* parameters,
+                gsl_vector const* measurements,
+                double* storage);
+
+        gsl_vector parameters_;
+        gsl_vector measurements_;
         double likelihood_;
+        // Null if the storage belongs to a pool
+        double* owned_storage_;
     };
 
 }
@@ -0,0 +1,253 @@
+/*
+ * File:   PointPool.cpp
+ * Author: donerkebab
+ *
+ * Created on May 6, 2014, 9:37 PM
+ */
+
+#include "PointPool.h"
+
+#include <cstddef>
+
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+#include "Point.h"
+
+namespace { // unnamed namespace
+    // Offset of the parameters from the start of a Point's slot
+    std::size_t const kStorageOffset = (sizeof(Mcmc::Point) +
+            alignof(double) - 1) / alignof(double) * alignof(double);
+}
+
+namespace Mcmc {
+
+    struct PointPool::Slots {
+        explicit Slots(std::size_t point_slot_size)
+        : owner(std::this_thread::get_id()),
+        point_slot_size(point_slot_size),
+        num_point_slots(0),
+        count_slot_size(0) {
+        }
+
+        ~Slots() {
+            for (std::vector<void*>* slots : {&free_point_slots,
+                    &returned_point_slots, &free_count_slots,
+                    &returned_count_slots}) {
+                for (void* slot : *slots) {
+                    ::operator delete(slot);
+                }
+            }
+        }
+
+        // Puts a freed slot on the owner's list, or if freed on another 
+        // thread, on the returned list
+        void Free(void* slot, std::vector<void*>& free_slots,
+                std::vector<void*>& returned_slots) {
+            if (std::this_thread::get_id() == owner) {
+                free_slots.push_back(slot);
+            } else {
+                std::lock_guard<std::mutex> lock(mutex);
+                returned_slots.push_back(slot);
+            }
+        }
+
+        // Takes a slot off the owner's list, which is only refilled from 
+        // the returned list when it runs dry, or returns null if both are
+        // empty.  Only on the owner's thread.  The lists are copied rather 
+        // than swapped, so that each keeps its own capacity.
+        void* Take(std::vector<void*>& free_slots,
+                std::vector<void*>& returned_slots) {
+            if (free_slots.empty()) {
+                std::lock_guard<std::mutex> lock(mutex);
+                free_slots.insert(free_slots.end(), returned_slots.begin(),
+                        returned_slots.end());
+                returned_slots.clear();
+            }
+            if (free_slots.empty()) {
+                return nullptr;
+            }
+            void* slot = free_slots.back();
+            free_slots.pop_back();
+            return slot;
+        }
+
+        // Makes room on the owner's lists for every slot there is, so that
+        // freeing a slot on the owner's thread does not allocate.  Called
+        // whenever a slot is made, and doubles the room when it runs out.
+        void Reserve() {
+            if (free_point_slots.capacity() < num_point_slots) {
+                free_point_slots.reserve(2 * num_point_slots);
+            }
+            if (free_count_slots.capacity() < num_point_slots) {
+                free_count_slots.reserve(2 * num_point_slots);
+            }
+        }
+
+        // The thread that makes the Points, which has the free lists to 
+        // itself.  Only the slots freed on other threads go through the 
+        // mutex.
+        std::thread::id const owner;
+        std::mutex mutex;
+        // Point object, parameters and measurements
+        std::size_t const point_slot_size;
+        std::vector<void*> free_point_slots;
+        std::vector<void*> returned_point_slots;
+        unsigned int num_point_slots;
+        // Reference counts all have the same size, which is only known once
+        // shared_ptr asks for the first one.  Until then, it is zero.
+        std::size_t count_slot_size;
+        std::vector<void*> free_count_slots;
+        std::vector<void*> returned_count_slots;
+    };
+
+    class PointPool::SlotReturner {
+    public:
+        explicit SlotReturner(Slots* slots)
+        : slots_(slots) {
+        }
+
+        void operator()(Mcmc::Point* point) const {
+            point->~Point();
+            slots_->Free(point, slots_->free_point_slots,
+                    slots_->returned_point_slots);
+        }
+
+    private:
+        // Kept alive by the CountAllocator next to it in the handle
+        Slots* slots_;
+    };
+
+    template <typename T>
+    class PointPool::CountAllocator {
+    public:
+        typedef T value_type;
+
+        explicit CountAllocator(std::shared_ptr<Slots> slots)
+        : slots_(slots) {
+        }
+
+        template <typename U>
+        CountAllocator(CountAllocator<U> const& other)
+        : slots_(other.slots_) {
+        }
+
+        T* allocate(std::size_t n) {
+            std::size_t size = n * sizeof(T);
+            if (slots_->count_slot_size == 0) {
+                slots_->count_slot_size = size;
+            }
+            void* slot = nullptr;
+            if (size == slots_->count_slot_size) {
+                slot = slots_->Take(slots_->free_count_slots,
+                        slots_->returned_count_slots);
+            }
+            if (slot == nullptr) {
+                slot = ::operator new(size);
+            }
+            return static_cast<T*>(slot);
+        }
+
+        void deallocate(T* p, std::size_t n) {
+            if (n * sizeof(T) != slots_->count_slot_size) {
+                ::operator delete(p);
+                return;
+            }
+            slots_->Free(p, slots_->free_count_slots,
+                    slots_->returned_count_slots);
+        }
+
+        template <typename U>
+        bool operator==(CountAllocator<U> const& other) const {
+            return slots_ == other.slots_;
+        }
+
+        template <typename U>
+        bool operator!=(CountAllocator<U> const& other) const {
+            return slots_ != other.slots_;
+        }
+
+    private:
+        template <typename U>
+        friend class CountAllocator;
+
+        std::shared_ptr<Slots> slots_;
+    };
+
+    PointPool::PointPool(unsigned int num_parameters,
+            unsigned int num_measurements)
+    : num_parameters_(num_parameters),
+    num_measurements_(num_measurements),
+    slots_(new Slots(kStorageOffset +
+    (num_parameters + num_measurements) * sizeof(double))) {
+    }
+
+    PointPool::~PointPool() {
+    }
+
+    unsigned int PointPool::num_parameters() const {
+        return num_parameters_;
+    }
+
+    unsigned int PointPool::num_measurements() const {
+        return num_measurements_;
+    }
+
+    unsigned int PointPool::num_slots() const {
+        return slots_->num_point_slots;
+    }
+
+    unsigned int PointPool::num_free_slots() const {
+        std::lock_guard<std::mutex> lock(slots_->mutex);
+        return slots_->free_point_slots.size() +
+                slots_->returned_point_slots.size();
+    }
+
+    std::shared_ptr<Mcmc::Point> PointPool::NewPoint(
+            gsl_vector const* parameters,
+            gsl_vector const* measurements,
+            double likelihood) {
+        if ((parameters != nullptr && parameters->size != num_parameters_) ||
+                (measurements != nullptr &&
+                measurements->size != num_measurements_)) {
+            throw std::invalid_argument("point does not fit the pool");
+        }
+
+        void* slot = slots_->Take(slots_->free_point_slots,
+                slots_->returned_point_slots);
+        if (slot == nullptr) {
+            slot = ::operator new(slots_->point_slot_size);
+            ++slots_->num_point_slots;
+            try {
+                slots_->Reserve();
+            } catch (...) {
+                ::operator delete(slot);
+                --slots_->num_point_slots;
+                throw;
+            }
+        }
+
+        Mcmc::Point* point;
+        try {
+            point = new (slot) Mcmc::Point(parameters, measurements,
+                    likelihood, reinterpret_cast<double*>(
+                    static_cast<char*>(slot) + kStorageOffset));
+        } catch (...) {
+            slots_->free_point_slots.push_back(slot);
+            throw;
+        }
+
+        // If the reference count cannot be allocated, shared_ptr returns the
+        // slot itself
+        return std::shared_ptr<Mcmc::Point>(point,
+                SlotReturner(slots_.get()), CountAllocator<Mcmc::Point>(
+                slots_));
+    }
+
+}
@@ -0,0 +1,94 @@
+/*
+ * File:   PointPool.h
+ * Author: donerkebab
+ *
+ * Makes Mcmc::Point objects of a fixed number of parameters and measurements
+ * without going to the heap for each of them.  Each Point lives in a slot
+ * that holds the Point object with its parameters and measurements right
+ * behind it, in one contiguous block.  When the last handle on a Point goes
+ * away, its slot goes back to the pool, and the next NewPoint() takes it
+ * from there instead of allocating a new one.  So once the scan has as many
+ * slots as it ever holds Points at once, making a Point allocates nothing,
+ * and neither does letting one go on the pool's thread, since the lists of
+ * free slots grow along with the slots.
+ *
+ * The handles are ordinary shared_ptr objects, so that Points from a pool
+ * can go anywhere other Points go.  Their reference counts are kept in
+ * recycled slots of the pool as well, rather than in a control block of
+ * their own on the heap.
+ *
+ * NewPoint() must only be called on the thread that made the pool, i.e. the
+ * scan's step loop, which keeps the free slots to itself without locking.
+ * Points may be let go of on any thread, e.g. by an Mcmc::OutputThread
+ * once they are written.  The slots of those go on a separate list under a 
+ * mutex, which the pool's thread only takes over when it runs out of slots
+ * of its own, so the step loop locks once per batch of returned slots 
+ * rather than for every Point.  The slots are shared between the pool and 
+ * its Points, so Points may outlive the pool; the slots are only freed once
+ * both are gone.
+ *
+ * Dev notes:
+ * * The slots are never handed back to the heap while the pool is in use,
+ *   so the memory held is that of the most Points ever alive at once.
+ * * Copy constructor is not supported because there is no need for it.
+ *
+ * Created on May 6, 2014, 9:37 PM
+ */
+
+#ifndef MCMC_POINTPOOL_H
+#define	MCMC_POINTPOOL_H
+
+#include <memory>
+
+#include <gsl/gsl_vector.h>
+
+#include "Point.h"
+
+namespace Mcmc {
+
+    class PointPool {
+    public:
+        PointPool(unsigned int num_parameters,
+                unsigned int num_measurements);
+        virtual ~PointPool();
+
+        unsigned int num_parameters() const;
+        unsigned int num_measurements() const;
+        // Number of Point slots made so far, and how many of them are free.
+        // Only on the pool's thread.
+        unsigned int num_slots() const;
+        unsigned int num_free_slots() const;
+
+        /*
+         * Same as constructing a Point and handing it to a shared_ptr, but
+         * in a slot of the pool.
+         *
+         * throws std::invalid_argument if the sizes of parameters and
+         * measurements are not those of the pool, or for the same inputs as
+         * the Point constructor
+         */
+        std::shared_ptr<Mcmc::Point> NewPoint(gsl_vector const* parameters,
+                gsl_vector const* measurements,
+                double likelihood);
+
+    private:
+        PointPool(PointPool const& orig);
+        void operator=(PointPool const& orig);
+
+        // The free slots, shared with the Points' handles
+        struct Slots;
+        // Returns a Point's slot to the pool
+        class SlotReturner;
+        // Allocator of the handles' reference counts
+        template <typename T>
+        class CountAllocator;
+
+        unsigned int const num_parameters_;
+        unsigned int const num_measurements_;
+        std::shared_ptr<Slots> slots_;
+    };
+
+}
+
+#endif	/* MCMC_POINTPOOL_H */
+
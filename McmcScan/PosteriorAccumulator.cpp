@@ -0,0 +1,281 @@
+/*
+ * File:   PosteriorAccumulator.cpp
+ * Author: donerkebab
+ *
+ * Created on May 4, 2014, 1:15 PM
+ */
+
+#include "PosteriorAccumulator.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+#include "Point.h"
+
+namespace { // unnamed namespace
+    // Index of element (i, j), i >= j, of a row-major lower triangle
+    unsigned int TriangleIndex(unsigned int i, unsigned int j) {
+        return i * (i + 1) / 2 + j;
+    }
+
+    void PrintValues(std::FILE* file,
+            std::vector<double>::const_iterator first,
+            std::vector<double>::const_iterator last) {
+        for (; first != last; ++first) {
+            std::fprintf(file, "%- 9.8E  ", *first);
+        }
+        std::fprintf(file, "\n");
+    }
+}
+
+namespace Mcmc {
+
+    PosteriorAccumulator::PosteriorAccumulator(unsigned int dimension,
+            unsigned int num_measurements)
+    : dimension_(dimension),
+    num_measurements_(num_measurements),
+    total_weight_(0.0),
+    means_(dimension + num_measurements, 0.0),
+    comoments_(TriangleIndex(dimension + num_measurements, 0), 0.0),
+    values_(dimension + num_measurements),
+    deltas_(dimension + num_measurements) {
+        if (dimension == 0) {
+            throw std::invalid_argument("cannot have zero dimension");
+        }
+    }
+
+    PosteriorAccumulator::~PosteriorAccumulator() {
+    }
+
+    unsigned int PosteriorAccumulator::dimension() const {
+        return dimension_;
+    }
+
+    unsigned int PosteriorAccumulator::num_measurements() const {
+        return num_measurements_;
+    }
+
+    double PosteriorAccumulator::total_weight() const {
+        return total_weight_;
+    }
+
+    unsigned int PosteriorAccumulator::AddHistogram1D(unsigned int i,
+            double low,
+            double high,
+            unsigned int num_bins) {
+        if (i >= num_variables() || num_bins == 0 || !(high > low)) {
+            throw std::invalid_argument("invalid histogram");
+        }
+        if (total_weight_ > 0.0) {
+            throw std::logic_error("histograms must be added before points");
+        }
+
+        Histogram1D histogram;
+        histogram.i = i;
+        histogram.low = low;
+        histogram.high = high;
+        histogram.num_bins = num_bins;
+        histogram.below = 0.0;
+        histogram.above = 0.0;
+        histogram.bins.assign(num_bins, 0.0);
+        histograms1d_.push_back(histogram);
+        return histograms1d_.size() - 1;
+    }
+
+    unsigned int PosteriorAccumulator::AddHistogram2D(unsigned int i,
+            double low_i,
+            double high_i,
+            unsigned int num_bins_i,
+            unsigned int j,
+            double low_j,
+            double high_j,
+            unsigned int num_bins_j) {
+        if (i >= num_variables() || num_bins_i == 0 || !(high_i > low_i) ||
+                j >= num_variables() || num_bins_j == 0 ||
+                !(high_j > low_j)) {
+            throw std::invalid_argument("invalid histogram");
+        }
+        if (total_weight_ > 0.0) {
+            throw std::logic_error("histograms must be added before points");
+        }
+
+        Histogram2D histogram;
+        histogram.i = i;
+        histogram.low_i = low_i;
+        histogram.high_i = high_i;
+        histogram.num_bins_i = num_bins_i;
+        histogram.j = j;
+        histogram.low_j = low_j;
+        histogram.high_j = high_j;
+        histogram.num_bins_j = num_bins_j;
+        histogram.outside = 0.0;
+        histogram.bins.assign(num_bins_i * num_bins_j, 0.0);
+        histograms2d_.push_back(histogram);
+        return histograms2d_.size() - 1;
+    }
+
+    void PosteriorAccumulator::Add(Mcmc::Point const& point, double weight) {
+        gsl_vector const* parameters = point.parameters();
+        gsl_vector const* measurements = point.measurements();
+        if (parameters->size != dimension_ ||
+                measurements->size != num_measurements_) {
+            throw std::invalid_argument("point does not match the "
+                    "accumulator's dimension and number of measurements");
+        }
+        if (!(weight > 0.0)) {
+            throw std::invalid_argument("weight must be positive");
+        }
+
+        for (unsigned int i = 0; i < dimension_; ++i) {
+            values_[i] = gsl_vector_get(parameters, i);
+        }
+        for (unsigned int i = 0; i < num_measurements_; ++i) {
+            values_[dimension_ + i] = gsl_vector_get(measurements, i);
+        }
+
+        // Weighted Welford update
+        double old_weight = total_weight_;
+        total_weight_ += weight;
+        double factor = weight * old_weight / total_weight_;
+        for (unsigned int i = 0; i < num_variables(); ++i) {
+            deltas_[i] = values_[i] - means_[i];
+            means_[i] += weight / total_weight_ * deltas_[i];
+        }
+        for (unsigned int i = 0; i < num_variables(); ++i) {
+            double* row = &comoments_[TriangleIndex(i, 0)];
+            double scaled_delta = factor * deltas_[i];
+            for (unsigned int j = 0; j <= i; ++j) {
+                row[j] += scaled_delta * deltas_[j];
+            }
+        }
+
+        for (Histogram1D& histogram : histograms1d_) {
+            int bin = Bin(values_[histogram.i], histogram.low, histogram.high,
+                    histogram.num_bins);
+            if (bin < 0) {
+                histogram.below += weight;
+            } else if (bin >= static_cast<int>(histogram.num_bins)) {
+                histogram.above += weight;
+            } else {
+                histogram.bins[bin] += weight;
+            }
+        }
+        for (Histogram2D& histogram : histograms2d_) {
+            int bin_i = Bin(values_[histogram.i], histogram.low_i,
+                    histogram.high_i, histogram.num_bins_i);
+            int bin_j = Bin(values_[histogram.j], histogram.low_j,
+                    histogram.high_j, histogram.num_bins_j);
+            if (bin_i < 0 ||
+                    bin_i >= static_cast<int>(histogram.num_bins_i) ||
+                    bin_j < 0 ||
+                    bin_j >= static_cast<int>(histogram.num_bins_j)) {
+                histogram.outside += weight;
+            } else {
+                histogram.bins[bin_i * histogram.num_bins_j + bin_j] +=
+                        weight;
+            }
+        }
+    }
+
+    double PosteriorAccumulator::mean(unsigned int i) const {
+        return means_.at(i);
+    }
+
+    double PosteriorAccumulator::covariance(unsigned int i, unsigned int j)
+    const {
+        if (i >= num_variables() || j >= num_variables()) {
+            throw std::out_of_range("no such variable");
+        }
+        if (i < j) {
+            return covariance(j, i);
+        }
+        return comoments_[TriangleIndex(i, j)] / (total_weight_ - 1.0);
+    }
+
+    double PosteriorAccumulator::histogram1d_bin(unsigned int i_histogram,
+            unsigned int i_bin) const {
+        return histograms1d_.at(i_histogram).bins.at(i_bin);
+    }
+
+    double PosteriorAccumulator::histogram2d_bin(unsigned int i_histogram,
+            unsigned int i_bin,
+            unsigned int j_bin) const {
+        Histogram2D const& histogram = histograms2d_.at(i_histogram);
+        if (i_bin >= histogram.num_bins_i || j_bin >= histogram.num_bins_j) {
+            throw std::out_of_range("no such bin");
+        }
+        return histogram.bins[i_bin * histogram.num_bins_j + j_bin];
+    }
+
+    void PosteriorAccumulator::WriteSummary(std::string filename) const {
+        std::FILE* file = std::fopen(filename.c_str(), "w");
+        if (file == nullptr) {
+            throw std::runtime_error("could not open " + filename);
+        }
+
+        std::fprintf(file, "total_weight %- 9.8E\n", total_weight_);
+        std::fprintf(file, "mean\n");
+        PrintValues(file, means_.begin(), means_.end());
+        std::fprintf(file, "covariance\n");
+        std::vector<double> row(num_variables());
+        for (unsigned int i = 0; i < num_variables(); ++i) {
+            for (unsigned int j = 0; j < num_variables(); ++j) {
+                row[j] = covariance(i, j);
+            }
+            PrintValues(file, row.begin(), row.end());
+        }
+
+        for (Histogram1D const& histogram : histograms1d_) {
+            std::fprintf(file, "histogram1d %u %- 9.8E %- 9.8E %u\n",
+                    histogram.i, histogram.low, histogram.high,
+                    histogram.num_bins);
+            std::fprintf(file, "%- 9.8E  %- 9.8E\n", histogram.below,
+                    histogram.above);
+            PrintValues(file, histogram.bins.begin(), histogram.bins.end());
+        }
+        for (Histogram2D const& histogram : histograms2d_) {
+            std::fprintf(file, "histogram2d %u %u %- 9.8E %- 9.8E %u "
+                    "%- 9.8E %- 9.8E %u\n", histogram.i, histogram.j,
+                    histogram.low_i, histogram.high_i, histogram.num_bins_i,
+                    histogram.low_j, histogram.high_j, histogram.num_bins_j);
+            std::fprintf(file, "%- 9.8E\n", histogram.outside);
+            for (unsigned int i_bin = 0; i_bin < histogram.num_bins_i;
+                    ++i_bin) {
+                std::vector<double>::const_iterator first =
+                        histogram.bins.begin() + i_bin * histogram.num_bins_j;
+                PrintValues(file, first, first + histogram.num_bins_j);
+            }
+        }
+
+        bool failed = std::ferror(file) != 0;
+        if (std::fclose(file) != 0 || failed) {
+            throw std::runtime_error("could not write " + filename);
+        }
+    }
+
+    int PosteriorAccumulator::Bin(double value,
+            double low,
+            double high,
+            unsigned int num_bins) {
+        if (value < low) {
+            return -1;
+        }
+        if (!(value < high)) {
+            return num_bins;
+        }
+        int bin = std::floor((value - low) / (high - low) * num_bins);
+        // Guard against rounding up at the top edge
+        return bin < static_cast<int>(num_bins) ? bin : num_bins - 1;
+    }
+
+    unsigned int PosteriorAccumulator::num_variables() const {
+        return dimension_ + num_measurements_;
+    }
+
+}
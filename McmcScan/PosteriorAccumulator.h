@@ -0,0 +1,189 @@
+/*
+ * File:   PosteriorAccumulator.h
+ * Author: donerkebab
+ *
+ * Accumulates summaries of the posterior distribution while a scan runs, so
+ * that quick-look numbers and plots need no chain files at all: the mean and
+ * covariance of the parameters and measurements, and any number of 1D and 2D
+ * histograms with fixed binning.
+ *
+ * The variables are numbered with the parameters first and the measurements
+ * after them, i.e. variable i < dimension is parameter i, and variable
+ * dimension + j is measurement j.
+ *
+ * Points are added with a weight, normally their multiplicity, i.e. the
+ * number of steps the chain stayed there.  The covariance is the unbiased
+ * estimate for such frequency weights, i.e. the sum of weighted squared
+ * deviations over (total weight - 1).  Each histogram bin holds the total
+ * weight of the points in it.  The bins are half-open, [low, high), and 1D
+ * histograms count the weight below and above their range separately.
+ *
+ * McmcScan hooks an accumulator into MarkovChain::Append() after the
+ * burn-in, see McmcScan::UsePosteriorAccumulator().  The histograms must be
+ * set up before the first point is added.
+ *
+ * WriteSummary() writes everything to a small text file, made of sections
+ * that each start with a keyword line:
+ *   total_weight W
+ *   mean                      then one line of d + m means
+ *   covariance                then d + m lines of d + m entries
+ *   histogram1d i low high n  then a line with the weight below and above
+ *                             the range, and a line of n bin weights
+ *   histogram2d i j low_i high_i n_i low_j high_j n_j
+ *                             then a line with the weight outside the range,
+ *                             and n_i lines of n_j bin weights
+ *
+ * Dev notes:
+ * * The mean and covariance are accumulated with the weighted version of
+ *   Welford's algorithm (West, Commun. ACM 22, 532 (1979)), which is
+ *   numerically stable.  Each point costs O((d + m)^2), for the lower
+ *   triangle of the co-moment matrix.
+ * * Not thread-safe.  McmcScan only appends to the chains from one thread.
+ * * Copy constructor is not supported because there is no need for it.
+ *
+ * Created on May 4, 2014, 1:15 PM
+ */
+
+#ifndef MCMC_POSTERIORACCUMULATOR_H
+#define	MCMC_POSTERIORACCUMULATOR_H
+
+#include <string>
+#include <vector>
+
+#include "Point.h"
+
+namespace Mcmc {
+
+    class PosteriorAccumulator {
+    public:
+        // throws std::invalid_argument if dimension is zero
+        PosteriorAccumulator(unsigned int dimension,
+                unsigned int num_measurements);
+        virtual ~PosteriorAccumulator();
+
+        unsigned int dimension() const;
+        unsigned int num_measurements() const;
+        double total_weight() const;
+
+        /*
+         * Adds a histogram of variable i, with num_bins bins between low and
+         * high.  Returns its index among the 1D histograms.
+         *
+         * throws std::invalid_argument if i is out of range, num_bins is
+         * zero, or high is not above low
+         *
+         * throws std::logic_error if points have been added already
+         */
+        unsigned int AddHistogram1D(unsigned int i,
+                double low,
+                double high,
+                unsigned int num_bins);
+        /*
+         * Adds a histogram of variables i and j, with num_bins_i by num_bins_j
+         * bins.  Returns its index among the 2D histograms.  Throws as above.
+         */
+        unsigned int AddHistogram2D(unsigned int i,
+                double low_i,
+                double high_i,
+                unsigned int num_bins_i,
+                unsigned int j,
+                double low_j,
+                double high_j,
+                unsigned int num_bins_j);
+
+        /*
+         * Adds a point with the given weight.
+         *
+         * throws std::invalid_argument if the point does not have the right
+         * number of parameters and measurements, or weight is not positive
+         */
+        void Add(Mcmc::Point const& point, double weight);
+
+        /*
+         * Mean of variable i, and covariance of variables i and j.  Only
+         * meaningful once points have been added, and for the covariance,
+         * more than a total weight of 1.
+         *
+         * throws std::out_of_range if i or j is out of range
+         */
+        double mean(unsigned int i) const;
+        double covariance(unsigned int i, unsigned int j) const;
+
+        /*
+         * Weight in bin i_bin of 1D histogram i_histogram, and in bin
+         * (i_bin, j_bin) of 2D histogram i_histogram.
+         *
+         * throws std::out_of_range if any index is out of range
+         */
+        double histogram1d_bin(unsigned int i_histogram,
+                unsigned int i_bin) const;
+        double histogram2d_bin(unsigned int i_histogram,
+                unsigned int i_bin,
+                unsigned int j_bin) const;
+
+        /*
+         * Writes the summary to the given file, replacing it.
+         *
+         * throws std::runtime_error if the file cannot be written
+         */
+        void WriteSummary(std::string filename) const;
+
+    private:
+        PosteriorAccumulator(PosteriorAccumulator const& orig);
+        void operator=(PosteriorAccumulator const& orig);
+
+        struct Histogram1D {
+            unsigned int i;
+            double low;
+            double high;
+            unsigned int num_bins;
+            double below;
+            double above;
+            std::vector<double> bins;
+        };
+
+        struct Histogram2D {
+            unsigned int i;
+            double low_i;
+            double high_i;
+            unsigned int num_bins_i;
+            unsigned int j;
+            double low_j;
+            double high_j;
+            unsigned int num_bins_j;
+            double outside;
+            // Row-major, num_bins_i rows of num_bins_j
+            std::vector<double> bins;
+        };
+
+        /*
+         * Bin of value in num_bins bins between low and high, or -1 below and
+         * num_bins above the range.
+         */
+        static int Bin(double value,
+                double low,
+                double high,
+                unsigned int num_bins);
+
+        unsigned int num_variables() const;
+
+        unsigned int const dimension_;
+        unsigned int const num_measurements_;
+
+        double total_weight_;
+        std::vector<double> means_;
+        // Lower triangle, row-major, of the weighted sum of products of
+        // deviations
+        std::vector<double> comoments_;
+        std::vector<Histogram1D> histograms1d_;
+        std::vector<Histogram2D> histograms2d_;
+
+        // Reused by Add()
+        std::vector<double> values_;
+        std::vector<double> deltas_;
+    };
+
+}
+
+#endif	/* MCMC_POSTERIORACCUMULATOR_H */
+
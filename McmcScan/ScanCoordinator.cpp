@@ -0,0 +1,291 @@
+/*
+ * File:   ScanCoordinator.cpp
+ * Author: donerkebab
+ *
+ * Created on May 6, 2014, 9:40 AM
+ */
+
+#include "ScanCoordinator.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "CoordinatorError.h"
+#include "CoordinatorProtocol.h"
+
+namespace Mcmc {
+
+    ScanCoordinator::ScanCoordinator(std::string socket_path,
+            unsigned int dimension,
+            unsigned int num_workers,
+            unsigned int max_staleness)
+    : socket_path_(socket_path),
+    dimension_(dimension),
+    num_workers_(num_workers),
+    max_staleness_(max_staleness),
+    listening_socket_(-1),
+    started_(false),
+    num_chains_(0),
+    num_syncs_(0),
+    stale_(true) {
+        sockaddr_un address;
+        if (socket_path.empty() ||
+                socket_path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("invalid socket path");
+        }
+        if (dimension == 0 || num_workers == 0) {
+            throw std::invalid_argument("invalid input to ScanCoordinator");
+        }
+
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, socket_path.c_str());
+
+        listening_socket_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listening_socket_ < 0) {
+            throw Mcmc::CoordinatorError("could not create socket");
+        }
+        ::unlink(socket_path.c_str());
+        if (::bind(listening_socket_, reinterpret_cast<sockaddr*>(&address),
+                sizeof(address)) != 0 ||
+                ::listen(listening_socket_, num_workers) != 0) {
+            std::string error = std::strerror(errno);
+            ::close(listening_socket_);
+            throw Mcmc::CoordinatorError("could not listen on " +
+                    socket_path + ": " + error);
+        }
+    }
+
+    ScanCoordinator::~ScanCoordinator() {
+        for (unsigned int i_worker = 0; i_worker < workers_.size();
+                ++i_worker) {
+            if (!workers_[i_worker].done) {
+                ::close(workers_[i_worker].socket);
+            }
+        }
+        ::close(listening_socket_);
+        ::unlink(socket_path_.c_str());
+    }
+
+    std::string ScanCoordinator::socket_path() const {
+        return socket_path_;
+    }
+
+    unsigned int ScanCoordinator::dimension() const {
+        return dimension_;
+    }
+
+    unsigned int ScanCoordinator::num_workers() const {
+        return num_workers_;
+    }
+
+    unsigned int ScanCoordinator::max_staleness() const {
+        return max_staleness_;
+    }
+
+    unsigned int ScanCoordinator::num_chains() const {
+        return num_chains_;
+    }
+
+    unsigned long ScanCoordinator::num_syncs() const {
+        return num_syncs_;
+    }
+
+    void ScanCoordinator::Run() {
+        if (started_) {
+            throw std::logic_error("coordinator has already run");
+        }
+        started_ = true;
+
+        // Every worker says hello with its chains' last points before
+        // anything else happens
+        std::vector<double> values;
+        while (workers_.size() < num_workers_) {
+            int socket = ::accept(listening_socket_, nullptr, nullptr);
+            if (socket < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw Mcmc::CoordinatorError(std::string("could not accept: ")
+                        + std::strerror(errno));
+            }
+            Worker worker;
+            worker.socket = socket;
+            worker.first_chain = num_chains_;
+            worker.num_chains = 0;
+            worker.num_syncs = 0;
+            worker.waiting = true;
+            worker.done = false;
+            workers_.push_back(worker);
+
+            if (CoordinatorProtocol::ReceiveMessage(socket, values) !=
+                    CoordinatorProtocol::kHello || values.empty() ||
+                    values.size() % dimension_ != 0) {
+                throw Mcmc::CoordinatorError("expected a hello from the "
+                        "worker");
+            }
+            workers_.back().num_chains = values.size() / dimension_;
+            num_chains_ += workers_.back().num_chains;
+            last_points_.insert(last_points_.end(), values.begin(),
+                    values.end());
+        }
+        if (num_chains_ <= dimension_) {
+            throw Mcmc::CoordinatorError("need more chains than dimensions");
+        }
+        ReleaseWorkers();
+
+        unsigned int num_done = 0;
+        std::vector<pollfd> poll_fds;
+        std::vector<unsigned int> polled_workers;
+        while (num_done < num_workers_) {
+            poll_fds.clear();
+            polled_workers.clear();
+            for (unsigned int i_worker = 0; i_worker < num_workers_;
+                    ++i_worker) {
+                if (!workers_[i_worker].done) {
+                    pollfd poll_fd;
+                    poll_fd.fd = workers_[i_worker].socket;
+                    poll_fd.events = POLLIN;
+                    poll_fd.revents = 0;
+                    poll_fds.push_back(poll_fd);
+                    polled_workers.push_back(i_worker);
+                }
+            }
+            if (::poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw Mcmc::CoordinatorError(std::string("could not poll: ") +
+                        std::strerror(errno));
+            }
+
+            for (unsigned int i_poll = 0; i_poll < poll_fds.size(); ++i_poll) {
+                if (poll_fds[i_poll].revents == 0) {
+                    continue;
+                }
+                Worker& worker = workers_[polled_workers[i_poll]];
+                std::uint32_t type = CoordinatorProtocol::ReceiveMessage(
+                        worker.socket, values);
+                if (type == CoordinatorProtocol::kSync && !worker.waiting) {
+                    StoreLastPoints(worker, values);
+                    ++worker.num_syncs;
+                    ++num_syncs_;
+                    worker.waiting = true;
+                } else if (type == CoordinatorProtocol::kDone &&
+                        !worker.waiting) {
+                    StoreLastPoints(worker, values);
+                    ::close(worker.socket);
+                    worker.done = true;
+                    ++num_done;
+                } else {
+                    throw Mcmc::CoordinatorError("unexpected message from a "
+                            "worker");
+                }
+            }
+            ReleaseWorkers();
+        }
+    }
+
+    double ScanCoordinator::mean(unsigned int i) const {
+        if (i >= dimension_ || state_.empty()) {
+            throw std::out_of_range("no such parameter");
+        }
+        return state_[2 + i];
+    }
+
+    double ScanCoordinator::covariance(unsigned int i, unsigned int j) const {
+        if (i >= dimension_ || j >= dimension_ || state_.empty()) {
+            throw std::out_of_range("no such parameter");
+        }
+        return state_[2 + dimension_ + i * dimension_ + j];
+    }
+
+    void ScanCoordinator::StoreLastPoints(Worker const& worker,
+            std::vector<double> const& values) {
+        if (values.size() != worker.num_chains * dimension_) {
+            throw Mcmc::CoordinatorError("worker sent the wrong number of "
+                    "values");
+        }
+        std::copy(values.begin(), values.end(),
+                last_points_.begin() + worker.first_chain * dimension_);
+        stale_ = true;
+    }
+
+    void ScanCoordinator::ComputeMeanAndCovariance() {
+        state_.assign(2 + dimension_ + dimension_ * dimension_, 0.0);
+        state_[0] = num_chains_;
+        double* mean = &state_[2];
+        double* covariance = &state_[2 + dimension_];
+
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            for (unsigned int i = 0; i < dimension_; ++i) {
+                mean[i] += last_points_[i_chain * dimension_ + i];
+            }
+        }
+        for (unsigned int i = 0; i < dimension_; ++i) {
+            mean[i] /= num_chains_;
+        }
+
+        // Normalized by n, as McmcScan does
+        for (unsigned int i_chain = 0; i_chain < num_chains_; ++i_chain) {
+            double const* point = &last_points_[i_chain * dimension_];
+            for (unsigned int i = 0; i < dimension_; ++i) {
+                for (unsigned int j = 0; j <= i; ++j) {
+                    covariance[i * dimension_ + j] += (point[i] - mean[i]) *
+                            (point[j] - mean[j]);
+                }
+            }
+        }
+        for (unsigned int i = 0; i < dimension_; ++i) {
+            for (unsigned int j = 0; j <= i; ++j) {
+                covariance[i * dimension_ + j] /= num_chains_;
+                covariance[j * dimension_ + i] =
+                        covariance[i * dimension_ + j];
+            }
+        }
+        stale_ = false;
+    }
+
+    void ScanCoordinator::ReleaseWorkers() {
+        bool any_running = false;
+        unsigned long min_syncs = 0;
+        for (unsigned int i_worker = 0; i_worker < workers_.size();
+                ++i_worker) {
+            Worker const& worker = workers_[i_worker];
+            if (!worker.done && (!any_running ||
+                    worker.num_syncs < min_syncs)) {
+                min_syncs = worker.num_syncs;
+                any_running = true;
+            }
+        }
+
+        for (unsigned int i_worker = 0; i_worker < workers_.size();
+                ++i_worker) {
+            Worker& worker = workers_[i_worker];
+            if (!worker.waiting ||
+                    worker.num_syncs > min_syncs + max_staleness_) {
+                continue;
+            }
+            if (stale_) {
+                ComputeMeanAndCovariance();
+            }
+            state_[1] = worker.first_chain;
+            CoordinatorProtocol::SendMessage(worker.socket,
+                    CoordinatorProtocol::kState, state_);
+            worker.waiting = false;
+        }
+    }
+
+}
+
@@ -0,0 +1,143 @@
+/*
+ * File:   ScanCoordinator.h
+ * Author: donerkebab
+ *
+ * Coordinator of a scan spread over several processes, e.g. to run more 
+ * chains than one machine has cores.  Each worker process runs a McmcScan 
+ * with its own share of the chains, see McmcScan::EnableDistributedMode(),
+ * and the coordinator owns what the chains have in common: the mean and 
+ * covariance of the last points of all chains, from which every worker draws
+ * its trial points.
+ *
+ * The coordinator listens on a Unix domain socket from construction on, so
+ * the workers can be started right after it.  Run() waits for num_workers 
+ * workers to say hello with the last points of their chains, numbers the
+ * chains in the order the workers connected, and sends each worker the mean
+ * and covariance of all of them.  From then on, every worker applies its own
+ * moves locally, and every so many steps sends its chains' last points in 
+ * and gets the current mean and covariance back.  Run() returns once every
+ * worker is done.  See CoordinatorProtocol.h for the messages.
+ *
+ * Staleness is bounded as in a stale synchronous parallel parameter server: 
+ * each worker's synchronizations are counted, and a worker that is more than
+ * max_staleness synchronizations ahead of the slowest worker that is still 
+ * running only gets its reply once that one catches up.  With max_staleness
+ * 0, the workers go in lockstep; with more, fast workers are held up less, 
+ * but see the other workers' moves later.
+ *
+ * Dev notes:
+ * * Everything runs on the calling thread, with poll() over the workers'
+ *   connections.  The mean and covariance are recomputed from all last 
+ *   points whenever one is needed after something changed, which is 
+ *   O(n d^2) for n chains, and cheap next to the workers' likelihoods.
+ * * Copy constructor is not supported because the copy would share the 
+ *   socket.
+ *
+ * Created on May 6, 2014, 9:40 AM
+ */
+
+#ifndef MCMC_SCANCOORDINATOR_H
+#define	MCMC_SCANCOORDINATOR_H
+
+#include <string>
+#include <vector>
+
+namespace Mcmc {
+
+    class ScanCoordinator {
+    public:
+        /*
+         * Starts listening on socket_path, replacing any file there.
+         *
+         * throws std::invalid_argument if socket_path is empty or too long 
+         * for a socket address, or dimension or num_workers is zero
+         *
+         * throws Mcmc::CoordinatorError if the socket cannot be set up
+         */
+        ScanCoordinator(std::string socket_path,
+                unsigned int dimension,
+                unsigned int num_workers,
+                unsigned int max_staleness);
+        // Stops listening and removes the socket file
+        virtual ~ScanCoordinator();
+
+        std::string socket_path() const;
+        unsigned int dimension() const;
+        unsigned int num_workers() const;
+        unsigned int max_staleness() const;
+        // Number of chains of all workers, once they have said hello
+        unsigned int num_chains() const;
+        // Number of synchronizations of all workers so far
+        unsigned long num_syncs() const;
+
+        /*
+         * Serves the workers until all of them are done.
+         *
+         * throws std::logic_error if called more than once
+         *
+         * throws Mcmc::CoordinatorError if a connection breaks, a message 
+         * does not fit the protocol, or there are no more chains than 
+         * dimensions in total
+         */
+        void Run();
+
+        /*
+         * Mean of parameter i, and covariance of parameters i and j, over 
+         * the last points of all chains as last received.
+         *
+         * throws std::out_of_range if i or j is out of range
+         */
+        double mean(unsigned int i) const;
+        double covariance(unsigned int i, unsigned int j) const;
+
+    private:
+        ScanCoordinator(ScanCoordinator const& orig);
+        void operator=(ScanCoordinator const& orig);
+
+        struct Worker {
+            int socket;
+            unsigned int first_chain;
+            unsigned int num_chains;
+            unsigned long num_syncs;
+            bool waiting;
+            bool done;
+        };
+
+        /*
+         * Copies the last points in a worker's message into last_points_.
+         *
+         * throws Mcmc::CoordinatorError if the message has the wrong size
+         */
+        void StoreLastPoints(Worker const& worker,
+                std::vector<double> const& values);
+        // Recomputes the mean and covariance from last_points_
+        void ComputeMeanAndCovariance();
+        /*
+         * Replies to the waiting workers that are not too far ahead.
+         *
+         * throws Mcmc::CoordinatorError if a connection breaks
+         */
+        void ReleaseWorkers();
+
+        std::string const socket_path_;
+        unsigned int const dimension_;
+        unsigned int const num_workers_;
+        unsigned int const max_staleness_;
+        int listening_socket_;
+        bool started_;
+
+        std::vector<Worker> workers_;
+        unsigned int num_chains_;
+        unsigned long num_syncs_;
+        // Row-major, d values per chain
+        std::vector<double> last_points_;
+        // The kState message: number of chains, first chain, mean, 
+        // covariance.  stale_ is set when last_points_ changed since.
+        std::vector<double> state_;
+        bool stale_;
+    };
+
+}
+
+#endif	/* MCMC_SCANCOORDINATOR_H */
+
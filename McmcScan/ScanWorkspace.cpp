@@ -0,0 +1,42 @@
+/*
+ * File:   ScanWorkspace.cpp
+ * Author: donerkebab
+ *
+ * Created on April 23, 2014, 9:47 PM
+ */
+
+#include "ScanWorkspace.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+
+namespace Mcmc {
+
+    ScanWorkspace::ScanWorkspace(unsigned int dimension,
+            unsigned int num_chains)
+    : batch_measurements(num_chains, nullptr),
+    batch_likelihoods(num_chains, nullptr),
+    stretch_rows(num_chains) {
+        if (dimension == 0 || num_chains == 0) {
+            throw std::invalid_argument("invalid input to ScanWorkspace");
+        }
+
+        trial_parameters = gsl_vector_calloc(dimension);
+
+        sweep_trial_parameters = gsl_matrix_calloc(num_chains, dimension);
+    }
+
+    ScanWorkspace::~ScanWorkspace() {
+        gsl_vector_free(trial_parameters);
+
+        gsl_matrix_free(sweep_trial_parameters);
+        for (unsigned int i = 0; i < batch_measurements.size(); ++i) {
+            gsl_matrix_free(batch_measurements[i]);
+            gsl_vector_free(batch_likelihoods[i]);
+        }
+    }
+
+}
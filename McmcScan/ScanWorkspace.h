@@ -0,0 +1,60 @@
+/*
+ * File:   ScanWorkspace.h
+ * Author: donerkebab
+ *
+ * All of the GSL vectors and matrices that McmcScan needs while it runs,
+ * allocated once when the scan is initialized.  Nothing in the step loop of
+ * McmcScan::Run() allocates memory for its own bookkeeping; it only writes
+ * into these.
+ *
+ * The last points' statistics of the adaptive Gaussian proposal are not in
+ * here, but in the scan's Mcmc::AdaptiveGaussianProposal, which keeps the
+ * scratch space for updating them as well.  All of the members are scratch
+ * space with no meaning between steps.
+ *
+ * Dev notes:
+ * * This is a plain struct with public members, because it only holds
+ *   storage for McmcScan, which is its only user.
+ * * Copy constructor is not supported because the workspace owns its GSL
+ *   objects.
+ *
+ * Created on April 23, 2014, 9:47 PM
+ */
+
+#ifndef MCMC_SCANWORKSPACE_H
+#define	MCMC_SCANWORKSPACE_H
+
+#include <vector>
+
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+
+namespace Mcmc {
+
+    struct ScanWorkspace {
+        // throws std::invalid_argument if dimension or num_chains is zero
+        ScanWorkspace(unsigned int dimension, unsigned int num_chains);
+        virtual ~ScanWorkspace();
+
+        // Trial parameters drawn in the default mode
+        gsl_vector* trial_parameters;
+
+        // Trial parameters drawn in sweep mode, one row per chain, and the
+        // measurement results of each batch
+        gsl_matrix* sweep_trial_parameters;
+        std::vector<gsl_matrix*> batch_measurements;
+        std::vector<gsl_vector*> batch_likelihoods;
+
+        // Row of each chain's trial point in sweep_trial_parameters with
+        // stretch moves, or -1 if it is not valid
+        std::vector<int> stretch_rows;
+
+    private:
+        ScanWorkspace(ScanWorkspace const& orig);
+        void operator=(ScanWorkspace const& orig);
+    };
+
+}
+
+#endif	/* MCMC_SCANWORKSPACE_H */
+
@@ -0,0 +1,91 @@
+/* 
+ * File:   StretchMoveProposal.h
+ * Author: donerkebab
+ *
+ * The proposal policy of McmcScan with stretch moves, see
+ * Mcmc::McmcScan::EnableStretchMove().  The chains are split into a first
+ * and a second half, and the trial point of a chain is
+ *   Y = X_j + z (X_k - X_j)
+ * for its last point X_k, the last point X_j of a random chain of the other
+ * half, and z drawn from g(z) ~ 1/sqrt(z) on [1/a, a].  The log Hastings
+ * ratio is (d - 1) log z, and there is no state to update on acceptance.
+ * 
+ * Dev notes:
+ * * The policy keeps the stretch factor of each chain's last Propose() for
+ *   LogHastingsRatio(), since McmcScan::StretchSweep() draws the trial
+ *   points of a whole half before it measures any of them.  The other half
+ *   has to stay put meanwhile, which the sweep sees to.
+ * * The methods are defined here, so that McmcScan::StretchSweep() can
+ *   inline them.
+ * 
+ * Created on May 6, 2014, 4:47 PM
+ */
+
+#ifndef MCMC_STRETCHMOVEPROPOSAL_H
+#define	MCMC_STRETCHMOVEPROPOSAL_H
+
+#include <cmath>
+#include <vector>
+
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_vector.h>
+
+#include "McmcScan.h"
+
+namespace Mcmc {
+
+    class StretchMoveProposal {
+    public:
+        explicit StretchMoveProposal(Mcmc::McmcScan& scan)
+        : scan_(scan),
+        stretch_factors_(scan.num_chains())
+        {}
+
+        void Propose(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_rng* rng,
+                gsl_vector* trial_parameters) {
+            // Stretch factors are between 1/a and a
+            double const scale = 2.0;
+
+            // A random chain of the other half
+            unsigned int num_chains = scan_.num_chains();
+            unsigned int half = num_chains / 2;
+            unsigned int first_partner = i_chain < half ? half : 0;
+            unsigned int num_partners = i_chain < half ?
+                    num_chains - half : half;
+            gsl_vector const* partner_parameters = scan_.last_parameters(
+                    first_partner + gsl_rng_uniform_int(rng, num_partners));
+
+            double z = std::pow((scale - 1.0) * gsl_rng_uniform(rng) + 1.0,
+                    2) / scale;
+            stretch_factors_[i_chain] = z;
+
+            for (unsigned int i = 0; i < scan_.dimension(); ++i) {
+                gsl_vector_set(trial_parameters, i,
+                        gsl_vector_get(partner_parameters, i) + z *
+                        (gsl_vector_get(last_parameters, i) -
+                        gsl_vector_get(partner_parameters, i)));
+            }
+        }
+
+        double LogHastingsRatio(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_vector const* trial_parameters) {
+            return (scan_.dimension() - 1.0) *
+                    std::log(stretch_factors_[i_chain]);
+        }
+
+        void UpdateState(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_vector const* trial_parameters) {
+        }
+
+    private:
+        Mcmc::McmcScan& scan_;
+        std::vector<double> stretch_factors_;
+    };
+
+}
+
+#endif	/* MCMC_STRETCHMOVEPROPOSAL_H */
@@ -0,0 +1,126 @@
+/*
+ * File:   TextChainWriter.cpp
+ * Author: donerkebab
+ *
+ * Created on April 29, 2014, 6:10 PM
+ */
+
+#include "TextChainWriter.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <gsl/gsl_vector.h>
+
+#include "ChainFlushError.h"
+#include "ChainWriter.h"
+#include "Point.h"
+
+namespace { // unnamed namespace
+    // First line of run-length encoded files
+    char const kRunLengthMarker[] = "# run-length encoded\n";
+
+    // throws Mcmc::ChainFlushError if the file cannot be opened
+    std::FILE* OpenForAppending(std::string const& filename) {
+        std::FILE* file = std::fopen(filename.c_str(), "a");
+        if (file == nullptr) {
+            throw Mcmc::ChainFlushError();
+        }
+        return file;
+    }
+}
+
+namespace Mcmc {
+
+    TextChainWriter::TextChainWriter(std::string filename)
+    : TextChainWriter(filename, false) {
+    }
+
+    TextChainWriter::TextChainWriter(std::string filename,
+            bool run_length_encoded)
+    : ChainWriter(filename, run_length_encoded),
+    output_file_(OpenForAppending(filename)) {
+        try {
+            std::fseek(output_file_, 0, SEEK_END);
+            if (std::ftell(output_file_) == 0) {
+                if (run_length_encoded) {
+                    WriteMarker();
+                }
+            } else {
+                CheckMarker();
+            }
+        } catch (...) {
+            std::fclose(output_file_);
+            throw;
+        }
+    }
+
+    TextChainWriter::~TextChainWriter() {
+        std::fclose(output_file_);
+    }
+
+    void TextChainWriter::Write(std::shared_ptr<Mcmc::Point> const* points,
+            unsigned int const* multiplicities,
+            unsigned int num_runs) {
+        for (unsigned int i_run = 0; i_run < num_runs; ++i_run) {
+            Mcmc::Point const* point = points[i_run].get();
+            unsigned int num_copies = run_length_encoded() ? 1 :
+                    multiplicities[i_run];
+
+            for (unsigned int i_copy = 0; i_copy < num_copies; ++i_copy) {
+                gsl_vector const* parameters = point->parameters();
+                for (size_t i = 0; i < parameters->size; ++i) {
+                    std::fprintf(output_file_, "%- 9.8E  ",
+                            gsl_vector_get(parameters, i));
+                }
+                std::fprintf(output_file_, "\n");
+
+                gsl_vector const* measurements = point->measurements();
+                for (size_t i = 0; i < measurements->size; ++i) {
+                    std::fprintf(output_file_, "%- 9.8E  ",
+                            gsl_vector_get(measurements, i));
+                }
+                std::fprintf(output_file_, "\n");
+
+                std::fprintf(output_file_, "%- 9.8E\n", point->likelihood());
+                if (run_length_encoded()) {
+                    std::fprintf(output_file_, "%u\n", multiplicities[i_run]);
+                }
+                std::fprintf(output_file_, "\n");
+            }
+        }
+
+        if (std::fflush(output_file_) != 0 || std::ferror(output_file_)) {
+            std::clearerr(output_file_);
+            throw Mcmc::ChainFlushError();
+        }
+    }
+
+    void TextChainWriter::WriteMarker() {
+        if (std::fputs(kRunLengthMarker, output_file_) == EOF ||
+                std::fflush(output_file_) != 0) {
+            throw Mcmc::ChainFlushError();
+        }
+    }
+
+    void TextChainWriter::CheckMarker() {
+        std::FILE* input_file = std::fopen(filename().c_str(), "r");
+        if (input_file == nullptr) {
+            throw Mcmc::ChainFlushError();
+        }
+        char line[sizeof(kRunLengthMarker)] = {0};
+        bool marked = std::fgets(line, sizeof(line), input_file) != nullptr &&
+                std::strcmp(line, kRunLengthMarker) == 0;
+        std::fclose(input_file);
+
+        if (marked != run_length_encoded()) {
+            throw std::invalid_argument("existing output file has a "
+                    "different run-length encoding");
+        }
+    }
+
+}
@@ -0,0 +1,67 @@
+/*
+ * File:   TextChainWriter.h
+ * Author: donerkebab
+ *
+ * Writes chain points in the original text format.  Each point takes up four
+ * lines: the parameters, the measurements, the likelihood, and a blank line.
+ * Numbers are printed with "%- 9.8E", i.e. with 9 significant digits.
+ *
+ * This is the format that the Mathematica notebooks read, and the default for
+ * MarkovChain.
+ * 
+ * When run-length encoded, the file starts with the line
+ *   # run-length encoded
+ * and each run of the same point is written once, with its multiplicity as 
+ * an integer on a fifth line after the likelihood, before the blank line.  
+ * Readers of the plain format stumble on the first line rather than 
+ * misreading the multiplicities as the next point.
+ *
+ * Created on April 29, 2014, 6:10 PM
+ */
+
+#ifndef MCMC_TEXTCHAINWRITER_H
+#define	MCMC_TEXTCHAINWRITER_H
+
+#include <cstdio>
+
+#include <memory>
+#include <string>
+
+#include "ChainWriter.h"
+#include "Point.h"
+
+namespace Mcmc {
+
+    class TextChainWriter : public ChainWriter {
+    public:
+        /*
+         * Opens the output file for appending, and keeps it open.  A new
+         * run-length encoded file gets its first line.
+         * 
+         * throws std::invalid_argument if filename is empty, or if the file
+         * already holds points with the other encoding
+         *
+         * throws Mcmc::ChainFlushError if output file cannot be opened
+         */
+        explicit TextChainWriter(std::string filename);
+        // As above, optionally run-length encoded
+        TextChainWriter(std::string filename, bool run_length_encoded);
+        virtual ~TextChainWriter();
+
+        // throws Mcmc::ChainFlushError if output file cannot be written
+        void Write(std::shared_ptr<Mcmc::Point> const* points,
+                unsigned int const* multiplicities,
+                unsigned int num_runs);
+
+    private:
+        std::FILE* const output_file_;
+
+        // throw as the constructor
+        void WriteMarker();
+        void CheckMarker();
+    };
+
+}
+
+#endif	/* MCMC_TEXTCHAINWRITER_H */
+
@@ -0,0 +1,123 @@
+/*
+ * File:   ThreadPool.cpp
+ * Author: donerkebab
+ *
+ * Created on April 14, 2014, 10:02 PM
+ */
+
+#include "ThreadPool.h"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace Mcmc {
+
+    ThreadPool::ThreadPool(unsigned int num_threads)
+    : shutting_down_(false),
+    batch_id_(0),
+    num_tasks_(0),
+    next_task_(0),
+    num_tasks_finished_(0) {
+        if (num_threads == 0) {
+            throw std::invalid_argument("need at least one thread");
+        }
+
+        for (unsigned int i = 0; i < num_threads; ++i) {
+            threads_.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shutting_down_ = true;
+        }
+        work_available_.notify_all();
+
+        for (std::vector<std::thread>::iterator i_thread = threads_.begin();
+                i_thread < threads_.end(); ++i_thread) {
+            i_thread->join();
+        }
+    }
+
+    unsigned int ThreadPool::num_threads() const {
+        return threads_.size();
+    }
+
+    void ThreadPool::ParallelFor(unsigned int num_tasks,
+            std::function<void(unsigned int)> task) {
+        if (num_tasks == 0) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        task_ = task;
+        num_tasks_ = num_tasks;
+        next_task_ = 0;
+        num_tasks_finished_ = 0;
+        first_exception_ = std::exception_ptr();
+        ++batch_id_;
+        work_available_.notify_all();
+
+        while (num_tasks_finished_ < num_tasks_) {
+            work_done_.wait(lock);
+        }
+
+        // Release the task so that anything it captured is not kept alive
+        // until the next batch
+        task_ = std::function<void(unsigned int)>();
+
+        if (first_exception_) {
+            std::exception_ptr exception = first_exception_;
+            first_exception_ = std::exception_ptr();
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void ThreadPool::WorkerLoop() {
+        unsigned long last_batch_id = 0;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            while (!shutting_down_ && batch_id_ == last_batch_id) {
+                work_available_.wait(lock);
+            }
+            if (shutting_down_) {
+                return;
+            }
+            last_batch_id = batch_id_;
+
+            // Take indices until the batch is exhausted.  The lock is only
+            // held while bookkeeping, not while the task itself runs.
+            while (next_task_ < num_tasks_) {
+                unsigned int i_task = next_task_++;
+                bool skip = static_cast<bool>(first_exception_);
+
+                lock.unlock();
+                std::exception_ptr exception;
+                if (!skip) {
+                    try {
+                        task_(i_task);
+                    } catch (...) {
+                        exception = std::current_exception();
+                    }
+                }
+                lock.lock();
+
+                if (exception && !first_exception_) {
+                    first_exception_ = exception;
+                }
+                ++num_tasks_finished_;
+                if (num_tasks_finished_ == num_tasks_) {
+                    work_done_.notify_all();
+                }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,86 @@
+/*
+ * File:   ThreadPool.h
+ * Author: donerkebab
+ *
+ * A fixed-size pool of worker threads, used by McmcScan to run independent
+ * pieces of work (chiefly MeasurePoint() calls) concurrently.
+ *
+ * The pool only supports one operation, ParallelFor(), which runs a task for
+ * every index in [0, num_tasks) and blocks until all of them are done.  Indices
+ * are handed out to the workers dynamically, so a few slow tasks do not hold up
+ * the rest.  The order in which the tasks run is unspecified; callers that need
+ * a deterministic result must write each task's output to its own slot and
+ * combine the slots afterwards.
+ *
+ * If any task throws, the remaining unstarted tasks are skipped, and the first
+ * exception is rethrown from ParallelFor() in the calling thread.
+ *
+ * Dev notes:
+ * * The worker threads live as long as the pool, so that the cost of thread
+ *   creation is paid once per scan and not once per sweep.
+ * * ParallelFor() is not reentrant: a task must not call ParallelFor() on the
+ *   same pool.
+ * * Copy constructor is not supported because the pool owns its threads.
+ *
+ * Created on April 14, 2014, 10:02 PM
+ */
+
+#ifndef MCMC_THREADPOOL_H
+#define	MCMC_THREADPOOL_H
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Mcmc {
+
+    class ThreadPool {
+    public:
+        // throws std::invalid_argument if num_threads is zero
+        explicit ThreadPool(unsigned int num_threads);
+        virtual ~ThreadPool();
+
+        unsigned int num_threads() const;
+
+        /*
+         * Runs task(i) for each i in [0, num_tasks) on the worker threads, and
+         * blocks until all of them have finished.
+         *
+         * rethrows the first exception thrown by a task
+         */
+        void ParallelFor(unsigned int num_tasks,
+                std::function<void(unsigned int)> task);
+
+    private:
+        ThreadPool(ThreadPool const& orig);
+        void operator=(ThreadPool const& orig);
+
+        /*
+         * Main loop of each worker thread.  Waits for a new batch of tasks,
+         * takes indices until the batch is exhausted, and reports back.
+         */
+        void WorkerLoop();
+
+        std::vector<std::thread> threads_;
+
+        std::mutex mutex_;
+        std::condition_variable work_available_;
+        std::condition_variable work_done_;
+
+        // All guarded by mutex_
+        bool shutting_down_;
+        unsigned long batch_id_;
+        std::function<void(unsigned int)> task_;
+        unsigned int num_tasks_;
+        unsigned int next_task_;
+        unsigned int num_tasks_finished_;
+        std::exception_ptr first_exception_;
+    };
+
+}
+
+#endif	/* MCMC_THREADPOOL_H */
+
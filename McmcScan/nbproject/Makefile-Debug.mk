@@ -35,15 +35,41 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
+	${OBJECTDIR}/AdaptiveGaussianProposal.o \
+	${OBJECTDIR}/AsyncChainWriter.o \
+	${OBJECTDIR}/AutocorrelationMonitor.o \
+	${OBJECTDIR}/BinaryChainWriter.o \
+	${OBJECTDIR}/ChainReader.o \
+	${OBJECTDIR}/ChainWriter.o \
+	${OBJECTDIR}/CompressedChainReader.o \
+	${OBJECTDIR}/CompressedChainWriter.o \
+	${OBJECTDIR}/ConvergenceMonitor.o \
+	${OBJECTDIR}/CoordinatorProtocol.o \
 	${OBJECTDIR}/MarkovChain.o \
 	${OBJECTDIR}/McmcScan.o \
-	${OBJECTDIR}/Point.o
+	${OBJECTDIR}/MeasurementCache.o \
+	${OBJECTDIR}/OutputThread.o \
+	${OBJECTDIR}/Point.o \
+	${OBJECTDIR}/PointPool.o \
+	${OBJECTDIR}/PosteriorAccumulator.o \
+	${OBJECTDIR}/ScanCoordinator.o \
+	${OBJECTDIR}/ScanWorkspace.o \
+	${OBJECTDIR}/TextChainWriter.o \
+	${OBJECTDIR}/ThreadPool.o
 
 # Test Directory
 TESTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}/tests
 
 # Test Files
 TESTFILES= \
+	${TESTDIR}/TestFiles/f10 \
+	${TESTDIR}/TestFiles/f9 \
+	${TESTDIR}/TestFiles/f8 \
+	${TESTDIR}/TestFiles/f7 \
+	${TESTDIR}/TestFiles/f6 \
+	${TESTDIR}/TestFiles/f5 \
+	${TESTDIR}/TestFiles/f4 \
+	${TESTDIR}/TestFiles/f3 \
 	${TESTDIR}/TestFiles/f2 \
 	${TESTDIR}/TestFiles/f1
 
@@ -51,8 +77,8 @@ TESTFILES= \
 CFLAGS=
 
 # CC Compiler Flags
-CCFLAGS=-lgsl -lgslcblas -lm
-CXXFLAGS=-lgsl -lgslcblas -lm
+CCFLAGS=-lgsl -lgslcblas -lm -lz -pthread
+CXXFLAGS=-lgsl -lgslcblas -lm -lz -pthread
 
 # Fortran Compiler Flags
 FFLAGS=
@@ -73,6 +99,56 @@ ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/libmcmcscan.a: ${OBJECTFILES}
 	${AR} -rv ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/libmcmcscan.a ${OBJECTFILES} 
 	$(RANLIB) ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/libmcmcscan.a
 
+${OBJECTDIR}/AdaptiveGaussianProposal.o: AdaptiveGaussianProposal.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/AdaptiveGaussianProposal.o AdaptiveGaussianProposal.cpp
+
+${OBJECTDIR}/AsyncChainWriter.o: AsyncChainWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/AsyncChainWriter.o AsyncChainWriter.cpp
+
+${OBJECTDIR}/AutocorrelationMonitor.o: AutocorrelationMonitor.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/AutocorrelationMonitor.o AutocorrelationMonitor.cpp
+
+${OBJECTDIR}/BinaryChainWriter.o: BinaryChainWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/BinaryChainWriter.o BinaryChainWriter.cpp
+
+${OBJECTDIR}/ChainReader.o: ChainReader.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ChainReader.o ChainReader.cpp
+
+${OBJECTDIR}/ChainWriter.o: ChainWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ChainWriter.o ChainWriter.cpp
+
+${OBJECTDIR}/CompressedChainReader.o: CompressedChainReader.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/CompressedChainReader.o CompressedChainReader.cpp
+
+${OBJECTDIR}/CompressedChainWriter.o: CompressedChainWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/CompressedChainWriter.o CompressedChainWriter.cpp
+
+${OBJECTDIR}/ConvergenceMonitor.o: ConvergenceMonitor.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ConvergenceMonitor.o ConvergenceMonitor.cpp
+
+${OBJECTDIR}/CoordinatorProtocol.o: CoordinatorProtocol.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/CoordinatorProtocol.o CoordinatorProtocol.cpp
+
 ${OBJECTDIR}/MarkovChain.o: MarkovChain.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -83,16 +159,88 @@ ${OBJECTDIR}/McmcScan.o: McmcScan.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/McmcScan.o McmcScan.cpp
 
+${OBJECTDIR}/MeasurementCache.o: MeasurementCache.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/MeasurementCache.o MeasurementCache.cpp
+
+${OBJECTDIR}/OutputThread.o: OutputThread.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/OutputThread.o OutputThread.cpp
+
 ${OBJECTDIR}/Point.o: Point.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/Point.o Point.cpp
 
+${OBJECTDIR}/PointPool.o: PointPool.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/PointPool.o PointPool.cpp
+
+${OBJECTDIR}/PosteriorAccumulator.o: PosteriorAccumulator.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/PosteriorAccumulator.o PosteriorAccumulator.cpp
+
+${OBJECTDIR}/ScanCoordinator.o: ScanCoordinator.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ScanCoordinator.o ScanCoordinator.cpp
+
+${OBJECTDIR}/ScanWorkspace.o: ScanWorkspace.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ScanWorkspace.o ScanWorkspace.cpp
+
+${OBJECTDIR}/TextChainWriter.o: TextChainWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TextChainWriter.o TextChainWriter.cpp
+
+${OBJECTDIR}/ThreadPool.o: ThreadPool.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ThreadPool.o ThreadPool.cpp
+
 # Subprojects
 .build-subprojects:
 
 # Build Test Targets
 .build-tests-conf: .build-conf ${TESTFILES}
+${TESTDIR}/TestFiles/f10: ${TESTDIR}/tests/PointPoolTest.o ${TESTDIR}/tests/PointPoolTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f10 $^ ${LDLIBSOPTIONS} `cppunit-config --libs`   
+
+${TESTDIR}/TestFiles/f9: ${TESTDIR}/tests/AutocorrelationMonitorTest.o ${TESTDIR}/tests/AutocorrelationMonitorTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f9 $^ ${LDLIBSOPTIONS} `cppunit-config --libs`   
+
+${TESTDIR}/TestFiles/f8: ${TESTDIR}/tests/PosteriorAccumulatorTest.o ${TESTDIR}/tests/PosteriorAccumulatorTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f8 $^ ${LDLIBSOPTIONS} `cppunit-config --libs`   
+
+${TESTDIR}/TestFiles/f7: ${TESTDIR}/tests/ConvergenceMonitorTest.o ${TESTDIR}/tests/ConvergenceMonitorTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f7 $^ ${LDLIBSOPTIONS} `cppunit-config --libs`   
+
+${TESTDIR}/TestFiles/f6: ${TESTDIR}/tests/ChainWriterTest.o ${TESTDIR}/tests/ChainWriterTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f6 $^ ${LDLIBSOPTIONS} `cppunit-config --libs`   
+
+${TESTDIR}/TestFiles/f5: ${TESTDIR}/tests/MeasurementCacheTest.o ${TESTDIR}/tests/MeasurementCacheTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f5 $^ ${LDLIBSOPTIONS} `cppunit-config --libs`   
+
+${TESTDIR}/TestFiles/f4: ${TESTDIR}/tests/McmcScanTest.o ${TESTDIR}/tests/McmcScanTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f4 $^ ${LDLIBSOPTIONS} `cppunit-config --libs`   
+
+${TESTDIR}/TestFiles/f3: ${TESTDIR}/tests/ThreadPoolTest.o ${TESTDIR}/tests/ThreadPoolTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f3 $^ ${LDLIBSOPTIONS} `cppunit-config --libs`   
+
 ${TESTDIR}/TestFiles/f2: ${TESTDIR}/tests/MarkovChainTestClass.o ${TESTDIR}/tests/MarkovChainTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
 	${MKDIR} -p ${TESTDIR}/TestFiles
 	${LINK.cc}   -o ${TESTDIR}/TestFiles/f2 $^ ${LDLIBSOPTIONS} `cppunit-config --libs`   
@@ -102,6 +250,102 @@ ${TESTDIR}/TestFiles/f1: ${TESTDIR}/tests/PointTest.o ${TESTDIR}/tests/PointTest
 	${LINK.cc}   -o ${TESTDIR}/TestFiles/f1 $^ ${LDLIBSOPTIONS} `cppunit-config --libs`   
 
 
+${TESTDIR}/tests/PointPoolTest.o: tests/PointPoolTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/PointPoolTest.o tests/PointPoolTest.cpp
+
+
+${TESTDIR}/tests/PointPoolTestRunner.o: tests/PointPoolTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/PointPoolTestRunner.o tests/PointPoolTestRunner.cpp
+
+
+${TESTDIR}/tests/AutocorrelationMonitorTest.o: tests/AutocorrelationMonitorTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/AutocorrelationMonitorTest.o tests/AutocorrelationMonitorTest.cpp
+
+
+${TESTDIR}/tests/AutocorrelationMonitorTestRunner.o: tests/AutocorrelationMonitorTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/AutocorrelationMonitorTestRunner.o tests/AutocorrelationMonitorTestRunner.cpp
+
+
+${TESTDIR}/tests/PosteriorAccumulatorTest.o: tests/PosteriorAccumulatorTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/PosteriorAccumulatorTest.o tests/PosteriorAccumulatorTest.cpp
+
+
+${TESTDIR}/tests/PosteriorAccumulatorTestRunner.o: tests/PosteriorAccumulatorTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/PosteriorAccumulatorTestRunner.o tests/PosteriorAccumulatorTestRunner.cpp
+
+
+${TESTDIR}/tests/ConvergenceMonitorTest.o: tests/ConvergenceMonitorTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/ConvergenceMonitorTest.o tests/ConvergenceMonitorTest.cpp
+
+
+${TESTDIR}/tests/ConvergenceMonitorTestRunner.o: tests/ConvergenceMonitorTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/ConvergenceMonitorTestRunner.o tests/ConvergenceMonitorTestRunner.cpp
+
+
+${TESTDIR}/tests/ChainWriterTest.o: tests/ChainWriterTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/ChainWriterTest.o tests/ChainWriterTest.cpp
+
+
+${TESTDIR}/tests/ChainWriterTestRunner.o: tests/ChainWriterTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/ChainWriterTestRunner.o tests/ChainWriterTestRunner.cpp
+
+
+${TESTDIR}/tests/MeasurementCacheTest.o: tests/MeasurementCacheTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/MeasurementCacheTest.o tests/MeasurementCacheTest.cpp
+
+
+${TESTDIR}/tests/MeasurementCacheTestRunner.o: tests/MeasurementCacheTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/MeasurementCacheTestRunner.o tests/MeasurementCacheTestRunner.cpp
+
+
+${TESTDIR}/tests/McmcScanTest.o: tests/McmcScanTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/McmcScanTest.o tests/McmcScanTest.cpp
+
+
+${TESTDIR}/tests/McmcScanTestRunner.o: tests/McmcScanTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/McmcScanTestRunner.o tests/McmcScanTestRunner.cpp
+
+
+${TESTDIR}/tests/ThreadPoolTest.o: tests/ThreadPoolTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/ThreadPoolTest.o tests/ThreadPoolTest.cpp
+
+
+${TESTDIR}/tests/ThreadPoolTestRunner.o: tests/ThreadPoolTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/ThreadPoolTestRunner.o tests/ThreadPoolTestRunner.cpp
+
+
 ${TESTDIR}/tests/MarkovChainTestClass.o: tests/MarkovChainTestClass.cpp 
 	${MKDIR} -p ${TESTDIR}/tests
 	${RM} "$@.d"
@@ -126,6 +370,136 @@ ${TESTDIR}/tests/PointTestRunner.o: tests/PointTestRunner.cpp
 	$(COMPILE.cc) -g `cppunit-config --cflags` -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/PointTestRunner.o tests/PointTestRunner.cpp
 
 
+${OBJECTDIR}/AdaptiveGaussianProposal_nomain.o: ${OBJECTDIR}/AdaptiveGaussianProposal.o AdaptiveGaussianProposal.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/AdaptiveGaussianProposal.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/AdaptiveGaussianProposal_nomain.o AdaptiveGaussianProposal.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/AdaptiveGaussianProposal.o ${OBJECTDIR}/AdaptiveGaussianProposal_nomain.o;\
+	fi
+
+${OBJECTDIR}/AsyncChainWriter_nomain.o: ${OBJECTDIR}/AsyncChainWriter.o AsyncChainWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/AsyncChainWriter.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/AsyncChainWriter_nomain.o AsyncChainWriter.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/AsyncChainWriter.o ${OBJECTDIR}/AsyncChainWriter_nomain.o;\
+	fi
+
+${OBJECTDIR}/AutocorrelationMonitor_nomain.o: ${OBJECTDIR}/AutocorrelationMonitor.o AutocorrelationMonitor.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/AutocorrelationMonitor.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/AutocorrelationMonitor_nomain.o AutocorrelationMonitor.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/AutocorrelationMonitor.o ${OBJECTDIR}/AutocorrelationMonitor_nomain.o;\
+	fi
+
+${OBJECTDIR}/BinaryChainWriter_nomain.o: ${OBJECTDIR}/BinaryChainWriter.o BinaryChainWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/BinaryChainWriter.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/BinaryChainWriter_nomain.o BinaryChainWriter.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/BinaryChainWriter.o ${OBJECTDIR}/BinaryChainWriter_nomain.o;\
+	fi
+
+${OBJECTDIR}/ChainReader_nomain.o: ${OBJECTDIR}/ChainReader.o ChainReader.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/ChainReader.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ChainReader_nomain.o ChainReader.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/ChainReader.o ${OBJECTDIR}/ChainReader_nomain.o;\
+	fi
+
+${OBJECTDIR}/ChainWriter_nomain.o: ${OBJECTDIR}/ChainWriter.o ChainWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/ChainWriter.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ChainWriter_nomain.o ChainWriter.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/ChainWriter.o ${OBJECTDIR}/ChainWriter_nomain.o;\
+	fi
+
+${OBJECTDIR}/CompressedChainReader_nomain.o: ${OBJECTDIR}/CompressedChainReader.o CompressedChainReader.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/CompressedChainReader.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/CompressedChainReader_nomain.o CompressedChainReader.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/CompressedChainReader.o ${OBJECTDIR}/CompressedChainReader_nomain.o;\
+	fi
+
+${OBJECTDIR}/CompressedChainWriter_nomain.o: ${OBJECTDIR}/CompressedChainWriter.o CompressedChainWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/CompressedChainWriter.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/CompressedChainWriter_nomain.o CompressedChainWriter.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/CompressedChainWriter.o ${OBJECTDIR}/CompressedChainWriter_nomain.o;\
+	fi
+
+${OBJECTDIR}/ConvergenceMonitor_nomain.o: ${OBJECTDIR}/ConvergenceMonitor.o ConvergenceMonitor.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/ConvergenceMonitor.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ConvergenceMonitor_nomain.o ConvergenceMonitor.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/ConvergenceMonitor.o ${OBJECTDIR}/ConvergenceMonitor_nomain.o;\
+	fi
+
+${OBJECTDIR}/CoordinatorProtocol_nomain.o: ${OBJECTDIR}/CoordinatorProtocol.o CoordinatorProtocol.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/CoordinatorProtocol.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/CoordinatorProtocol_nomain.o CoordinatorProtocol.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/CoordinatorProtocol.o ${OBJECTDIR}/CoordinatorProtocol_nomain.o;\
+	fi
+
 ${OBJECTDIR}/MarkovChain_nomain.o: ${OBJECTDIR}/MarkovChain.o MarkovChain.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	@NMOUTPUT=`${NM} ${OBJECTDIR}/MarkovChain.o`; \
@@ -152,6 +526,32 @@ ${OBJECTDIR}/McmcScan_nomain.o: ${OBJECTDIR}/McmcScan.o McmcScan.cpp
 	    ${CP} ${OBJECTDIR}/McmcScan.o ${OBJECTDIR}/McmcScan_nomain.o;\
 	fi
 
+${OBJECTDIR}/MeasurementCache_nomain.o: ${OBJECTDIR}/MeasurementCache.o MeasurementCache.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/MeasurementCache.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/MeasurementCache_nomain.o MeasurementCache.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/MeasurementCache.o ${OBJECTDIR}/MeasurementCache_nomain.o;\
+	fi
+
+${OBJECTDIR}/OutputThread_nomain.o: ${OBJECTDIR}/OutputThread.o OutputThread.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/OutputThread.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/OutputThread_nomain.o OutputThread.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/OutputThread.o ${OBJECTDIR}/OutputThread_nomain.o;\
+	fi
+
 ${OBJECTDIR}/Point_nomain.o: ${OBJECTDIR}/Point.o Point.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	@NMOUTPUT=`${NM} ${OBJECTDIR}/Point.o`; \
@@ -165,10 +565,96 @@ ${OBJECTDIR}/Point_nomain.o: ${OBJECTDIR}/Point.o Point.cpp
 	    ${CP} ${OBJECTDIR}/Point.o ${OBJECTDIR}/Point_nomain.o;\
 	fi
 
+${OBJECTDIR}/PointPool_nomain.o: ${OBJECTDIR}/PointPool.o PointPool.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/PointPool.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/PointPool_nomain.o PointPool.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/PointPool.o ${OBJECTDIR}/PointPool_nomain.o;\
+	fi
+
+${OBJECTDIR}/PosteriorAccumulator_nomain.o: ${OBJECTDIR}/PosteriorAccumulator.o PosteriorAccumulator.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/PosteriorAccumulator.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/PosteriorAccumulator_nomain.o PosteriorAccumulator.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/PosteriorAccumulator.o ${OBJECTDIR}/PosteriorAccumulator_nomain.o;\
+	fi
+
+${OBJECTDIR}/ScanCoordinator_nomain.o: ${OBJECTDIR}/ScanCoordinator.o ScanCoordinator.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/ScanCoordinator.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ScanCoordinator_nomain.o ScanCoordinator.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/ScanCoordinator.o ${OBJECTDIR}/ScanCoordinator_nomain.o;\
+	fi
+
+${OBJECTDIR}/ScanWorkspace_nomain.o: ${OBJECTDIR}/ScanWorkspace.o ScanWorkspace.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/ScanWorkspace.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ScanWorkspace_nomain.o ScanWorkspace.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/ScanWorkspace.o ${OBJECTDIR}/ScanWorkspace_nomain.o;\
+	fi
+
+${OBJECTDIR}/TextChainWriter_nomain.o: ${OBJECTDIR}/TextChainWriter.o TextChainWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/TextChainWriter.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TextChainWriter_nomain.o TextChainWriter.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/TextChainWriter.o ${OBJECTDIR}/TextChainWriter_nomain.o;\
+	fi
+
+${OBJECTDIR}/ThreadPool_nomain.o: ${OBJECTDIR}/ThreadPool.o ThreadPool.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/ThreadPool.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.cc) -g -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ThreadPool_nomain.o ThreadPool.cpp;\
+	else  \
+	    ${CP} ${OBJECTDIR}/ThreadPool.o ${OBJECTDIR}/ThreadPool_nomain.o;\
+	fi
+
 # Run Test Targets
 .test-conf:
 	@if [ "${TEST}" = "" ]; \
 	then  \
+	    ${TESTDIR}/TestFiles/f10 || true; \
+	    ${TESTDIR}/TestFiles/f9 || true; \
+	    ${TESTDIR}/TestFiles/f8 || true; \
+	    ${TESTDIR}/TestFiles/f7 || true; \
+	    ${TESTDIR}/TestFiles/f6 || true; \
+	    ${TESTDIR}/TestFiles/f5 || true; \
+	    ${TESTDIR}/TestFiles/f4 || true; \
+	    ${TESTDIR}/TestFiles/f3 || true; \
 	    ${TESTDIR}/TestFiles/f2 || true; \
 	    ${TESTDIR}/TestFiles/f1 || true; \
 	else  \
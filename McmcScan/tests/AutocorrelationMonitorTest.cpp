@@ -0,0 +1,173 @@
+/*
+ * File:   AutocorrelationMonitorTest.cpp
+ * Author: donerkebab
+ *
+ * Created on May 5, 2014, 11:40:21 AM
+ */
+
+#include "AutocorrelationMonitorTest.h"
+
+#include <cmath>
+
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_vector.h>
+
+#include "../AutocorrelationMonitor.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AutocorrelationMonitorTest);
+
+AutocorrelationMonitorTest::AutocorrelationMonitorTest()
+: d_(1E-12) {
+}
+
+AutocorrelationMonitorTest::~AutocorrelationMonitorTest() {
+}
+
+void AutocorrelationMonitorTest::setUp() {
+}
+
+void AutocorrelationMonitorTest::tearDown() {
+}
+
+void AutocorrelationMonitorTest::testInitialization() {
+    CPPUNIT_ASSERT_THROW(Mcmc::AutocorrelationMonitor monitor(0, 2),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(Mcmc::AutocorrelationMonitor monitor(2, 0),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(Mcmc::AutocorrelationMonitor monitor(2, 2, 1),
+            std::invalid_argument);
+
+    Mcmc::AutocorrelationMonitor monitor(3, 2, 4);
+    CPPUNIT_ASSERT(monitor.num_chains() == 3);
+    CPPUNIT_ASSERT(monitor.dimension() == 2);
+    CPPUNIT_ASSERT(monitor.min_batches() == 4);
+    CPPUNIT_ASSERT(monitor.num_points(2) == 0);
+    CPPUNIT_ASSERT(monitor.batch_size(2) == 1);
+    CPPUNIT_ASSERT(!monitor.ready());
+    CPPUNIT_ASSERT_THROW(monitor.AutocorrelationTime(0, 0), std::logic_error);
+    std::vector<double> sample_sizes;
+    CPPUNIT_ASSERT_THROW(monitor.ComputeEffectiveSampleSizes(sample_sizes),
+            std::logic_error);
+    CPPUNIT_ASSERT_THROW(monitor.AutocorrelationTime(3, 0),
+            std::out_of_range);
+    CPPUNIT_ASSERT_THROW(monitor.AutocorrelationTime(0, 2),
+            std::out_of_range);
+
+    gsl_vector* parameters = gsl_vector_calloc(2);
+    CPPUNIT_ASSERT_THROW(monitor.Add(3, parameters), std::invalid_argument);
+    gsl_vector* wrong_parameters = gsl_vector_calloc(3);
+    CPPUNIT_ASSERT_THROW(monitor.Add(0, wrong_parameters),
+            std::invalid_argument);
+    gsl_vector_free(wrong_parameters);
+    gsl_vector_free(parameters);
+}
+
+void AutocorrelationMonitorTest::testBatching() {
+    // With at least 2 batches, points 1, 2, 3, ... are merged into batches of
+    // 2 after 4 points, 4 after 8, 8 after 16, and so on
+    Mcmc::AutocorrelationMonitor monitor(2, 1, 2);
+    gsl_vector* parameters = gsl_vector_alloc(1);
+    for (int n = 1; n <= 40; ++n) {
+        gsl_vector_set(parameters, 0, n);
+        monitor.Add(0, parameters);
+        CPPUNIT_ASSERT(monitor.num_points(0) == n);
+        CPPUNIT_ASSERT(monitor.ready(0) == (n >= 2));
+        unsigned long batch_size = n < 4 ? 1 : n < 8 ? 2 : n < 16 ? 4 :
+                n < 32 ? 8 : 16;
+        CPPUNIT_ASSERT(monitor.batch_size(0) == batch_size);
+    }
+    CPPUNIT_ASSERT(monitor.num_points(1) == 0);
+    CPPUNIT_ASSERT(!monitor.ready());
+    gsl_vector_free(parameters);
+
+    // 40 points: two batches of 16 with means 8.5 and 24.5, and the points
+    // 33..40 still in the unfinished batch.  tau = b s_b^2 / s^2.
+    double batch_variance = 0.5 * (24.5 - 8.5) * (24.5 - 8.5);
+    double variance = 40.0 * 41.0 / 12.0;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(16.0 * batch_variance / variance,
+            monitor.AutocorrelationTime(0, 0), 1E-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(40.0 / (16.0 * batch_variance / variance),
+            monitor.EffectiveSampleSize(0, 0), 1E-9);
+}
+
+void AutocorrelationMonitorTest::testAutocorrelationTime() {
+    // Chain 0 is independent points, tau = 1.  Chain 1 is an AR(1) process
+    // x_n = phi x_(n-1) + noise, tau = (1 + phi) / (1 - phi) = 19 for 
+    // phi = 0.9.
+    gsl_rng* rng = gsl_rng_alloc(gsl_rng_default);
+    gsl_rng_set(rng, 12345);
+
+    unsigned int dimension = 8;
+    unsigned int num_points = 3 << 16;
+    double phi = 0.9;
+    Mcmc::AutocorrelationMonitor monitor(2, dimension);
+    gsl_vector* parameters = gsl_vector_alloc(dimension);
+    gsl_vector* ar_parameters = gsl_vector_calloc(dimension);
+    for (unsigned int n = 0; n < num_points; ++n) {
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(parameters, i, gsl_ran_gaussian(rng, 1.0));
+            gsl_vector_set(ar_parameters, i, phi *
+                    gsl_vector_get(ar_parameters, i) +
+                    gsl_ran_gaussian(rng, 1.0));
+        }
+        monitor.Add(0, parameters);
+        monitor.Add(1, ar_parameters);
+    }
+    CPPUNIT_ASSERT(monitor.ready());
+    CPPUNIT_ASSERT(monitor.batch_size(0) == 1 << 12);
+
+    // With 48 batches, each estimate is only good to about 20%, so compare
+    // the averages over the parameters
+    double mean_tau = 0.0;
+    double mean_ar_tau = 0.0;
+    for (int i = 0; i < dimension; ++i) {
+        mean_tau += monitor.AutocorrelationTime(0, i) / dimension;
+        mean_ar_tau += monitor.AutocorrelationTime(1, i) / dimension;
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, mean_tau, 0.25);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(19.0, mean_ar_tau, 4.5);
+
+    std::vector<double> sample_sizes;
+    double min_sample_size = monitor.ComputeEffectiveSampleSizes(
+            sample_sizes);
+    CPPUNIT_ASSERT(sample_sizes.size() == dimension);
+    bool found_min = false;
+    for (int i = 0; i < dimension; ++i) {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(monitor.EffectiveSampleSize(0, i) +
+                monitor.EffectiveSampleSize(1, i), sample_sizes[i],
+                1E-9 * sample_sizes[i]);
+        CPPUNIT_ASSERT(min_sample_size <= sample_sizes[i]);
+        found_min = found_min || min_sample_size == sample_sizes[i];
+    }
+    CPPUNIT_ASSERT(found_min);
+
+    gsl_vector_free(parameters);
+    gsl_vector_free(ar_parameters);
+    gsl_rng_free(rng);
+}
+
+void AutocorrelationMonitorTest::testStuckChain() {
+    // A parameter that never moves is worth nothing
+    Mcmc::AutocorrelationMonitor monitor(1, 2, 2);
+    gsl_vector* parameters = gsl_vector_alloc(2);
+    gsl_vector_set(parameters, 0, 1.5);
+    for (int n = 0; n < 10; ++n) {
+        gsl_vector_set(parameters, 1, n % 3);
+        monitor.Add(0, parameters);
+    }
+    CPPUNIT_ASSERT(monitor.AutocorrelationTime(0, 0) ==
+            std::numeric_limits<double>::infinity());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, monitor.EffectiveSampleSize(0, 0), d_);
+    CPPUNIT_ASSERT(monitor.EffectiveSampleSize(0, 1) > 0.0);
+
+    std::vector<double> sample_sizes;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0,
+            monitor.ComputeEffectiveSampleSizes(sample_sizes), d_);
+    gsl_vector_free(parameters);
+}
+
@@ -0,0 +1,39 @@
+/*
+ * File:   AutocorrelationMonitorTest.h
+ * Author: donerkebab
+ *
+ * Created on May 5, 2014, 11:40:20 AM
+ */
+
+#ifndef MCMC_AUTOCORRELATIONMONITORTEST_H
+#define	MCMC_AUTOCORRELATIONMONITORTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class AutocorrelationMonitorTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(AutocorrelationMonitorTest);
+
+    CPPUNIT_TEST(testInitialization);
+    CPPUNIT_TEST(testBatching);
+    CPPUNIT_TEST(testAutocorrelationTime);
+    CPPUNIT_TEST(testStuckChain);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    AutocorrelationMonitorTest();
+    virtual ~AutocorrelationMonitorTest();
+    void setUp();
+    void tearDown();
+
+private:
+    void testInitialization();
+    void testBatching();
+    void testAutocorrelationTime();
+    void testStuckChain();
+
+    double const d_;  // delta for CPPUNIT_ASSERT_DOUBLES_EQUAL
+};
+
+#endif	/* MCMC_AUTOCORRELATIONMONITORTEST_H */
+
@@ -0,0 +1,567 @@
+/*
+ * File:   ChainWriterTest.cpp
+ * Author: donerkebab
+ *
+ * Created on Apr 29, 2014, 7:14:06 PM
+ */
+
+#include "ChainWriterTest.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gsl/gsl_vector.h>
+
+#include "../AsyncChainWriter.h"
+#include "../BinaryChainWriter.h"
+#include "../ChainReadError.h"
+#include "../ChainReader.h"
+#include "../ChainWriter.h"
+#include "../CompressedChainReader.h"
+#include "../CompressedChainWriter.h"
+#include "../MarkovChain.h"
+#include "../OutputThread.h"
+#include "../Point.h"
+#include "../TextChainWriter.h"
+
+namespace { // unnamed namespace
+    std::vector<unsigned char> ReadFile(std::string const& filename) {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        return std::vector<unsigned char>(
+                std::istreambuf_iterator<char>(file),
+                std::istreambuf_iterator<char>());
+    }
+
+    std::uint32_t DecodeUint32(unsigned char const* bytes) {
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<std::uint32_t>(bytes[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    double DecodeDouble(unsigned char const* bytes) {
+        std::uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i) {
+            bits |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+        }
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::shared_ptr<Mcmc::Point> NewPoint(unsigned int dimension,
+            unsigned int num_measurements, double seed) {
+        gsl_vector* parameters = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(parameters, i, std::sin(seed * (i + 1.0)) * 1E3);
+        }
+        gsl_vector* measurements = gsl_vector_alloc(num_measurements);
+        for (int i = 0; i < num_measurements; ++i) {
+            gsl_vector_set(measurements, i, std::cos(seed + i) * 1E-3);
+        }
+        std::shared_ptr<Mcmc::Point> point(new Mcmc::Point(parameters,
+                measurements, std::exp(-seed)));
+        gsl_vector_free(parameters);
+        gsl_vector_free(measurements);
+        return point;
+    }
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ChainWriterTest);
+
+ChainWriterTest::ChainWriterTest()
+: text_filename_("dummy_chainwriter_text.dat"),
+binary_filename_("dummy_chainwriter_binary.dat") {
+}
+
+ChainWriterTest::~ChainWriterTest() {
+}
+
+void ChainWriterTest::setUp() {
+}
+
+void ChainWriterTest::tearDown() {
+    std::remove(text_filename_.c_str());
+    std::remove(binary_filename_.c_str());
+}
+
+void ChainWriterTest::testBinaryHeader() {
+    CPPUNIT_ASSERT_THROW(Mcmc::BinaryChainWriter writer("", 2, 3, ""),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(Mcmc::BinaryChainWriter writer(binary_filename_, 0,
+            3, ""), std::invalid_argument);
+    std::remove(binary_filename_.c_str());
+
+    std::string metadata = "chain = 0";
+    {
+        Mcmc::BinaryChainWriter writer(binary_filename_, 2, 3, metadata);
+        CPPUNIT_ASSERT(writer.filename() == binary_filename_);
+        CPPUNIT_ASSERT(writer.dimension() == 2);
+        CPPUNIT_ASSERT(writer.num_measurements() == 3);
+        CPPUNIT_ASSERT(writer.record_bytes() == 6 * sizeof(double));
+    }
+
+    std::vector<unsigned char> header = ReadFile(binary_filename_);
+    CPPUNIT_ASSERT(header.size() == 40);
+    CPPUNIT_ASSERT(std::string(header.begin(), header.begin() + 8) ==
+            "MCMCCHN1");
+    CPPUNIT_ASSERT(DecodeUint32(&header[8]) == 40);
+    CPPUNIT_ASSERT(DecodeUint32(&header[12]) == 2);
+    CPPUNIT_ASSERT(DecodeUint32(&header[16]) == 3);
+    CPPUNIT_ASSERT(DecodeUint32(&header[20]) == 0);
+    CPPUNIT_ASSERT(DecodeUint32(&header[24]) == metadata.size());
+    CPPUNIT_ASSERT(std::string(header.begin() + 28,
+            header.begin() + 28 + metadata.size()) == metadata);
+
+    // Reopening the file leaves the header alone, as long as it matches
+    {
+        Mcmc::BinaryChainWriter writer(binary_filename_, 2, 3, "other");
+    }
+    CPPUNIT_ASSERT(ReadFile(binary_filename_) == header);
+    CPPUNIT_ASSERT_THROW(Mcmc::BinaryChainWriter writer(binary_filename_, 3,
+            3, ""), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(Mcmc::BinaryChainWriter writer(binary_filename_, 2,
+            2, ""), std::invalid_argument);
+
+    // Text is not mistaken for a header
+    std::FILE* text_file = std::fopen(text_filename_.c_str(), "w");
+    std::fprintf(text_file, "1.0  2.0\n");
+    std::fclose(text_file);
+    CPPUNIT_ASSERT_THROW(Mcmc::BinaryChainWriter writer(text_filename_, 2,
+            3, ""), std::invalid_argument);
+}
+
+void ChainWriterTest::testRoundTrip() {
+    unsigned int dimension = 3;
+    unsigned int num_measurements = 2;
+    unsigned int buffer_size = 4;
+
+    // Same points into both formats, with some repeats as in a real chain
+    std::vector<std::shared_ptr<Mcmc::Point> > points;
+    for (int i_point = 0; i_point < 10; ++i_point) {
+        if (i_point % 3 == 2) {
+            points.push_back(points.back());
+        } else {
+            points.push_back(NewPoint(dimension, num_measurements,
+                    0.37 * i_point + 0.1));
+        }
+    }
+    {
+        Mcmc::MarkovChain text_chain(points[0], text_filename_, buffer_size);
+        Mcmc::MarkovChain binary_chain(points[0],
+                std::unique_ptr<Mcmc::ChainWriter>(
+                new Mcmc::BinaryChainWriter(binary_filename_, dimension,
+                num_measurements, "")), buffer_size, 0);
+        CPPUNIT_ASSERT(binary_chain.filename() == binary_filename_);
+        for (int i_point = 1; i_point < points.size(); ++i_point) {
+            text_chain.Append(points[i_point]);
+            binary_chain.Append(points[i_point]);
+        }
+        CPPUNIT_ASSERT(binary_chain.num_points_flushed() ==
+                text_chain.num_points_flushed());
+    }
+
+    // Binary holds the exact values, and text agrees to 9 significant digits
+    std::vector<unsigned char> binary = ReadFile(binary_filename_);
+    std::size_t header_bytes = DecodeUint32(&binary[8]);
+    std::size_t record_bytes = (dimension + num_measurements + 1) *
+            sizeof(double);
+    CPPUNIT_ASSERT(binary.size() == header_bytes +
+            points.size() * record_bytes);
+
+    std::FILE* text_file = std::fopen(text_filename_.c_str(), "r");
+    for (int i_point = 0; i_point < points.size(); ++i_point) {
+        std::vector<double> expected;
+        for (int i = 0; i < dimension; ++i) {
+            expected.push_back(gsl_vector_get(points[i_point]->parameters(),
+                    i));
+        }
+        for (int i = 0; i < num_measurements; ++i) {
+            expected.push_back(gsl_vector_get(points[i_point]->measurements(),
+                    i));
+        }
+        expected.push_back(points[i_point]->likelihood());
+
+        unsigned char const* record = &binary[header_bytes +
+                i_point * record_bytes];
+        for (int i = 0; i < expected.size(); ++i) {
+            double binary_value = DecodeDouble(record + i * sizeof(double));
+            CPPUNIT_ASSERT(binary_value == expected[i]);
+
+            double text_value;
+            CPPUNIT_ASSERT(std::fscanf(text_file, "%lf", &text_value) == 1);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(binary_value, text_value,
+                    std::fabs(binary_value) * 1E-8);
+        }
+    }
+    double extra;
+    CPPUNIT_ASSERT(std::fscanf(text_file, "%lf", &extra) == EOF);
+    std::fclose(text_file);
+}
+
+void ChainWriterTest::testBinaryMismatchedPoint() {
+    Mcmc::BinaryChainWriter writer(binary_filename_, 2, 3, "");
+    std::vector<unsigned char> header = ReadFile(binary_filename_);
+
+    std::shared_ptr<Mcmc::Point> points[2] = {NewPoint(2, 3, 0.5),
+        NewPoint(2, 4, 0.6)};
+    unsigned int multiplicities[2] = {1, 1};
+    CPPUNIT_ASSERT_THROW(writer.Write(points, multiplicities, 2),
+            std::invalid_argument);
+    CPPUNIT_ASSERT(ReadFile(binary_filename_) == header);
+
+    writer.Write(points, multiplicities, 1);
+    CPPUNIT_ASSERT(ReadFile(binary_filename_).size() ==
+            header.size() + writer.record_bytes());
+}
+
+void ChainWriterTest::testRunLengthEncoding() {
+    unsigned int dimension = 2;
+    unsigned int num_measurements = 1;
+    unsigned int buffer_size = 6;
+
+    // Runs of 3, 1, 4, 2 and 5 copies of the same point
+    unsigned int run_lengths[5] = {3, 1, 4, 2, 5};
+    std::vector<std::shared_ptr<Mcmc::Point> > points;
+    for (int i_run = 0; i_run < 5; ++i_run) {
+        std::shared_ptr<Mcmc::Point> point = NewPoint(dimension,
+                num_measurements, 0.7 * i_run + 0.2);
+        for (int i = 0; i < run_lengths[i_run]; ++i) {
+            points.push_back(point);
+        }
+    }
+    {
+        Mcmc::MarkovChain text_chain(points[0],
+                std::unique_ptr<Mcmc::ChainWriter>(
+                new Mcmc::TextChainWriter(text_filename_, true)),
+                buffer_size, 0);
+        Mcmc::MarkovChain binary_chain(points[0],
+                std::unique_ptr<Mcmc::ChainWriter>(
+                new Mcmc::BinaryChainWriter(binary_filename_, dimension,
+                num_measurements, "", true)), buffer_size, 0);
+        for (int i_point = 1; i_point < points.size(); ++i_point) {
+            text_chain.Append(points[i_point]);
+            binary_chain.Append(points[i_point]);
+        }
+        CPPUNIT_ASSERT(binary_chain.num_points_flushed() ==
+                text_chain.num_points_flushed());
+        CPPUNIT_ASSERT(binary_chain.length() == points.size());
+    }
+
+    // Expanding the runs gives back the whole chain.  Runs may be split at
+    // flushes, so there can be more records than runs.
+    std::vector<unsigned char> binary = ReadFile(binary_filename_);
+    CPPUNIT_ASSERT(DecodeUint32(&binary[20]) == 1);
+    std::size_t header_bytes = DecodeUint32(&binary[8]);
+    std::size_t record_bytes = (dimension + num_measurements + 2) *
+            sizeof(double);
+    CPPUNIT_ASSERT((binary.size() - header_bytes) % record_bytes == 0);
+    std::size_t num_records = (binary.size() - header_bytes) / record_bytes;
+    CPPUNIT_ASSERT(num_records >= 5);
+    CPPUNIT_ASSERT(num_records < points.size() / 2);
+
+    // The text file says it is run-length encoded, and cannot be appended
+    // to without
+    CPPUNIT_ASSERT_THROW(Mcmc::TextChainWriter writer(text_filename_),
+            std::invalid_argument);
+    std::FILE* text_file = std::fopen(text_filename_.c_str(), "r");
+    char marker[64];
+    CPPUNIT_ASSERT(std::fgets(marker, sizeof(marker), text_file) != nullptr);
+    CPPUNIT_ASSERT(std::string(marker) == "# run-length encoded\n");
+    int i_point = 0;
+    for (int i_record = 0; i_record < num_records; ++i_record) {
+        unsigned char const* record = &binary[header_bytes +
+                i_record * record_bytes];
+        double values[5];
+        for (int i = 0; i < 5; ++i) {
+            values[i] = DecodeDouble(record + i * sizeof(double));
+        }
+        unsigned int multiplicity = values[4];
+        CPPUNIT_ASSERT(multiplicity == values[4]);
+        CPPUNIT_ASSERT(multiplicity > 0);
+
+        for (int i = 0; i < multiplicity; ++i, ++i_point) {
+            CPPUNIT_ASSERT(i_point < points.size());
+            CPPUNIT_ASSERT(values[0] ==
+                    gsl_vector_get(points[i_point]->parameters(), 0));
+            CPPUNIT_ASSERT(values[1] ==
+                    gsl_vector_get(points[i_point]->parameters(), 1));
+            CPPUNIT_ASSERT(values[2] ==
+                    gsl_vector_get(points[i_point]->measurements(), 0));
+            CPPUNIT_ASSERT(values[3] == points[i_point]->likelihood());
+        }
+
+        double text_values[4];
+        unsigned int text_multiplicity;
+        for (int i = 0; i < 4; ++i) {
+            CPPUNIT_ASSERT(std::fscanf(text_file, "%lf", &text_values[i])
+                    == 1);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(values[i], text_values[i],
+                    std::fabs(values[i]) * 1E-8);
+        }
+        CPPUNIT_ASSERT(std::fscanf(text_file, "%u", &text_multiplicity) == 1);
+        CPPUNIT_ASSERT(text_multiplicity == multiplicity);
+    }
+    CPPUNIT_ASSERT(i_point == points.size());
+    double extra;
+    CPPUNIT_ASSERT(std::fscanf(text_file, "%lf", &extra) == EOF);
+    std::fclose(text_file);
+}
+
+void ChainWriterTest::testAsyncWriter() {
+    std::shared_ptr<Mcmc::OutputThread> output_thread =
+            std::make_shared<Mcmc::OutputThread>();
+    CPPUNIT_ASSERT_THROW(Mcmc::AsyncChainWriter writer(
+            std::unique_ptr<Mcmc::ChainWriter>(), output_thread),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(Mcmc::AsyncChainWriter writer(
+            std::unique_ptr<Mcmc::ChainWriter>(
+            new Mcmc::TextChainWriter(text_filename_)), nullptr),
+            std::invalid_argument);
+    std::remove(text_filename_.c_str());
+
+    // The same chain, written directly and in the background, with many
+    // small flushes
+    std::string async_filename = "dummy_chainwriter_async.dat";
+    unsigned int buffer_size = 3;
+    std::vector<std::shared_ptr<Mcmc::Point> > points;
+    for (int i_point = 0; i_point < 1000; ++i_point) {
+        if (i_point % 4 == 1) {
+            points.push_back(points.back());
+        } else {
+            points.push_back(NewPoint(2, 2, 0.01 * i_point));
+        }
+    }
+    {
+        Mcmc::MarkovChain chain(points[0], text_filename_, buffer_size);
+        Mcmc::MarkovChain async_chain(points[0],
+                std::unique_ptr<Mcmc::ChainWriter>(
+                new Mcmc::AsyncChainWriter(std::unique_ptr<Mcmc::ChainWriter>(
+                new Mcmc::TextChainWriter(async_filename)), output_thread)),
+                buffer_size, 0);
+        CPPUNIT_ASSERT(async_chain.filename() == async_filename);
+        for (int i_point = 1; i_point < points.size(); ++i_point) {
+            chain.Append(points[i_point]);
+            async_chain.Append(points[i_point]);
+        }
+
+        // Sync() leaves everything but the last point in the file
+        chain.Flush();
+        async_chain.Sync();
+        CPPUNIT_ASSERT(ReadFile(async_filename) == ReadFile(text_filename_));
+    }
+
+    // The last point is written on destruction as well
+    std::vector<unsigned char> async_contents = ReadFile(async_filename);
+    std::remove(async_filename.c_str());
+    CPPUNIT_ASSERT(async_contents == ReadFile(text_filename_));
+}
+
+void ChainWriterTest::testCompressedRoundTrip() {
+    unsigned int dimension = 3;
+    unsigned int num_measurements = 4;
+    unsigned int buffer_size = 7;
+    std::string compressed_filename = "dummy_chainwriter_compressed.dat";
+
+    std::vector<std::shared_ptr<Mcmc::Point> > points;
+    for (int i_point = 0; i_point < 500; ++i_point) {
+        if (i_point % 3 != 0) {
+            points.push_back(points.back());
+        } else {
+            points.push_back(NewPoint(dimension, num_measurements,
+                    0.01 * i_point));
+        }
+    }
+    unsigned int num_flushes = 0;
+    {
+        Mcmc::MarkovChain binary_chain(points[0],
+                std::unique_ptr<Mcmc::ChainWriter>(
+                new Mcmc::BinaryChainWriter(binary_filename_, dimension,
+                num_measurements, "")), buffer_size, 0);
+        Mcmc::MarkovChain compressed_chain(points[0],
+                std::unique_ptr<Mcmc::ChainWriter>(
+                new Mcmc::CompressedChainWriter(compressed_filename,
+                dimension, num_measurements, "chain = 0", false)),
+                buffer_size, 0);
+        for (int i_point = 1; i_point < points.size(); ++i_point) {
+            binary_chain.Append(points[i_point]);
+            compressed_chain.Append(points[i_point]);
+            if (compressed_chain.num_points_buffered() == 1) {
+                ++num_flushes;
+            }
+        }
+    }
+    ++num_flushes;  // on destruction
+
+    std::vector<unsigned char> binary = ReadFile(binary_filename_);
+    std::vector<unsigned char> compressed = ReadFile(compressed_filename);
+    CPPUNIT_ASSERT(DecodeUint32(&compressed[20]) == 2);
+    CPPUNIT_ASSERT(compressed.size() < binary.size() / 2);
+
+    // Decompressed, the records are the same as without compression
+    std::size_t header_bytes = DecodeUint32(&binary[8]);
+    std::vector<double> expected;
+    for (std::size_t i = header_bytes; i < binary.size(); i += 8) {
+        expected.push_back(DecodeDouble(&binary[i]));
+    }
+    {
+        CPPUNIT_ASSERT_THROW(Mcmc::CompressedChainReader reader(
+                compressed_filename, 0), std::invalid_argument);
+        CPPUNIT_ASSERT_THROW(Mcmc::CompressedChainReader reader(
+                binary_filename_, 2), Mcmc::ChainReadError);
+        CPPUNIT_ASSERT_THROW(Mcmc::CompressedChainReader reader(
+                "dummy_chainwriter_nonexistent.dat", 2), Mcmc::ChainReadError);
+
+        Mcmc::CompressedChainReader reader(compressed_filename, 3);
+        CPPUNIT_ASSERT(reader.dimension() == dimension);
+        CPPUNIT_ASSERT(reader.num_measurements() == num_measurements);
+        CPPUNIT_ASSERT(!reader.run_length_encoded());
+        CPPUNIT_ASSERT(reader.metadata() == "chain = 0");
+        CPPUNIT_ASSERT(reader.record_size() == 8);
+
+        std::vector<double> decompressed;
+        std::vector<double> block;
+        unsigned int num_blocks = 0;
+        while (reader.ReadBlock(block)) {
+            decompressed.insert(decompressed.end(), block.begin(),
+                    block.end());
+            ++num_blocks;
+        }
+        CPPUNIT_ASSERT(num_blocks == num_flushes);
+        CPPUNIT_ASSERT(decompressed == expected);
+        CPPUNIT_ASSERT(!reader.truncated());
+        CPPUNIT_ASSERT(!reader.ReadBlock(block));
+    }
+
+    // A block cut short by a crash only loses that block
+    CPPUNIT_ASSERT(::truncate(compressed_filename.c_str(),
+            compressed.size() - 3) == 0);
+    {
+        Mcmc::CompressedChainReader reader(compressed_filename, 2);
+        std::vector<double> decompressed;
+        std::vector<double> block;
+        unsigned int num_blocks = 0;
+        while (reader.ReadBlock(block)) {
+            decompressed.insert(decompressed.end(), block.begin(),
+                    block.end());
+            ++num_blocks;
+        }
+        CPPUNIT_ASSERT(num_blocks == num_flushes - 1);
+        CPPUNIT_ASSERT(reader.truncated());
+        CPPUNIT_ASSERT(decompressed.size() < expected.size());
+        CPPUNIT_ASSERT(std::equal(decompressed.begin(), decompressed.end(),
+                expected.begin()));
+    }
+    std::remove(compressed_filename.c_str());
+}
+
+void ChainWriterTest::testChainReader() {
+    unsigned int dimension = 2;
+    unsigned int num_measurements = 3;
+    unsigned int buffer_size = 4;
+
+    std::vector<std::shared_ptr<Mcmc::Point> > points;
+    for (int i_point = 0; i_point < 40; ++i_point) {
+        if (i_point % 4 == 1 || i_point % 4 == 2) {
+            points.push_back(points.back());
+        } else {
+            points.push_back(NewPoint(dimension, num_measurements,
+                    0.1 * i_point));
+        }
+    }
+
+    for (int run_length_encoded = 0; run_length_encoded < 2;
+            ++run_length_encoded) {
+        {
+            Mcmc::MarkovChain chain(points[0],
+                    std::unique_ptr<Mcmc::ChainWriter>(
+                    new Mcmc::BinaryChainWriter(binary_filename_, dimension,
+                    num_measurements, "chain = 0", run_length_encoded)),
+                    buffer_size, 0);
+            for (int i_point = 1; i_point < points.size(); ++i_point) {
+                chain.Append(points[i_point]);
+            }
+        }
+
+        std::size_t file_size;
+        {
+            Mcmc::ChainReader reader(binary_filename_);
+            CPPUNIT_ASSERT(reader.filename() == binary_filename_);
+            CPPUNIT_ASSERT(reader.dimension() == dimension);
+            CPPUNIT_ASSERT(reader.num_measurements() == num_measurements);
+            CPPUNIT_ASSERT(reader.run_length_encoded() == run_length_encoded);
+            CPPUNIT_ASSERT(reader.metadata() == "chain = 0");
+            CPPUNIT_ASSERT(!reader.truncated());
+            CPPUNIT_ASSERT(reader.num_steps() == points.size());
+            if (run_length_encoded) {
+                CPPUNIT_ASSERT(reader.num_rows() < points.size());
+            } else {
+                CPPUNIT_ASSERT(reader.num_rows() == points.size());
+            }
+
+            // The rows point right into the mapped records
+            CPPUNIT_ASSERT(reader.row(1).parameters() ==
+                    reader.records() + reader.record_size());
+
+            int i_point = 0;
+            for (std::size_t i_row = 0; i_row < reader.num_rows(); ++i_row) {
+                Mcmc::ChainRow row = reader.row(i_row);
+                CPPUNIT_ASSERT(row.multiplicity() > 0);
+                for (int i_copy = 0; i_copy < row.multiplicity();
+                        ++i_copy, ++i_point) {
+                    Mcmc::Point const& point = *points[i_point];
+                    for (int i = 0; i < dimension; ++i) {
+                        CPPUNIT_ASSERT(row.parameters()[i] ==
+                                gsl_vector_get(point.parameters(), i));
+                    }
+                    for (int i = 0; i < num_measurements; ++i) {
+                        CPPUNIT_ASSERT(row.measurements()[i] ==
+                                gsl_vector_get(point.measurements(), i));
+                    }
+                    CPPUNIT_ASSERT(row.likelihood() == point.likelihood());
+                }
+            }
+            CPPUNIT_ASSERT(i_point == points.size());
+            file_size = ReadFile(binary_filename_).size();
+        }
+
+        // A record cut short is left out
+        CPPUNIT_ASSERT(::truncate(binary_filename_.c_str(),
+                file_size - 5) == 0);
+        {
+            Mcmc::ChainReader reader(binary_filename_);
+            CPPUNIT_ASSERT(reader.truncated());
+            CPPUNIT_ASSERT(reader.num_rows() * reader.record_size() *
+                    sizeof(double) < file_size);
+        }
+        std::remove(binary_filename_.c_str());
+    }
+
+    // Compressed and text files cannot be mapped
+    {
+        Mcmc::CompressedChainWriter writer(binary_filename_, dimension,
+                num_measurements, "", false);
+    }
+    CPPUNIT_ASSERT_THROW(Mcmc::ChainReader reader(binary_filename_),
+            Mcmc::ChainReadError);
+    {
+        Mcmc::MarkovChain chain(points[0], text_filename_, buffer_size);
+    }
+    CPPUNIT_ASSERT_THROW(Mcmc::ChainReader reader(text_filename_),
+            Mcmc::ChainReadError);
+    CPPUNIT_ASSERT_THROW(Mcmc::ChainReader reader(
+            "dummy_chainwriter_nonexistent.dat"), Mcmc::ChainReadError);
+}
@@ -0,0 +1,48 @@
+/*
+ * File:   ChainWriterTest.h
+ * Author: donerkebab
+ *
+ * Created on Apr 29, 2014, 7:14:05 PM
+ */
+
+#ifndef MCMC_CHAINWRITERTEST_H
+#define	MCMC_CHAINWRITERTEST_H
+
+#include <string>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class ChainWriterTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(ChainWriterTest);
+
+    CPPUNIT_TEST(testBinaryHeader);
+    CPPUNIT_TEST(testRoundTrip);
+    CPPUNIT_TEST(testBinaryMismatchedPoint);
+    CPPUNIT_TEST(testRunLengthEncoding);
+    CPPUNIT_TEST(testAsyncWriter);
+    CPPUNIT_TEST(testCompressedRoundTrip);
+    CPPUNIT_TEST(testChainReader);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    ChainWriterTest();
+    virtual ~ChainWriterTest();
+    void setUp();
+    void tearDown();
+
+private:
+    void testBinaryHeader();
+    void testRoundTrip();
+    void testBinaryMismatchedPoint();
+    void testRunLengthEncoding();
+    void testAsyncWriter();
+    void testCompressedRoundTrip();
+    void testChainReader();
+
+    std::string const text_filename_;
+    std::string const binary_filename_;
+};
+
+#endif	/* MCMC_CHAINWRITERTEST_H */
+
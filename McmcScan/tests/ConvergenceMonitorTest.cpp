@@ -0,0 +1,128 @@
+/*
+ * File:   ConvergenceMonitorTest.cpp
+ * Author: donerkebab
+ *
+ * Created on May 3, 2014, 3:25:11 PM
+ */
+
+#include "ConvergenceMonitorTest.h"
+
+#include <cmath>
+
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+#include "../ConvergenceMonitor.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ConvergenceMonitorTest);
+
+ConvergenceMonitorTest::ConvergenceMonitorTest()
+: d_(1E-12) {
+}
+
+ConvergenceMonitorTest::~ConvergenceMonitorTest() {
+}
+
+void ConvergenceMonitorTest::setUp() {
+}
+
+void ConvergenceMonitorTest::tearDown() {
+}
+
+void ConvergenceMonitorTest::testInitialization() {
+    CPPUNIT_ASSERT_THROW(Mcmc::ConvergenceMonitor monitor(1, 2),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(Mcmc::ConvergenceMonitor monitor(2, 0),
+            std::invalid_argument);
+
+    Mcmc::ConvergenceMonitor monitor(3, 2);
+    CPPUNIT_ASSERT(monitor.num_chains() == 3);
+    CPPUNIT_ASSERT(monitor.dimension() == 2);
+    CPPUNIT_ASSERT(monitor.num_points(2) == 0);
+    CPPUNIT_ASSERT(!monitor.ready());
+    std::vector<double> r_hats;
+    CPPUNIT_ASSERT_THROW(monitor.ComputeRHats(r_hats), std::logic_error);
+
+    gsl_vector* parameters = gsl_vector_calloc(2);
+    CPPUNIT_ASSERT_THROW(monitor.Add(3, parameters), std::invalid_argument);
+    gsl_vector* wrong_parameters = gsl_vector_calloc(3);
+    CPPUNIT_ASSERT_THROW(monitor.Add(0, wrong_parameters),
+            std::invalid_argument);
+    gsl_vector_free(wrong_parameters);
+
+    for (int i_chain = 0; i_chain < 3; ++i_chain) {
+        monitor.Add(i_chain, parameters);
+        CPPUNIT_ASSERT(!monitor.ready());
+        monitor.Add(i_chain, parameters);
+    }
+    CPPUNIT_ASSERT(monitor.ready());
+    CPPUNIT_ASSERT(monitor.num_points(2) == 2);
+
+    // No spread within the chains at all
+    CPPUNIT_ASSERT(monitor.ComputeRHats(r_hats) ==
+            std::numeric_limits<double>::infinity());
+    gsl_vector_free(parameters);
+}
+
+void ConvergenceMonitorTest::testRHat() {
+    // Parameter 0 is shifted between the chains, parameter 1 is not
+    double values[2][3][2] = {
+        {{1.0, 1.0}, {2.0, 2.0}, {3.0, 3.0}},
+        {{3.0, 1.0}, {4.0, 2.0}, {5.0, 3.0}}
+    };
+    Mcmc::ConvergenceMonitor monitor(2, 2);
+    for (int i_point = 0; i_point < 3; ++i_point) {
+        for (int i_chain = 0; i_chain < 2; ++i_chain) {
+            gsl_vector_view parameters = gsl_vector_view_array(
+                    values[i_chain][i_point], 2);
+            monitor.Add(i_chain, &parameters.vector);
+        }
+    }
+
+    // W = 1, n = 3, B/n = 2 and 0
+    std::vector<double> r_hats;
+    double max_r_hat = monitor.ComputeRHats(r_hats);
+    CPPUNIT_ASSERT(r_hats.size() == 2);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(std::sqrt(2.0 / 3.0 + 2.0), r_hats[0], d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(std::sqrt(2.0 / 3.0), r_hats[1], d_);
+    CPPUNIT_ASSERT(max_r_hat == r_hats[0]);
+}
+
+void ConvergenceMonitorTest::testRunningMoments() {
+    // Large offsets with small spreads, where the textbook formula for the
+    // variance loses all of its digits.  Both chains have the same spread,
+    // and means that differ by 0.1.
+    Mcmc::ConvergenceMonitor monitor(2, 1);
+    gsl_vector* parameters = gsl_vector_alloc(1);
+    unsigned int num_points = 1000;
+    for (unsigned int i_point = 0; i_point < num_points; ++i_point) {
+        double x = 1.0E9 + std::sin(0.1 * i_point);
+        gsl_vector_set(parameters, 0, x);
+        monitor.Add(0, parameters);
+        gsl_vector_set(parameters, 0, x + 0.1);
+        monitor.Add(1, parameters);
+    }
+    gsl_vector_free(parameters);
+
+    double mean = 0.0;
+    for (unsigned int i_point = 0; i_point < num_points; ++i_point) {
+        mean += std::sin(0.1 * i_point);
+    }
+    mean /= num_points;
+    double variance = 0.0;
+    for (unsigned int i_point = 0; i_point < num_points; ++i_point) {
+        variance += std::pow(std::sin(0.1 * i_point) - mean, 2);
+    }
+    variance /= num_points - 1;
+
+    double n = num_points;
+    double expected = std::sqrt(((n - 1.0) / n * variance + 0.005) /
+            variance);
+    std::vector<double> r_hats;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, monitor.ComputeRHats(r_hats),
+            1E-6);
+}
+
@@ -0,0 +1,37 @@
+/*
+ * File:   ConvergenceMonitorTest.h
+ * Author: donerkebab
+ *
+ * Created on May 3, 2014, 3:25:10 PM
+ */
+
+#ifndef MCMC_CONVERGENCEMONITORTEST_H
+#define	MCMC_CONVERGENCEMONITORTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class ConvergenceMonitorTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(ConvergenceMonitorTest);
+
+    CPPUNIT_TEST(testInitialization);
+    CPPUNIT_TEST(testRHat);
+    CPPUNIT_TEST(testRunningMoments);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    ConvergenceMonitorTest();
+    virtual ~ConvergenceMonitorTest();
+    void setUp();
+    void tearDown();
+
+private:
+    void testInitialization();
+    void testRHat();
+    void testRunningMoments();
+
+    double const d_;  // delta for CPPUNIT_ASSERT_DOUBLES_EQUAL
+};
+
+#endif	/* MCMC_CONVERGENCEMONITORTEST_H */
+
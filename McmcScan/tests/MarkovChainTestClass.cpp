@@ -12,11 +12,49 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
+#include "../BinaryChainWriter.h"
+#include "../ChainFlushError.h"
+#include "../ChainReader.h"
+#include "../ChainWriter.h"
 #include "../Point.h"
 #include "../MarkovChain.h"
+#include "../PosteriorAccumulator.h"
 
 
+namespace { // unnamed namespace
+    // Keeps the runs it is given, or fails while fail is set
+    class RecordingChainWriter : public Mcmc::ChainWriter {
+    public:
+        RecordingChainWriter(
+                std::vector<std::shared_ptr<Mcmc::Point> >& points,
+                std::vector<unsigned int>& multiplicities,
+                bool const& fail)
+        : Mcmc::ChainWriter("recorded", true),
+        points_(points),
+        multiplicities_(multiplicities),
+        fail_(fail) {
+        }
+
+        void Write(std::shared_ptr<Mcmc::Point> const* points,
+                unsigned int const* multiplicities,
+                unsigned int num_runs) {
+            if (fail_) {
+                throw Mcmc::ChainFlushError();
+            }
+            points_.insert(points_.end(), points, points + num_runs);
+            multiplicities_.insert(multiplicities_.end(), multiplicities,
+                    multiplicities + num_runs);
+        }
+
+    private:
+        std::vector<std::shared_ptr<Mcmc::Point> >& points_;
+        std::vector<unsigned int>& multiplicities_;
+        bool const& fail_;
+    };
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(MarkovChainTestClass);
 
 MarkovChainTestClass::MarkovChainTestClass()
@@ -158,6 +196,172 @@ void MarkovChainTestClass::testChainFill() {
     CPPUNIT_ASSERT(chain.last_point() == point4);
 }
 
+void MarkovChainTestClass::testAccumulator() {
+    // Points at 0, 1, 2, ... with runs of 1, 2, 3, ... copies
+    std::vector<std::shared_ptr<Mcmc::Point> > points;
+    gsl_vector* params = gsl_vector_calloc(1);
+    gsl_vector* meas = gsl_vector_calloc(1);
+    for (int i_run = 0; i_run < 6; ++i_run) {
+        gsl_vector_set(params, 0, i_run);
+        std::shared_ptr<Mcmc::Point> point(
+                new Mcmc::Point(params, meas, 0.5));
+        for (int i = 0; i <= i_run; ++i) {
+            points.push_back(point);
+        }
+    }
+    gsl_vector_free(params);
+    gsl_vector_free(meas);
+
+    std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator(
+            new Mcmc::PosteriorAccumulator(1, 1));
+    accumulator->AddHistogram1D(0, 0.0, 6.0, 6);
+    {
+        Mcmc::MarkovChain chain(points[0], dummy_output_filename_, 4);
+
+        // Only what is appended from now on counts, i.e. not the first point
+        chain.SetAccumulator(accumulator);
+        for (int i_point = 1; i_point < points.size(); ++i_point) {
+            chain.Append(points[i_point]);
+        }
+
+        // The last run is still going on
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(points.size() - 1 - 6,
+                accumulator->total_weight(), d_);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, accumulator->histogram1d_bin(0, 0),
+                d_);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0, accumulator->histogram1d_bin(0, 1),
+                d_);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, accumulator->histogram1d_bin(0, 4),
+                d_);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, accumulator->histogram1d_bin(0, 5),
+                d_);
+    }
+
+    // and is added when the chain is destroyed
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(points.size() - 1,
+            accumulator->total_weight(), d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(6.0, accumulator->histogram1d_bin(0, 5), d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(70.0 / 20.0, accumulator->mean(0), d_);
+}
+
+void MarkovChainTestClass::testOutputPolicy() {
+    // Runs of 1, 2, 3, ... copies of the points at 0, 1, 2, ...
+    std::vector<std::shared_ptr<Mcmc::Point> > points;
+    gsl_vector* params = gsl_vector_calloc(1);
+    gsl_vector* meas = gsl_vector_calloc(1);
+    for (int i_run = 0; i_run < 8; ++i_run) {
+        gsl_vector_set(params, 0, i_run);
+        std::shared_ptr<Mcmc::Point> point(
+                new Mcmc::Point(params, meas, 0.5));
+        for (int i = 0; i <= i_run; ++i) {
+            points.push_back(point);
+        }
+    }
+    gsl_vector_free(params);
+    gsl_vector_free(meas);
 
+    // Write nothing up to position 9, and every third point from 10 on
+    unsigned int first_written = 10;
+    unsigned int thinning = 3;
+    {
+        Mcmc::MarkovChain chain(points[0],
+                std::unique_ptr<Mcmc::ChainWriter>(
+                new Mcmc::BinaryChainWriter(dummy_output_filename_, 1, 1, "",
+                true)), 64, 0);
+        CPPUNIT_ASSERT(chain.first_written() == 0);
+        CPPUNIT_ASSERT(chain.thinning() == 1);
+        CPPUNIT_ASSERT_THROW(chain.SetOutputPolicy(0, 0),
+                std::invalid_argument);
 
+        chain.SetOutputPolicy(Mcmc::MarkovChain::kNeverWritten, 1);
+        for (int i_point = 1; i_point < first_written; ++i_point) {
+            chain.Append(points[i_point]);
+        }
+        chain.SetOutputPolicy(chain.length(), thinning);
+        CPPUNIT_ASSERT(chain.first_written() == first_written);
+        for (int i_point = first_written; i_point < points.size();
+                ++i_point) {
+            chain.Append(points[i_point]);
+        }
 
+        chain.Flush();
+        CPPUNIT_ASSERT(chain.num_points_flushed() == points.size() - 1);
+        CPPUNIT_ASSERT(chain.num_points_written() ==
+                (points.size() - 2 - first_written) / thinning + 1);
+    }
+
+    // The runs come out with the number of their copies that were kept
+    Mcmc::ChainReader reader(dummy_output_filename_);
+    std::vector<int> positions;
+    for (int i_point = first_written; i_point < points.size();
+            i_point += thinning) {
+        positions.push_back(i_point);
+    }
+    CPPUNIT_ASSERT(reader.num_steps() == positions.size());
+    std::size_t i_position = 0;
+    for (std::size_t i_row = 0; i_row < reader.num_rows(); ++i_row) {
+        Mcmc::ChainRow row = reader.row(i_row);
+        for (unsigned int i = 0; i < row.multiplicity(); ++i, ++i_position) {
+            CPPUNIT_ASSERT(row.parameters()[0] == gsl_vector_get(
+                    points[positions[i_position]]->parameters(), 0));
+        }
+    }
+    CPPUNIT_ASSERT(i_position == positions.size());
+    CPPUNIT_ASSERT(reader.num_rows() < positions.size());
+}
+
+void MarkovChainTestClass::testFailedFlush() {
+    gsl_vector* params = gsl_vector_calloc(1);
+    gsl_vector* meas = gsl_vector_calloc(1);
+    std::shared_ptr<Mcmc::Point> points[3];
+    for (int i = 0; i < 3; ++i) {
+        gsl_vector_set(params, 0, i);
+        points[i].reset(new Mcmc::Point(params, meas, 0.5));
+    }
+    gsl_vector_free(params);
+    gsl_vector_free(meas);
+
+    std::vector<std::shared_ptr<Mcmc::Point> > written_points;
+    std::vector<unsigned int> multiplicities;
+    bool fail = false;
+    {
+        unsigned int buffer_size = 4;
+        Mcmc::MarkovChain chain(points[0],
+                std::unique_ptr<Mcmc::ChainWriter>(new RecordingChainWriter(
+                written_points, multiplicities, fail)), buffer_size, 0);
+        chain.Append(points[0]);
+        chain.Append(points[0]);
+
+        // The buffer keeps everything while the writer fails, even past the
+        // buffer size
+        fail = true;
+        CPPUNIT_ASSERT_THROW(chain.Append(points[1]), Mcmc::ChainFlushError);
+        CPPUNIT_ASSERT_THROW(chain.Append(points[1]), Mcmc::ChainFlushError);
+        CPPUNIT_ASSERT_THROW(chain.Flush(), Mcmc::ChainFlushError);
+        CPPUNIT_ASSERT(chain.num_points_buffered() == buffer_size + 1);
+        CPPUNIT_ASSERT(chain.num_points_flushed() == 0);
+        CPPUNIT_ASSERT(written_points.empty());
+
+        // All but the last copy of the last point go out at once
+        fail = false;
+        chain.Flush();
+        CPPUNIT_ASSERT(chain.num_points_buffered() == 1);
+        CPPUNIT_ASSERT(chain.num_points_flushed() == buffer_size);
+        CPPUNIT_ASSERT(chain.last_point() == points[1]);
+        CPPUNIT_ASSERT(written_points.size() == 2);
+        CPPUNIT_ASSERT(written_points[0] == points[0]);
+        CPPUNIT_ASSERT(multiplicities[0] == 3);
+        CPPUNIT_ASSERT(written_points[1] == points[1]);
+        CPPUNIT_ASSERT(multiplicities[1] == 1);
+
+        chain.Append(points[1]);
+        chain.Append(points[2]);
+    }
+
+    // The destructor writes the rest, with the kept copy back in its run
+    CPPUNIT_ASSERT(written_points.size() == 4);
+    CPPUNIT_ASSERT(written_points[2] == points[1]);
+    CPPUNIT_ASSERT(multiplicities[2] == 2);
+    CPPUNIT_ASSERT(written_points[3] == points[2]);
+    CPPUNIT_ASSERT(multiplicities[3] == 1);
+}
@@ -17,6 +17,9 @@ class MarkovChainTestClass : public CPPUNIT_NS::TestFixture {
 
     CPPUNIT_TEST(testChainInitFails);
     CPPUNIT_TEST(testChainFill);
+    CPPUNIT_TEST(testAccumulator);
+    CPPUNIT_TEST(testOutputPolicy);
+    CPPUNIT_TEST(testFailedFlush);
     
     CPPUNIT_TEST_SUITE_END();
 
@@ -29,6 +32,9 @@ public:
 private:
     void testChainInitFails();
     void testChainFill();
+    void testAccumulator();
+    void testOutputPolicy();
+    void testFailedFlush();
 
     std::string const dummy_output_filename_;
     double const d_;  // delta for CPPUNIT_ASSERT_DOUBLES_EQUAL
@@ -0,0 +1,1401 @@
+/*
+ * File:   McmcScanTest.cpp
+ * Author: donerkebab
+ *
+ * Created on Apr 24, 2014, 10:12:30 PM
+ */
+
+#include "McmcScanTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_vector.h>
+
+#include "../AutocorrelationMonitor.h"
+#include "../ChainReader.h"
+#include "../CheckpointError.h"
+#include "../CoordinatorError.h"
+#include "../AdaptiveGaussianProposal.h"
+#include "../FixedDimensionGaussianProposal.h"
+#include "../McmcScan.h"
+#include "../PosteriorAccumulator.h"
+#include "../ScanCoordinator.h"
+#include "../ScanWorkspace.h"
+
+namespace { // unnamed namespace
+    // Allocation counting.  malloc() and friends are replaced for the whole
+    // test program, and forward to glibc's own implementations.  operator new
+    // goes through malloc() as well.
+    bool counting_allocations = false;
+    unsigned long num_allocations = 0;
+
+    std::string ReadFile(std::string const& filename) {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    /*
+     * Unit Gaussian in every direction, with a single dummy measurement.
+     */
+    class GaussianTestScan : public Mcmc::McmcScan {
+    public:
+        GaussianTestScan(unsigned int dimension, unsigned int num_chains,
+                unsigned int max_steps = 10000, double burn_fraction = 0.1)
+        : Mcmc::McmcScan(dimension, num_chains, max_steps, burn_fraction) {
+        }
+
+        static double Likelihood(gsl_vector const* parameters) {
+            return std::exp(-0.5 * std::pow(gsl_blas_dnrm2(parameters), 2));
+        }
+
+    private:
+        bool IsValidParameters(gsl_vector const* parameters) {
+            return true;
+        }
+
+        void MeasurePoint(gsl_vector const* parameters,
+                gsl_vector*& measurements,
+                double& likelihood) {
+            measurements = gsl_vector_calloc(1);
+            likelihood = Likelihood(parameters);
+        }
+    };
+
+    /*
+     * Proposal policy for a plain random walk Metropolis algorithm, with a
+     * fixed Gaussian step in every direction.  Counts its calls.
+     */
+    class RandomWalkProposal {
+    public:
+        explicit RandomWalkProposal(double step_size)
+        : step_size(step_size), num_proposals(0), num_updates(0) {
+        }
+
+        void Propose(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_rng* rng,
+                gsl_vector* trial_parameters) {
+            for (int i = 0; i < trial_parameters->size; ++i) {
+                gsl_vector_set(trial_parameters, i,
+                        gsl_vector_get(last_parameters, i) +
+                        gsl_ran_gaussian(rng, step_size));
+            }
+            ++num_proposals;
+        }
+
+        double LogHastingsRatio(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_vector const* trial_parameters) {
+            return 0.0;
+        }
+
+        void UpdateState(unsigned int i_chain,
+                gsl_vector const* last_parameters,
+                gsl_vector const* trial_parameters) {
+            ++num_updates;
+        }
+
+        double const step_size;
+        unsigned int num_proposals;
+        unsigned int num_updates;
+    };
+
+    /*
+     * Gaussian in two badly scaled and strongly correlated parameters, with
+     * standard deviations kScale0 and kScale1 and correlation kCorrelation.
+     */
+    class CorrelatedTestScan : public Mcmc::McmcScan {
+    public:
+        CorrelatedTestScan(unsigned int num_chains, unsigned int max_steps)
+        : Mcmc::McmcScan(2, num_chains, max_steps, 0.1) {
+        }
+
+        static double const kScale0;
+        static double const kScale1;
+        static double const kCorrelation;
+
+    private:
+        bool IsValidParameters(gsl_vector const* parameters) {
+            return true;
+        }
+
+        void MeasurePoint(gsl_vector const* parameters,
+                gsl_vector*& measurements,
+                double& likelihood) {
+            double u = gsl_vector_get(parameters, 0) / kScale0;
+            double v = gsl_vector_get(parameters, 1) / kScale1;
+            measurements = gsl_vector_calloc(1);
+            likelihood = std::exp(-0.5 * (u * u - 2.0 * kCorrelation * u * v
+                    + v * v) / (1.0 - kCorrelation * kCorrelation));
+        }
+    };
+
+    double const CorrelatedTestScan::kScale0 = 100.0;
+    double const CorrelatedTestScan::kScale1 = 0.1;
+    double const CorrelatedTestScan::kCorrelation = 0.9;
+
+    /*
+     * Two narrow Gaussian modes at (-4, 0, ...) and (4, 0, ...), too far 
+     * apart for the chains to cross at lambda = 1.
+     */
+    class BimodalTestScan : public Mcmc::McmcScan {
+    public:
+        BimodalTestScan(unsigned int dimension, unsigned int num_chains,
+                unsigned int max_steps)
+        : Mcmc::McmcScan(dimension, num_chains, max_steps, 0.1) {
+        }
+
+    private:
+        bool IsValidParameters(gsl_vector const* parameters) {
+            return true;
+        }
+
+        void MeasurePoint(gsl_vector const* parameters,
+                gsl_vector*& measurements,
+                double& likelihood) {
+            double sigma = 0.5;
+            double distance_squared = 0.0;
+            for (int i = 1; i < parameters->size; ++i) {
+                distance_squared += std::pow(gsl_vector_get(parameters, i), 2);
+            }
+            double x = gsl_vector_get(parameters, 0);
+            measurements = gsl_vector_calloc(1);
+            likelihood = std::exp(-0.5 * distance_squared / sigma / sigma) *
+                    (std::exp(-0.5 * std::pow((x - 4.0) / sigma, 2)) +
+                    std::exp(-0.5 * std::pow((x + 4.0) / sigma, 2)));
+        }
+    };
+
+    /*
+     * Flat likelihood on the unit box, so that the chains spend much of 
+     * their time near its faces.
+     */
+    class BoxTestScan : public Mcmc::McmcScan {
+    public:
+        BoxTestScan(unsigned int dimension, unsigned int num_chains,
+                unsigned int max_steps)
+        : Mcmc::McmcScan(dimension, num_chains, max_steps, 0.1) {
+        }
+
+    private:
+        bool IsValidParameters(gsl_vector const* parameters) {
+            for (int i = 0; i < parameters->size; ++i) {
+                double x = gsl_vector_get(parameters, i);
+                if (x < 0.0 || x > 1.0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void MeasurePoint(gsl_vector const* parameters,
+                gsl_vector*& measurements,
+                double& likelihood) {
+            measurements = gsl_vector_calloc(1);
+            likelihood = 1.0;
+        }
+    };
+}
+
+#ifdef __GLIBC__
+extern "C" {
+    void* __libc_malloc(std::size_t size);
+    void* __libc_calloc(std::size_t num, std::size_t size);
+    void* __libc_realloc(void* ptr, std::size_t size);
+
+    void* malloc(std::size_t size) {
+        if (counting_allocations) {
+            ++num_allocations;
+        }
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t num, std::size_t size) {
+        if (counting_allocations) {
+            ++num_allocations;
+        }
+        return __libc_calloc(num, size);
+    }
+
+    void* realloc(void* ptr, std::size_t size) {
+        if (counting_allocations) {
+            ++num_allocations;
+        }
+        return __libc_realloc(ptr, size);
+    }
+}
+#endif
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(McmcScanTest);
+
+McmcScanTest::McmcScanTest()
+: d_(1E-8) {
+}
+
+McmcScanTest::~McmcScanTest() {
+}
+
+void McmcScanTest::setUp() {
+    dummy_output_filenames_.clear();
+}
+
+void McmcScanTest::tearDown() {
+    for (int i = 0; i < dummy_output_filenames_.size(); ++i) {
+        std::remove(dummy_output_filenames_[i].c_str());
+    }
+}
+
+void McmcScanTest::testStepLoopDoesNotAllocate() {
+    unsigned int dimension = 3;
+    unsigned int num_chains = 8;
+    GaussianTestScan scan(dimension, num_chains);
+
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(seed, i, std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+    scan.Initialize(10, chains_info);
+
+    // Play the part of Run() for chain 0 only, leaving out the measurement
+    // and the chain's output, which are allowed to allocate.  Start past the
+    // burn-in period so that both branches get plenty of exercise.
+    scan.num_steps_ = 5000;
+    gsl_vector* last_parameters = gsl_vector_alloc(dimension);
+    gsl_vector_memcpy(last_parameters, chains_info[0].first);
+    double last_likelihood = GaussianTestScan::Likelihood(last_parameters);
+    gsl_vector* trial_parameters = scan.workspace_->trial_parameters;
+    Mcmc::AdaptiveGaussianProposal& proposal = *scan.gaussian_proposal_;
+    unsigned int num_accepted = 0;
+    unsigned int num_steps = 5000;
+
+    // Only count in the steady state, after a few warm-up steps, so that any
+    // one-time lazy setup inside the libraries is not counted
+    unsigned int num_warmup_steps = 10;
+    for (int i_step = 0; i_step < num_steps; ++i_step) {
+        if (i_step == num_warmup_steps) {
+            num_allocations = 0;
+            counting_allocations = true;
+        }
+        proposal.Propose(0, last_parameters, scan.rng_, trial_parameters);
+        double trial_likelihood = GaussianTestScan::Likelihood(
+                trial_parameters);
+        double log_hastings_ratio = proposal.LogHastingsRatio(0,
+                last_parameters, trial_parameters);
+        if (scan.MetropolisHastingsTest(last_likelihood, trial_likelihood,
+                log_hastings_ratio)) {
+            proposal.UpdateState(0, last_parameters, trial_parameters);
+            gsl_vector_memcpy(last_parameters, trial_parameters);
+            last_likelihood = trial_likelihood;
+            ++num_accepted;
+        }
+    }
+    counting_allocations = false;
+
+#ifdef __GLIBC__
+    CPPUNIT_ASSERT(num_allocations == 0);
+#endif
+
+    // Enough accepted steps to go through a full refactorization of the
+    // Cholesky decomposition, and enough rejected ones as well
+    CPPUNIT_ASSERT(num_accepted > 1000);
+    CPPUNIT_ASSERT(num_accepted < num_steps);
+
+    // The swapped buffers should still describe the chains' last points
+    for (int i = 0; i < dimension; ++i) {
+        double mean = gsl_vector_get(last_parameters, i);
+        for (int i_chain = 1; i_chain < num_chains; ++i_chain) {
+            mean += gsl_vector_get(chains_info[i_chain].first, i);
+        }
+        mean /= num_chains;
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(mean,
+                gsl_vector_get(proposal.mean_, i), d_);
+    }
+
+    // C * C^-1 = I
+    gsl_matrix* identity = gsl_matrix_alloc(dimension, dimension);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0,
+            proposal.covariance_, proposal.covariance_inv_, 0.0, identity);
+    for (int i = 0; i < dimension; ++i) {
+        for (int j = 0; j < dimension; ++j) {
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(i == j ? 1.0 : 0.0,
+                    gsl_matrix_get(identity, i, j), 1E-6);
+        }
+    }
+
+    // The log determinant matches a fresh factorization
+    gsl_matrix_memcpy(identity, proposal.covariance_);
+    gsl_linalg_cholesky_decomp(identity);
+    double logdet = 0.0;
+    for (int i = 0; i < dimension; ++i) {
+        logdet += 2.0 * std::log(gsl_matrix_get(identity, i, i));
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(logdet, proposal.covariance_logdet_, 1E-9);
+
+    gsl_matrix_free(identity);
+    gsl_vector_free(last_parameters);
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
+
+void McmcScanTest::testStepAllocations() {
+    unsigned int dimension = 3;
+    unsigned int num_chains = 8;
+    GaussianTestScan scan(dimension, num_chains);
+
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(seed, i, std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+    scan.Initialize(10, chains_info);
+
+    // What MeasurePoint() allocates for one point's measurements
+    num_allocations = 0;
+    counting_allocations = true;
+    gsl_vector* measurements = gsl_vector_calloc(1);
+    gsl_vector_free(measurements);
+    counting_allocations = false;
+    unsigned long allocations_per_measurement = num_allocations;
+
+    // The whole step, output and all, past the burn-in and its one-time
+    // setup.  The only allocations left are MeasurePoint()'s, and those of 
+    // the point pool when the chains hold more Points at once than ever 
+    // before: a slot and a reference count for each new slot, and maybe 
+    // larger free lists.
+    Mcmc::AdaptiveGaussianProposal proposal(scan);
+    unsigned int num_steps = 5000;
+    unsigned int num_warmup_steps = 2000;
+    unsigned int num_slots = 0;
+    for (int i_step = 0; i_step < num_steps; ++i_step) {
+        if (i_step == num_warmup_steps) {
+            num_slots = scan.point_pool_->num_slots();
+            num_allocations = 0;
+            counting_allocations = true;
+        }
+        scan.Step(proposal);
+    }
+    counting_allocations = false;
+    unsigned long num_new_slots = scan.point_pool_->num_slots() - num_slots;
+
+#ifdef __GLIBC__
+    unsigned long num_measurement_allocations = (num_steps -
+            num_warmup_steps) * allocations_per_measurement;
+    CPPUNIT_ASSERT(num_allocations >= num_measurement_allocations +
+            2 * num_new_slots);
+    CPPUNIT_ASSERT(num_allocations <= num_measurement_allocations +
+            4 * num_new_slots);
+#endif
+
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
+
+void McmcScanTest::testModeConflicts() {
+    GaussianTestScan scan(2, 4);
+    scan.EnableDelayedAcceptance();
+    CPPUNIT_ASSERT_THROW(scan.EnableDelayedAcceptance(), std::logic_error);
+    CPPUNIT_ASSERT_THROW(scan.EnableSweepMode(2), std::logic_error);
+
+    GaussianTestScan other_scan(2, 4);
+    other_scan.EnableSweepMode(2);
+    CPPUNIT_ASSERT_THROW(other_scan.EnableDelayedAcceptance(),
+            std::logic_error);
+}
+
+void McmcScanTest::testSweepMode() {
+    unsigned int dimension = 2;
+    unsigned int num_chains = 8;
+    unsigned int max_steps = 40000;
+
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(seed, i, std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+
+    std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator(
+            new Mcmc::PosteriorAccumulator(dimension, 1));
+    std::string summary_filename = "dummy_mcmcscan_summary.dat";
+    dummy_output_filenames_.push_back(summary_filename);
+
+    GaussianTestScan scan(dimension, num_chains, max_steps);
+    scan.EnableSweepMode(2);
+    scan.UsePosteriorAccumulator(accumulator, summary_filename);
+    scan.Initialize(10, chains_info);
+    scan.Run();
+    CPPUNIT_ASSERT_EQUAL(max_steps, scan.num_steps_);
+
+    // Unit Gaussian, up to Monte Carlo error
+    for (int i = 0; i < dimension; ++i) {
+        CPPUNIT_ASSERT(std::fabs(accumulator->mean(i)) < 0.2);
+        CPPUNIT_ASSERT(std::fabs(accumulator->covariance(i, i) - 1.0) < 0.25);
+    }
+    CPPUNIT_ASSERT(std::fabs(accumulator->covariance(0, 1)) < 0.2);
+
+    // The current statistics, not the snapshot's, follow the chains
+    for (int i = 0; i < dimension; ++i) {
+        double mean = 0.0;
+        for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            mean += gsl_vector_get(scan.last_parameters(i_chain), i) /
+                    num_chains;
+        }
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(mean,
+                gsl_vector_get(scan.last_points_mean(), i), 1E-9);
+    }
+
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
+
+void McmcScanTest::testPartialSweep() {
+    unsigned int dimension = 2;
+    unsigned int num_chains = 4;
+
+    // Two full sweeps and one step of a third, which should not always go
+    // to the same chain
+    std::set<int> chains_stepped;
+    for (int i_scan = 0; i_scan < 20; ++i_scan) {
+        std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+        for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            gsl_vector* seed = gsl_vector_alloc(dimension);
+            for (int i = 0; i < dimension; ++i) {
+                gsl_vector_set(seed, i, std::cos(1.0 + i_chain * (i + 1.0)));
+            }
+            char filename[64];
+            std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+            dummy_output_filenames_.push_back(filename);
+            chains_info.push_back(std::make_pair(seed, std::string(filename)));
+        }
+
+        // Scans made in the same second would share a seed
+        GaussianTestScan scan(dimension, num_chains, 2 * num_chains + 1);
+        gsl_rng_set(scan.rng_, i_scan + 1);
+        scan.EnableSweepMode(2);
+        scan.Initialize(10, chains_info);
+        scan.Run();
+
+        unsigned int shortest = scan.chains_[0]->length();
+        for (int i_chain = 1; i_chain < num_chains; ++i_chain) {
+            shortest = std::min(shortest, scan.chains_[i_chain]->length());
+        }
+        int num_longer = 0;
+        for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            if (scan.chains_[i_chain]->length() > shortest) {
+                chains_stepped.insert(i_chain);
+                ++num_longer;
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(1, num_longer);
+
+        for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            gsl_vector_free(chains_info[i_chain].first);
+        }
+    }
+    CPPUNIT_ASSERT(chains_stepped.size() > 1);
+}
+
+void McmcScanTest::testCheckpointResume() {
+    unsigned int dimension = 2;
+    unsigned int num_chains = 4;
+    std::string checkpoint_filename = "dummy_mcmcscan_checkpoint.dat";
+    dummy_output_filenames_.push_back(checkpoint_filename);
+    std::string log_filename = "dummy_mcmcscan_rhat.dat";
+    dummy_output_filenames_.push_back(log_filename);
+
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(seed, i, std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+
+    // Uninterrupted run, which leaves a checkpoint behind at step 2000
+    double uninterrupted_r_hat;
+    unsigned long uninterrupted_num_points;
+    {
+        GaussianTestScan scan(dimension, num_chains, 3000);
+        CPPUNIT_ASSERT_THROW(scan.EnableCheckpoints("", 2000),
+                std::invalid_argument);
+        CPPUNIT_ASSERT_THROW(scan.EnableCheckpoints(checkpoint_filename, 0),
+                std::invalid_argument);
+        scan.EnableCheckpoints(checkpoint_filename, 2000);
+        scan.EnableConvergenceMonitor(log_filename, 500);
+        scan.Initialize(10, chains_info);
+        scan.Run();
+        uninterrupted_r_hat = scan.last_max_r_hat_;
+        uninterrupted_num_points = scan.autocorrelation_monitor().num_points(0);
+    }
+    std::vector<std::string> uninterrupted_chains;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        uninterrupted_chains.push_back(ReadFile(chains_info[i_chain].second));
+        CPPUNIT_ASSERT(uninterrupted_chains[i_chain].size() > 0);
+    }
+
+    // Resuming cuts the chain files back, and then ends up in the same place,
+    // also when the output is written in the background
+    {
+        GaussianTestScan scan(dimension, num_chains, 3000);
+        scan.EnableBackgroundOutput();
+        scan.EnableConvergenceMonitor(log_filename, 500);
+        scan.ResumeFromCheckpoint(checkpoint_filename);
+        CPPUNIT_ASSERT(scan.num_steps_ == 2000);
+        CPPUNIT_ASSERT_THROW(scan.Initialize(10, chains_info),
+                std::logic_error);
+        CPPUNIT_ASSERT_THROW(scan.ResumeFromCheckpoint(checkpoint_filename),
+                std::logic_error);
+        for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            CPPUNIT_ASSERT(ReadFile(chains_info[i_chain].second).size() <
+                    uninterrupted_chains[i_chain].size());
+        }
+        scan.Run();
+
+        // The monitors carried on with the points before the checkpoint
+        CPPUNIT_ASSERT_EQUAL(uninterrupted_r_hat, scan.last_max_r_hat_);
+        CPPUNIT_ASSERT_EQUAL(uninterrupted_num_points,
+                scan.autocorrelation_monitor().num_points(0));
+    }
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        CPPUNIT_ASSERT(ReadFile(chains_info[i_chain].second) ==
+                uninterrupted_chains[i_chain]);
+    }
+
+    // A checkpoint in the second half of the burn-in, where automatic 
+    // thinning collects the autocorrelation times it picks the thinning from
+    unsigned int uninterrupted_thinning;
+    {
+        GaussianTestScan scan(dimension, num_chains, 3900, 0.8);
+        scan.EnableAutomaticThinning();
+        scan.EnableCheckpoints(checkpoint_filename, 2000);
+        scan.Initialize(10, chains_info);
+        scan.Run();
+        uninterrupted_thinning = scan.output_thinning_;
+    }
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        uninterrupted_chains[i_chain] = ReadFile(chains_info[i_chain].second);
+    }
+    {
+        GaussianTestScan scan(dimension, num_chains, 3900, 0.8);
+        scan.EnableAutomaticThinning();
+        scan.ResumeFromCheckpoint(checkpoint_filename);
+        CPPUNIT_ASSERT(scan.num_steps_ == 2000);
+        scan.Run();
+        CPPUNIT_ASSERT_EQUAL(uninterrupted_thinning, scan.output_thinning_);
+    }
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        CPPUNIT_ASSERT(ReadFile(chains_info[i_chain].second) ==
+                uninterrupted_chains[i_chain]);
+    }
+
+    // Checkpoints only fit the scan that wrote them
+    GaussianTestScan other_scan(dimension + 1, num_chains, 3000);
+    CPPUNIT_ASSERT_THROW(other_scan.ResumeFromCheckpoint(checkpoint_filename),
+            Mcmc::CheckpointError);
+    CPPUNIT_ASSERT_THROW(other_scan.ResumeFromCheckpoint(
+            "dummy_mcmcscan_nonexistent.dat"), Mcmc::CheckpointError);
+    CPPUNIT_ASSERT_THROW(other_scan.ResumeFromCheckpoint(
+            chains_info[0].second), Mcmc::CheckpointError);
+
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
+
+void McmcScanTest::testEarlyStop() {
+    unsigned int dimension = 2;
+    unsigned int num_chains = 6;
+    unsigned int max_steps = 200000;
+    std::string log_filename = "dummy_mcmcscan_rhat.dat";
+    dummy_output_filenames_.push_back(log_filename);
+
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(seed, i, 3.0 * std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+
+    GaussianTestScan scan(dimension, num_chains, max_steps);
+    CPPUNIT_ASSERT_THROW(scan.EnableEarlyStop(1.05), std::logic_error);
+    CPPUNIT_ASSERT_THROW(scan.EnableConvergenceMonitor("", 1000),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(scan.EnableConvergenceMonitor(log_filename, 0),
+            std::invalid_argument);
+    scan.EnableConvergenceMonitor(log_filename, 1000);
+    CPPUNIT_ASSERT_THROW(scan.EnableConvergenceMonitor(log_filename, 1000),
+            std::logic_error);
+    CPPUNIT_ASSERT_THROW(scan.EnableEarlyStop(1.0), std::invalid_argument);
+    scan.EnableEarlyStop(1.05);
+    CPPUNIT_ASSERT_THROW(scan.EnableEarlyStop(1.05), std::logic_error);
+
+    scan.Initialize(10, chains_info);
+    scan.Run();
+
+    // Stops well before max_steps, at a check after the burn-in
+    CPPUNIT_ASSERT(scan.num_steps_ < max_steps / 2);
+    CPPUNIT_ASSERT(scan.num_steps_ > 0.1 * max_steps);
+    CPPUNIT_ASSERT(scan.num_steps_ % 1000 == 0);
+
+    // One line per check: the step count, then an R-hat per parameter, the
+    // last of them all below the threshold
+    std::ifstream log(log_filename.c_str());
+    std::string line;
+    unsigned int num_lines = 0;
+    unsigned int step = 0;
+    double r_hats[2];
+    while (std::getline(log, line)) {
+        std::istringstream fields(line);
+        CPPUNIT_ASSERT(fields >> step >> r_hats[0] >> r_hats[1]);
+        CPPUNIT_ASSERT(step > 0.1 * max_steps);
+        ++num_lines;
+    }
+    CPPUNIT_ASSERT(num_lines > 0);
+    CPPUNIT_ASSERT(step == scan.num_steps_);
+    CPPUNIT_ASSERT(r_hats[0] < 1.05 && r_hats[1] < 1.05);
+
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
+
+void McmcScanTest::testPosteriorSummary() {
+    unsigned int dimension = 2;
+    unsigned int num_chains = 4;
+    unsigned int max_steps = 40000;
+    std::string summary_filename = "dummy_mcmcscan_summary.dat";
+    dummy_output_filenames_.push_back(summary_filename);
+
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(seed, i, std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+
+    std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator(
+            new Mcmc::PosteriorAccumulator(dimension, 1));
+    accumulator->AddHistogram1D(0, -5.0, 5.0, 20);
+
+    GaussianTestScan scan(dimension, num_chains, max_steps);
+    CPPUNIT_ASSERT_THROW(scan.UsePosteriorAccumulator(nullptr,
+            summary_filename), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(scan.UsePosteriorAccumulator(
+            std::shared_ptr<Mcmc::PosteriorAccumulator>(
+            new Mcmc::PosteriorAccumulator(dimension + 1, 1)),
+            summary_filename), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(scan.UsePosteriorAccumulator(accumulator, ""),
+            std::invalid_argument);
+    scan.UsePosteriorAccumulator(accumulator, summary_filename);
+    CPPUNIT_ASSERT_THROW(scan.UsePosteriorAccumulator(accumulator,
+            summary_filename), std::logic_error);
+
+    scan.Initialize(10, chains_info);
+    scan.Run();
+
+    // Every step after the burn-in is in the accumulator, including the runs
+    // still going on at the end
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.9 * max_steps, accumulator->total_weight(),
+            1.0);
+    double histogram_weight = 0.0;
+    for (int i_bin = 0; i_bin < 20; ++i_bin) {
+        histogram_weight += accumulator->histogram1d_bin(0, i_bin);
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(accumulator->total_weight(),
+            histogram_weight, 1E-6);
+
+    // Unit Gaussian, up to Monte Carlo error
+    for (int i = 0; i < dimension; ++i) {
+        CPPUNIT_ASSERT(std::fabs(accumulator->mean(i)) < 0.2);
+        CPPUNIT_ASSERT(std::fabs(accumulator->covariance(i, i) - 1.0) < 0.25);
+    }
+    CPPUNIT_ASSERT(std::fabs(accumulator->covariance(0, 1)) < 0.2);
+
+    // The autocorrelation monitor sees the same points, one chain at a time
+    Mcmc::AutocorrelationMonitor const& monitor =
+            scan.autocorrelation_monitor();
+    unsigned long num_points = 0;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        num_points += monitor.num_points(i_chain);
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(accumulator->total_weight(), num_points,
+            1E-6);
+    CPPUNIT_ASSERT(monitor.ready());
+
+    std::ifstream summary(summary_filename.c_str());
+    std::string keyword;
+    double total_weight;
+    CPPUNIT_ASSERT(summary >> keyword >> total_weight);
+    CPPUNIT_ASSERT(keyword == "total_weight");
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(accumulator->total_weight(), total_weight,
+            1E-6);
+
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
+
+void McmcScanTest::testOutputPolicy() {
+    unsigned int dimension = 2;
+    unsigned int num_chains = 4;
+    unsigned int thinning = 5;
+    std::string checkpoint_filename = "dummy_mcmcscan_checkpoint.dat";
+    dummy_output_filenames_.push_back(checkpoint_filename);
+
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(seed, i, std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+
+    // Fixed thinning without the burn-in, leaving a checkpoint behind at 
+    // step 2000
+    std::vector<unsigned long> nums_points;
+    {
+        GaussianTestScan scan(dimension, num_chains, 3000);
+        CPPUNIT_ASSERT_THROW(scan.SetOutputPolicy(true, 0),
+                std::invalid_argument);
+        scan.SetOutputPolicy(true, thinning);
+        CPPUNIT_ASSERT_THROW(scan.SetOutputPolicy(true, thinning),
+                std::logic_error);
+        CPPUNIT_ASSERT_THROW(scan.EnableAutomaticThinning(),
+                std::logic_error);
+        scan.EnableBinaryOutput();
+        scan.EnableRunLengthEncoding();
+        scan.EnableCheckpoints(checkpoint_filename, 2000);
+        scan.Initialize(10, chains_info);
+        scan.Run();
+        for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            nums_points.push_back(
+                    scan.autocorrelation_monitor().num_points(i_chain));
+        }
+    }
+
+    // Each chain file holds every thinning-th point after the burn-in
+    std::vector<std::string> uninterrupted_chains;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        Mcmc::ChainReader reader(chains_info[i_chain].second);
+        CPPUNIT_ASSERT(reader.num_steps() ==
+                (nums_points[i_chain] + thinning - 1) / thinning);
+        uninterrupted_chains.push_back(ReadFile(chains_info[i_chain].second));
+    }
+
+    // The chains carry on with the same policy after a resume
+    {
+        GaussianTestScan scan(dimension, num_chains, 3000);
+        scan.SetOutputPolicy(true, thinning);
+        scan.EnableBinaryOutput();
+        scan.EnableRunLengthEncoding();
+        scan.ResumeFromCheckpoint(checkpoint_filename);
+        scan.Run();
+    }
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        CPPUNIT_ASSERT(ReadFile(chains_info[i_chain].second) ==
+                uninterrupted_chains[i_chain]);
+    }
+
+    // Automatic thinning, into new files
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        std::remove(chains_info[i_chain].second.c_str());
+    }
+    unsigned int automatic_thinning;
+    nums_points.clear();
+    {
+        GaussianTestScan scan(dimension, num_chains, 3000);
+        scan.EnableAutomaticThinning();
+        scan.EnableBinaryOutput();
+        scan.Initialize(10, chains_info);
+        CPPUNIT_ASSERT_THROW(scan.SetOutputPolicy(false, 1),
+                std::logic_error);
+        scan.Run();
+        automatic_thinning = scan.output_thinning_;
+        for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            nums_points.push_back(
+                    scan.autocorrelation_monitor().num_points(i_chain));
+        }
+    }
+    CPPUNIT_ASSERT(automatic_thinning >= 1);
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        Mcmc::ChainReader reader(chains_info[i_chain].second);
+        CPPUNIT_ASSERT(reader.num_steps() == (nums_points[i_chain] +
+                automatic_thinning - 1) / automatic_thinning);
+    }
+
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
+
+void McmcScanTest::testDistributedScan() {
+    unsigned int dimension = 2;
+    unsigned int num_workers = 3;
+    unsigned int num_chains = 3;
+    unsigned int max_steps = 6000;
+    unsigned int sync_interval = 50;
+    std::string socket_path = "dummy_mcmcscan_coordinator.sock";
+
+    CPPUNIT_ASSERT_THROW(Mcmc::ScanCoordinator("", dimension, num_workers, 2),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(Mcmc::ScanCoordinator(socket_path, 0, num_workers,
+            2), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(Mcmc::ScanCoordinator(socket_path, dimension, 0, 2),
+            std::invalid_argument);
+
+    GaussianTestScan scan(dimension, num_chains);
+    CPPUNIT_ASSERT_THROW(scan.EnableDistributedMode("", sync_interval),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(scan.EnableDistributedMode(socket_path, 0),
+            std::invalid_argument);
+    scan.EnableDistributedMode(socket_path, sync_interval);
+    CPPUNIT_ASSERT_THROW(scan.EnableDistributedMode(socket_path,
+            sync_interval), std::logic_error);
+
+    for (int i_worker = 0; i_worker < num_workers; ++i_worker) {
+        for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            char filename[64];
+            std::sprintf(filename, "dummy_mcmcscan_worker%d_chain%d.dat",
+                    i_worker, i_chain);
+            dummy_output_filenames_.push_back(filename);
+        }
+    }
+
+    // The workers are separate processes, which report through their exit
+    // status: 0 if all went well, 1 if the scan did not see every worker's
+    // chains, and 2 if anything threw
+    Mcmc::ScanCoordinator coordinator(socket_path, dimension, num_workers, 2);
+    std::fflush(stdout);
+    std::vector<pid_t> workers;
+    for (int i_worker = 0; i_worker < num_workers; ++i_worker) {
+        pid_t pid = fork();
+        CPPUNIT_ASSERT(pid >= 0);
+        if (pid != 0) {
+            workers.push_back(pid);
+            continue;
+        }
+
+        int status = 0;
+        try {
+            std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+            for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+                gsl_vector* seed = gsl_vector_alloc(dimension);
+                for (int i = 0; i < dimension; ++i) {
+                    gsl_vector_set(seed, i, std::cos(1.0 + (i_worker * 
+                            num_chains + i_chain) * (i + 1.0)));
+                }
+                chains_info.push_back(std::make_pair(seed,
+                        dummy_output_filenames_[i_worker * num_chains + 
+                        i_chain]));
+            }
+
+            GaussianTestScan worker_scan(dimension, num_chains, max_steps);
+            worker_scan.EnableDistributedMode(socket_path, sync_interval);
+            worker_scan.Initialize(10, chains_info);
+            worker_scan.Run();
+            if (worker_scan.ensemble_size_ != num_workers * num_chains) {
+                status = 1;
+            }
+
+            for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+                gsl_vector_free(chains_info[i_chain].first);
+            }
+        } catch (std::exception& e) {
+            status = 2;
+        }
+        std::fflush(stdout);
+        _exit(status);
+    }
+
+    coordinator.Run();
+    for (int i_worker = 0; i_worker < num_workers; ++i_worker) {
+        int status;
+        CPPUNIT_ASSERT(waitpid(workers[i_worker], &status, 0) ==
+                workers[i_worker]);
+        CPPUNIT_ASSERT(WIFEXITED(status));
+        CPPUNIT_ASSERT_EQUAL(0, WEXITSTATUS(status));
+    }
+
+    CPPUNIT_ASSERT_EQUAL(num_workers * num_chains, coordinator.num_chains());
+    CPPUNIT_ASSERT_EQUAL((unsigned long) num_workers * max_steps / 
+            sync_interval, coordinator.num_syncs());
+    CPPUNIT_ASSERT_THROW(coordinator.Run(), std::logic_error);
+    CPPUNIT_ASSERT_THROW(coordinator.mean(dimension), std::out_of_range);
+
+    // The last points of all the chains, spread around the unit Gaussian
+    for (int i = 0; i < dimension; ++i) {
+        CPPUNIT_ASSERT(std::fabs(coordinator.mean(i)) < 2.0);
+        CPPUNIT_ASSERT(coordinator.covariance(i, i) > 0.0);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(coordinator.covariance(i, 1 - i),
+                coordinator.covariance(1 - i, i), d_);
+    }
+
+    // Each worker wrote its own chains
+    for (int i = 0; i < dummy_output_filenames_.size(); ++i) {
+        CPPUNIT_ASSERT(!ReadFile(dummy_output_filenames_[i]).empty());
+    }
+}
+
+void McmcScanTest::testParallelTempering() {
+    unsigned int dimension = 2;
+    unsigned int num_chains = 6;
+    unsigned int max_steps = 40000;
+    std::vector<double> ladder = {1.0, 0.3, 0.1, 0.03};
+
+    GaussianTestScan scan(dimension, num_chains);
+    CPPUNIT_ASSERT_THROW(scan.EnableParallelTempering(std::vector<double>(),
+            10), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(scan.EnableParallelTempering({0.5, 0.1}, 10),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(scan.EnableParallelTempering({1.0, 0.1, 0.3}, 10),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(scan.EnableParallelTempering({1.0, 0.0}, 10),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(scan.EnableParallelTempering(ladder, 0),
+            std::invalid_argument);
+    scan.EnableParallelTempering(ladder, 10);
+    CPPUNIT_ASSERT_THROW(scan.EnableParallelTempering(ladder, 10),
+            std::logic_error);
+    CPPUNIT_ASSERT_THROW(scan.EnableSweepMode(2), std::logic_error);
+    CPPUNIT_ASSERT_THROW(scan.EnableDelayedAcceptance(), std::logic_error);
+    CPPUNIT_ASSERT_THROW(scan.EnableDistributedMode("dummy.sock", 10),
+            std::logic_error);
+    CPPUNIT_ASSERT_THROW(scan.swap_acceptance_rate(ladder.size() - 1),
+            std::out_of_range);
+
+    // Every chain starts in the mode at x = 4, and only gets to the other
+    // one through swaps
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(seed, i, (i == 0 ? 4.0 : 0.0) +
+                    0.3 * std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+
+    std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator(
+            new Mcmc::PosteriorAccumulator(dimension, 1));
+    accumulator->AddHistogram1D(0, -10.0, 10.0, 2);
+    std::string summary_filename = "dummy_mcmcscan_summary.dat";
+    dummy_output_filenames_.push_back(summary_filename);
+
+    BimodalTestScan tempered_scan(dimension, num_chains, max_steps);
+    tempered_scan.EnableParallelTempering(ladder, 10);
+    tempered_scan.UsePosteriorAccumulator(accumulator, summary_filename);
+    tempered_scan.Initialize(10, chains_info);
+    tempered_scan.Run();
+
+    // Swaps add no samples: every chain holds its seed and one point per
+    // step
+    unsigned int total_length = 0;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        total_length += tempered_scan.chains_[i_chain]->length();
+    }
+    CPPUNIT_ASSERT_EQUAL(max_steps + num_chains, total_length);
+
+    // Both modes get about half of the weight at lambda = 1
+    double negative_weight = accumulator->histogram1d_bin(0, 0);
+    double positive_weight = accumulator->histogram1d_bin(0, 1);
+    CPPUNIT_ASSERT(negative_weight > 0.25 * accumulator->total_weight());
+    CPPUNIT_ASSERT(positive_weight > 0.25 * accumulator->total_weight());
+    CPPUNIT_ASSERT(std::fabs(accumulator->covariance(1, 1) - 0.25) < 0.1);
+
+    for (int i_rung = 0; i_rung + 1 < ladder.size(); ++i_rung) {
+        CPPUNIT_ASSERT(tempered_scan.swap_acceptance_rate(i_rung) > 0.05);
+        CPPUNIT_ASSERT(tempered_scan.swap_acceptance_rate(i_rung) <= 1.0);
+    }
+
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
+
+void McmcScanTest::testDifferentialEvolution() {
+    unsigned int dimension = 2;
+    unsigned int num_chains = 6;
+    unsigned int max_steps = 40000;
+
+    GaussianTestScan two_chain_scan(1, 2);
+    CPPUNIT_ASSERT_THROW(two_chain_scan.EnableDifferentialEvolution(),
+            std::logic_error);
+    GaussianTestScan sweep_scan(dimension, num_chains);
+    sweep_scan.EnableSweepMode(2);
+    CPPUNIT_ASSERT_THROW(sweep_scan.EnableDifferentialEvolution(),
+            std::logic_error);
+
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(seed, i, std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+
+    std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator(
+            new Mcmc::PosteriorAccumulator(dimension, 1));
+    std::string summary_filename = "dummy_mcmcscan_summary.dat";
+    dummy_output_filenames_.push_back(summary_filename);
+
+    GaussianTestScan scan(dimension, num_chains, max_steps);
+    scan.EnableDifferentialEvolution();
+    CPPUNIT_ASSERT_THROW(scan.EnableDifferentialEvolution(),
+            std::logic_error);
+    CPPUNIT_ASSERT_THROW(scan.EnableDelayedAcceptance(), std::logic_error);
+    CPPUNIT_ASSERT_THROW(scan.EnableParallelTempering({1.0, 0.5}, 10),
+            std::logic_error);
+    scan.UsePosteriorAccumulator(accumulator, summary_filename);
+    scan.Initialize(10, chains_info);
+
+    double seed_variance = gsl_matrix_get(scan.last_points_covariance(), 0,
+            0);
+    scan.Run();
+
+    // Unit Gaussian, up to Monte Carlo error
+    for (int i = 0; i < dimension; ++i) {
+        CPPUNIT_ASSERT(std::fabs(accumulator->mean(i)) < 0.2);
+        CPPUNIT_ASSERT(std::fabs(accumulator->covariance(i, i) - 1.0) < 0.25);
+    }
+    CPPUNIT_ASSERT(std::fabs(accumulator->covariance(0, 1)) < 0.2);
+
+    // The covariance matrix was never touched
+    CPPUNIT_ASSERT_EQUAL(0u, scan.gaussian_proposal_->num_cholesky_updates_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(seed_variance, gsl_matrix_get(
+            scan.last_points_covariance(), 0, 0), d_);
+
+    // Trial points outside the box are rejected, not redrawn, so the chains
+    // are uniform right up to its faces: mean 1/2 and variance 1/12.
+    // Redrawing would make them thinner near the faces.
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(chains_info[i_chain].first, i,
+                    0.5 + 0.4 * std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+    }
+    std::shared_ptr<Mcmc::PosteriorAccumulator> box_accumulator(
+            new Mcmc::PosteriorAccumulator(dimension, 1));
+    BoxTestScan box_scan(dimension, num_chains, max_steps);
+    box_scan.EnableDifferentialEvolution();
+    box_scan.UsePosteriorAccumulator(box_accumulator, summary_filename);
+    box_scan.Initialize(10, chains_info);
+    box_scan.Run();
+    for (int i = 0; i < dimension; ++i) {
+        CPPUNIT_ASSERT(std::fabs(box_accumulator->mean(i) - 0.5) < 0.05);
+        CPPUNIT_ASSERT(std::fabs(box_accumulator->covariance(i, i) * 12.0 -
+                1.0) < 0.1);
+    }
+
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
+
+void McmcScanTest::testStretchMove() {
+    unsigned int num_chains = 8;
+    unsigned int max_steps = 40000;
+    double const scales[2] = {CorrelatedTestScan::kScale0,
+        CorrelatedTestScan::kScale1};
+
+    GaussianTestScan scan(2, num_chains);
+    CPPUNIT_ASSERT_THROW(scan.EnableStretchMove(0), std::invalid_argument);
+    scan.EnableStretchMove(2);
+    CPPUNIT_ASSERT_THROW(scan.EnableStretchMove(2), std::logic_error);
+    CPPUNIT_ASSERT_THROW(scan.EnableSweepMode(2), std::logic_error);
+    CPPUNIT_ASSERT_THROW(scan.EnableDifferentialEvolution(),
+            std::logic_error);
+
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(2);
+        for (int i = 0; i < 2; ++i) {
+            gsl_vector_set(seed, i, scales[i] *
+                    std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+
+    std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator(
+            new Mcmc::PosteriorAccumulator(2, 1));
+    std::string summary_filename = "dummy_mcmcscan_summary.dat";
+    dummy_output_filenames_.push_back(summary_filename);
+
+    CorrelatedTestScan correlated_scan(num_chains, max_steps);
+    correlated_scan.EnableStretchMove(2);
+    correlated_scan.UsePosteriorAccumulator(accumulator, summary_filename);
+    correlated_scan.Initialize(10, chains_info);
+    correlated_scan.Run();
+    CPPUNIT_ASSERT_EQUAL(max_steps, correlated_scan.num_steps_);
+
+    // The scales and correlation, up to Monte Carlo error
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.9 * max_steps, accumulator->total_weight(),
+            1.0);
+    for (int i = 0; i < 2; ++i) {
+        CPPUNIT_ASSERT(std::fabs(accumulator->mean(i) / scales[i]) < 0.25);
+        CPPUNIT_ASSERT(std::fabs(accumulator->covariance(i, i) /
+                (scales[i] * scales[i]) - 1.0) < 0.3);
+    }
+    CPPUNIT_ASSERT(std::fabs(accumulator->covariance(0, 1) /
+            (scales[0] * scales[1]) - CorrelatedTestScan::kCorrelation) <
+            0.15);
+
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
+
+void McmcScanTest::testProposalPolicy() {
+    unsigned int dimension = 2;
+    unsigned int num_chains = 4;
+    unsigned int max_steps = 40000;
+
+    RandomWalkProposal proposal(1.0);
+
+    GaussianTestScan uninitialized_scan(dimension, num_chains);
+    CPPUNIT_ASSERT_THROW(uninitialized_scan.Run(proposal), std::logic_error);
+    GaussianTestScan sweep_scan(dimension, num_chains);
+    sweep_scan.EnableSweepMode(2);
+    CPPUNIT_ASSERT_THROW(sweep_scan.Run(proposal), std::logic_error);
+
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(seed, i, std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+
+    std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator(
+            new Mcmc::PosteriorAccumulator(dimension, 1));
+    std::string summary_filename = "dummy_mcmcscan_summary.dat";
+    dummy_output_filenames_.push_back(summary_filename);
+
+    GaussianTestScan scan(dimension, num_chains, max_steps);
+    scan.UsePosteriorAccumulator(accumulator, summary_filename);
+    scan.Initialize(10, chains_info);
+    CPPUNIT_ASSERT_EQUAL(dimension, scan.dimension());
+    CPPUNIT_ASSERT_EQUAL(num_chains, scan.num_chains());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(std::cos(2.0),
+            gsl_vector_get(scan.last_parameters(1), 0), d_);
+    CPPUNIT_ASSERT_THROW(scan.last_parameters(num_chains), std::out_of_range);
+    double seed_mean = 0.0;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        seed_mean += std::cos(1.0 + i_chain) / num_chains;
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(seed_mean,
+            gsl_vector_get(scan.last_points_mean(), 0), d_);
+    scan.Run(proposal);
+    CPPUNIT_ASSERT_EQUAL(max_steps, scan.num_steps_);
+
+    // Every step went through the policy, and the scan's own statistics 
+    // were only recomputed from the chains at the end
+    CPPUNIT_ASSERT_EQUAL(max_steps, proposal.num_proposals);
+    CPPUNIT_ASSERT(proposal.num_updates > max_steps / 4);
+    CPPUNIT_ASSERT(proposal.num_updates < max_steps);
+    CPPUNIT_ASSERT_EQUAL(0u, scan.gaussian_proposal_->num_cholesky_updates_);
+    for (int i = 0; i < dimension; ++i) {
+        double last_mean = 0.0;
+        for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            last_mean += gsl_vector_get(scan.last_parameters(i_chain), i) /
+                    num_chains;
+        }
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(last_mean,
+                gsl_vector_get(scan.last_points_mean(), i), d_);
+    }
+
+    // Unit Gaussian, up to Monte Carlo error
+    for (int i = 0; i < dimension; ++i) {
+        CPPUNIT_ASSERT(std::fabs(accumulator->mean(i)) < 0.2);
+        CPPUNIT_ASSERT(std::fabs(accumulator->covariance(i, i) - 1.0) < 0.25);
+    }
+    CPPUNIT_ASSERT(std::fabs(accumulator->covariance(0, 1)) < 0.2);
+
+    // Delayed acceptance takes the trial points from the policy as well
+    RandomWalkProposal delayed_proposal(1.0);
+    GaussianTestScan delayed_scan(dimension, num_chains, 1000);
+    delayed_scan.EnableDelayedAcceptance();
+    delayed_scan.Initialize(10, chains_info);
+    delayed_scan.Run(delayed_proposal);
+    CPPUNIT_ASSERT_EQUAL(1000u, delayed_scan.num_steps_);
+    CPPUNIT_ASSERT_EQUAL(1000u, delayed_proposal.num_proposals);
+    CPPUNIT_ASSERT(delayed_proposal.num_updates > 0);
+
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
+
+void McmcScanTest::testFixedDimensionProposal() {
+    unsigned int const dimension = 3;
+    unsigned int num_chains = 8;
+    unsigned int max_steps = 40000;
+
+    GaussianTestScan wrong_scan(2, num_chains);
+    CPPUNIT_ASSERT_THROW(Mcmc::FixedDimensionGaussianProposal<dimension>
+            wrong_proposal(wrong_scan), std::invalid_argument);
+
+    std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector* seed = gsl_vector_alloc(dimension);
+        for (int i = 0; i < dimension; ++i) {
+            gsl_vector_set(seed, i, std::cos(1.0 + i_chain * (i + 1.0)));
+        }
+        char filename[64];
+        std::sprintf(filename, "dummy_mcmcscan_chain%d.dat", i_chain);
+        dummy_output_filenames_.push_back(filename);
+        chains_info.push_back(std::make_pair(seed, std::string(filename)));
+    }
+
+    // Walk chain 0 around as in testStepLoopDoesNotAllocate(), with both 
+    // the fixed-dimension policy and the scan's own adaptive Gaussian 
+    // proposal, which have to agree on every Hastings ratio.  The walk is
+    // a Metropolis walk on the likelihood, from a fixed seed, so that it 
+    // stays near the other chains and the two proposals' rounding errors 
+    // stay small.
+    {
+        GaussianTestScan scan(dimension, num_chains);
+        scan.Initialize(10, chains_info);
+        gsl_rng_set(scan.rng_, 1);
+        Mcmc::FixedDimensionGaussianProposal<dimension> proposal(scan);
+        Mcmc::AdaptiveGaussianProposal& gaussian_proposal =
+                *scan.gaussian_proposal_;
+
+        gsl_vector* last_parameters = gsl_vector_alloc(dimension);
+        gsl_vector_memcpy(last_parameters, chains_info[0].first);
+        gsl_vector* trial_parameters = scan.workspace_->trial_parameters;
+        for (int i_step = 0; i_step < 500; ++i_step) {
+            proposal.Propose(0, last_parameters, scan.rng_, trial_parameters);
+            double log_hastings_ratio = proposal.LogHastingsRatio(0,
+                    last_parameters, trial_parameters);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(gaussian_proposal.LogHastingsRatio(0,
+                    last_parameters, trial_parameters), log_hastings_ratio,
+                    1E-6 * (1.0 + std::fabs(log_hastings_ratio)));
+
+            double log_acceptance = log_hastings_ratio +
+                    std::log(GaussianTestScan::Likelihood(trial_parameters) /
+                    GaussianTestScan::Likelihood(last_parameters));
+            if (std::log(gsl_rng_uniform(scan.rng_)) < log_acceptance) {
+                proposal.UpdateState(0, last_parameters, trial_parameters);
+                gaussian_proposal.UpdateState(0, last_parameters,
+                        trial_parameters);
+                gsl_vector_memcpy(last_parameters, trial_parameters);
+            }
+        }
+        gsl_vector_free(last_parameters);
+    }
+
+    std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator(
+            new Mcmc::PosteriorAccumulator(dimension, 1));
+    std::string summary_filename = "dummy_mcmcscan_summary.dat";
+    dummy_output_filenames_.push_back(summary_filename);
+
+    GaussianTestScan scan(dimension, num_chains, max_steps);
+    scan.UsePosteriorAccumulator(accumulator, summary_filename);
+    scan.Initialize(10, chains_info);
+    Mcmc::FixedDimensionGaussianProposal<dimension> proposal(scan);
+    scan.Run(proposal);
+    CPPUNIT_ASSERT_EQUAL(max_steps, scan.num_steps_);
+
+    // The scan's own statistics are in sync with the chains after the run
+    CPPUNIT_ASSERT_EQUAL(0u, scan.gaussian_proposal_->num_cholesky_updates_);
+    for (int i = 0; i < dimension; ++i) {
+        double last_mean = 0.0;
+        for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            last_mean += gsl_vector_get(scan.last_parameters(i_chain), i) /
+                    num_chains;
+        }
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(last_mean,
+                gsl_vector_get(scan.last_points_mean(), i), d_);
+    }
+
+    // Unit Gaussian, up to Monte Carlo error
+    for (int i = 0; i < dimension; ++i) {
+        CPPUNIT_ASSERT(std::fabs(accumulator->mean(i)) < 0.2);
+        CPPUNIT_ASSERT(std::fabs(accumulator->covariance(i, i) - 1.0) < 0.25);
+        for (int j = 0; j < i; ++j) {
+            CPPUNIT_ASSERT(std::fabs(accumulator->covariance(i, j)) < 0.2);
+        }
+    }
+
+    for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+        gsl_vector_free(chains_info[i_chain].first);
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * File:   McmcScanTest.h
+ * Author: donerkebab
+ *
+ * McmcScan declares this fixture a friend, so that the tests can drive the
+ * private step methods directly, without the measurement and the chains'
+ * output getting in the way.
+ *
+ * Created on Apr 24, 2014, 10:12:29 PM
+ */
+
+#ifndef MCMC_MCMCSCANTEST_H
+#define	MCMC_MCMCSCANTEST_H
+
+#include <string>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class McmcScanTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(McmcScanTest);
+
+    CPPUNIT_TEST(testStepLoopDoesNotAllocate);
+    CPPUNIT_TEST(testStepAllocations);
+    CPPUNIT_TEST(testModeConflicts);
+    CPPUNIT_TEST(testSweepMode);
+    CPPUNIT_TEST(testPartialSweep);
+    CPPUNIT_TEST(testCheckpointResume);
+    CPPUNIT_TEST(testEarlyStop);
+    CPPUNIT_TEST(testPosteriorSummary);
+    CPPUNIT_TEST(testOutputPolicy);
+    CPPUNIT_TEST(testDistributedScan);
+    CPPUNIT_TEST(testParallelTempering);
+    CPPUNIT_TEST(testDifferentialEvolution);
+    CPPUNIT_TEST(testStretchMove);
+    CPPUNIT_TEST(testProposalPolicy);
+    CPPUNIT_TEST(testFixedDimensionProposal);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    McmcScanTest();
+    virtual ~McmcScanTest();
+    void setUp();
+    void tearDown();
+
+private:
+    void testStepLoopDoesNotAllocate();
+    void testStepAllocations();
+    void testModeConflicts();
+    void testSweepMode();
+    void testPartialSweep();
+    void testCheckpointResume();
+    void testEarlyStop();
+    void testPosteriorSummary();
+    void testOutputPolicy();
+    void testDistributedScan();
+    void testParallelTempering();
+    void testDifferentialEvolution();
+    void testStretchMove();
+    void testProposalPolicy();
+    void testFixedDimensionProposal();
+
+    std::vector<std::string> dummy_output_filenames_;
+    double const d_;  // delta for CPPUNIT_ASSERT_DOUBLES_EQUAL
+};
+
+#endif	/* MCMC_MCMCSCANTEST_H */
+
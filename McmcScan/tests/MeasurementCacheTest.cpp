@@ -0,0 +1,169 @@
+/*
+ * File:   MeasurementCacheTest.cpp
+ * Author: donerkebab
+ *
+ * Created on Apr 26, 2014, 5:02:43 PM
+ */
+
+#include "MeasurementCacheTest.h"
+
+#include <stdexcept>
+
+#include <gsl/gsl_vector.h>
+
+#include "../MeasurementCache.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MeasurementCacheTest);
+
+MeasurementCacheTest::MeasurementCacheTest()
+: d_(1E-12) {
+}
+
+MeasurementCacheTest::~MeasurementCacheTest() {
+}
+
+void MeasurementCacheTest::setUp() {
+}
+
+void MeasurementCacheTest::tearDown() {
+}
+
+void MeasurementCacheTest::testInitialization() {
+    CPPUNIT_ASSERT_THROW(Mcmc::MeasurementCache cache(0),
+            std::invalid_argument);
+
+    Mcmc::MeasurementCache cache(1000);
+    CPPUNIT_ASSERT(cache.max_bytes() == 1000);
+    CPPUNIT_ASSERT(cache.num_bytes() == 0);
+    CPPUNIT_ASSERT(cache.num_entries() == 0);
+    CPPUNIT_ASSERT(cache.num_hits() == 0);
+    CPPUNIT_ASSERT(cache.num_misses() == 0);
+}
+
+void MeasurementCacheTest::testHitAndMiss() {
+    Mcmc::MeasurementCache cache(100000);
+
+    gsl_vector* params = gsl_vector_alloc(2);
+    gsl_vector_set(params, 0, 1.5);
+    gsl_vector_set(params, 1, -2.5);
+    gsl_vector* meas = gsl_vector_alloc(3);
+    gsl_vector_set(meas, 0, 0.1);
+    gsl_vector_set(meas, 1, 1.2);
+    gsl_vector_set(meas, 2, 2.3);
+
+    gsl_vector* found_meas = nullptr;
+    double found_like = 0.0;
+    CPPUNIT_ASSERT(!cache.Lookup(params, found_meas, found_like));
+    CPPUNIT_ASSERT(found_meas == nullptr);
+    CPPUNIT_ASSERT(cache.num_misses() == 1);
+
+    cache.Insert(params, meas, 0.56);
+    CPPUNIT_ASSERT(cache.num_entries() == 1);
+    CPPUNIT_ASSERT(cache.num_bytes() > 0);
+
+    // The cache keeps its own copy
+    gsl_vector_set(meas, 0, 9.9);
+
+    CPPUNIT_ASSERT(cache.Lookup(params, found_meas, found_like));
+    CPPUNIT_ASSERT(cache.num_hits() == 1);
+    CPPUNIT_ASSERT(found_meas->size == 3);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.1, gsl_vector_get(found_meas, 0), d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.2, gsl_vector_get(found_meas, 1), d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(2.3, gsl_vector_get(found_meas, 2), d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.56, found_like, d_);
+    gsl_vector_free(found_meas);
+
+    // Inserting the same parameters again replaces the entry
+    cache.Insert(params, meas, 0.78);
+    CPPUNIT_ASSERT(cache.num_entries() == 1);
+    CPPUNIT_ASSERT(cache.Lookup(params, found_meas, found_like));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(9.9, gsl_vector_get(found_meas, 0), d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.78, found_like, d_);
+    gsl_vector_free(found_meas);
+
+    gsl_vector_free(params);
+    gsl_vector_free(meas);
+}
+
+void MeasurementCacheTest::testBitPattern() {
+    Mcmc::MeasurementCache cache(100000);
+
+    gsl_vector* params = gsl_vector_calloc(2);
+    gsl_vector* meas = gsl_vector_calloc(1);
+    cache.Insert(params, meas, 1.0);
+
+    // -0.0 == 0.0, but the bit patterns differ
+    gsl_vector* negative_zero = gsl_vector_calloc(2);
+    gsl_vector_set(negative_zero, 1, -0.0);
+    gsl_vector* found_meas = nullptr;
+    double found_like = 0.0;
+    CPPUNIT_ASSERT(!cache.Lookup(negative_zero, found_meas, found_like));
+
+    // The smallest possible change also misses
+    gsl_vector* nearby = gsl_vector_calloc(2);
+    gsl_vector_set(nearby, 0, 1E-300);
+    CPPUNIT_ASSERT(!cache.Lookup(nearby, found_meas, found_like));
+
+    gsl_vector* same = gsl_vector_calloc(2);
+    CPPUNIT_ASSERT(cache.Lookup(same, found_meas, found_like));
+    gsl_vector_free(found_meas);
+
+    gsl_vector_free(params);
+    gsl_vector_free(meas);
+    gsl_vector_free(negative_zero);
+    gsl_vector_free(nearby);
+    gsl_vector_free(same);
+}
+
+void MeasurementCacheTest::testEviction() {
+    // Find out how big one entry is, and make room for exactly three
+    gsl_vector* params = gsl_vector_calloc(2);
+    gsl_vector* meas = gsl_vector_calloc(3);
+    std::size_t entry_bytes;
+    {
+        Mcmc::MeasurementCache cache(100000);
+        cache.Insert(params, meas, 1.0);
+        entry_bytes = cache.num_bytes();
+    }
+    Mcmc::MeasurementCache cache(3 * entry_bytes);
+
+    for (int i = 0; i < 3; ++i) {
+        gsl_vector_set(params, 0, i);
+        cache.Insert(params, meas, i);
+    }
+    CPPUNIT_ASSERT(cache.num_entries() == 3);
+    CPPUNIT_ASSERT(cache.num_bytes() == 3 * entry_bytes);
+
+    // Use entry 0, so that entry 1 is now the least recently used
+    gsl_vector* found_meas = nullptr;
+    double found_like = 0.0;
+    gsl_vector_set(params, 0, 0);
+    CPPUNIT_ASSERT(cache.Lookup(params, found_meas, found_like));
+    gsl_vector_free(found_meas);
+
+    gsl_vector_set(params, 0, 3);
+    cache.Insert(params, meas, 3);
+    CPPUNIT_ASSERT(cache.num_entries() == 3);
+    CPPUNIT_ASSERT(cache.num_bytes() <= cache.max_bytes());
+
+    gsl_vector_set(params, 0, 1);
+    CPPUNIT_ASSERT(!cache.Lookup(params, found_meas, found_like));
+    for (int i = 0; i < 4; i += 2) {
+        gsl_vector_set(params, 0, i);
+        CPPUNIT_ASSERT(cache.Lookup(params, found_meas, found_like));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(i, found_like, d_);
+        gsl_vector_free(found_meas);
+    }
+    gsl_vector_set(params, 0, 3);
+    CPPUNIT_ASSERT(cache.Lookup(params, found_meas, found_like));
+    gsl_vector_free(found_meas);
+
+    // An entry bigger than the whole cache is not stored
+    Mcmc::MeasurementCache small_cache(entry_bytes / 2);
+    small_cache.Insert(params, meas, 1.0);
+    CPPUNIT_ASSERT(small_cache.num_entries() == 0);
+    CPPUNIT_ASSERT(small_cache.num_bytes() == 0);
+
+    gsl_vector_free(params);
+    gsl_vector_free(meas);
+}
@@ -0,0 +1,39 @@
+/*
+ * File:   MeasurementCacheTest.h
+ * Author: donerkebab
+ *
+ * Created on Apr 26, 2014, 5:02:42 PM
+ */
+
+#ifndef MCMC_MEASUREMENTCACHETEST_H
+#define	MCMC_MEASUREMENTCACHETEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class MeasurementCacheTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(MeasurementCacheTest);
+
+    CPPUNIT_TEST(testInitialization);
+    CPPUNIT_TEST(testHitAndMiss);
+    CPPUNIT_TEST(testBitPattern);
+    CPPUNIT_TEST(testEviction);
+    
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    MeasurementCacheTest();
+    virtual ~MeasurementCacheTest();
+    void setUp();
+    void tearDown();
+
+private:
+    void testInitialization();
+    void testHitAndMiss();
+    void testBitPattern();
+    void testEviction();
+
+    double const d_;  // delta for CPPUNIT_ASSERT_DOUBLES_EQUAL
+};
+
+#endif	/* MCMC_MEASUREMENTCACHETEST_H */
+
@@ -0,0 +1,154 @@
+/*
+ * File:   PointPoolTest.cpp
+ * Author: donerkebab
+ *
+ * Created on May 6, 2014, 10:02:15 PM
+ */
+
+#include "PointPoolTest.h"
+
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+#include "../Point.h"
+#include "../PointPool.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PointPoolTest);
+
+PointPoolTest::PointPoolTest()
+: d_(1E-5)
+{
+}
+
+PointPoolTest::~PointPoolTest() {
+}
+
+void PointPoolTest::setUp() {
+    parameters_ = gsl_vector_alloc(3);
+    gsl_vector_set(parameters_, 0, 0.0);
+    gsl_vector_set(parameters_, 1, -1.0);
+    gsl_vector_set(parameters_, 2, 2.0);
+    measurements_ = gsl_vector_alloc(2);
+    gsl_vector_set(measurements_, 0, -10.4);
+    gsl_vector_set(measurements_, 1, 56.1);
+    likelihood_ = 0.6;
+}
+
+void PointPoolTest::tearDown() {
+    gsl_vector_free(parameters_);
+    gsl_vector_free(measurements_);
+}
+
+void PointPoolTest::testNewPoint() {
+    Mcmc::PointPool pool(3, 2);
+    CPPUNIT_ASSERT_EQUAL(3u, pool.num_parameters());
+    CPPUNIT_ASSERT_EQUAL(2u, pool.num_measurements());
+
+    std::shared_ptr<Mcmc::Point> point = pool.NewPoint(parameters_,
+            measurements_, likelihood_);
+    CPPUNIT_ASSERT(gsl_vector_equal(point->parameters(), parameters_) == 1);
+    CPPUNIT_ASSERT(gsl_vector_equal(point->measurements(), measurements_)
+            == 1);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(point->likelihood(), likelihood_, d_);
+
+    // Defensive copy, into one contiguous block
+    gsl_vector_set(parameters_, 0, 55.);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, gsl_vector_get(point->parameters(), 0),
+            d_);
+    CPPUNIT_ASSERT(point->measurements()->data ==
+            point->parameters()->data + 3);
+}
+
+void PointPoolTest::testInvalidInputs() {
+    Mcmc::PointPool pool(3, 2);
+    gsl_vector* short_parameters = gsl_vector_calloc(2);
+
+    CPPUNIT_ASSERT_THROW(pool.NewPoint(short_parameters, measurements_,
+            likelihood_), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(pool.NewPoint(measurements_, parameters_,
+            likelihood_), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(pool.NewPoint(nullptr, measurements_, likelihood_),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(pool.NewPoint(parameters_, nullptr, likelihood_),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(pool.NewPoint(parameters_, measurements_, -0.6),
+            std::invalid_argument);
+
+    // A Point that failed to construct gives its slot back
+    CPPUNIT_ASSERT_EQUAL(pool.num_slots(), pool.num_free_slots());
+
+    gsl_vector_free(short_parameters);
+}
+
+void PointPoolTest::testRecycling() {
+    Mcmc::PointPool pool(3, 2);
+
+    std::shared_ptr<Mcmc::Point> first = pool.NewPoint(parameters_,
+            measurements_, likelihood_);
+    std::shared_ptr<Mcmc::Point> second = pool.NewPoint(parameters_,
+            measurements_, 0.1);
+    CPPUNIT_ASSERT_EQUAL(2u, pool.num_slots());
+    CPPUNIT_ASSERT_EQUAL(0u, pool.num_free_slots());
+
+    // The slot only goes back once the last handle on the Point is gone
+    Mcmc::Point const* first_address = first.get();
+    std::shared_ptr<Mcmc::Point> copy = first;
+    first.reset();
+    CPPUNIT_ASSERT_EQUAL(0u, pool.num_free_slots());
+    copy.reset();
+    CPPUNIT_ASSERT_EQUAL(1u, pool.num_free_slots());
+
+    std::shared_ptr<Mcmc::Point> third = pool.NewPoint(parameters_,
+            measurements_, 0.2);
+    CPPUNIT_ASSERT(third.get() == first_address);
+    CPPUNIT_ASSERT_EQUAL(2u, pool.num_slots());
+    CPPUNIT_ASSERT_EQUAL(0u, pool.num_free_slots());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.2, third->likelihood(), d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.1, second->likelihood(), d_);
+}
+
+void PointPoolTest::testPointsOutlivePool() {
+    std::shared_ptr<Mcmc::Point> point;
+    {
+        Mcmc::PointPool pool(3, 2);
+        point = pool.NewPoint(parameters_, measurements_, likelihood_);
+    }
+
+    CPPUNIT_ASSERT(gsl_vector_equal(point->parameters(), parameters_) == 1);
+    CPPUNIT_ASSERT(gsl_vector_equal(point->measurements(), measurements_)
+            == 1);
+    point.reset();
+}
+
+void PointPoolTest::testFreedOnOtherThread() {
+    Mcmc::PointPool pool(3, 2);
+
+    std::vector<std::shared_ptr<Mcmc::Point> > points;
+    for (int i = 0; i < 4; ++i) {
+        points.push_back(pool.NewPoint(parameters_, measurements_, 0.1 * i));
+    }
+    Mcmc::Point const* first_address = points[0].get();
+
+    // As an output thread lets go of the Points it wrote
+    std::thread other([&points]() {
+        points.clear();
+    });
+    other.join();
+    CPPUNIT_ASSERT_EQUAL(4u, pool.num_free_slots());
+
+    // The pool's thread takes the returned slots over once it needs them
+    for (int i = 0; i < 4; ++i) {
+        points.push_back(pool.NewPoint(parameters_, measurements_, 0.2));
+    }
+    CPPUNIT_ASSERT_EQUAL(4u, pool.num_slots());
+    CPPUNIT_ASSERT_EQUAL(0u, pool.num_free_slots());
+    bool reused = false;
+    for (int i = 0; i < 4; ++i) {
+        reused = reused || points[i].get() == first_address;
+    }
+    CPPUNIT_ASSERT(reused);
+}
@@ -0,0 +1,46 @@
+/*
+ * File:   PointPoolTest.h
+ * Author: donerkebab
+ *
+ * Created on May 6, 2014, 10:02:14 PM
+ */
+
+#ifndef MCMC_POINTPOOLTEST_H
+#define	MCMC_POINTPOOLTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <gsl/gsl_vector.h>
+
+class PointPoolTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(PointPoolTest);
+
+    CPPUNIT_TEST(testNewPoint);
+    CPPUNIT_TEST(testInvalidInputs);
+    CPPUNIT_TEST(testRecycling);
+    CPPUNIT_TEST(testPointsOutlivePool);
+    CPPUNIT_TEST(testFreedOnOtherThread);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    PointPoolTest();
+    virtual ~PointPoolTest();
+    void setUp();
+    void tearDown();
+
+private:
+    void testNewPoint();
+    void testInvalidInputs();
+    void testRecycling();
+    void testPointsOutlivePool();
+    void testFreedOnOtherThread();
+
+    gsl_vector* parameters_;
+    gsl_vector* measurements_;
+    double likelihood_;
+
+    double const d_;  // delta for CPPUNIT_ASSERT_DOUBLES_EQUAL
+};
+
+#endif	/* MCMC_POINTPOOLTEST_H */
+
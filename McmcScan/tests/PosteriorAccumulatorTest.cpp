@@ -0,0 +1,242 @@
+/*
+ * File:   PosteriorAccumulatorTest.cpp
+ * Author: donerkebab
+ *
+ * Created on May 4, 2014, 2:30:41 PM
+ */
+
+#include "PosteriorAccumulatorTest.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+#include "../Point.h"
+#include "../PosteriorAccumulator.h"
+
+namespace { // unnamed namespace
+    Mcmc::Point* NewPoint(double x, double y, double z) {
+        gsl_vector* parameters = gsl_vector_alloc(2);
+        gsl_vector_set(parameters, 0, x);
+        gsl_vector_set(parameters, 1, y);
+        gsl_vector* measurements = gsl_vector_alloc(1);
+        gsl_vector_set(measurements, 0, z);
+        Mcmc::Point* point = new Mcmc::Point(parameters, measurements, 0.5);
+        gsl_vector_free(parameters);
+        gsl_vector_free(measurements);
+        return point;
+    }
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PosteriorAccumulatorTest);
+
+PosteriorAccumulatorTest::PosteriorAccumulatorTest()
+: dummy_output_filename_("dummy_posterior_summary.dat"),
+d_(1E-9) {
+}
+
+PosteriorAccumulatorTest::~PosteriorAccumulatorTest() {
+}
+
+void PosteriorAccumulatorTest::setUp() {
+}
+
+void PosteriorAccumulatorTest::tearDown() {
+    std::remove(dummy_output_filename_.c_str());
+}
+
+void PosteriorAccumulatorTest::testInitialization() {
+    CPPUNIT_ASSERT_THROW(Mcmc::PosteriorAccumulator accumulator(0, 1),
+            std::invalid_argument);
+
+    Mcmc::PosteriorAccumulator accumulator(2, 1);
+    CPPUNIT_ASSERT(accumulator.dimension() == 2);
+    CPPUNIT_ASSERT(accumulator.num_measurements() == 1);
+    CPPUNIT_ASSERT(accumulator.total_weight() == 0.0);
+
+    CPPUNIT_ASSERT_THROW(accumulator.AddHistogram1D(3, 0.0, 1.0, 10),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(accumulator.AddHistogram1D(0, 0.0, 1.0, 0),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(accumulator.AddHistogram1D(0, 1.0, 1.0, 10),
+            std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(accumulator.AddHistogram2D(0, 0.0, 1.0, 10,
+            3, 0.0, 1.0, 10), std::invalid_argument);
+    CPPUNIT_ASSERT(accumulator.AddHistogram1D(2, 0.0, 1.0, 10) == 0);
+
+    Mcmc::Point* point = NewPoint(0.1, 0.2, 0.3);
+    CPPUNIT_ASSERT_THROW(accumulator.Add(*point, 0.0), std::invalid_argument);
+    accumulator.Add(*point, 1.0);
+    CPPUNIT_ASSERT_THROW(accumulator.AddHistogram1D(2, 0.0, 1.0, 10),
+            std::logic_error);
+    delete point;
+
+    gsl_vector* parameters = gsl_vector_calloc(3);
+    gsl_vector* measurements = gsl_vector_calloc(1);
+    Mcmc::Point wrong_point(parameters, measurements, 0.5);
+    CPPUNIT_ASSERT_THROW(accumulator.Add(wrong_point, 1.0),
+            std::invalid_argument);
+    gsl_vector_free(parameters);
+    gsl_vector_free(measurements);
+
+    CPPUNIT_ASSERT_THROW(accumulator.mean(3), std::out_of_range);
+    CPPUNIT_ASSERT_THROW(accumulator.covariance(0, 3), std::out_of_range);
+    CPPUNIT_ASSERT_THROW(accumulator.histogram1d_bin(1, 0),
+            std::out_of_range);
+    CPPUNIT_ASSERT_THROW(accumulator.histogram1d_bin(0, 10),
+            std::out_of_range);
+}
+
+void PosteriorAccumulatorTest::testWeightedMoments() {
+    // A point added with weight w is the same as w copies of it.  Compare
+    // against the two-pass formulas over the expanded points.
+    double values[5][3] = {
+        {1.0, 2.0, -1.0},
+        {2.5, 1.0, 0.0},
+        {-0.5, 3.0, 4.0},
+        {1.5, -2.0, 2.0},
+        {0.0, 0.5, 1.0}
+    };
+    unsigned int weights[5] = {3, 1, 4, 1, 5};
+
+    Mcmc::PosteriorAccumulator accumulator(2, 1);
+    std::vector<std::vector<double> > expanded;
+    for (int i_point = 0; i_point < 5; ++i_point) {
+        Mcmc::Point* point = NewPoint(values[i_point][0], values[i_point][1],
+                values[i_point][2]);
+        accumulator.Add(*point, weights[i_point]);
+        delete point;
+        for (int i = 0; i < weights[i_point]; ++i) {
+            expanded.push_back(std::vector<double>(values[i_point],
+                    values[i_point] + 3));
+        }
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expanded.size(), accumulator.total_weight(),
+            d_);
+
+    double n = expanded.size();
+    double means[3] = {0.0, 0.0, 0.0};
+    for (int i_point = 0; i_point < expanded.size(); ++i_point) {
+        for (int i = 0; i < 3; ++i) {
+            means[i] += expanded[i_point][i] / n;
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(means[i], accumulator.mean(i), d_);
+        for (int j = 0; j < 3; ++j) {
+            double covariance = 0.0;
+            for (int i_point = 0; i_point < expanded.size(); ++i_point) {
+                covariance += (expanded[i_point][i] - means[i]) *
+                        (expanded[i_point][j] - means[j]);
+            }
+            covariance /= n - 1.0;
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(covariance,
+                    accumulator.covariance(i, j), d_);
+        }
+    }
+}
+
+void PosteriorAccumulatorTest::testHistograms() {
+    Mcmc::PosteriorAccumulator accumulator(2, 1);
+    CPPUNIT_ASSERT(accumulator.AddHistogram1D(0, 0.0, 1.0, 4) == 0);
+    CPPUNIT_ASSERT(accumulator.AddHistogram2D(0, 0.0, 1.0, 2,
+            2, -1.0, 1.0, 2) == 0);
+
+    // Bins are half-open, [low, high)
+    double xs[6] = {0.0, 0.25, 0.3, 0.99, 1.0, -0.1};
+    double zs[6] = {-1.0, 0.5, 0.0, -0.5, 0.0, 0.0};
+    for (int i_point = 0; i_point < 6; ++i_point) {
+        Mcmc::Point* point = NewPoint(xs[i_point], 0.0, zs[i_point]);
+        accumulator.Add(*point, i_point + 1.0);
+        delete point;
+    }
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, accumulator.histogram1d_bin(0, 0), d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, accumulator.histogram1d_bin(0, 1), d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, accumulator.histogram1d_bin(0, 2), d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, accumulator.histogram1d_bin(0, 3), d_);
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, accumulator.histogram2d_bin(0, 0, 0),
+            d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, accumulator.histogram2d_bin(0, 0, 1),
+            d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, accumulator.histogram2d_bin(0, 1, 0),
+            d_);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, accumulator.histogram2d_bin(0, 1, 1),
+            d_);
+    CPPUNIT_ASSERT_THROW(accumulator.histogram2d_bin(0, 2, 0),
+            std::out_of_range);
+}
+
+void PosteriorAccumulatorTest::testSummary() {
+    Mcmc::PosteriorAccumulator accumulator(2, 1);
+    accumulator.AddHistogram1D(1, 0.0, 1.0, 3);
+    accumulator.AddHistogram2D(0, 0.0, 1.0, 2, 1, 0.0, 1.0, 3);
+    for (int i_point = 0; i_point < 10; ++i_point) {
+        Mcmc::Point* point = NewPoint(0.1 * i_point, 0.05 * i_point,
+                std::sin(i_point));
+        accumulator.Add(*point, 2.0);
+        delete point;
+    }
+    accumulator.WriteSummary(dummy_output_filename_);
+
+    std::ifstream summary(dummy_output_filename_.c_str());
+    std::string keyword;
+    double value;
+    CPPUNIT_ASSERT(summary >> keyword >> value);
+    CPPUNIT_ASSERT(keyword == "total_weight");
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(20.0, value, d_);
+
+    CPPUNIT_ASSERT(summary >> keyword && keyword == "mean");
+    for (int i = 0; i < 3; ++i) {
+        CPPUNIT_ASSERT(summary >> value);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(accumulator.mean(i), value, 1E-7);
+    }
+    CPPUNIT_ASSERT(summary >> keyword && keyword == "covariance");
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            CPPUNIT_ASSERT(summary >> value);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(accumulator.covariance(i, j), value,
+                    1E-7);
+        }
+    }
+
+    unsigned int i_variable;
+    unsigned int num_bins;
+    double low;
+    double high;
+    double below;
+    double above;
+    CPPUNIT_ASSERT(summary >> keyword >> i_variable >> low >> high >>
+            num_bins >> below >> above);
+    CPPUNIT_ASSERT(keyword == "histogram1d" && i_variable == 1 &&
+            num_bins == 3);
+    double total = below + above;
+    for (int i_bin = 0; i_bin < 3; ++i_bin) {
+        CPPUNIT_ASSERT(summary >> value);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(accumulator.histogram1d_bin(0, i_bin),
+                value, d_);
+        total += value;
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(20.0, total, d_);
+
+    CPPUNIT_ASSERT(summary >> keyword && keyword == "histogram2d");
+    for (int i = 0; i < 9; ++i) {
+        CPPUNIT_ASSERT(summary >> value);
+    }
+    for (int i_bin = 0; i_bin < 2; ++i_bin) {
+        for (int j_bin = 0; j_bin < 3; ++j_bin) {
+            CPPUNIT_ASSERT(summary >> value);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(accumulator.histogram2d_bin(0, i_bin,
+                    j_bin), value, d_);
+        }
+    }
+    CPPUNIT_ASSERT(!(summary >> keyword));
+}
+
@@ -0,0 +1,42 @@
+/*
+ * File:   PosteriorAccumulatorTest.h
+ * Author: donerkebab
+ *
+ * Created on May 4, 2014, 2:30:40 PM
+ */
+
+#ifndef MCMC_POSTERIORACCUMULATORTEST_H
+#define	MCMC_POSTERIORACCUMULATORTEST_H
+
+#include <string>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class PosteriorAccumulatorTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(PosteriorAccumulatorTest);
+
+    CPPUNIT_TEST(testInitialization);
+    CPPUNIT_TEST(testWeightedMoments);
+    CPPUNIT_TEST(testHistograms);
+    CPPUNIT_TEST(testSummary);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    PosteriorAccumulatorTest();
+    virtual ~PosteriorAccumulatorTest();
+    void setUp();
+    void tearDown();
+
+private:
+    void testInitialization();
+    void testWeightedMoments();
+    void testHistograms();
+    void testSummary();
+
+    std::string const dummy_output_filename_;
+    double const d_;  // delta for CPPUNIT_ASSERT_DOUBLES_EQUAL
+};
+
+#endif	/* MCMC_POSTERIORACCUMULATORTEST_H */
+
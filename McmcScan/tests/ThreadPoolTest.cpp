@@ -0,0 +1,83 @@
+/*
+ * File:   ThreadPoolTest.cpp
+ * Author: donerkebab
+ *
+ * Created on Apr 14, 2014, 11:40:13 PM
+ */
+
+#include "ThreadPoolTest.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include "../ThreadPool.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ThreadPoolTest);
+
+ThreadPoolTest::ThreadPoolTest() {
+}
+
+ThreadPoolTest::~ThreadPoolTest() {
+}
+
+void ThreadPoolTest::setUp() {
+}
+
+void ThreadPoolTest::tearDown() {
+}
+
+void ThreadPoolTest::testInitialization() {
+    CPPUNIT_ASSERT_THROW(Mcmc::ThreadPool pool(0), std::invalid_argument);
+    
+    Mcmc::ThreadPool pool(3);
+    CPPUNIT_ASSERT(pool.num_threads() == 3);
+}
+
+void ThreadPoolTest::testAllTasksRun() {
+    // Each task writes only to its own slot, so every slot should be written
+    // exactly once no matter how the tasks were scheduled
+    Mcmc::ThreadPool pool(4);
+    unsigned int num_tasks = 1000;
+    std::vector<unsigned int> counts(num_tasks, 0);
+    
+    pool.ParallelFor(num_tasks, [&](unsigned int i) { counts[i] += i + 1; });
+    
+    for (unsigned int i = 0; i < num_tasks; ++i) {
+        CPPUNIT_ASSERT(counts[i] == i + 1);
+    }
+    
+    // No tasks: should return immediately
+    pool.ParallelFor(0, [&](unsigned int i) { counts[i] = 0; });
+    CPPUNIT_ASSERT(counts[0] == 1);
+}
+
+void ThreadPoolTest::testReuse() {
+    // Fewer tasks than threads, many times over
+    Mcmc::ThreadPool pool(8);
+    std::vector<unsigned int> counts(3, 0);
+    
+    for (int i_batch = 0; i_batch < 500; ++i_batch) {
+        pool.ParallelFor(3, [&](unsigned int i) { ++counts[i]; });
+    }
+    
+    for (unsigned int i = 0; i < 3; ++i) {
+        CPPUNIT_ASSERT(counts[i] == 500);
+    }
+}
+
+void ThreadPoolTest::testExceptionPropagates() {
+    Mcmc::ThreadPool pool(2);
+    
+    CPPUNIT_ASSERT_THROW(pool.ParallelFor(10, [](unsigned int i) {
+        if (i == 5) {
+            throw std::runtime_error("task failed");
+        }
+    }), std::runtime_error);
+    
+    // The pool should still be usable afterwards
+    std::vector<unsigned int> counts(10, 0);
+    pool.ParallelFor(10, [&](unsigned int i) { ++counts[i]; });
+    for (unsigned int i = 0; i < 10; ++i) {
+        CPPUNIT_ASSERT(counts[i] == 1);
+    }
+}
@@ -0,0 +1,37 @@
+/*
+ * File:   ThreadPoolTest.h
+ * Author: donerkebab
+ *
+ * Created on Apr 14, 2014, 11:40:12 PM
+ */
+
+#ifndef MCMC_THREADPOOLTEST_H
+#define	MCMC_THREADPOOLTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class ThreadPoolTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(ThreadPoolTest);
+
+    CPPUNIT_TEST(testInitialization);
+    CPPUNIT_TEST(testAllTasksRun);
+    CPPUNIT_TEST(testReuse);
+    CPPUNIT_TEST(testExceptionPropagates);
+    
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    ThreadPoolTest();
+    virtual ~ThreadPoolTest();
+    void setUp();
+    void tearDown();
+
+private:
+    void testInitialization();
+    void testAllTasksRun();
+    void testReuse();
+    void testExceptionPropagates();
+};
+
+#endif	/* MCMC_THREADPOOLTEST_H */
+
@@ -0,0 +1,95 @@
+/* 
+ * File:   GaussianScan.cpp
+ * Author: donerkebab
+ * 
+ * Created on April 21, 2014, 7:12 PM
+ */
+
+#include "GaussianScan.h"
+
+#include <cmath>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_vector.h>
+
+#include "McmcScan.h"
+
+namespace ToyScans {
+
+    GaussianScan::GaussianScan(unsigned int dimension,
+            unsigned int num_chains,
+            unsigned int max_steps,
+            double burn_fraction)
+    : Mcmc::McmcScan(dimension, num_chains, max_steps, burn_fraction),
+    dimension_(dimension) {
+    }
+
+    GaussianScan::~GaussianScan() {
+    }
+
+    std::vector<std::pair<gsl_vector*, std::string> >
+    GaussianScan::GenerateChainSeeds(unsigned int num_chains) {
+
+        if (num_chains == 0) {
+            throw std::invalid_argument("bad input to GenerateChainSeeds()");
+        }
+
+        std::vector<std::pair<gsl_vector*, std::string> > chains_info;
+
+        for (int i_chain = 0; i_chain < num_chains; ++i_chain) {
+            // Generate random parameters by expanding the random number in 
+            // [0,1) to the range [-(i + 1), i + 1)
+            gsl_vector* seed_parameters = gsl_vector_alloc(dimension_);
+            for (int i_dimension = 0; i_dimension < dimension_; 
+                    ++i_dimension) {
+                gsl_vector_set(seed_parameters, i_dimension,
+                        (i_dimension + 1.0) *
+                        (2.0 * gsl_rng_uniform(rng_) - 1.0));
+            }
+
+            std::stringstream filename_stream;
+            filename_stream << "GaussianScan_d" << dimension_ << "_chain" 
+                    << i_chain + 1 << ".dat";
+
+            chains_info.push_back(
+                    std::pair<gsl_vector*, std::string>(seed_parameters,
+                    filename_stream.str()));
+        }
+
+        return chains_info;
+    }
+
+    bool GaussianScan::IsValidParameters(gsl_vector const* parameters) {
+        for (int i = 0; i < parameters->size; ++i) {
+            if (std::fabs(gsl_vector_get(parameters, i)) > 10.0 * (i + 1.0)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void GaussianScan::MeasurePoint(gsl_vector const* parameters,
+            gsl_vector*& measurements,
+            double& likelihood) {
+        double distance_squared = 0.0;
+        double chi_squared = 0.0;
+        for (int i = 0; i < parameters->size; ++i) {
+            double x = gsl_vector_get(parameters, i);
+            distance_squared += x * x;
+            chi_squared += std::pow(x / (i + 1.0), 2);
+        }
+
+        measurements = gsl_vector_alloc(1);
+        gsl_vector_set(measurements, 0, std::sqrt(distance_squared));
+
+        likelihood = std::exp(-chi_squared / 2.0);
+    }
+
+}
+
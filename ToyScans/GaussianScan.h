@@ -0,0 +1,81 @@
+/* 
+ * File:   GaussianScan.h
+ * Author: donerkebab
+ *
+ * Implements a toy Markov chain Monte Carlo scan in a parameter space of any
+ * dimension, using the Mcmc package.  The scan seeks out a Gaussian centered at
+ * the origin.
+ * 
+ * This class is meant for benchmarking the Mcmc package rather than for
+ * looking at the results: its MeasurePoint() is as cheap as possible, so the 
+ * time per step is dominated by the scan's own bookkeeping, and the dimension
+ * can be varied freely.
+ * 
+ * The uncertainty in parameter i is (i + 1), so that the posterior is badly
+ * scaled in the higher dimensions, much like a real scan.  The only 
+ * measurement is the distance from the origin.
+ * 
+ * Created on April 21, 2014, 7:12 PM
+ */
+
+#ifndef TOYSCANS_GAUSSIANSCAN_H
+#define	TOYSCANS_GAUSSIANSCAN_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gsl/gsl_vector.h>
+
+#include "McmcScan.h"
+
+namespace ToyScans {
+
+    class GaussianScan : public Mcmc::McmcScan {
+    public:
+        GaussianScan(unsigned int dimension,
+                unsigned int num_chains,
+                unsigned int max_steps,
+                double burn_fraction);
+        virtual ~GaussianScan();
+
+        /*
+         * Generates chain seed parameters and filenames.  It just chooses
+         * random points for the seeds.  Filenames are generated trivially, and
+         * include the dimension so that benchmarks in different dimensions do
+         * not append to each other's files.
+         */
+        std::vector<std::pair<gsl_vector*, std::string> > GenerateChainSeeds(
+                unsigned int num_chains);
+
+    private:
+        GaussianScan(GaussianScan const& orig);
+        void operator=(GaussianScan const& orig);
+
+        /*
+         * Determines if the parameters are valid in the parameter space.
+         * 
+         * For this scan, we keep the chains in a box [-10 * (i + 1), 
+         * 10 * (i + 1)] in dimension i.
+         */
+        bool IsValidParameters(gsl_vector const* parameters);
+
+        /*
+         * Calculates the measurements and likelihood for a given set of
+         * parameters.  Stores them in output arguments.  GSL vector 
+         * measurements gets newly allocated within the method.
+         * 
+         * Input: parameters
+         * Outputs: measurements, likelihood
+         */
+        void MeasurePoint(gsl_vector const* parameters,
+                gsl_vector*& measurements,
+                double& likelihood);
+
+        unsigned int const dimension_;
+    };
+
+}
+
+#endif	/* TOYSCANS_GAUSSIANSCAN_H */
+
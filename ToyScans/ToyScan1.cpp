@@ -16,6 +16,7 @@
 #include <utility>
 #include <vector>
 
+#include <gsl/gsl_matrix.h>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_vector.h>
 
@@ -116,6 +117,61 @@ namespace ToyScans {
         }
     }
 
+    void ToyScan1::MeasureBatch(gsl_matrix const* parameters,
+            gsl_matrix*& measurements,
+            gsl_vector*& likelihoods) {
+        size_t const num_points = parameters->size1;
+        measurements = gsl_matrix_alloc(num_points, 3);
+        likelihoods = gsl_vector_alloc(num_points);
+
+        // Hoist everything that does not depend on the point out of the loop.
+        // The product of the three Gaussians is computed as the exponential of
+        // a single weighted sum.
+        double const target_x = gsl_vector_get(target_point_, 0);
+        double const target_y = gsl_vector_get(target_point_, 1);
+        double const target_z = gsl_vector_get(target_point_, 2);
+        double const weight_x = -0.5 / std::pow(
+                gsl_vector_get(uncertainties_, 0), 2);
+        double const weight_y = -0.5 / std::pow(
+                gsl_vector_get(uncertainties_, 1), 2);
+        double const weight_z = -0.5 / std::pow(
+                gsl_vector_get(uncertainties_, 2), 2);
+
+        double const* const parameters_data = parameters->data;
+        size_t const parameters_tda = parameters->tda;
+        double* const measurements_data = measurements->data;
+        size_t const measurements_tda = measurements->tda;
+        double* const likelihoods_data = likelihoods->data;
+        size_t const likelihoods_stride = likelihoods->stride;
+
+        for (size_t i = 0; i < num_points; ++i) {
+            double const* point = parameters_data + i * parameters_tda;
+            double const dx = point[0] - target_x;
+            double const dy = point[1] - target_y;
+            double const dz = point[2] - target_z;
+
+            double const distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+            double* point_measurements = measurements_data +
+                    i * measurements_tda;
+            point_measurements[0] = distance;
+            point_measurements[1] = std::acos(dz / distance);
+            point_measurements[2] = std::atan(dy / dx);
+
+            likelihoods_data[i * likelihoods_stride] = std::exp(
+                    weight_x * dx * dx + weight_y * dy * dy +
+                    weight_z * dz * dz);
+        }
+    }
 
-}
+    double ToyScan1::SurrogateLikelihood(gsl_vector const* parameters) {
+        double exponent = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            exponent += std::pow((gsl_vector_get(parameters, i) -
+                    gsl_vector_get(target_point_, i)) /
+                    (1.5 * gsl_vector_get(uncertainties_, i)), 2);
+        }
+        return std::exp(-exponent / 2.0);
+    }
 
+}
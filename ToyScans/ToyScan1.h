@@ -14,6 +14,9 @@
  * scan should result in a 3D Gaussian posterior distribution centered at the
  * target point.
  * 
+ * The scan also supplies a surrogate likelihood, so that it can be run in
+ * delayed-acceptance mode.
+ * 
  * Created on March 28, 2014, 8:45 AM
  */
 
@@ -24,6 +27,7 @@
 #include <utility>
 #include <vector>
 
+#include <gsl/gsl_matrix.h>
 #include <gsl/gsl_vector.h>
 
 #include "McmcScan.h"
@@ -78,6 +82,27 @@ namespace ToyScans {
                 gsl_vector*& measurements,
                 double& likelihood);
 
+        /*
+         * Batched version of MeasurePoint(), with the same measurements and
+         * likelihood.  Works directly on the rows of the GSL matrices, with
+         * the arithmetic for each point written out for all three dimensions,
+         * so that the loop over points has no function calls other than the
+         * math library and can be vectorized by the compiler.
+         */
+        void MeasureBatch(gsl_matrix const* parameters,
+                gsl_matrix*& measurements,
+                gsl_vector*& likelihoods);
+
+        /*
+         * Calculates a cheap approximation to the likelihood, for 
+         * delayed-acceptance mode.
+         * 
+         * For this scan, it is the same Gaussian as the likelihood, but with
+         * the uncertainties inflated by 50%.  It is deliberately a little off,
+         * so that the second stage has something to correct.
+         */
+        double SurrogateLikelihood(gsl_vector const* parameters);
+
         gsl_vector* target_point_;
         gsl_vector* uncertainties_;
     };
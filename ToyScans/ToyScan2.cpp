@@ -16,6 +16,7 @@
 #include <utility>
 #include <vector>
 
+#include <gsl/gsl_matrix.h>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_vector.h>
 
@@ -109,6 +110,43 @@ namespace ToyScans {
                 / 2.0);
     }
 
+    void ToyScan2::MeasureBatch(gsl_matrix const* parameters,
+            gsl_matrix*& measurements,
+            gsl_vector*& likelihoods) {
+        size_t const num_points = parameters->size1;
+        measurements = gsl_matrix_alloc(num_points, 2);
+        likelihoods = gsl_vector_alloc(num_points);
+
+        // Hoist everything that does not depend on the point out of the loop
+        double const center_x = gsl_vector_get(center_point_, 0);
+        double const center_y = gsl_vector_get(center_point_, 1);
+        double const weight = -0.5 / (uncertainty_ * uncertainty_);
+
+        double const* const parameters_data = parameters->data;
+        size_t const parameters_tda = parameters->tda;
+        double* const measurements_data = measurements->data;
+        size_t const measurements_tda = measurements->tda;
+        double* const likelihoods_data = likelihoods->data;
+        size_t const likelihoods_stride = likelihoods->stride;
+
+        for (size_t i = 0; i < num_points; ++i) {
+            double const* point = parameters_data + i * parameters_tda;
+            double const dx = point[0] - center_x;
+            double const dy = point[1] - center_y;
+
+            double const distance = std::sqrt(dx * dx + dy * dy);
+
+            double* point_measurements = measurements_data +
+                    i * measurements_tda;
+            point_measurements[0] = distance;
+            point_measurements[1] = std::acos(dx / distance);
+
+            double const residual = distance - radius_;
+            likelihoods_data[i * likelihoods_stride] = std::exp(
+                    weight * residual * residual);
+        }
+    }
+
 
 }
 
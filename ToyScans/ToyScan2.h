@@ -24,6 +24,7 @@
 #include <utility>
 #include <vector>
 
+#include <gsl/gsl_matrix.h>
 #include <gsl/gsl_vector.h>
 
 #include "McmcScan.h"
@@ -78,6 +79,16 @@ namespace ToyScans {
                 gsl_vector*& measurements,
                 double& likelihood);
 
+        /*
+         * Batched version of MeasurePoint(), with the same measurements and
+         * likelihood.  Works directly on the rows of the GSL matrices, so
+         * that the loop over points has no function calls other than the math
+         * library and can be vectorized by the compiler.
+         */
+        void MeasureBatch(gsl_matrix const* parameters,
+                gsl_matrix*& measurements,
+                gsl_vector*& likelihoods);
+
         gsl_vector* center_point_;
         double radius_;
         double uncertainty_;
@@ -8,39 +8,112 @@
 #include <cstdlib>
 #include <cstdio>
 
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <gsl/gsl_vector.h>
 
+#include "FixedDimensionGaussianProposal.h"
+#include "PosteriorAccumulator.h"
+#include "ScanCoordinator.h"
+
+#include "GaussianScan.h"
 #include "ToyScan1.h"
 #include "ToyScan2.h"
 
 
 namespace { // unnamed namespace
     // Forward declarations of scan functions
-    void RunScan1();
-    void RunScan2();
+    void RunScan1(unsigned int num_threads, bool delayed_acceptance,
+            bool convergence_monitor);
+    void RunScan2(unsigned int num_threads, bool parallel_tempering);
+    void RunStepCostBenchmark();
+    void RunDistributedScan1(unsigned int num_workers);
+    void RunProposalBenchmark();
+    void RunFixedDimensionBenchmark();
+    template <unsigned int D>
+    std::pair<double, double> FixedDimensionStepsPerSecond();
 }
 
 /*
  * Runs the selected toy scan.
  * 
- * Input: number of the toy scan to run.
+ * Input: number of the toy scan to run, and optionally the number of threads
+ * to run it with in sweep mode.  Without the second input, the scan runs in
+ * the default single-threaded mode.
+ * 
+ * Selection 3 is not a scan, but a benchmark of the time per step against the
+ * dimension of the parameter space.
+ * 
+ * Selection 4 runs toy scan 1 in delayed-acceptance mode.
+ * 
+ * Selection 5 runs toy scan 1 distributed over worker processes, as many as 
+ * the second input says (default 4), each with its own 10 chains, and prints 
+ * the steps per second of all of them together, to compare against other 
+ * numbers of workers.
+ * 
+ * Selection 6 runs toy scan 2 with parallel tempering.
+ * 
+ * Selection 7 is a benchmark of the default proposal against differential
+ * evolution and stretch moves, in steps per second and effective sample 
+ * size per second, on toy scans 1 and 2.
+ * 
+ * Selection 8 is a benchmark of the steps per second of the default proposal
+ * against Mcmc::FixedDimensionGaussianProposal, for dimensions 2 to 8.
+ * 
+ * Selection 9 runs toy scan 1 with the convergence monitor, which logs the 
+ * R-hats to ToyScan1_rhat.dat as the scan goes, to see how many steps it 
+ * really needs.
  * 
  */
 int main(int argc, char** argv) {
 
-    if (argc != 2) {
-        printf("only one input required");
+    if (argc != 2 && argc != 3) {
+        printf("one or two inputs required");
         exit(1);
     }
 
     int scan_selection = std::atoi(argv[1]);
+    unsigned int num_threads = 0;
+    if (argc == 3) {
+        num_threads = std::atoi(argv[2]);
+    }
 
     switch (scan_selection) {
         case 1:
-            ::RunScan1();
+            ::RunScan1(num_threads, false, false);
             break;
         case 2:
-            ::RunScan2();
+            ::RunScan2(num_threads, false);
+            break;
+        case 3:
+            ::RunStepCostBenchmark();
+            break;
+        case 4:
+            ::RunScan1(0, true, false);
+            break;
+        case 5:
+            ::RunDistributedScan1(num_threads > 0 ? num_threads : 4);
+            break;
+        case 6:
+            ::RunScan2(0, true);
+            break;
+        case 7:
+            ::RunProposalBenchmark();
+            break;
+        case 8:
+            ::RunFixedDimensionBenchmark();
+            break;
+        case 9:
+            ::RunScan1(0, false, true);
             break;
         default:
             printf("scan selected does not exist");
@@ -52,7 +125,8 @@ int main(int argc, char** argv) {
 
 namespace {
 
-    void RunScan1() {
+    void RunScan1(unsigned int num_threads, bool delayed_acceptance,
+            bool convergence_monitor) {
         unsigned int num_chains = 10;
         unsigned int buffer_size = 25;
         unsigned int max_steps = 10000;
@@ -73,6 +147,15 @@ namespace {
 
         scan.Initialize(buffer_size, scan.GenerateChainSeeds(num_chains));
 
+        if (convergence_monitor) {
+            scan.EnableConvergenceMonitor("ToyScan1_rhat.dat", 500);
+        }
+        if (num_threads > 0) {
+            scan.EnableSweepMode(num_threads);
+        }
+        if (delayed_acceptance) {
+            scan.EnableDelayedAcceptance();
+        }
         scan.Run();
 
         // Memory cleanup
@@ -80,7 +163,7 @@ namespace {
         gsl_vector_free(uncertainties);
     }
 
-    void RunScan2() {
+    void RunScan2(unsigned int num_threads, bool parallel_tempering) {
         unsigned int num_chains = 10;
         unsigned int buffer_size = 20;
         unsigned int max_steps = 100000;
@@ -96,16 +179,330 @@ namespace {
         ToyScans::ToyScan2 scan(num_chains, max_steps, burn_fraction,
                 center_point, radius, uncertainty);
 
+        // Quick-look histograms of the ring, in the plane and in the radius
+        std::shared_ptr<Mcmc::PosteriorAccumulator> accumulator(
+                new Mcmc::PosteriorAccumulator(2, 2));
+        accumulator->AddHistogram2D(0, -2.0, 6.0, 80, 1, -3.0, 5.0, 80);
+        accumulator->AddHistogram1D(2, 0.0, 6.0, 60);
+        scan.UsePosteriorAccumulator(accumulator, "ToyScan2_summary.dat");
+
+        // Keep the chain output out of the way of the step loop
+        scan.EnableBackgroundOutput();
         scan.Initialize(buffer_size, scan.GenerateChainSeeds(num_chains));
 
+        if (num_threads > 0) {
+            scan.EnableSweepMode(num_threads);
+        }
+        if (parallel_tempering) {
+            scan.EnableParallelTempering({1.0, 0.5, 0.25, 0.1}, 10);
+        }
         scan.Run();
 
         // Memory cleanup
         gsl_vector_free(center_point);
     }
 
+    void RunStepCostBenchmark() {
+        unsigned int const dimensions[] = {2, 4, 8, 16, 32, 64};
+        unsigned int buffer_size = 1000;
+        unsigned int max_steps = 20000;
+        double burn_fraction = 0.1;
 
+        std::vector<std::pair<unsigned int, double> > results;
 
+        for (unsigned int dimension : dimensions) {
+            unsigned int num_chains = 2 * dimension + 2;
+            std::vector<std::string> filenames;
+            double seconds;
+            {
+                ToyScans::GaussianScan scan(dimension, num_chains, max_steps,
+                        burn_fraction);
 
-}
+                std::vector<std::pair<gsl_vector*, std::string> > chains_info =
+                        scan.GenerateChainSeeds(num_chains);
+                for (unsigned int i = 0; i < chains_info.size(); ++i) {
+                    filenames.push_back(chains_info[i].second);
+                }
+                scan.Initialize(buffer_size, chains_info);
+                for (unsigned int i = 0; i < chains_info.size(); ++i) {
+                    gsl_vector_free(chains_info[i].first);
+                }
+
+                std::chrono::steady_clock::time_point start =
+                        std::chrono::steady_clock::now();
+                scan.Run();
+                std::chrono::duration<double> elapsed =
+                        std::chrono::steady_clock::now() - start;
+                seconds = elapsed.count();
+            }
+
+            // The chains are only there to be timed
+            for (unsigned int i = 0; i < filenames.size(); ++i) {
+                std::remove(filenames[i].c_str());
+            }
 
+            results.push_back(std::make_pair(dimension, seconds));
+        }
+
+        printf("dimension    time per step (us)\n");
+        for (unsigned int i = 0; i < results.size(); ++i) {
+            printf("%9u    %18.3f\n", results[i].first,
+                    1.0E6 * results[i].second / max_steps);
+        }
+    }
+
+
+    void RunDistributedScan1(unsigned int num_workers) {
+        unsigned int num_chains = 10;
+        unsigned int buffer_size = 25;
+        unsigned int max_steps = 10000;
+        double burn_fraction = 0.1;
+        unsigned int sync_interval = 100;
+        unsigned int max_staleness = 2;
+        std::string socket_path = "ToyScan1_coordinator.sock";
+
+        Mcmc::ScanCoordinator coordinator(socket_path, 3, num_workers,
+                max_staleness);
+
+        std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+        std::fflush(stdout);
+        std::vector<pid_t> workers;
+        for (unsigned int i_worker = 0; i_worker < num_workers; ++i_worker) {
+            pid_t pid = fork();
+            if (pid < 0) {
+                printf("could not start worker %u\n", i_worker);
+                exit(1);
+            }
+            if (pid != 0) {
+                workers.push_back(pid);
+                continue;
+            }
+
+            gsl_vector* target_point = gsl_vector_alloc(3);
+            gsl_vector_set(target_point, 0, 1);
+            gsl_vector_set(target_point, 1, 1);
+            gsl_vector_set(target_point, 2, 1);
+
+            gsl_vector* uncertainties = gsl_vector_alloc(3);
+            gsl_vector_set(uncertainties, 0, 0.1);
+            gsl_vector_set(uncertainties, 1, 0.5);
+            gsl_vector_set(uncertainties, 2, 1);
+
+            {
+                ToyScans::ToyScan1 scan(num_chains, max_steps, burn_fraction,
+                        target_point, uncertainties);
+
+                // The chains of different workers go to different files
+                std::vector<std::pair<gsl_vector*, std::string> > 
+                        chains_info = scan.GenerateChainSeeds(num_chains);
+                for (unsigned int i = 0; i < chains_info.size(); ++i) {
+                    std::stringstream filename_stream;
+                    filename_stream << "ToyScan1_worker" << i_worker + 1 << 
+                            "_chain" << i + 1 << ".dat";
+                    chains_info[i].second = filename_stream.str();
+                }
+                scan.Initialize(buffer_size, chains_info);
+                for (unsigned int i = 0; i < chains_info.size(); ++i) {
+                    gsl_vector_free(chains_info[i].first);
+                }
+
+                scan.EnableDistributedMode(socket_path, sync_interval);
+                scan.Run();
+            }
+
+            // Memory cleanup
+            gsl_vector_free(target_point);
+            gsl_vector_free(uncertainties);
+            std::fflush(stdout);
+            _exit(0);
+        }
+
+        coordinator.Run();
+        for (unsigned int i_worker = 0; i_worker < num_workers; ++i_worker) {
+            waitpid(workers[i_worker], nullptr, 0);
+        }
+        std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+        printf("%u workers, %u chains: %u steps in %.3f s, %.0f steps/s, "
+                "%lu synchronizations\n", num_workers, coordinator.num_chains(),
+                num_workers * max_steps, elapsed.count(),
+                num_workers * max_steps / elapsed.count(),
+                coordinator.num_syncs());
+    }
+
+
+    void RunProposalBenchmark() {
+        unsigned int num_chains = 10;
+        unsigned int buffer_size = 1000;
+        unsigned int max_steps = 100000;
+        double burn_fraction = 0.1;
+
+        gsl_vector* target_point = gsl_vector_alloc(3);
+        gsl_vector_set(target_point, 0, 1);
+        gsl_vector_set(target_point, 1, 1);
+        gsl_vector_set(target_point, 2, 1);
+        gsl_vector* uncertainties = gsl_vector_alloc(3);
+        gsl_vector_set(uncertainties, 0, 0.1);
+        gsl_vector_set(uncertainties, 1, 0.5);
+        gsl_vector_set(uncertainties, 2, 1);
+
+        gsl_vector* center_point = gsl_vector_alloc(2);
+        gsl_vector_set(center_point, 0, 2);
+        gsl_vector_set(center_point, 1, 1);
+
+        std::vector<std::string> results;
+
+        for (unsigned int i_scan = 1; i_scan <= 2; ++i_scan) {
+            for (unsigned int i_proposal = 0; i_proposal < 3; ++i_proposal) {
+                char const* const proposals[] = {"covariance",
+                    "differential evolution", "stretch move"};
+                std::vector<std::string> filenames;
+                double seconds;
+                double effective_sample_size;
+                {
+                    std::unique_ptr<Mcmc::McmcScan> scan;
+                    std::vector<std::pair<gsl_vector*, std::string> > 
+                            chains_info;
+                    if (i_scan == 1) {
+                        ToyScans::ToyScan1* toy_scan = new ToyScans::ToyScan1(
+                                num_chains, max_steps, burn_fraction,
+                                target_point, uncertainties);
+                        scan.reset(toy_scan);
+                        chains_info = toy_scan->GenerateChainSeeds(num_chains);
+                    } else {
+                        ToyScans::ToyScan2* toy_scan = new ToyScans::ToyScan2(
+                                num_chains, max_steps, burn_fraction,
+                                center_point, 3, 0.3);
+                        scan.reset(toy_scan);
+                        chains_info = toy_scan->GenerateChainSeeds(num_chains);
+                    }
+
+                    for (unsigned int i = 0; i < chains_info.size(); ++i) {
+                        filenames.push_back(chains_info[i].second);
+                    }
+                    scan->Initialize(buffer_size, chains_info);
+                    for (unsigned int i = 0; i < chains_info.size(); ++i) {
+                        gsl_vector_free(chains_info[i].first);
+                    }
+                    if (i_proposal == 1) {
+                        scan->EnableDifferentialEvolution();
+                    } else if (i_proposal == 2) {
+                        scan->EnableStretchMove(1);
+                    }
+
+                    std::chrono::steady_clock::time_point start =
+                            std::chrono::steady_clock::now();
+                    scan->Run();
+                    std::chrono::duration<double> elapsed =
+                            std::chrono::steady_clock::now() - start;
+                    seconds = elapsed.count();
+
+                    std::vector<double> effective_sample_sizes;
+                    effective_sample_size = scan->autocorrelation_monitor()
+                            .ComputeEffectiveSampleSizes(
+                            effective_sample_sizes);
+                }
+
+                // The chains are only there to be timed
+                for (unsigned int i = 0; i < filenames.size(); ++i) {
+                    std::remove(filenames[i].c_str());
+                }
+
+                char result[128];
+                std::sprintf(result, "%8u    %-22s  %10.0f  %10.0f  %10.0f",
+                        i_scan, proposals[i_proposal],
+                        max_steps / seconds, effective_sample_size,
+                        effective_sample_size / seconds);
+                results.push_back(result);
+            }
+        }
+
+        printf("toy scan    proposal                   steps/s         ESS"
+                "       ESS/s\n");
+        for (unsigned int i = 0; i < results.size(); ++i) {
+            printf("%s\n", results[i].c_str());
+        }
+
+        // Memory cleanup
+        gsl_vector_free(target_point);
+        gsl_vector_free(uncertainties);
+        gsl_vector_free(center_point);
+    }
+
+
+    void RunFixedDimensionBenchmark() {
+        std::vector<std::pair<double, double> > results;
+        results.push_back(FixedDimensionStepsPerSecond<2>());
+        results.push_back(FixedDimensionStepsPerSecond<3>());
+        results.push_back(FixedDimensionStepsPerSecond<4>());
+        results.push_back(FixedDimensionStepsPerSecond<5>());
+        results.push_back(FixedDimensionStepsPerSecond<6>());
+        results.push_back(FixedDimensionStepsPerSecond<7>());
+        results.push_back(FixedDimensionStepsPerSecond<8>());
+
+        printf("dimension    runtime steps/s    fixed steps/s    speedup\n");
+        for (unsigned int i = 0; i < results.size(); ++i) {
+            printf("%9u    %15.0f    %13.0f    %7.2f\n", i + 2,
+                    results[i].first, results[i].second,
+                    results[i].second / results[i].first);
+        }
+    }
+
+    /*
+     * Steps per second of a GaussianScan in dimension D, with the default 
+     * proposal and with Mcmc::FixedDimensionGaussianProposal<D>.
+     */
+    template <unsigned int D>
+    std::pair<double, double> FixedDimensionStepsPerSecond() {
+        unsigned int num_chains = 2 * D + 2;
+        unsigned int buffer_size = 1000;
+        unsigned int max_steps = 200000;
+        double burn_fraction = 0.1;
+
+        double steps_per_second[2];
+
+        for (unsigned int i_path = 0; i_path < 2; ++i_path) {
+            std::vector<std::string> filenames;
+            double seconds;
+            {
+                ToyScans::GaussianScan scan(D, num_chains, max_steps,
+                        burn_fraction);
+
+                std::vector<std::pair<gsl_vector*, std::string> > chains_info =
+                        scan.GenerateChainSeeds(num_chains);
+                for (unsigned int i = 0; i < chains_info.size(); ++i) {
+                    filenames.push_back(chains_info[i].second);
+                }
+                scan.Initialize(buffer_size, chains_info);
+                for (unsigned int i = 0; i < chains_info.size(); ++i) {
+                    gsl_vector_free(chains_info[i].first);
+                }
+
+                Mcmc::FixedDimensionGaussianProposal<D> proposal(scan);
+
+                std::chrono::steady_clock::time_point start =
+                        std::chrono::steady_clock::now();
+                if (i_path == 0) {
+                    scan.Run();
+                } else {
+                    scan.Run(proposal);
+                }
+                std::chrono::duration<double> elapsed =
+                        std::chrono::steady_clock::now() - start;
+                seconds = elapsed.count();
+            }
+
+            // The chains are only there to be timed
+            for (unsigned int i = 0; i < filenames.size(); ++i) {
+                std::remove(filenames[i].c_str());
+            }
+
+            steps_per_second[i_path] = max_steps / seconds;
+        }
+
+        return std::make_pair(steps_per_second[0], steps_per_second[1]);
+    }
+
+}
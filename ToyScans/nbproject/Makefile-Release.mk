@@ -35,6 +35,7 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
+	${OBJECTDIR}/GaussianScan.o \
 	${OBJECTDIR}/ToyScan1.o \
 	${OBJECTDIR}/ToyScan2.o \
 	${OBJECTDIR}/main.o
@@ -64,6 +65,11 @@ ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/toyscans: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
 	${LINK.cc} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/toyscans ${OBJECTFILES} ${LDLIBSOPTIONS}
 
+${OBJECTDIR}/GaussianScan.o: GaussianScan.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/GaussianScan.o GaussianScan.cpp
+
 ${OBJECTDIR}/ToyScan1.o: ToyScan1.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
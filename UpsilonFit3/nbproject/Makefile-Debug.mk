@@ -43,8 +43,8 @@ OBJECTFILES= \
 CFLAGS=
 
 # CC Compiler Flags
-CCFLAGS=-lgsl lgslcblas -lm
-CXXFLAGS=-lgsl lgslcblas -lm
+CCFLAGS=-lgsl lgslcblas -lm -pthread
+CXXFLAGS=-lgsl lgslcblas -lm -pthread
 
 # Fortran Compiler Flags
 FFLAGS=